@@ -303,6 +303,36 @@ libclc_add_generic_variants(nir_shader *shader)
    }
 }
 
+static bool
+libclc_optimize(nir_shader *nir, void *data)
+{
+   bool any_progress = false;
+   bool progress;
+   do {
+      progress = false;
+      NIR_PASS(progress, nir, nir_opt_copy_prop_vars);
+      NIR_PASS(progress, nir, nir_lower_var_copies);
+      NIR_PASS(progress, nir, nir_lower_vars_to_ssa);
+      NIR_PASS(progress, nir, nir_copy_prop);
+      NIR_PASS(progress, nir, nir_opt_remove_phis);
+      NIR_PASS(progress, nir, nir_opt_dce);
+      NIR_PASS(progress, nir, nir_opt_if, false);
+      NIR_PASS(progress, nir, nir_opt_dead_cf);
+      NIR_PASS(progress, nir, nir_opt_cse);
+      /* drivers run this pass, so don't be too aggressive. More aggressive
+       * values only increase effectiveness by <5%
+       */
+      NIR_PASS(progress, nir, nir_opt_peephole_select, 0, false, false);
+      NIR_PASS(progress, nir, nir_opt_algebraic);
+      NIR_PASS(progress, nir, nir_opt_constant_folding);
+      NIR_PASS(progress, nir, nir_opt_undef);
+      NIR_PASS(progress, nir, nir_opt_deref);
+      any_progress |= progress;
+   } while(progress);
+
+   return any_progress;
+}
+
 nir_shader *
 nir_load_libclc_shader(unsigned ptr_bit_size,
                        struct disk_cache *disk_cache,
@@ -366,29 +396,15 @@ nir_load_libclc_shader(unsigned ptr_bit_size,
    if (optimize) {
       NIR_PASS_V(nir, nir_split_var_copies);
 
-      bool progress;
-      do {
-         progress = false;
-         NIR_PASS(progress, nir, nir_opt_copy_prop_vars);
-         NIR_PASS(progress, nir, nir_lower_var_copies);
-         NIR_PASS(progress, nir, nir_lower_vars_to_ssa);
-         NIR_PASS(progress, nir, nir_copy_prop);
-         NIR_PASS(progress, nir, nir_opt_remove_phis);
-         NIR_PASS(progress, nir, nir_opt_dce);
-         NIR_PASS(progress, nir, nir_opt_if, false);
-         NIR_PASS(progress, nir, nir_opt_dead_cf);
-         NIR_PASS(progress, nir, nir_opt_cse);
-         /* drivers run this pass, so don't be too aggressive. More aggressive
-          * values only increase effectiveness by <5%
-          */
-         NIR_PASS(progress, nir, nir_opt_peephole_select, 0, false, false);
-         NIR_PASS(progress, nir, nir_opt_algebraic);
-         NIR_PASS(progress, nir, nir_opt_constant_folding);
-         NIR_PASS(progress, nir, nir_opt_undef);
-         NIR_PASS(progress, nir, nir_opt_deref);
-      } while(progress);
-
-      nir_sweep(nir);
+      /* Every pass in the loop only looks at one function at a time, so
+       * optimize the library's functions in parallel.
+       */
+      nir_shader_parallel_impl_pass(nir, libclc_optimize, NULL);
+
+      /* The library is kept around and inlined into every kernel, so pack
+       * what survived the optimization loop instead of only sweeping it.
+       */
+      nir_compact(nir);
    }
 
 #ifdef ENABLE_SHADER_CACHE
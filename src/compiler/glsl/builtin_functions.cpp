@@ -87,6 +87,8 @@
 #include <math.h>
 #include "builtin_functions.h"
 #include "util/hash_table.h"
+#include "util/set.h"
+#include "util/u_debug.h"
 
 #ifndef M_PIf
 #define M_PIf   ((float) M_PI)
@@ -1022,6 +1024,9 @@ public:
    void release();
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, exec_list *actual_parameters);
+   ir_function *get_function(const char *name);
+   void foreach_function(void (*callback)(ir_function *f, void *data),
+                         void *data);
 
    /**
     * A shader to hold all the built-in signatures; created by this module.
@@ -1035,6 +1040,22 @@ public:
 private:
    void *mem_ctx;
 
+   /**
+    * Built-in functions are generated lazily.  initialize() only records the
+    * name of every function here, and the IR for a function is generated the
+    * first time get_function() asks for it, by running create_intrinsics()
+    * and create_builtins() again with build_filter set to its name.  Only
+    * the add_function() calls for that name evaluate their signatures.
+    *
+    * With GLSL_EAGER_BUILTINS set, initialize() generates all of them right
+    * away instead, like it used to.
+    */
+   struct set *function_names;
+   const char *build_filter;
+   bool generate_all;
+
+   bool want_function(const char *name);
+
    void create_shader();
    void create_intrinsics();
    void create_builtins();
@@ -1428,6 +1449,9 @@ builtin_builder::builtin_builder()
    : shader(NULL)
 {
    mem_ctx = NULL;
+   function_names = NULL;
+   build_filter = NULL;
+   generate_all = false;
 }
 
 builtin_builder::~builtin_builder()
@@ -1456,7 +1480,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = get_function(name);
    if (f == NULL)
       return NULL;
 
@@ -1478,9 +1502,58 @@ builtin_builder::initialize()
    glsl_type_singleton_init_or_ref();
 
    mem_ctx = ralloc_context(NULL);
+   function_names = _mesa_set_create(mem_ctx, _mesa_hash_string,
+                                     _mesa_key_string_equal);
+   build_filter = NULL;
+   generate_all = debug_get_bool_option("GLSL_EAGER_BUILTINS", false);
+
    create_shader();
    create_intrinsics();
    create_builtins();
+
+   generate_all = false;
+}
+
+ir_function *
+builtin_builder::get_function(const char *name)
+{
+   ir_function *f = shader->symbols->get_function(name);
+   if (f != NULL)
+      return f;
+
+   if (!_mesa_set_search(function_names, name))
+      return NULL;
+
+   /* Generating a function may need the intrinsics it calls, in which case
+    * we get back here recursively.
+    */
+   const char *saved_filter = build_filter;
+   build_filter = name;
+   create_intrinsics();
+   create_builtins();
+   build_filter = saved_filter;
+
+   return shader->symbols->get_function(name);
+}
+
+void
+builtin_builder::foreach_function(void (*callback)(ir_function *f,
+                                                   void *data),
+                                  void *data)
+{
+   set_foreach(function_names, entry)
+      callback(get_function((const char *) entry->key), data);
+}
+
+bool
+builtin_builder::want_function(const char *name)
+{
+   if (build_filter == NULL) {
+      _mesa_set_add(function_names, name);
+      return generate_all;
+   }
+
+   return strcmp(name, build_filter) == 0;
 }
 
 void
@@ -1488,6 +1561,7 @@ builtin_builder::release()
 {
    ralloc_free(mem_ctx);
    mem_ctx = NULL;
+   function_names = NULL;
 
    ralloc_free(shader);
    shader = NULL;
@@ -1508,6 +1582,15 @@ builtin_builder::create_shader()
 
 /** @} */
 
+/* Only evaluate the signatures, i.e. generate their IR, for the function
+ * currently being built.  See builtin_builder::want_function().
+ */
+#define add_function(NAME, ...)              \
+   do {                                      \
+      if (want_function(NAME))               \
+         add_function(NAME, __VA_ARGS__);    \
+   } while (0)
+
 /**
  * Create ir_function and ir_function_signature objects for each
  * intrinsic.
@@ -5787,6 +5870,8 @@ builtin_builder::create_builtins()
 #undef FIU2_MIXED
 }
 
+#undef add_function
+
 void
 builtin_builder::add_function(const char *name, ...)
 {
@@ -5857,6 +5942,9 @@ builtin_builder::add_image_function(const char *name,
       &glsl_type_builtin_uimage2DMSArray
    };
 
+   if (!want_function(name))
+      return;
+
    ir_function *f = new(mem_ctx) ir_function(name);
 
    for (unsigned i = 0; i < ARRAY_SIZE(types); ++i) {
@@ -7573,8 +7661,7 @@ builtin_builder::_is_sparse_texels_resident(void)
    MAKE_SIG(&glsl_type_builtin_bool, sparse_enabled, 1, code);
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_bool, "retval");
-   ir_function *f =
-      shader->symbols->get_function("__intrinsic_is_sparse_texels_resident");
+   ir_function *f = get_function("__intrinsic_is_sparse_texels_resident");
 
    body.emit(call(f, retval, sig->parameters));
    body.emit(ret(retval));
@@ -8425,7 +8512,7 @@ builtin_builder::_atomic_counter_op(const char *intrinsic,
    MAKE_SIG(&glsl_type_builtin_uint, avail, 1, counter);
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_uint, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8455,8 +8542,7 @@ builtin_builder::_atomic_counter_op1(const char *intrinsic,
       parameters.push_tail(new(mem_ctx) ir_dereference_variable(counter));
       parameters.push_tail(new(mem_ctx) ir_dereference_variable(neg_data));
 
-      ir_function *const func =
-         shader->symbols->get_function("__intrinsic_atomic_add");
+      ir_function *const func = get_function("__intrinsic_atomic_add");
       ir_instruction *const c = call(func, retval, parameters);
 
       assert(c != NULL);
@@ -8464,7 +8550,7 @@ builtin_builder::_atomic_counter_op1(const char *intrinsic,
 
       body.emit(c);
    } else {
-      body.emit(call(shader->symbols->get_function(intrinsic), retval,
+      body.emit(call(get_function(intrinsic), retval,
                      sig->parameters));
    }
 
@@ -8482,7 +8568,7 @@ builtin_builder::_atomic_counter_op2(const char *intrinsic,
    MAKE_SIG(&glsl_type_builtin_uint, avail, 3, counter, compare, data);
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_uint, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8500,7 +8586,7 @@ builtin_builder::_atomic_op2(const char *intrinsic,
    atomic->data.implicit_conversion_prohibited = true;
 
    ir_variable *retval = body.make_temp(type, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8519,7 +8605,7 @@ builtin_builder::_atomic_op3(const char *intrinsic,
    atomic->data.implicit_conversion_prohibited = true;
 
    ir_variable *retval = body.make_temp(type, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8737,7 +8823,7 @@ builtin_builder::_image(image_prototype_ctr prototype,
 
    if (flags & IMAGE_FUNCTION_EMIT_STUB) {
       ir_factory body(&sig->body, mem_ctx);
-      ir_function *f = shader->symbols->get_function(intrinsic_name);
+      ir_function *f = get_function(intrinsic_name);
 
       if (flags & IMAGE_FUNCTION_RETURNS_VOID) {
          body.emit(call(f, NULL, sig->parameters));
@@ -8794,7 +8880,7 @@ builtin_builder::_memory_barrier(const char *intrinsic_name,
                                  builtin_available_predicate avail)
 {
    MAKE_SIG(&glsl_type_builtin_void, avail, 0);
-   body.emit(call(shader->symbols->get_function(intrinsic_name),
+   body.emit(call(get_function(intrinsic_name),
                   NULL, sig->parameters));
    return sig;
 }
@@ -8816,7 +8902,7 @@ builtin_builder::_ballot()
    MAKE_SIG(&glsl_type_builtin_uint64_t, shader_ballot, 1, value);
    ir_variable *retval = body.make_temp(&glsl_type_builtin_uint64_t, "retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_ballot"),
+   body.emit(call(get_function("__intrinsic_ballot"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8839,7 +8925,7 @@ builtin_builder::_read_first_invocation(const glsl_type *type)
    MAKE_SIG(type, shader_ballot, 1, value);
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_read_first_invocation"),
+   body.emit(call(get_function("__intrinsic_read_first_invocation"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8864,7 +8950,7 @@ builtin_builder::_read_invocation(const glsl_type *type)
    MAKE_SIG(type, shader_ballot, 2, value, invocation);
    ir_variable *retval = body.make_temp(type, "retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_read_invocation"),
+   body.emit(call(get_function("__intrinsic_read_invocation"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8883,7 +8969,7 @@ builtin_builder::_invocation_interlock(const char *intrinsic_name,
                                        builtin_available_predicate avail)
 {
    MAKE_SIG(&glsl_type_builtin_void, avail, 0);
-   body.emit(call(shader->symbols->get_function(intrinsic_name),
+   body.emit(call(get_function(intrinsic_name),
                   NULL, sig->parameters));
    return sig;
 }
@@ -8904,7 +8990,7 @@ builtin_builder::_shader_clock(builtin_available_predicate avail,
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_uvec2, "clock_retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_shader_clock"),
+   body.emit(call(get_function("__intrinsic_shader_clock"),
                   retval, sig->parameters));
 
    if (type == &glsl_type_builtin_uint64_t) {
@@ -8935,7 +9021,7 @@ builtin_builder::_vote(const char *intrinsic_name,
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_bool, "retval");
 
-   body.emit(call(shader->symbols->get_function(intrinsic_name),
+   body.emit(call(get_function(intrinsic_name),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -8956,7 +9042,7 @@ builtin_builder::_helper_invocation()
 
    ir_variable *retval = body.make_temp(&glsl_type_builtin_bool, "retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_helper_invocation"),
+   body.emit(call(get_function("__intrinsic_helper_invocation"),
                   retval, sig->parameters));
    body.emit(ret(retval));
 
@@ -9012,7 +9098,7 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    ir_function *f;
    bool ret = false;
    simple_mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
+   f = builtins.get_function(name);
    if (f != NULL) {
       foreach_in_list(ir_function_signature, sig, &f->signatures) {
          if (sig->is_builtin_available(state)) {
@@ -9026,10 +9112,25 @@ _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state, const char *name)
    return ret;
 }
 
-gl_shader *
-_mesa_glsl_get_builtin_function_shader()
+ir_function *
+_mesa_glsl_get_builtin_function(const char *name)
 {
-   return builtins.shader;
+   ir_function *f;
+   simple_mtx_lock(&builtins_lock);
+   f = builtins.get_function(name);
+   simple_mtx_unlock(&builtins_lock);
+
+   return f;
+}
+
+void
+_mesa_glsl_foreach_builtin_function(void (*callback)(ir_function *f,
+                                                     void *data),
+                                    void *data)
+{
+   simple_mtx_lock(&builtins_lock);
+   builtins.foreach_function(callback, data);
+   simple_mtx_unlock(&builtins_lock);
 }
 
 
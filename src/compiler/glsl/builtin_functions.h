@@ -48,8 +48,18 @@ extern bool
 _mesa_glsl_has_builtin_function(_mesa_glsl_parse_state *state,
                                 const char *name);
 
-extern gl_shader *
-_mesa_glsl_get_builtin_function_shader(void);
+extern ir_function *
+_mesa_glsl_get_builtin_function(const char *name);
+
+/**
+ * Call \p callback for every built-in function, generating the ones that
+ * weren't yet.  The built-ins lock is held, so \p callback must not use the
+ * functions above.
+ */
+extern void
+_mesa_glsl_foreach_builtin_function(void (*callback)(ir_function *f,
+                                                     void *data),
+                                    void *data);
 
 extern ir_function_signature *
 _mesa_get_main_function_signature(glsl_symbol_table *symbols);
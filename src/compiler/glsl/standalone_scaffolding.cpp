@@ -113,6 +113,7 @@ _mesa_new_shader(GLuint name, gl_shader_stage stage)
       shader->Stage = stage;
       shader->Name = name;
       shader->RefCount = 1;
+      util_queue_fence_init(&shader->compile_fence);
    }
    return shader;
 }
@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <ctype.h>
+#include <stdlib.h>
+
+#include "ir.h"
+#include "glsl_symbol_table.h"
+#include "builtin_functions.h"
+#include "util/memstream.h"
+
+typedef std::map<std::string, std::string> function_map;
+
+/**
+ * The printer makes clashing variable names unique with a global counter,
+ * number them from the start of each function instead.
+ */
+static std::string
+renumber_variables(const std::string &ir)
+{
+   std::map<std::string, unsigned> ids;
+   std::string out;
+   size_t pos = 0, at;
+
+   while ((at = ir.find('@', pos)) != std::string::npos) {
+      size_t end = at + 1;
+
+      while (end < ir.size() && isdigit(ir[end]))
+         end++;
+
+      out += ir.substr(pos, end - pos);
+      if (end > at + 1) {
+         std::string n = ir.substr(at + 1, end - at - 1);
+
+         out.resize(out.size() - n.size());
+         out += std::to_string(ids.emplace(n, ids.size()).first->second);
+      }
+      pos = end;
+   }
+
+   return out + ir.substr(pos);
+}
+
+static void
+print_function(ir_function *f, void *data)
+{
+   function_map *functions = (function_map *) data;
+   struct u_memstream mem;
+   char *buf = NULL;
+   size_t size = 0;
+
+   ASSERT_NE(f, nullptr);
+   ASSERT_TRUE(u_memstream_open(&mem, &buf, &size));
+   f->fprint(u_memstream_get(&mem));
+   u_memstream_close(&mem);
+
+   (*functions)[f->name] = renumber_variables(std::string(buf, size));
+   free(buf);
+}
+
+static void
+print_builtin_functions(bool eager, function_map *functions)
+{
+#ifdef _WIN32
+   _putenv(eager ? "GLSL_EAGER_BUILTINS=true" : "GLSL_EAGER_BUILTINS=");
+#else
+   if (eager)
+      setenv("GLSL_EAGER_BUILTINS", "true", 1);
+   else
+      unsetenv("GLSL_EAGER_BUILTINS");
+#endif
+
+   _mesa_glsl_builtin_functions_init_or_ref();
+   _mesa_glsl_foreach_builtin_function(print_function, functions);
+   _mesa_glsl_builtin_functions_decref();
+}
+
+/*
+ * Built-in functions are generated on first use, in whatever order shaders
+ * happen to call them, pulling in the intrinsics they call as needed.  They
+ * must come out the same as when all of them are generated at once.
+ */
+TEST(builtin_functions, lazy_matches_eager)
+{
+   function_map eager, lazy;
+
+   /* Anonymous structs are printed by address, keep the same ones around. */
+   glsl_type_singleton_init_or_ref();
+
+   print_builtin_functions(true, &eager);
+   print_builtin_functions(false, &lazy);
+
+   glsl_type_singleton_decref();
+
+   ASSERT_FALSE(eager.empty());
+   EXPECT_EQ(eager.size(), lazy.size());
+
+   for (const auto &f : eager) {
+      auto it = lazy.find(f.first);
+
+      ASSERT_NE(it, lazy.end()) << f.first << " wasn't generated lazily";
+      EXPECT_EQ(f.second, it->second) << f.first;
+   }
+}
@@ -201,6 +201,7 @@ nir_shader_create(void *mem_ctx,
 #ifndef NDEBUG
    nir_process_debug_variable();
 #endif
+   nir_pass_profile_init();
 
    exec_list_make_empty(&shader->variables);
 
@@ -602,6 +603,7 @@ nir_block_create(nir_shader *shader)
     * opt.  Do any of the references not need dominance metadata?
     */
    block->dom_frontier = _mesa_pointer_set_create(block);
+   block->dirty_passes = nir_dirty_pass_all;
 
    exec_list_make_empty(&block->instr_list);
 
@@ -864,6 +866,7 @@ nir_phi_instr_add_src(nir_phi_instr *instr, nir_block *pred, nir_def *src)
    phi_src->pred = pred;
    phi_src->src = nir_src_for_ssa(src);
    nir_src_set_parent_instr(&phi_src->src, &instr->instr);
+   nir_block_mark_dirty(instr->instr.block);
    exec_list_push_tail(&instr->srcs, &phi_src->node);
 
    return phi_src;
@@ -1116,10 +1119,20 @@ nir_instr_insert(nir_cursor cursor, nir_instr *instr)
    if (instr->type == nir_instr_type_jump)
       nir_handle_add_jump(instr->block);
 
+   nir_block_mark_dirty(instr->block);
+
    nir_function_impl *impl = nir_cf_node_get_function(&instr->block->cf_node);
    impl->valid_metadata &= ~nir_metadata_instr_index;
 }
 
+/* The condition of an if belongs to the block preceding it. */
+void
+nir_if_mark_dirty(nir_if *nif)
+{
+   if (nif->cf_node.node.prev)
+      nir_block_mark_dirty(nir_cf_node_as_block(nir_cf_node_prev(&nif->cf_node)));
+}
+
 bool
 nir_instr_move(nir_cursor cursor, nir_instr *instr)
 {
@@ -1162,6 +1175,7 @@ remove_defs_uses(nir_instr *instr)
 void
 nir_instr_remove_v(nir_instr *instr)
 {
+   nir_block_mark_dirty(instr->block);
    remove_defs_uses(instr);
    exec_node_remove(&instr->node);
 
@@ -2991,6 +2991,11 @@ typedef struct nir_block {
     */
    bool divergent;
 
+   /** Passes that haven't looked at this block since it last changed, a mask
+    * of nir_dirty_pass.  Only valid with nir_metadata_dirty_blocks.
+    */
+   uint8_t dirty_passes;
+
    /*
     * Each block can only have up to 2 successors, so we put them in a simple
     * array - no need for anything more complicated.
@@ -3357,6 +3362,19 @@ typedef enum {
     */
    nir_metadata_instr_index = 0x20,
 
+   /** Indicates that nir_block::dirty_passes is valid.
+    *
+    * Every block that changed since an incremental pass last ran on it has
+    * that pass's nir_dirty_pass bit set, so the pass can skip all other
+    * blocks.  nir_instr_insert(), nir_instr_remove(), nir_src_rewrite() and
+    * everything built on top of them mark the blocks they touch.
+    *
+    * A pass can preserve this metadata type if it doesn't touch the CFG and
+    * only modifies instructions through those helpers or marks the blocks
+    * itself with nir_block_mark_dirty().
+    */
+   nir_metadata_dirty_blocks = 0x40,
+
    /** All control flow metadata
     *
     * This includes all metadata preserved by a pass that preserves control flow
@@ -3380,6 +3398,16 @@ typedef enum {
 } nir_metadata;
 MESA_DEFINE_CPP_ENUM_BITFIELD_OPERATORS(nir_metadata)
 
+/** Passes that only revisit blocks changed since they last ran, see
+ * nir_metadata_dirty_blocks.
+ */
+typedef enum {
+   nir_dirty_pass_copy_prop = 0x1,
+   nir_dirty_pass_constant_folding = 0x2,
+
+   nir_dirty_pass_all = 0xff,
+} nir_dirty_pass;
+
 typedef struct {
    nir_cf_node cf_node;
 
@@ -4861,11 +4889,24 @@ bool nir_src_is_always_uniform(nir_src src);
 bool nir_srcs_equal(nir_src src1, nir_src src2);
 bool nir_instrs_equal(const nir_instr *instr1, const nir_instr *instr2);
 
+static inline void
+nir_block_mark_dirty(nir_block *block)
+{
+   if (block)
+      block->dirty_passes = nir_dirty_pass_all;
+}
+
+void nir_if_mark_dirty(nir_if *nif);
+
 static inline void
 nir_src_rewrite(nir_src *src, nir_def *new_ssa)
 {
    assert(src->ssa);
    assert(nir_src_is_if(src) ? (nir_src_parent_if(src) != NULL) : (nir_src_parent_instr(src) != NULL));
+   if (nir_src_is_if(src))
+      nir_if_mark_dirty(nir_src_parent_if(src));
+   else
+      nir_block_mark_dirty(nir_src_parent_instr(src)->block);
    list_del(&src->use_link);
    src->ssa = new_ssa;
    list_addtail(&src->use_link, &new_ssa->uses);
@@ -5155,6 +5196,44 @@ should_print_nir(UNUSED nir_shader *shader)
 }
 #endif /* NDEBUG */
 
+/*
+ * Per-pass profiling, enabled with NIR_PASS_PROFILE=<file>, see
+ * nir_pass_profile.c.
+ */
+extern bool nir_pass_profile_enabled;
+
+struct nir_pass_profile_state {
+   uint64_t start;
+   unsigned instrs;
+};
+
+void nir_pass_profile_init(void);
+void nir_pass_profile_print(FILE *f);
+void _nir_pass_profile_begin(struct nir_pass_profile_state *state,
+                             const nir_shader *shader);
+void _nir_pass_profile_end(struct nir_pass_profile_state *state,
+                           const nir_shader *shader, const char *pass,
+                           int progress);
+
+static inline void
+nir_pass_profile_begin(struct nir_pass_profile_state *state,
+                       const nir_shader *shader)
+{
+   state->start = 0;
+   if (unlikely(nir_pass_profile_enabled))
+      _nir_pass_profile_begin(state, shader);
+}
+
+/* progress is 1 or 0 for NIR_PASS, -1 if unknown (NIR_PASS_V) */
+static inline void
+nir_pass_profile_end(struct nir_pass_profile_state *state,
+                     const nir_shader *shader, const char *pass,
+                     int progress)
+{
+   if (unlikely(state->start))
+      _nir_pass_profile_end(state, shader, pass, progress);
+}
+
 #define _PASS(pass, nir, do_pass)                                       \
    do {                                                                 \
       if (should_skip_nir(#pass)) {                                     \
@@ -5172,10 +5251,14 @@ should_print_nir(UNUSED nir_shader *shader)
    } while (0)
 
 #define NIR_PASS(progress, nir, pass, ...) _PASS(pass, nir, {   \
+   struct nir_pass_profile_state _profile;                      \
    nir_metadata_set_validation_flag(nir);                       \
    if (should_print_nir(nir))                                   \
       printf("%s\n", #pass);                                    \
-   if (pass(nir, ##__VA_ARGS__)) {                              \
+   nir_pass_profile_begin(&_profile, nir);                      \
+   bool _pass_progress = pass(nir, ##__VA_ARGS__);              \
+   nir_pass_profile_end(&_profile, nir, #pass, _pass_progress); \
+   if (_pass_progress) {                                        \
       nir_validate_shader(nir, "after " #pass " in " __FILE__); \
       UNUSED bool _;                                            \
       progress = true;                                          \
@@ -5186,9 +5269,12 @@ should_print_nir(UNUSED nir_shader *shader)
 })
 
 #define NIR_PASS_V(nir, pass, ...) _PASS(pass, nir, {        \
+   struct nir_pass_profile_state _profile;                   \
    if (should_print_nir(nir))                                \
       printf("%s\n", #pass);                                 \
+   nir_pass_profile_begin(&_profile, nir);                   \
    pass(nir, ##__VA_ARGS__);                                 \
+   nir_pass_profile_end(&_profile, nir, #pass, -1);          \
    nir_validate_shader(nir, "after " #pass " in " __FILE__); \
    if (should_print_nir(nir))                                \
       nir_print_shader(nir, stdout);                         \
@@ -6711,6 +6797,11 @@ bool nir_opt_ray_query_ranges(nir_shader *shader);
 bool nir_opt_reuse_constants(nir_shader *shader);
 
 void nir_sweep(nir_shader *shader);
+void nir_compact(nir_shader *shader);
+
+typedef bool (*nir_shader_pass_cb)(nir_shader *shader, void *data);
+bool nir_shader_parallel_impl_pass(nir_shader *shader, nir_shader_pass_cb cb,
+                                   void *data);
 
 void nir_remap_dual_slot_attributes(nir_shader *shader,
                                     uint64_t *dual_slot_inputs);
@@ -40,6 +40,10 @@ nir_metadata_require(nir_function_impl *impl, nir_metadata required, ...)
       nir_calc_dominance_impl(impl);
    if (NEEDS_UPDATE(nir_metadata_live_defs))
       nir_live_defs_impl(impl);
+   if (NEEDS_UPDATE(nir_metadata_dirty_blocks)) {
+      nir_foreach_block(block, impl)
+         block->dirty_passes = nir_dirty_pass_all;
+   }
    if (NEEDS_UPDATE(nir_metadata_loop_analysis)) {
       va_list ap;
       va_start(ap, required);
@@ -401,6 +401,24 @@ try_fold_instr(nir_builder *b, nir_instr *instr, void *_state)
    }
 }
 
+/* Whether any load_constant is left, e.g. in blocks that weren't visited. */
+static bool
+shader_has_load_constant(nir_shader *shader)
+{
+   nir_foreach_function_impl(impl, shader) {
+      nir_foreach_block(block, impl) {
+         nir_foreach_instr(instr, block) {
+            if (instr->type == nir_instr_type_intrinsic &&
+                nir_instr_as_intrinsic(instr)->intrinsic ==
+                   nir_intrinsic_load_constant)
+               return true;
+         }
+      }
+   }
+
+   return false;
+}
+
 bool
 nir_opt_constant_folding(nir_shader *shader)
 {
@@ -408,15 +426,53 @@ nir_opt_constant_folding(nir_shader *shader)
    state.has_load_constant = false;
    state.has_indirect_load_const = false;
 
-   bool progress = nir_shader_instructions_pass(shader, try_fold_instr,
-                                                nir_metadata_control_flow,
-                                                &state);
+   bool progress = false;
+   bool visited_all = true;
+
+   nir_foreach_function_impl(impl, shader) {
+      nir_builder b = nir_builder_create(impl);
+      bool impl_progress = false;
+
+      /* Folding only depends on the instruction and its sources.  Whenever
+       * a source is replaced by a constant the user's block is marked, so
+       * blocks that didn't change since the last run have nothing to fold.
+       */
+      nir_metadata_require(impl, nir_metadata_dirty_blocks);
+
+      nir_foreach_block(block, impl) {
+         if (!(block->dirty_passes & nir_dirty_pass_constant_folding)) {
+            visited_all = false;
+            continue;
+         }
+
+         block->dirty_passes &= ~nir_dirty_pass_constant_folding;
+
+         nir_foreach_instr_safe(instr, block) {
+            if (try_fold_instr(&b, instr, &state)) {
+               /* Some folds modify the instruction in place. */
+               nir_block_mark_dirty(block);
+               impl_progress = true;
+            }
+         }
+      }
+
+      if (impl_progress) {
+         nir_metadata_preserve(impl, nir_metadata_control_flow |
+                                     nir_metadata_dirty_blocks);
+         progress = true;
+      } else {
+         nir_metadata_preserve(impl, nir_metadata_all);
+      }
+   }
 
    /* This doesn't free the constant data if there are no constant loads because
-    * the data might still be used but the loads have been lowered to load_ubo
+    * the data might still be used but the loads have been lowered to load_ubo.
+    * Skipped blocks may still contain loads, so look for them once the
+    * visited blocks folded theirs.
     */
    if (state.has_load_constant && !state.has_indirect_load_const &&
-       shader->constant_data_size) {
+       shader->constant_data_size &&
+       (visited_all || !shader_has_load_constant(shader))) {
       ralloc_free(shader->constant_data);
       shader->constant_data = NULL;
       shader->constant_data_size = 0;
@@ -27,6 +27,7 @@
 
 #include "nir.h"
 #include "nir_builder.h"
+#include "util/u_dynarray.h"
 
 /**
  * SSA-based copy propagation
@@ -56,8 +57,26 @@ is_swizzleless_move(nir_alu_instr *instr)
    return true;
 }
 
+struct copy_list {
+   struct util_dynarray instrs;
+   struct set *seen;
+};
+
+static void
+add_copy(struct copy_list *copies, nir_instr *instr)
+{
+   if (instr->type != nir_instr_type_alu ||
+       !nir_op_is_vec_or_mov(nir_instr_as_alu(instr)->op))
+      return;
+
+   bool found;
+   _mesa_set_search_or_add(copies->seen, instr, &found);
+   if (!found)
+      util_dynarray_append(&copies->instrs, nir_instr *, instr);
+}
+
 static bool
-rewrite_to_vec(nir_alu_instr *mov, nir_alu_instr *vec)
+rewrite_to_vec(nir_alu_instr *mov, nir_alu_instr *vec, struct copy_list *copies)
 {
    if (mov->op != nir_op_mov)
       return false;
@@ -71,6 +90,7 @@ rewrite_to_vec(nir_alu_instr *mov, nir_alu_instr *vec)
 
    nir_def *new = nir_builder_alu_instr_finish_and_insert(&b, new_vec);
    nir_def_rewrite_uses(&mov->def, new);
+   add_copy(copies, &new_vec->instr);
 
    /* If we remove "mov" and it's the next instruction in the
     * nir_foreach_instr_safe() loop, then we would end copy-propagation early. */
@@ -79,7 +99,8 @@ rewrite_to_vec(nir_alu_instr *mov, nir_alu_instr *vec)
 }
 
 static bool
-copy_propagate_alu(nir_alu_src *src, nir_alu_instr *copy)
+copy_propagate_alu(nir_alu_src *src, nir_alu_instr *copy,
+                   struct copy_list *copies)
 {
    nir_def *def = NULL;
    nir_alu_instr *user = nir_instr_as_alu(nir_src_parent_instr(&src->src));
@@ -97,7 +118,7 @@ copy_propagate_alu(nir_alu_src *src, nir_alu_instr *copy)
 
       for (unsigned i = 1; i < num_comp; i++) {
          if (copy->src[src->swizzle[i]].src.ssa != def)
-            return rewrite_to_vec(user, copy);
+            return rewrite_to_vec(user, copy, copies);
       }
 
       for (unsigned i = 0; i < num_comp; i++)
@@ -121,7 +142,7 @@ copy_propagate(nir_src *src, nir_alu_instr *copy)
 }
 
 static bool
-copy_prop_instr(nir_instr *instr)
+copy_prop_instr(nir_instr *instr, struct copy_list *copies)
 {
    if (instr->type != nir_instr_type_alu)
       return false;
@@ -135,7 +156,8 @@ copy_prop_instr(nir_instr *instr)
 
    nir_foreach_use_including_if_safe(src, &mov->def) {
       if (!nir_src_is_if(src) && nir_src_parent_instr(src)->type == nir_instr_type_alu)
-         progress |= copy_propagate_alu(container_of(src, nir_alu_src, src), mov);
+         progress |= copy_propagate_alu(container_of(src, nir_alu_src, src), mov,
+                                        copies);
       else
          progress |= copy_propagate(src, mov);
    }
@@ -146,19 +168,58 @@ copy_prop_instr(nir_instr *instr)
    return progress;
 }
 
+static bool
+add_src_copy(nir_src *src, void *copies)
+{
+   add_copy(copies, src->ssa->parent_instr);
+   return true;
+}
+
+/* A copy that still has something to propagate is either new itself or
+ * has a new use, so only the blocks changed since the last run need to be
+ * looked at.
+ */
 bool
 nir_copy_prop_impl(nir_function_impl *impl)
 {
    bool progress = false;
+   struct copy_list copies;
+   util_dynarray_init(&copies.instrs, NULL);
+   copies.seen = _mesa_pointer_set_create(NULL);
+
+   nir_metadata_require(impl, nir_metadata_dirty_blocks);
 
    nir_foreach_block(block, impl) {
-      nir_foreach_instr_safe(instr, block) {
-         progress |= copy_prop_instr(instr);
+      if (!(block->dirty_passes & nir_dirty_pass_copy_prop))
+         continue;
+
+      block->dirty_passes &= ~nir_dirty_pass_copy_prop;
+
+      nir_foreach_instr(instr, block) {
+         nir_foreach_src(instr, add_src_copy, &copies);
+         add_copy(&copies, instr);
       }
+
+      nir_if *nif = nir_block_get_following_if(block);
+      if (nif)
+         add_copy(&copies, nif->condition.ssa->parent_instr);
+   }
+
+   /* Propagating removes copies, so only start once they're all collected.
+    * New vecs are appended while propagating.
+    */
+   for (unsigned i = 0;
+        i < util_dynarray_num_elements(&copies.instrs, nir_instr *); i++) {
+      nir_instr *instr = *util_dynarray_element(&copies.instrs, nir_instr *, i);
+      progress |= copy_prop_instr(instr, &copies);
    }
 
+   _mesa_set_destroy(copies.seen, NULL);
+   util_dynarray_fini(&copies.instrs);
+
    if (progress) {
-      nir_metadata_preserve(impl, nir_metadata_control_flow);
+      nir_metadata_preserve(impl, nir_metadata_control_flow |
+                                  nir_metadata_dirty_blocks);
    } else {
       nir_metadata_preserve(impl, nir_metadata_all);
    }
@@ -238,7 +238,8 @@ nir_opt_dce_impl(nir_function_impl *impl)
    nir_instr_free_list(&dead_instrs);
 
    if (progress) {
-      nir_metadata_preserve(impl, nir_metadata_control_flow);
+      nir_metadata_preserve(impl, nir_metadata_control_flow |
+                                  nir_metadata_dirty_blocks);
    } else {
       nir_metadata_preserve(impl, nir_metadata_all);
    }
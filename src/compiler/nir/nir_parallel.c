@@ -0,0 +1,208 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Running function-local passes on several function impls at once.
+ *
+ * Every impl is cloned into a proxy shader of its own, which shares the
+ * options and info of the real shader but has its own memory contexts and
+ * copies of the global variables, so nothing that a pass touches is shared
+ * between threads.  Once all of them are done, the impls that made progress
+ * are pointed back at the real variables, replace the original impls and
+ * their memory is handed over to the real shader.
+ */
+
+#include "util/hash_table.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
+#include "util/u_queue.h"
+#include "util/u_thread.h"
+#include "nir.h"
+
+struct impl_job {
+   nir_shader *shader;
+   nir_function *func;
+   nir_shader_pass_cb cb;
+   void *data;
+
+   nir_shader *proxy;
+   nir_function *proxy_func;
+   struct hash_table *proxy_vars;
+   bool progress;
+
+   struct util_queue_fence fence;
+};
+
+static struct util_queue nir_parallel_queue;
+static bool nir_parallel_queue_ready;
+static __THREAD_INITIAL_EXEC bool in_nir_parallel_job;
+
+static void
+nir_parallel_queue_init_once(void)
+{
+   unsigned num_threads = debug_get_num_option("NIR_PARALLEL_THREADS",
+                                               util_get_cpu_caps()->nr_cpus);
+   if (num_threads < 2)
+      return;
+
+   nir_parallel_queue_ready =
+      util_queue_init(&nir_parallel_queue, "nir_opt", 64, num_threads,
+                      UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL);
+}
+
+static void
+remap_deref_vars(nir_function_impl *impl, struct hash_table *remap)
+{
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block) {
+         if (instr->type != nir_instr_type_deref)
+            continue;
+
+         nir_deref_instr *deref = nir_instr_as_deref(instr);
+         if (deref->deref_type != nir_deref_type_var)
+            continue;
+
+         struct hash_entry *entry = _mesa_hash_table_search(remap, deref->var);
+         if (entry)
+            deref->var = entry->data;
+      }
+   }
+}
+
+static void
+impl_job_execute(void *data, void *gdata, int thread_index)
+{
+   struct impl_job *job = data;
+   nir_shader *shader = job->shader;
+
+   /* Constant data is copied because constant folding may free it. */
+   nir_shader *proxy = ralloc(NULL, nir_shader);
+   memcpy(proxy, shader, sizeof(*proxy));
+   proxy->gctx = gc_context(proxy);
+   if (shader->constant_data_size) {
+      proxy->constant_data = ralloc_memdup(proxy, shader->constant_data,
+                                           shader->constant_data_size);
+   }
+
+   /* Both ways, so the impl can be pointed back at the real variables. */
+   struct hash_table *to_proxy = _mesa_pointer_hash_table_create(proxy);
+   struct hash_table *from_proxy = _mesa_pointer_hash_table_create(proxy);
+   exec_list_make_empty(&proxy->variables);
+   nir_foreach_variable_in_shader(var, shader) {
+      nir_variable *nvar = nir_variable_clone(var, proxy);
+      exec_list_push_tail(&proxy->variables, &nvar->node);
+      _mesa_hash_table_insert(to_proxy, var, nvar);
+      _mesa_hash_table_insert(from_proxy, nvar, var);
+   }
+
+   nir_function *func = ralloc(proxy, nir_function);
+   memcpy(func, job->func, sizeof(*func));
+   func->shader = proxy;
+   exec_list_make_empty(&proxy->functions);
+   exec_list_push_tail(&proxy->functions, &func->node);
+   nir_function_set_impl(func, nir_function_impl_clone(proxy, job->func->impl));
+   remap_deref_vars(func->impl, to_proxy);
+   _mesa_hash_table_destroy(to_proxy, NULL);
+
+   in_nir_parallel_job = true;
+   job->progress = job->cb(proxy, job->data);
+   in_nir_parallel_job = false;
+
+   job->proxy = proxy;
+   job->proxy_func = func;
+   job->proxy_vars = from_proxy;
+}
+
+/**
+ * Calls \p cb once for every function impl of \p shader, each time with a
+ * shader that only contains that one impl, on as many threads as there are
+ * CPUs or as NIR_PARALLEL_THREADS says.
+ *
+ * \p cb may only run passes that are local to the impl: they can read the
+ * shader's variables, info and constant data but must not add or remove
+ * global variables, and must not look at other functions.  Changes to
+ * shader-level state are lost.  \p cb is also called from several threads
+ * at once, so \p data must only be read.
+ *
+ * Falls back to calling \p cb on the whole shader when there is nothing to
+ * parallelize or when NIR_DEBUG clones or serializes shaders between
+ * passes.  Returns whether \p cb returned true for any impl.
+ */
+bool
+nir_shader_parallel_impl_pass(nir_shader *shader, nir_shader_pass_cb cb,
+                              void *data)
+{
+   static once_flag flag = ONCE_FLAG_INIT;
+   call_once(&flag, nir_parallel_queue_init_once);
+
+   unsigned num_impls = 0;
+   bool structured = true;
+   nir_foreach_function_impl(impl, shader) {
+      structured &= impl->structured;
+      num_impls++;
+   }
+
+   if (num_impls < 2 || !structured || !nir_parallel_queue_ready ||
+       in_nir_parallel_job || NIR_DEBUG(CLONE) || NIR_DEBUG(SERIALIZE))
+      return cb(shader, data);
+
+   struct impl_job *jobs = calloc(num_impls, sizeof(*jobs));
+   if (!jobs)
+      return cb(shader, data);
+
+   unsigned i = 0;
+   nir_foreach_function_with_impl(func, impl, shader) {
+      struct impl_job *job = &jobs[i++];
+      job->shader = shader;
+      job->func = func;
+      job->cb = cb;
+      job->data = data;
+      util_queue_fence_init(&job->fence);
+      util_queue_add_job(&nir_parallel_queue, job, &job->fence,
+                         impl_job_execute, NULL, 0);
+   }
+
+   /* Jobs still clone from the original impls, so wait for all of them
+    * before replacing any.
+    */
+   for (i = 0; i < num_impls; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+
+   bool progress = false;
+   for (i = 0; i < num_impls; i++) {
+      struct impl_job *job = &jobs[i];
+      nir_shader *proxy = job->proxy;
+
+      if (job->progress) {
+         remap_deref_vars(job->proxy_func->impl, job->proxy_vars);
+         nir_function_set_impl(job->func, job->proxy_func->impl);
+
+         /* Keep everything the passes allocated, but not the proxy's own
+          * copies of the shader-level data.
+          */
+         gc_adopt(shader->gctx, proxy->gctx);
+         ralloc_free(proxy->gctx);
+         ralloc_free(proxy->constant_data);
+         ralloc_free(job->proxy_func);
+         _mesa_hash_table_destroy(job->proxy_vars, NULL);
+         nir_foreach_variable_in_shader_safe(var, proxy)
+            ralloc_free(var);
+         ralloc_adopt(shader, proxy);
+         progress = true;
+      }
+
+      ralloc_free(proxy);
+   }
+
+   free(jobs);
+
+   /* Free the impls that were replaced. */
+   if (progress)
+      nir_sweep(shader);
+
+   return progress;
+}
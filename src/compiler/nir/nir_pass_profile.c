@@ -0,0 +1,213 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Per-pass compile time profiling for NIR_PASS and friends.
+ *
+ * Setting NIR_PASS_PROFILE=<file> makes every NIR_PASS/NIR_PASS_V record
+ * its wall time, whether it made progress and how the instruction count
+ * changed.  The numbers are aggregated per pass and shader stage across
+ * the whole process and written to <file> as JSON at exit.
+ *
+ * Passes are identified by the name used at the NIR_PASS call site, so
+ * passes invoked through function pointers show up under that name.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/hash_table.h"
+#include "util/os_time.h"
+#include "util/simple_mtx.h"
+#include "util/u_debug.h"
+#include "nir.h"
+
+bool nir_pass_profile_enabled = false;
+
+struct pass_profile_stats {
+   uint64_t invocations;
+   /* NIR_PASS_V doesn't report progress, so neither of these count it */
+   uint64_t progress;
+   uint64_t no_progress;
+   uint64_t time_ns;
+   int64_t instr_delta;
+};
+
+struct pass_profile {
+   const char *name;
+   struct pass_profile_stats stages[MESA_SHADER_KERNEL + 1];
+};
+
+static const char *profile_path;
+static simple_mtx_t profile_mtx = SIMPLE_MTX_INITIALIZER;
+static struct hash_table *profile_passes;
+
+static unsigned
+count_instrs(const nir_shader *shader)
+{
+   unsigned count = 0;
+
+   nir_foreach_function_impl(impl, shader) {
+      nir_foreach_block(block, impl) {
+         count += exec_list_length(&block->instr_list);
+      }
+   }
+
+   return count;
+}
+
+static int
+compare_pass_time(const void *a, const void *b)
+{
+   const struct pass_profile *pa = *(const struct pass_profile **)a;
+   const struct pass_profile *pb = *(const struct pass_profile **)b;
+   uint64_t ta = 0, tb = 0;
+
+   for (unsigned i = 0; i <= MESA_SHADER_KERNEL; i++) {
+      ta += pa->stages[i].time_ns;
+      tb += pb->stages[i].time_ns;
+   }
+
+   return ta < tb ? 1 : ta > tb ? -1 : strcmp(pa->name, pb->name);
+}
+
+/**
+ * Writes the totals recorded so far to \p f as JSON.
+ */
+void
+nir_pass_profile_print(FILE *f)
+{
+   simple_mtx_lock(&profile_mtx);
+
+   /* Sort by total time so the expensive passes come first. */
+   unsigned count =
+      profile_passes ? _mesa_hash_table_num_entries(profile_passes) : 0;
+   struct pass_profile **passes = malloc(MAX2(count, 1) * sizeof(*passes));
+   if (!passes) {
+      fprintf(stderr, "NIR_PASS_PROFILE: out of memory\n");
+      goto out;
+   }
+
+   unsigned n = 0;
+   if (profile_passes) {
+      hash_table_foreach(profile_passes, entry)
+         passes[n++] = entry->data;
+   }
+   qsort(passes, n, sizeof(*passes), compare_pass_time);
+
+   fprintf(f, "{\n  \"passes\": [");
+   bool first = true;
+   for (unsigned i = 0; i < n; i++) {
+      for (unsigned stage = 0; stage <= MESA_SHADER_KERNEL; stage++) {
+         const struct pass_profile_stats *s = &passes[i]->stages[stage];
+         if (!s->invocations)
+            continue;
+
+         fprintf(f, "%s\n    { \"name\": \"%s\", \"stage\": \"%s\", "
+                 "\"invocations\": %" PRIu64 ", "
+                 "\"progress\": %" PRIu64 ", "
+                 "\"no_progress\": %" PRIu64 ", "
+                 "\"time_us\": %.3f, "
+                 "\"instr_delta\": %" PRId64 " }",
+                 first ? "" : ",", passes[i]->name,
+                 _mesa_shader_stage_to_string(stage),
+                 s->invocations, s->progress, s->no_progress,
+                 s->time_ns / 1000.0, s->instr_delta);
+         first = false;
+      }
+   }
+   fprintf(f, "\n  ]\n}\n");
+
+   free(passes);
+out:
+   simple_mtx_unlock(&profile_mtx);
+}
+
+static void
+nir_pass_profile_dump(void)
+{
+   FILE *f = fopen(profile_path, "w");
+   if (!f) {
+      fprintf(stderr, "NIR_PASS_PROFILE: can't open %s\n", profile_path);
+      return;
+   }
+
+   nir_pass_profile_print(f);
+   fclose(f);
+}
+
+static void
+nir_pass_profile_init_once(void)
+{
+   profile_path = debug_get_option("NIR_PASS_PROFILE", NULL);
+   if (!profile_path || !profile_path[0])
+      return;
+
+   atexit(nir_pass_profile_dump);
+   nir_pass_profile_enabled = true;
+}
+
+void
+nir_pass_profile_init(void)
+{
+   static once_flag flag = ONCE_FLAG_INIT;
+   call_once(&flag, nir_pass_profile_init_once);
+}
+
+void
+_nir_pass_profile_begin(struct nir_pass_profile_state *state,
+                        const nir_shader *shader)
+{
+   state->instrs = count_instrs(shader);
+   state->start = os_time_get_nano();
+}
+
+void
+_nir_pass_profile_end(struct nir_pass_profile_state *state,
+                      const nir_shader *shader, const char *pass,
+                      int progress)
+{
+   uint64_t time_ns = os_time_get_nano() - state->start;
+   int64_t instr_delta = (int64_t)count_instrs(shader) - state->instrs;
+   gl_shader_stage stage = shader->info.stage;
+
+   if (stage < 0 || stage > MESA_SHADER_KERNEL)
+      return;
+
+   simple_mtx_lock(&profile_mtx);
+
+   if (!profile_passes) {
+      profile_passes = _mesa_hash_table_create(NULL, _mesa_hash_string,
+                                               _mesa_key_string_equal);
+      if (!profile_passes)
+         goto out;
+   }
+
+   struct hash_entry *entry = _mesa_hash_table_search(profile_passes, pass);
+   struct pass_profile *profile;
+   if (entry) {
+      profile = entry->data;
+   } else {
+      profile = calloc(1, sizeof(*profile));
+      if (!profile)
+         goto out;
+      /* pass names are string literals */
+      profile->name = pass;
+      _mesa_hash_table_insert(profile_passes, profile->name, profile);
+   }
+
+   struct pass_profile_stats *s = &profile->stages[stage];
+   s->invocations++;
+   if (progress > 0)
+      s->progress++;
+   else if (progress == 0)
+      s->no_progress++;
+   s->time_ns += time_ns;
+   s->instr_delta += instr_delta;
+
+out:
+   simple_mtx_unlock(&profile_mtx);
+}
@@ -943,7 +943,8 @@ nir_algebraic_impl(nir_function_impl *impl,
    util_dynarray_fini(&states);
 
    if (progress) {
-      nir_metadata_preserve(impl, nir_metadata_control_flow);
+      nir_metadata_preserve(impl, nir_metadata_control_flow |
+                                  nir_metadata_dirty_blocks);
    } else {
       nir_metadata_preserve(impl, nir_metadata_all);
    }
@@ -71,6 +71,9 @@ typedef struct {
 
    struct blob_reader *blob;
 
+   /* The function implementation being read, for SSA def indices. */
+   nir_function_impl *impl;
+
    /* the next index to assign to a NIR in-memory object */
    uint32_t next_idx;
 
@@ -89,6 +92,36 @@ typedef struct {
    struct nir_variable_data last_var_data;
 } read_ctx;
 
+/*
+ * Inlined equivalents of blob_read_uint8/16/32() for the instruction stream,
+ * which is where nir_deserialize() spends most of its time.  They align and
+ * check for overruns the same way: once the blob overruns, reads return 0.
+ */
+#define READ_UINT(name, type)                                               \
+static inline type                                                          \
+name(read_ctx *ctx)                                                         \
+{                                                                           \
+   struct blob_reader *blob = ctx->blob;                                    \
+   const uint8_t *ptr =                                                     \
+      blob->data + align_uintptr(blob->current - blob->data, sizeof(type)); \
+   type value = 0;                                                          \
+                                                                            \
+   if (likely(!blob->overrun && ptr <= blob->end &&                         \
+              (size_t)(blob->end - ptr) >= sizeof(type))) {                 \
+      memcpy(&value, ptr, sizeof(type));                                    \
+      blob->current = ptr + sizeof(type);                                   \
+   } else {                                                                 \
+      blob->overrun = true;                                                 \
+   }                                                                        \
+   return value;                                                            \
+}
+
+READ_UINT(read_uint8, uint8_t)
+READ_UINT(read_uint16, uint16_t)
+READ_UINT(read_uint32, uint32_t)
+
+#undef READ_UINT
+
 static void
 write_add_object(write_ctx *ctx, const void *obj)
 {
@@ -122,7 +155,7 @@ read_lookup_object(read_ctx *ctx, uint32_t idx)
 static void *
 read_object(read_ctx *ctx)
 {
-   return read_lookup_object(ctx, blob_read_uint32(ctx->blob));
+   return read_lookup_object(ctx, read_uint32(ctx));
 }
 
 static uint32_t
@@ -190,7 +223,7 @@ read_constant(read_ctx *ctx, nir_variable *nvar)
    static const nir_const_value zero_vals[ARRAY_SIZE(c->values)] = { 0 };
    blob_copy_bytes(ctx->blob, (uint8_t *)c->values, sizeof(c->values));
    c->is_null_constant = memcmp(c->values, zero_vals, sizeof(c->values)) == 0;
-   c->num_elements = blob_read_uint32(ctx->blob);
+   c->num_elements = read_uint32(ctx);
    c->elements = ralloc_array(nvar, nir_constant *, c->num_elements);
    for (unsigned i = 0; i < c->num_elements; i++) {
       c->elements[i] = read_constant(ctx, nvar);
@@ -337,7 +370,7 @@ read_variable(read_ctx *ctx)
    read_add_object(ctx, var);
 
    union packed_var flags;
-   flags.u32 = blob_read_uint32(ctx->blob);
+   flags.u32 = read_uint32(ctx);
 
    if (flags.u.type_same_as_last) {
       var->type = ctx->last_type;
@@ -367,7 +400,7 @@ read_variable(read_ctx *ctx)
       ctx->last_var_data = var->data;
    } else { /* var_encode_location_diff */
       union packed_var_data_diff diff;
-      diff.u32 = blob_read_uint32(ctx->blob);
+      diff.u32 = read_uint32(ctx);
 
       var->data = ctx->last_var_data;
       var->data.location += diff.u.location;
@@ -422,7 +455,7 @@ static void
 read_var_list(read_ctx *ctx, struct exec_list *dst)
 {
    exec_list_make_empty(dst);
-   unsigned num_vars = blob_read_uint32(ctx->blob);
+   unsigned num_vars = read_uint32(ctx);
    for (unsigned i = 0; i < num_vars; i++) {
       nir_variable *var = read_variable(ctx);
       exec_list_push_tail(dst, &var->node);
@@ -470,7 +503,7 @@ read_src(read_ctx *ctx, nir_src *src)
 {
    STATIC_ASSERT(sizeof(union packed_src) == 4);
    union packed_src header;
-   header.u32 = blob_read_uint32(ctx->blob);
+   header.u32 = read_uint32(ctx);
 
    src->ssa = read_lookup_object(ctx, header.any.object_idx);
    return header;
@@ -659,11 +692,15 @@ read_def(read_ctx *ctx, nir_def *def, nir_instr *instr,
    unsigned bit_size = decode_bit_size_3bits(pdef.bit_size);
    unsigned num_components;
    if (pdef.num_components == NUM_COMPONENTS_IS_SEPARATE_7)
-      num_components = blob_read_uint32(ctx->blob);
+      num_components = read_uint32(ctx);
    else
       num_components = decode_num_components_in_3bits(pdef.num_components);
    nir_def_init(instr, def, num_components, bit_size);
    def->divergent = pdef.divergent;
+   /* Instructions are appended in order, so this is the index that
+    * nir_instr_insert() would assign without walking up to the impl.
+    */
+   def->index = ctx->impl->ssa_alloc++;
    read_add_object(ctx, def);
 }
 
@@ -774,19 +811,19 @@ read_alu(read_ctx *ctx, union packed_instr header)
    alu->no_unsigned_wrap = header.alu.no_unsigned_wrap;
 
    read_def(ctx, &alu->def, &alu->instr, header);
-   alu->fp_fast_math = blob_read_uint32(ctx->blob);
+   alu->fp_fast_math = read_uint32(ctx);
 
    if (header.alu.packed_src_ssa_16bit) {
       for (unsigned i = 0; i < num_srcs; i++) {
          nir_alu_src *src = &alu->src[i];
-         src->src.ssa = read_lookup_object(ctx, blob_read_uint16(ctx->blob));
-
-         memset(&src->swizzle, 0, sizeof(src->swizzle));
+         src->src.ssa = read_lookup_object(ctx, read_uint16(ctx));
 
+         /* nir_alu_instr_create() set identity swizzles, only clear the
+          * unused channels.
+          */
          unsigned src_components = nir_ssa_alu_instr_src_components(alu, i);
-
-         for (unsigned chan = 0; chan < src_components; chan++)
-            src->swizzle[chan] = chan;
+         memset(&src->swizzle[src_components], 0,
+                sizeof(src->swizzle) - src_components);
       }
    } else {
       for (unsigned i = 0; i < num_srcs; i++) {
@@ -805,7 +842,7 @@ read_alu(read_ctx *ctx, union packed_instr header)
          } else {
             /* Load swizzles for vec8 and vec16. */
             for (unsigned o = 0; o < src_channels; o += 8) {
-               unsigned value = blob_read_uint32(ctx->blob);
+               unsigned value = read_uint32(ctx);
 
                for (unsigned j = 0; j < 8 && o + j < src_channels; j++) {
                   alu->src[i].swizzle[o + j] =
@@ -822,6 +859,14 @@ read_alu(read_ctx *ctx, union packed_instr header)
          alu->src[1].swizzle[0] = header.alu.writemask_or_two_swizzles >> 2;
    }
 
+   /* Add the uses here rather than through nir_instr_insert(), see
+    * read_instr().
+    */
+   for (unsigned i = 0; i < num_srcs; i++) {
+      nir_src_set_parent_instr(&alu->src[i].src, &alu->instr);
+      list_addtail(&alu->src[i].src.use_link, &alu->src[i].src.ssa->uses);
+   }
+
    return alu;
 }
 
@@ -965,15 +1010,15 @@ read_deref(read_ctx *ctx, union packed_instr header)
    case nir_deref_type_struct:
       read_src(ctx, &deref->parent);
       parent = nir_src_as_deref(deref->parent);
-      deref->strct.index = blob_read_uint32(ctx->blob);
+      deref->strct.index = read_uint32(ctx);
       deref->type = glsl_get_struct_field(parent->type, deref->strct.index);
       break;
 
    case nir_deref_type_array:
    case nir_deref_type_ptr_as_array:
       if (header.deref.packed_src_ssa_16bit) {
-         deref->parent.ssa = read_lookup_object(ctx, blob_read_uint16(ctx->blob));
-         deref->arr.index.ssa = read_lookup_object(ctx, blob_read_uint16(ctx->blob));
+         deref->parent.ssa = read_lookup_object(ctx, read_uint16(ctx));
+         deref->arr.index.ssa = read_lookup_object(ctx, read_uint16(ctx));
       } else {
          read_src(ctx, &deref->parent);
          read_src(ctx, &deref->arr.index);
@@ -990,9 +1035,9 @@ read_deref(read_ctx *ctx, union packed_instr header)
 
    case nir_deref_type_cast:
       read_src(ctx, &deref->parent);
-      deref->cast.ptr_stride = blob_read_uint32(ctx->blob);
-      deref->cast.align_mul = blob_read_uint32(ctx->blob);
-      deref->cast.align_offset = blob_read_uint32(ctx->blob);
+      deref->cast.ptr_stride = read_uint32(ctx);
+      deref->cast.align_mul = read_uint32(ctx);
+      deref->cast.align_offset = read_uint32(ctx);
       if (header.deref.cast_type_same_as_last) {
          deref->type = ctx->last_type;
       } else {
@@ -1132,15 +1177,15 @@ read_intrinsic(read_ctx *ctx, union packed_instr header)
       }
       case const_indices_8bit:
          for (unsigned i = 0; i < num_indices; i++)
-            intrin->const_index[i] = blob_read_uint8(ctx->blob);
+            intrin->const_index[i] = read_uint8(ctx);
          break;
       case const_indices_16bit:
          for (unsigned i = 0; i < num_indices; i++)
-            intrin->const_index[i] = blob_read_uint16(ctx->blob);
+            intrin->const_index[i] = read_uint16(ctx);
          break;
       case const_indices_32bit:
          for (unsigned i = 0; i < num_indices; i++)
-            intrin->const_index[i] = blob_read_uint32(ctx->blob);
+            intrin->const_index[i] = read_uint32(ctx);
          break;
       }
    }
@@ -1288,18 +1333,18 @@ read_load_const(read_ctx *ctx, union packed_instr header)
 
       case 32:
          for (unsigned i = 0; i < lc->def.num_components; i++)
-            lc->value[i].u32 = blob_read_uint32(ctx->blob);
+            lc->value[i].u32 = read_uint32(ctx);
          break;
 
       case 16:
          for (unsigned i = 0; i < lc->def.num_components; i++)
-            lc->value[i].u16 = blob_read_uint16(ctx->blob);
+            lc->value[i].u16 = read_uint16(ctx);
          break;
 
       default:
          assert(lc->def.bit_size <= 8);
          for (unsigned i = 0; i < lc->def.num_components; i++)
-            lc->value[i].u8 = blob_read_uint8(ctx->blob);
+            lc->value[i].u8 = read_uint8(ctx);
          break;
       }
       break;
@@ -1411,14 +1456,14 @@ read_tex(read_ctx *ctx, union packed_instr header)
    read_def(ctx, &tex->def, &tex->instr, header);
 
    tex->op = header.tex.op;
-   tex->texture_index = blob_read_uint32(ctx->blob);
-   tex->sampler_index = blob_read_uint32(ctx->blob);
-   tex->backend_flags = blob_read_uint32(ctx->blob);
+   tex->texture_index = read_uint32(ctx);
+   tex->sampler_index = read_uint32(ctx);
+   tex->backend_flags = read_uint32(ctx);
    if (tex->op == nir_texop_tg4)
       blob_copy_bytes(ctx->blob, tex->tg4_offsets, sizeof(tex->tg4_offsets));
 
    union packed_tex_data packed;
-   packed.u32 = blob_read_uint32(ctx->blob);
+   packed.u32 = read_uint32(ctx);
    tex->sampler_dim = packed.u.sampler_dim;
    tex->dest_type = packed.u.dest_type;
    tex->coord_components = packed.u.coord_components;
@@ -1500,8 +1545,8 @@ read_phi(read_ctx *ctx, nir_block *blk, union packed_instr header)
    nir_instr_insert_after_block(blk, &phi->instr);
 
    for (unsigned i = 0; i < header.phi.num_srcs; i++) {
-      nir_def *def = (nir_def *)(uintptr_t)blob_read_uint32(ctx->blob);
-      nir_block *pred = (nir_block *)(uintptr_t)blob_read_uint32(ctx->blob);
+      nir_def *def = (nir_def *)(uintptr_t)read_uint32(ctx);
+      nir_block *pred = (nir_block *)(uintptr_t)read_uint32(ctx);
       nir_phi_src *src = nir_phi_instr_add_src(phi, pred, def);
 
       /* Since we're not letting nir_insert_instr handle use/def stuff for us,
@@ -1631,13 +1676,21 @@ read_instr(read_ctx *ctx, nir_block *block)
 {
    STATIC_ASSERT(sizeof(union packed_instr) == 4);
    union packed_instr header;
-   header.u32 = blob_read_uint32(ctx->blob);
+   header.u32 = read_uint32(ctx);
    nir_instr *instr;
 
    switch (header.any.instr_type) {
    case nir_instr_type_alu:
-      for (unsigned i = 0; i <= header.alu.num_followup_alu_sharing_header; i++)
-         nir_instr_insert_after_block(block, &read_alu(ctx, header)->instr);
+      /* ALU instructions dominate most shaders.  read_alu() already set up
+       * the uses and read_def() the def index, so append them directly.
+       */
+      assert(nir_block_last_instr(block) == NULL ||
+             nir_block_last_instr(block)->type != nir_instr_type_jump);
+      for (unsigned i = 0; i <= header.alu.num_followup_alu_sharing_header; i++) {
+         nir_instr *alu = &read_alu(ctx, header)->instr;
+         alu->block = block;
+         exec_list_push_tail(&block->instr_list, &alu->node);
+      }
       return header.alu.num_followup_alu_sharing_header + 1;
    case nir_instr_type_deref:
       instr = &read_deref(ctx, header)->instr;
@@ -1705,8 +1758,8 @@ read_block(read_ctx *ctx, struct exec_list *cf_list)
       exec_node_data(nir_block, exec_list_get_tail(cf_list), cf_node.node);
 
    read_add_object(ctx, block);
-   block->divergent = blob_read_uint8(ctx->blob);
-   unsigned num_instrs = blob_read_uint32(ctx->blob);
+   block->divergent = read_uint8(ctx);
+   unsigned num_instrs = read_uint32(ctx);
    for (unsigned i = 0; i < num_instrs;) {
       i += read_instr(ctx, block);
    }
@@ -1734,7 +1787,7 @@ read_if(read_ctx *ctx, struct exec_list *cf_list)
    nir_if *nif = nir_if_create(ctx->nir);
 
    read_src(ctx, &nif->condition);
-   nif->control = blob_read_uint8(ctx->blob);
+   nif->control = read_uint8(ctx);
 
    nir_cf_node_insert_end(cf_list, &nif->cf_node);
 
@@ -1763,9 +1816,9 @@ read_loop(read_ctx *ctx, struct exec_list *cf_list)
 
    nir_cf_node_insert_end(cf_list, &loop->cf_node);
 
-   loop->control = blob_read_uint8(ctx->blob);
-   loop->divergent = blob_read_uint8(ctx->blob);
-   bool has_continue_construct = blob_read_uint8(ctx->blob);
+   loop->control = read_uint8(ctx);
+   loop->divergent = read_uint8(ctx);
+   bool has_continue_construct = read_uint8(ctx);
 
    read_cf_list(ctx, &loop->body);
    if (has_continue_construct) {
@@ -1797,7 +1850,7 @@ write_cf_node(write_ctx *ctx, nir_cf_node *cf)
 static void
 read_cf_node(read_ctx *ctx, struct exec_list *list)
 {
-   nir_cf_node_type type = blob_read_uint32(ctx->blob);
+   nir_cf_node_type type = read_uint32(ctx);
 
    switch (type) {
    case nir_cf_node_block:
@@ -1826,7 +1879,7 @@ write_cf_list(write_ctx *ctx, const struct exec_list *cf_list)
 static void
 read_cf_list(read_ctx *ctx, struct exec_list *cf_list)
 {
-   uint32_t num_cf_nodes = blob_read_uint32(ctx->blob);
+   uint32_t num_cf_nodes = read_uint32(ctx);
    for (unsigned i = 0; i < num_cf_nodes; i++)
       read_cf_node(ctx, cf_list);
 }
@@ -1851,14 +1904,15 @@ read_function_impl(read_ctx *ctx)
 {
    nir_function_impl *fi = nir_function_impl_create_bare(ctx->nir);
 
-   fi->structured = blob_read_uint8(ctx->blob);
-   bool preamble = blob_read_uint8(ctx->blob);
+   fi->structured = read_uint8(ctx);
+   bool preamble = read_uint8(ctx);
 
    if (preamble)
       fi->preamble = read_object(ctx);
 
    read_var_list(ctx, &fi->locals);
 
+   ctx->impl = fi;
    read_cf_list(ctx, &fi->body);
    read_fixup_phis(ctx);
 
@@ -1915,25 +1969,25 @@ write_function(write_ctx *ctx, const nir_function *fxn)
 static void
 read_function(read_ctx *ctx)
 {
-   uint32_t flags = blob_read_uint32(ctx->blob);
+   uint32_t flags = read_uint32(ctx);
 
    bool has_name = flags & 0x4;
    char *name = has_name ? blob_read_string(ctx->blob) : NULL;
 
    nir_function *fxn = nir_function_create(ctx->nir, name);
 
-   fxn->subroutine_index = blob_read_uint32(ctx->blob);
-   fxn->num_subroutine_types = blob_read_uint32(ctx->blob);
+   fxn->subroutine_index = read_uint32(ctx);
+   fxn->num_subroutine_types = read_uint32(ctx);
    for (unsigned i = 0; i < fxn->num_subroutine_types; i++) {
       fxn->subroutine_types[i] = decode_type_from_blob(ctx->blob);
    }
 
    read_add_object(ctx, fxn);
 
-   fxn->num_params = blob_read_uint32(ctx->blob);
+   fxn->num_params = read_uint32(ctx);
    fxn->params = ralloc_array(fxn, nir_parameter, fxn->num_params);
    for (unsigned i = 0; i < fxn->num_params; i++) {
-      uint32_t val = blob_read_uint32(ctx->blob);
+      uint32_t val = read_uint32(ctx);
       fxn->params[i].num_components = val & 0xff;
       fxn->params[i].bit_size = (val >> 8) & 0xff;
    }
@@ -1963,7 +2017,7 @@ write_xfb_info(write_ctx *ctx, const nir_xfb_info *xfb)
 static nir_xfb_info *
 read_xfb_info(read_ctx *ctx)
 {
-   uint32_t size = blob_read_uint32(ctx->blob);
+   uint32_t size = read_uint32(ctx);
    if (size == 0)
       return NULL;
 
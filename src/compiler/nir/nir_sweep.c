@@ -185,3 +185,42 @@ nir_sweep(nir_shader *nir)
    gc_sweep_end(nir->gctx);
    ralloc_free(rubbish);
 }
+
+/**
+ * Like nir_sweep(), but also moves the live instructions.  Every function
+ * impl is re-created in program order in a fresh gc context and the old
+ * context is freed as a whole.
+ *
+ * After long optimization loops the surviving instructions are scattered
+ * over mostly empty slabs; afterwards they are packed together in the order
+ * later passes walk them and the empty slabs are returned.
+ *
+ * This invalidates all pointers to instructions, defs, blocks, function
+ * impls and function_temp variables, so only call it when nothing holds on
+ * to any of those.  Unstructured shaders can't be cloned and are only
+ * swept.
+ */
+void
+nir_compact(nir_shader *nir)
+{
+   nir_foreach_function_impl(impl, nir) {
+      if (!impl->structured) {
+         nir_sweep(nir);
+         return;
+      }
+   }
+
+   gc_ctx *old_gctx = nir->gctx;
+   nir->gctx = gc_context(nir);
+
+   nir_foreach_function(func, nir) {
+      if (func->impl)
+         nir_function_set_impl(func, nir_function_impl_clone(nir, func->impl));
+   }
+
+   /* Nothing references the old instructions anymore. */
+   ralloc_free(old_gctx);
+
+   /* Free the old impls, blocks and locals. */
+   nir_sweep(nir);
+}
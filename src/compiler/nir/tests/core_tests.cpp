@@ -21,6 +21,7 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include "util/memstream.h"
 #include "nir_test.h"
 
 namespace {
@@ -117,4 +118,221 @@ TEST_F(nir_core_test, nir_instr_free_and_dce_multiple_src_test)
    nir_validate_shader(b->shader, "after remove_and_dce");
 }
 
+
+TEST_F(nir_core_test, nir_compact_test)
+{
+   nir_variable *var = nir_local_variable_create(b->impl, glsl_int_type(), "var");
+   nir_store_var(b, var, nir_imm_int(b, 0), 0x1);
+
+   nir_loop *loop = nir_push_loop(b);
+   {
+      nir_def *count = nir_load_var(b, var);
+      nir_break_if(b, nir_ige_imm(b, count, 4));
+      nir_store_var(b, var, nir_iadd_imm(b, count, 1), 0x1);
+   }
+   nir_pop_loop(b, loop);
+
+   nir_def *dead = nir_imul_imm(b, nir_load_var(b, var), 3);
+   nir_store_var(b, var, nir_iadd_imm(b, nir_load_var(b, var), 2), 0x1);
+   nir_lower_vars_to_ssa(b->shader);
+   nir_opt_dce(b->shader);
+   ASSERT_FALSE(shader_contains_def(dead));
+
+   unsigned num_instrs = 0;
+   nir_foreach_block(block, b->impl)
+      num_instrs += exec_list_length(&block->instr_list);
+
+   nir_def *phi = NULL;
+   nir_foreach_phi(instr, nir_loop_first_block(loop))
+      phi = &instr->def;
+   ASSERT_NE(phi, nullptr);
+
+   nir_compact(b->shader);
+   b->impl = nir_shader_get_entrypoint(b->shader);
+   nir_validate_shader(b->shader, "after nir_compact");
+
+   ASSERT_FALSE(shader_contains_def(phi));
+
+   unsigned num_compacted = 0;
+   nir_foreach_block(block, b->impl)
+      num_compacted += exec_list_length(&block->instr_list);
+   ASSERT_EQ(num_instrs, num_compacted);
+}
+
+TEST_F(nir_core_test, nir_dirty_blocks_test)
+{
+   nir_def *one = nir_imm_int(b, 1);
+   nir_def *mov = nir_mov(b, nir_iadd(b, one, one));
+
+   nir_push_if(b, nir_ine_imm(b, mov, 0));
+   nir_def *then_use = nir_iadd(b, mov, one);
+   nir_pop_if(b, NULL);
+   nir_block *then_block = then_use->parent_instr->block;
+   nir_block *after_block = nir_cursor_current_block(b->cursor);
+
+   ASSERT_TRUE(nir_opt_constant_folding(b->shader));
+   nir_copy_prop(b->shader);
+   ASSERT_FALSE(nir_opt_constant_folding(b->shader));
+   ASSERT_FALSE(nir_copy_prop(b->shader));
+   ASSERT_FALSE(then_block->dirty_passes & nir_dirty_pass_constant_folding);
+
+   /* A new instruction only dirties its own block. */
+   nir_def *add = nir_iadd(b, one, one);
+   ASSERT_EQ(after_block->dirty_passes, nir_dirty_pass_all);
+   ASSERT_FALSE(then_block->dirty_passes & nir_dirty_pass_constant_folding);
+
+   ASSERT_TRUE(nir_opt_constant_folding(b->shader));
+   ASSERT_FALSE(shader_contains_def(add));
+
+   /* Anything not going through the helpers drops the dirty bits. */
+   nir_metadata_preserve(b->impl, nir_metadata_control_flow);
+   nir_metadata_require(b->impl, nir_metadata_dirty_blocks);
+   ASSERT_EQ(then_block->dirty_passes, nir_dirty_pass_all);
+
+   nir_validate_shader(b->shader, "after nir_dirty_blocks_test");
+}
+
+static nir_def *
+load_constant(nir_builder *b, nir_def *offset, unsigned range)
+{
+   nir_def *load = nir_load_constant(b, 1, 32, offset);
+   nir_intrinsic_set_range(nir_instr_as_intrinsic(load->parent_instr), range);
+   return load;
+}
+
+TEST_F(nir_core_test, nir_dirty_blocks_constant_data)
+{
+   static const uint32_t data[4] = { 1, 2, 3, 4 };
+
+   b->shader->constant_data = ralloc_memdup(b->shader, data, sizeof(data));
+   b->shader->constant_data_size = sizeof(data);
+
+   /* An indirect load keeps the data, even when its block is skipped. */
+   nir_push_if(b, nir_ine_imm(b, nir_undef(b, 1, 32), 0));
+   load_constant(b, nir_undef(b, 1, 32), sizeof(data));
+   nir_pop_if(b, NULL);
+
+   nir_opt_constant_folding(b->shader);
+   nir_def *load = load_constant(b, nir_imm_int(b, 4), sizeof(data));
+   ASSERT_TRUE(nir_opt_constant_folding(b->shader));
+   ASSERT_FALSE(shader_contains_def(load));
+   ASSERT_NE(b->shader->constant_data, nullptr);
+
+   /* Once the last load is folded by a run that only visits its block,
+    * the data goes away.
+    */
+   nir_foreach_block(block, b->impl) {
+      nir_foreach_instr_safe(instr, block) {
+         if (instr->type == nir_instr_type_intrinsic &&
+             nir_instr_as_intrinsic(instr)->intrinsic ==
+                nir_intrinsic_load_constant)
+            nir_instr_remove(instr);
+      }
+   }
+   nir_opt_constant_folding(b->shader);
+   b->cursor = nir_after_impl(b->impl);
+   load = load_constant(b, nir_imm_int(b, 8), sizeof(data));
+   ASSERT_TRUE(nir_opt_constant_folding(b->shader));
+   ASSERT_FALSE(shader_contains_def(load));
+   ASSERT_EQ(b->shader->constant_data, nullptr);
+   ASSERT_EQ(b->shader->constant_data_size, 0u);
+
+   nir_validate_shader(b->shader, "after nir_dirty_blocks_constant_data");
+}
+
+static bool
+fold_constants(nir_shader *shader, void *data)
+{
+   bool progress = false;
+   NIR_PASS(progress, shader, nir_opt_constant_folding);
+   NIR_PASS(progress, shader, nir_opt_dce);
+   return progress;
+}
+
+TEST_F(nir_core_test, nir_parallel_impl_pass_test)
+{
+   /* Use the threads even on a single-CPU machine.  The queue is created by
+    * the first call, so this has to happen before that.
+    */
+#ifdef _WIN32
+   _putenv("NIR_PARALLEL_THREADS=2");
+#else
+   setenv("NIR_PARALLEL_THREADS", "2", 1);
+#endif
+
+   nir_store_global(b, nir_imm_int64(b, 0), 4,
+                    nir_iadd(b, nir_imm_int(b, 1), nir_imm_int(b, 2)), 0x1);
+
+   nir_variable *var = nir_variable_create(b->shader, nir_var_shader_temp,
+                                           glsl_int_type(), "var");
+
+   nir_function *funcs[4];
+   for (unsigned i = 0; i < ARRAY_SIZE(funcs); i++) {
+      funcs[i] = nir_function_create(b->shader, "func");
+      nir_builder fb = nir_builder_at(nir_before_impl(nir_function_impl_create(funcs[i])));
+      nir_def *v = nir_imm_int(&fb, i);
+      /* Only the odd functions have anything to fold. */
+      if (i & 1)
+         v = nir_imul_imm(&fb, v, 3);
+      nir_store_var(&fb, var, v, 0x1);
+   }
+   nir_function_impl *even_impl = funcs[0]->impl;
+   nir_function_impl *odd_impl = funcs[1]->impl;
+
+   ASSERT_TRUE(nir_shader_parallel_impl_pass(b->shader, fold_constants, NULL));
+   b->impl = nir_shader_get_entrypoint(b->shader);
+   nir_validate_shader(b->shader, "after nir_shader_parallel_impl_pass");
+
+   /* Functions without progress keep their impl, the others get the one
+    * the job made, which also shows that the threads were used.
+    */
+   ASSERT_EQ(funcs[0]->impl, even_impl);
+   ASSERT_NE(funcs[1]->impl, odd_impl);
+
+   nir_foreach_function_impl(impl, b->shader) {
+      nir_foreach_block(block, impl) {
+         nir_foreach_instr(instr, block) {
+            ASSERT_NE(instr->type, nir_instr_type_alu);
+            /* Derefs point at the shader's own variables again. */
+            if (instr->type == nir_instr_type_deref) {
+               ASSERT_EQ(nir_instr_as_deref(instr)->var, var);
+            }
+         }
+      }
+   }
+
+   ASSERT_FALSE(nir_shader_parallel_impl_pass(b->shader, fold_constants, NULL));
+}
+
+
+TEST_F(nir_core_test, nir_pass_profile_print_test)
+{
+   nir_store_global(b, nir_imm_int64(b, 0), 4,
+                    nir_iadd(b, nir_imm_int(b, 1), nir_imm_int(b, 2)), 0x1);
+
+   /* Record one pass without going through NIR_PASS_PROFILE and atexit. */
+   bool was_enabled = nir_pass_profile_enabled;
+   nir_pass_profile_enabled = true;
+   bool progress = false;
+   NIR_PASS(progress, b->shader, nir_opt_constant_folding);
+   nir_pass_profile_enabled = was_enabled;
+   ASSERT_TRUE(progress);
+
+   char *buf = NULL;
+   size_t size = 0;
+   struct u_memstream mem;
+   ASSERT_TRUE(u_memstream_open(&mem, &buf, &size));
+   nir_pass_profile_print(u_memstream_get(&mem));
+   u_memstream_close(&mem);
+
+   ASSERT_NE(buf, nullptr);
+   const char *header = "{\n  \"passes\": [";
+   EXPECT_EQ(strncmp(buf, header, strlen(header)), 0);
+   /* Other tests may have been recorded too if NIR_PASS_PROFILE is set. */
+   EXPECT_NE(strstr(buf, "{ \"name\": \"nir_opt_constant_folding\", "
+                         "\"stage\": \"compute\", \"invocations\": "),
+             nullptr);
+   free(buf);
+}
+
 }
@@ -0,0 +1,183 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Decode throughput benchmark for nir_deserialize().
+ *
+ * Usage: nir_serialize_bench [-i iterations] [-o dir] [file...]
+ *
+ * Each file holds the output of a single nir_serialize() call, for example
+ * what a driver writes to its shader cache before compression.  Every file
+ * is deserialized the given number of times and the average decode time,
+ * the throughput in MB/s and in instructions per second are reported.
+ *
+ * Without any file, synthetic shaders of increasing size are generated with
+ * nir_builder instead.  -o writes those to the given directory so they can
+ * be used as a starting corpus.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/os_file.h"
+#include "util/os_time.h"
+#include "util/ralloc.h"
+#include "nir.h"
+#include "nir_builder.h"
+#include "nir_serialize.h"
+
+static const nir_shader_compiler_options options = { 0 };
+
+static unsigned
+count_instrs(nir_shader *nir)
+{
+   unsigned count = 0;
+
+   nir_foreach_function_impl(impl, nir) {
+      nir_foreach_block(block, impl) {
+         count += exec_list_length(&block->instr_list);
+      }
+   }
+
+   return count;
+}
+
+static bool
+bench(const void *data, size_t size, const char *name, unsigned iterations)
+{
+   unsigned instrs = 0;
+   int64_t total = 0;
+
+   for (unsigned i = 0; i < iterations; i++) {
+      void *mem_ctx = ralloc_context(NULL);
+      struct blob_reader reader;
+
+      blob_reader_init(&reader, data, size);
+
+      int64_t start = os_time_get_nano();
+      nir_shader *nir = nir_deserialize(mem_ctx, &options, &reader);
+      total += os_time_get_nano() - start;
+
+      if (!nir || reader.overrun) {
+         fprintf(stderr, "%s: corrupt shader\n", name);
+         ralloc_free(mem_ctx);
+         return false;
+      }
+
+      instrs = count_instrs(nir);
+      ralloc_free(mem_ctx);
+   }
+
+   double sec = total / 1e9;
+   printf("%-32s %8zu bytes %8u instrs %10.3f us/iter %8.1f MB/s "
+          "%8.2f Minstr/s\n",
+          name, size, instrs, total / 1000.0 / iterations,
+          size * (double)iterations / sec / 1e6,
+          instrs * (double)iterations / sec / 1e6);
+   return true;
+}
+
+/**
+ * Roughly what a scalarized shader looks like to the serializer: buffer
+ * loads feeding long ALU chains, with some control flow and phis.
+ */
+static nir_shader *
+synthetic(unsigned blocks)
+{
+   nir_builder b = nir_builder_init_simple_shader(MESA_SHADER_COMPUTE,
+                                                  &options, "synthetic");
+   nir_def *acc = nir_load_local_invocation_index(&b);
+   nir_def *f = nir_u2f32(&b, acc);
+
+   for (unsigned i = 0; i < blocks; i++) {
+      nir_def *v = nir_load_ssbo(&b, 4, 32, nir_imm_int(&b, 0),
+                                 nir_imul_imm(&b, acc, 16 + i));
+      for (unsigned c = 0; c < 4; c++) {
+         nir_def *x = nir_channel(&b, v, c);
+         f = nir_ffma(&b, nir_u2f32(&b, x), f, nir_imm_float(&b, 0.5f * c));
+         f = nir_fmax(&b, f, nir_fmul_imm(&b, f, 0.25));
+      }
+
+      nir_def *then_f;
+      nir_push_if(&b, nir_flt(&b, f, nir_imm_float(&b, i)));
+      {
+         then_f = nir_fsqrt(&b, nir_fabs(&b, f));
+      }
+      nir_pop_if(&b, NULL);
+      f = nir_if_phi(&b, then_f, f);
+
+      acc = nir_iadd(&b, acc, nir_f2u32(&b, f));
+   }
+
+   nir_store_ssbo(&b, acc, nir_imm_int(&b, 1), nir_imm_int(&b, 0));
+   return b.shader;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned iterations = 100;
+   const char *out_dir = NULL;
+   int first_file = 1;
+
+   while (first_file + 1 < argc) {
+      if (strcmp(argv[first_file], "-i") == 0)
+         iterations = MAX2(atoi(argv[first_file + 1]), 1);
+      else if (strcmp(argv[first_file], "-o") == 0)
+         out_dir = argv[first_file + 1];
+      else
+         break;
+      first_file += 2;
+   }
+
+   glsl_type_singleton_init_or_ref();
+
+   int ret = 0;
+   if (first_file >= argc) {
+      static const unsigned sizes[] = { 16, 128, 1024, 8192 };
+      for (unsigned i = 0; i < ARRAY_SIZE(sizes); i++) {
+         nir_shader *nir = synthetic(sizes[i]);
+         struct blob blob;
+         char name[64];
+
+         blob_init(&blob);
+         nir_serialize(&blob, nir, true);
+         snprintf(name, sizeof(name), "synthetic-%u", sizes[i]);
+
+         if (out_dir) {
+            char *path = ralloc_asprintf(NULL, "%s/%s.nir", out_dir, name);
+            FILE *f = fopen(path, "wb");
+            if (f) {
+               fwrite(blob.data, 1, blob.size, f);
+               fclose(f);
+            }
+            ralloc_free(path);
+         }
+
+         if (!bench(blob.data, blob.size, name, iterations))
+            ret = 1;
+
+         blob_finish(&blob);
+         ralloc_free(nir);
+      }
+   }
+
+   for (int i = first_file; i < argc; i++) {
+      size_t size;
+      char *data = os_read_file(argv[i], &size);
+      if (!data) {
+         fprintf(stderr, "%s: can't read file\n", argv[i]);
+         ret = 1;
+         continue;
+      }
+
+      if (!bench(data, size, argv[i], iterations))
+         ret = 1;
+      free(data);
+   }
+
+   glsl_type_singleton_decref();
+   return ret;
+}
@@ -30,6 +30,7 @@
 #include "nir.h"
 #include "nir_spirv.h"
 #include "spirv.h"
+#include "util/os_time.h"
 #include "util/u_dynarray.h"
 #include "vtn_private.h"
 
@@ -102,6 +103,11 @@ print_usage(char *exec_name, FILE *f)
            "  -g, --opengl            Use OpenGL environment instead of Vulkan for\n"
            "                          graphics stages.\n"
            "  --optimize              Run basic NIR optimizations in the result.\n"
+           "  -l, --library           Translate an OpenCL library without any\n"
+           "                          entry-point, such as libclc.\n"
+           "  -t, --time <count>      Translate the module <count> times and print\n"
+           "                          the average time and throughput instead of\n"
+           "                          the shader.\n"
            "\n"
            "Passing the stage and the entry-point name is optional unless there's\n"
            "ambiguity, in which case the program will print the entry-points\n"
@@ -188,6 +194,28 @@ select_entry_point(void *mem_ctx, const uint32_t *words, size_t word_count,
    return r;
 }
 
+static SpvAddressingModel
+get_addressing_model(const uint32_t *words, size_t word_count)
+{
+   /* Skip header. */
+   const uint32_t *w = words + 5;
+   const uint32_t *end = words + word_count;
+
+   while (w < end) {
+      SpvOp opcode = w[0] & SpvOpCodeMask;
+      unsigned count = w[0] >> SpvWordCountShift;
+      if (count < 1 || w + count > end)
+         break;
+
+      if (opcode == SpvOpMemoryModel && count >= 3)
+         return w[1];
+
+      w += count;
+   }
+
+   return SpvAddressingModelLogical;
+}
+
 int main(int argc, char **argv)
 {
    struct entry_point entry_point = {
@@ -197,6 +225,8 @@ int main(int argc, char **argv)
    int ch;
    bool optimize = false;
    enum nir_spirv_execution_environment env = NIR_SPIRV_VULKAN;
+   bool library = false;
+   unsigned iterations = 0;
 
    static struct option long_options[] =
       {
@@ -205,10 +235,12 @@ int main(int argc, char **argv)
          {"entry",    required_argument, 0, 'e'},
          {"opengl",   no_argument,       0, 'g'},
          {"optimize", no_argument,       0, 'O'},
+         {"library",  no_argument,       0, 'l'},
+         {"time",     required_argument, 0, 't'},
          {0, 0,                          0, 0}
       };
 
-   while ((ch = getopt_long(argc, argv, "hs:e:g", long_options, NULL)) != -1) {
+   while ((ch = getopt_long(argc, argv, "hs:e:glt:", long_options, NULL)) != -1) {
       switch (ch) {
       case 'h':
          print_usage(argv[0], stdout);
@@ -232,6 +264,13 @@ int main(int argc, char **argv)
       case 'O':
          optimize = true;
          break;
+      case 'l':
+         library = true;
+         entry_point.stage = MESA_SHADER_KERNEL;
+         break;
+      case 't':
+         iterations = MAX2(atoi(optarg), 1);
+         break;
       default:
          fprintf(stderr, "Unrecognized option \"%s\".\n", optarg);
          print_usage(argv[0], stderr);
@@ -273,9 +312,11 @@ int main(int argc, char **argv)
 
    void *mem_ctx = ralloc_context(NULL);
 
-   entry_point = select_entry_point(mem_ctx, map, word_count, entry_point);
-   if (!entry_point.name)
-      return 1;
+   if (!library) {
+      entry_point = select_entry_point(mem_ctx, map, word_count, entry_point);
+      if (!entry_point.name)
+         return 1;
+   }
 
    glsl_type_singleton_init_or_ref();
 
@@ -283,11 +324,52 @@ int main(int argc, char **argv)
 
    struct spirv_to_nir_options spirv_opts = {
       .environment = env,
+      .create_library = library,
    };
 
-   if (entry_point.stage == MESA_SHADER_KERNEL)
+   if (entry_point.stage == MESA_SHADER_KERNEL) {
       spirv_opts.environment = NIR_SPIRV_OPENCL;
 
+      /* The pointer size has to match the module's addressing model. */
+      if (get_addressing_model(map, word_count) ==
+          SpvAddressingModelPhysical64) {
+         spirv_opts.global_addr_format = nir_address_format_64bit_global;
+         spirv_opts.constant_addr_format = nir_address_format_64bit_global;
+         spirv_opts.shared_addr_format = nir_address_format_32bit_offset_as_64bit;
+         spirv_opts.temp_addr_format = nir_address_format_32bit_offset_as_64bit;
+      } else {
+         spirv_opts.global_addr_format = nir_address_format_32bit_global;
+         spirv_opts.constant_addr_format = nir_address_format_32bit_global;
+         spirv_opts.shared_addr_format = nir_address_format_32bit_offset;
+         spirv_opts.temp_addr_format = nir_address_format_32bit_offset;
+      }
+   }
+
+   if (iterations) {
+      int64_t total = 0;
+      for (unsigned i = 0; i < iterations; i++) {
+         int64_t start = os_time_get_nano();
+         nir_shader *nir = spirv_to_nir(map, word_count, NULL, 0,
+                                        entry_point.stage, entry_point.name,
+                                        &spirv_opts, &nir_opts);
+         total += os_time_get_nano() - start;
+
+         if (!nir) {
+            fprintf(stderr, "SPIRV to NIR compilation failed\n");
+            return 1;
+         }
+         ralloc_free(nir);
+      }
+
+      printf("%s: %zu words %10.3f ms/iter %8.1f MB/s\n", filename,
+             word_count, total / 1e6 / iterations,
+             len * (double)iterations / (total / 1e9) / 1e6);
+
+      glsl_type_singleton_decref();
+      ralloc_free(mem_ctx);
+      return 0;
+   }
+
    nir_shader *nir = spirv_to_nir(map, word_count, NULL, 0,
                                   entry_point.stage, entry_point.name,
                                   &spirv_opts, &nir_opts);
@@ -424,6 +424,14 @@ vtn_base_type_to_string(enum vtn_base_type t)
    return "UNKNOWN";
 }
 
+struct vtn_value *
+vtn_create_value(struct vtn_builder *b, uint32_t value_id)
+{
+   struct vtn_value *val = vtn_zalloc(b, struct vtn_value);
+   val->id = value_id;
+   b->values[value_id] = val;
+   return val;
+}
 
 void
 _vtn_fail_value_type_mismatch(struct vtn_builder *b, uint32_t value_id,
@@ -2427,8 +2435,8 @@ vtn_handle_constant(struct vtn_builder *b, SpvOp opcode,
       SpvOp opcode = u32op.u32;
       switch (opcode) {
       case SpvOpVectorShuffle: {
-         struct vtn_value *v0 = &b->values[w[4]];
-         struct vtn_value *v1 = &b->values[w[5]];
+         struct vtn_value *v0 = vtn_untyped_value(b, w[4]);
+         struct vtn_value *v1 = vtn_untyped_value(b, w[5]);
 
          vtn_assert(v0->value_type == vtn_value_type_constant ||
                     v0->value_type == vtn_value_type_undef);
@@ -4842,7 +4850,7 @@ void
 vtn_handle_entry_point(struct vtn_builder *b, const uint32_t *w,
                        unsigned count)
 {
-   struct vtn_value *entry_point = &b->values[w[2]];
+   struct vtn_value *entry_point = vtn_untyped_value(b, w[2]);
    /* Let this be a name label regardless */
    unsigned name_words;
    entry_point->name = vtn_string_literal(b, &w[3], count - 3, &name_words);
@@ -4990,7 +4998,8 @@ vtn_handle_preamble_instruction(struct vtn_builder *b, SpvOp opcode,
       break;
 
    case SpvOpName:
-      b->values[w[1]].name = vtn_string_literal(b, &w[2], count - 2, NULL);
+      vtn_untyped_value(b, w[1])->name =
+         vtn_string_literal(b, &w[2], count - 2, NULL);
       break;
 
    case SpvOpMemberName:
@@ -6656,7 +6665,7 @@ vtn_create_builder(const uint32_t *words, size_t word_count,
    *dup_options = *options;
 
    b->options = dup_options;
-   b->values = vtn_zalloc_array(b, struct vtn_value, value_id_bound);
+   b->values = vtn_zalloc_array(b, struct vtn_value *, value_id_bound);
 
    if (b->options->capabilities != NULL)
       b->supported_capabilities = *b->options->capabilities;
@@ -6910,9 +6919,7 @@ spirv_to_nir(const uint32_t *words, size_t word_count,
       b->shader->info.workgroup_size[2] = const_size[2].u32;
    }
 
-   /* Set types on all vtn_values */
-   vtn_foreach_instruction(b, words, word_end, vtn_set_instruction_result_type);
-
+   /* Also sets types on all vtn_values in the function bodies. */
    vtn_build_cfg(b, words, word_end);
 
    if (!options->create_library) {
@@ -7223,9 +7230,7 @@ spirv_library_to_nir_builder(FILE *fp, const uint32_t *words, size_t word_count,
    words = vtn_foreach_instruction(b, words, word_end,
                                    vtn_handle_variable_or_type_instruction);
 
-   /* Set types on all vtn_values */
-   vtn_foreach_instruction(b, words, word_end, vtn_set_instruction_result_type);
-
+   /* Also sets types on all vtn_values in the function bodies. */
    vtn_build_cfg(b, words, word_end);
 
    fprintf(fp, "#include \"compiler/nir/nir_builder.h\"\n\n");
@@ -7246,8 +7251,8 @@ static unsigned
 vtn_id_for_type(struct vtn_builder *b, struct vtn_type *type)
 {
    for (unsigned i = 0; i < b->value_id_bound; i++) {
-      struct vtn_value *v = &b->values[i];
-      if (v->value_type == vtn_value_type_type &&
+      struct vtn_value *v = b->values[i];
+      if (v && v->value_type == vtn_value_type_type &&
           v->type == type)
          return i;
    }
@@ -7314,7 +7319,7 @@ vtn_dump_values(struct vtn_builder *b, FILE *f)
 {
    fprintf(f, "=== SPIR-V values\n");
    for (unsigned i = 1; i < b->value_id_bound; i++) {
-      struct vtn_value *val = &b->values[i];
+      struct vtn_value *val = vtn_untyped_value(b, i);
       fprintf(f, "%8d = ", i);
       vtn_print_value(b, val, f);
    }
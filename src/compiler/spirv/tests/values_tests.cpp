@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include "helpers.h"
+
+class Values : public spirv_test {};
+
+/*
+ * vtn_values are only allocated for the ids a module uses, so a module
+ * with a large id bound and few ids must translate like a dense one.
+ *
+ *             OpCapability Shader
+ *        %1 = OpExtInstImport "GLSL.std.450"
+ *             OpMemoryModel Logical GLSL450
+ *             OpEntryPoint GLCompute %4 "main"
+ *             OpExecutionMode %4 LocalSize 1 1 1
+ *             OpMemberDecorate %_struct_7 0 Offset 0
+ *             OpDecorate %_struct_7 BufferBlock
+ *             OpDecorate %9 DescriptorSet 0
+ *             OpDecorate %9 Binding 0
+ *     %void = OpTypeVoid
+ *        %3 = OpTypeFunction %void
+ *     %uint = OpTypeInt 32 0
+ *%_struct_7 = OpTypeStruct %uint
+ *%_ptr_Uniform__struct_7 = OpTypePointer Uniform %_struct_7
+ *        %9 = OpVariable %_ptr_Uniform__struct_7 Uniform
+ *      %int = OpTypeInt 32 1
+ *    %int_0 = OpConstant %int 0
+ *%_ptr_Uniform_uint = OpTypePointer Uniform %uint
+ *        %4 = OpFunction %void None %3
+ *        %5 = OpLabel
+ *       %13 = OpAccessChain %_ptr_Uniform_uint %9 %int_0
+ *       %14 = OpLoad %uint %13
+ *             OpStore %13 %14
+ *             OpReturn
+ *             OpFunctionEnd
+ *
+ * with the ids spread out over 0x1000-0xe206, out of a bound of 0xe207.
+ */
+static const uint32_t sparse_words[] = {
+   0x07230203, 0x00010300, 0x00070000, 0x0000e207, 0x00000000, 0x00020011,
+   0x00000001, 0x0006000b, 0x00001025, 0x4c534c47, 0x6474732e, 0x3035342e,
+   0x00000000, 0x0003000e, 0x00000000, 0x00000001, 0x0005000f, 0x00000005,
+   0x0000204a, 0x6e69616d, 0x00000000, 0x00060010, 0x0000204a, 0x00000011,
+   0x00000001, 0x00000001, 0x00000001, 0x00050048, 0x0000306f, 0x00000000,
+   0x00000023, 0x00000000, 0x00030047, 0x0000306f, 0x00000003, 0x00040047,
+   0x00004094, 0x00000022, 0x00000000, 0x00040047, 0x00004094, 0x00000021,
+   0x00000000, 0x00020013, 0x000050b9, 0x00030021, 0x000060de, 0x000050b9,
+   0x00040015, 0x00007103, 0x00000020, 0x00000000, 0x0003001e, 0x0000306f,
+   0x00007103, 0x00040020, 0x00008128, 0x00000002, 0x0000306f, 0x0004003b,
+   0x00008128, 0x00004094, 0x00000002, 0x00040015, 0x0000914d, 0x00000020,
+   0x00000001, 0x0004002b, 0x0000914d, 0x0000a172, 0x00000000, 0x00040020,
+   0x0000b197, 0x00000002, 0x00007103, 0x00050036, 0x000050b9, 0x0000204a,
+   0x00000000, 0x000060de, 0x000200f8, 0x0000c1bc, 0x00050041, 0x0000b197,
+   0x0000d1e1, 0x00004094, 0x0000a172, 0x0005003d, 0x00007103, 0x0000e206,
+   0x0000d1e1, 0x00000001, 0x0003003e, 0x0000d1e1, 0x0000e206, 0x000100fd,
+   0x00010038,
+};
+
+TEST_F(Values, sparse_ids)
+{
+   get_nir(ARRAY_SIZE(sparse_words), sparse_words);
+   ASSERT_NE(shader, nullptr);
+
+   nir_intrinsic_instr *load = find_intrinsic(nir_intrinsic_load_deref);
+   ASSERT_NE(load, nullptr);
+
+   nir_intrinsic_instr *store = find_intrinsic(nir_intrinsic_store_deref);
+   ASSERT_NE(store, nullptr);
+   EXPECT_EQ(store->src[1].ssa, &load->def);
+}
+
+TEST_F(Values, id_out_of_bounds)
+{
+   uint32_t words[ARRAY_SIZE(sparse_words)];
+
+   /* The loaded value's id is the last one below the bound. */
+   memcpy(words, sparse_words, sizeof(words));
+   ASSERT_EQ(words[3], 0xe207u);
+   words[3] = 0xe206;
+
+   get_nir(ARRAY_SIZE(words), words);
+   EXPECT_EQ(shader, nullptr);
+}
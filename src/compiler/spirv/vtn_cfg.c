@@ -243,6 +243,11 @@ bool
 vtn_cfg_handle_prepass_instruction(struct vtn_builder *b, SpvOp opcode,
                                    const uint32_t *w, unsigned count)
 {
+   /* This is the only walk over the function section before the bodies are
+    * emitted, so it also sets the types on all the values defined there.
+    */
+   vtn_set_instruction_result_type(b, opcode, w, count);
+
    switch (opcode) {
    case SpvOpFunction: {
       vtn_assert(b->func == NULL);
@@ -568,6 +568,9 @@ struct vtn_image_pointer {
 struct vtn_value {
    enum vtn_value_type value_type;
 
+   /* The SPIR-V id this value was created for. */
+   uint32_t id;
+
    /* Workaround for https://gitlab.freedesktop.org/mesa/mesa/-/issues/3406
     * Only set for OpImage / OpSampledImage. Note that this is in addition
     * the existence of a NonUniform decoration on this value.*/
@@ -667,7 +670,11 @@ struct vtn_builder {
    struct nir_spirv_specialization *specializations;
 
    unsigned value_id_bound;
-   struct vtn_value *values;
+   /* Indexed by SPIR-V id.  The values themselves are only allocated once an
+    * id is looked up for the first time, so the ids a module never uses cost
+    * a pointer instead of a whole vtn_value.
+    */
+   struct vtn_value **values;
 
    /* Information on the origin of the SPIR-V */
    enum vtn_generator generator_id;
@@ -726,12 +733,17 @@ struct vtn_ssa_value *
 vtn_const_ssa_value(struct vtn_builder *b, nir_constant *constant,
                     const struct glsl_type *type);
 
+struct vtn_value *vtn_create_value(struct vtn_builder *b, uint32_t value_id);
+
 static inline struct vtn_value *
 vtn_untyped_value(struct vtn_builder *b, uint32_t value_id)
 {
    vtn_fail_if(value_id >= b->value_id_bound,
                "SPIR-V id %u is out-of-bounds", value_id);
-   return &b->values[value_id];
+   struct vtn_value *val = b->values[value_id];
+   if (unlikely(val == NULL))
+      val = vtn_create_value(b, value_id);
+   return val;
 }
 
 void vtn_print_value(struct vtn_builder *b, struct vtn_value *val, FILE *f);
@@ -740,9 +752,10 @@ void vtn_dump_values(struct vtn_builder *b, FILE *f);
 static inline uint32_t
 vtn_id_for_value(struct vtn_builder *b, struct vtn_value *value)
 {
-   vtn_fail_if(value <= b->values, "vtn_value pointer outside the range of valid values");
-   uint32_t value_id = value - b->values;
-   vtn_fail_if(value_id >= b->value_id_bound, "vtn_value pointer outside the range of valid values");
+   uint32_t value_id = value->id;
+   vtn_fail_if(value_id == 0 || value_id >= b->value_id_bound ||
+               b->values[value_id] != value,
+               "vtn_value pointer outside the range of valid values");
    return value_id;
 }
 
@@ -766,7 +779,7 @@ vtn_push_value(struct vtn_builder *b, uint32_t value_id,
 
    val->value_type = value_type;
 
-   return &b->values[value_id];
+   return val;
 }
 
 /* These separated fail functions exist so the helpers like vtn_value()
@@ -26,6 +26,7 @@
  **************************************************************************/
 
 
+#include "util/format/u_format.h"
 #include "lp_bld_format.h"
 
 LLVMTypeRef lp_build_format_cache_elem_type(struct gallivm_state *gallivm, enum cache_member member) {
@@ -72,3 +73,38 @@ lp_build_format_cache_type(struct gallivm_state *gallivm)
 
    return s;
 }
+
+
+/**
+ * Whether texture sampling from this format should go through a
+ * lp_build_format_cache.
+ *
+ * S3TC blocks are decoded into the cache by generated code, but decoding
+ * them directly is about as fast.  The other formats are too involved for
+ * that and have their blocks decoded by the util_format unpack function on a
+ * cache miss, which only pays off for formats that fit in 8 bits per
+ * channel.
+ */
+bool
+lp_build_format_uses_cache(const struct util_format_description *format_desc)
+{
+   switch (format_desc->layout) {
+   case UTIL_FORMAT_LAYOUT_S3TC:
+      return LP_BUILD_FORMAT_CACHE_S3TC;
+   case UTIL_FORMAT_LAYOUT_ETC:
+      return format_desc->format == PIPE_FORMAT_ETC1_RGB8 ||
+             format_desc->format == PIPE_FORMAT_ETC2_RGB8 ||
+             format_desc->format == PIPE_FORMAT_ETC2_SRGB8 ||
+             format_desc->format == PIPE_FORMAT_ETC2_RGB8A1 ||
+             format_desc->format == PIPE_FORMAT_ETC2_SRGB8A1 ||
+             format_desc->format == PIPE_FORMAT_ETC2_RGBA8 ||
+             format_desc->format == PIPE_FORMAT_ETC2_SRGBA8;
+   case UTIL_FORMAT_LAYOUT_BPTC:
+      return format_desc->format == PIPE_FORMAT_BPTC_RGBA_UNORM ||
+             format_desc->format == PIPE_FORMAT_BPTC_SRGBA;
+   case UTIL_FORMAT_LAYOUT_ASTC:
+      return format_desc->block.depth == 1;
+   default:
+      return false;
+   }
+}
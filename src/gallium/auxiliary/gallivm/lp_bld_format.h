@@ -45,6 +45,13 @@ struct lp_build_context;
 
 
 #define LP_BUILD_FORMAT_CACHE_DEBUG 0
+
+/*
+ * Whether S3TC textures go through the block cache when sampling.  The other
+ * formats that can use it always do.
+ */
+#define LP_BUILD_FORMAT_CACHE_S3TC 0
+
 /*
  * Block cache
  *
@@ -88,6 +95,9 @@ lp_build_format_cache_member_type(struct gallivm_state *gallivm, enum cache_memb
 LLVMTypeRef
 lp_build_format_cache_elem_type(struct gallivm_state *gallivm, enum cache_member member);
 
+bool
+lp_build_format_uses_cache(const struct util_format_description *format_desc);
+
 /*
  * AoS
  */
@@ -194,6 +204,16 @@ lp_build_fetch_s3tc_rgba_aos(struct gallivm_state *gallivm,
                              LLVMValueRef j,
                              LLVMValueRef cache);
 
+LLVMValueRef
+lp_build_fetch_cached_rgba_aos(struct gallivm_state *gallivm,
+                               const struct util_format_description *format_desc,
+                               unsigned n,
+                               LLVMValueRef base_ptr,
+                               LLVMValueRef offset,
+                               LLVMValueRef i,
+                               LLVMValueRef j,
+                               LLVMValueRef cache);
+
 /*
  * RGTC
  */
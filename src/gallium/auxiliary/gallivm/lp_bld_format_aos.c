@@ -787,6 +787,40 @@ lp_build_fetch_rgba_aos(struct gallivm_state *gallivm,
        return tmp;
    }
 
+   /*
+    * formats decoded into the block cache in C (etc, bptc, astc)
+    *
+    * sRGB values are returned encoded, so only do this for sRGB formats if
+    * the caller asked for 8 bit values.
+    */
+
+   if (cache && format_desc->layout != UTIL_FORMAT_LAYOUT_S3TC &&
+       lp_build_format_uses_cache(format_desc) &&
+       (format_desc->colorspace != UTIL_FORMAT_COLORSPACE_SRGB ||
+        (!type.floating && type.width == 8 && !type.sign && type.norm))) {
+      struct lp_type tmp_type;
+      LLVMValueRef tmp;
+
+      memset(&tmp_type, 0, sizeof tmp_type);
+      tmp_type.width = 8;
+      tmp_type.length = num_pixels * 4;
+      tmp_type.norm = true;
+
+      tmp = lp_build_fetch_cached_rgba_aos(gallivm,
+                                           format_desc,
+                                           num_pixels,
+                                           base_ptr,
+                                           offset,
+                                           i, j,
+                                           cache);
+
+      lp_build_conv(gallivm,
+                    tmp_type, type,
+                    &tmp, 1, &tmp, 1);
+
+      return tmp;
+   }
+
    /*
     * Fallback to util_format_description::fetch_rgba_8unorm().
     */
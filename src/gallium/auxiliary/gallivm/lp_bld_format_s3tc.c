@@ -38,6 +38,7 @@
 
 #include "util/format/u_format.h"
 #include "util/u_math.h"
+#include "util/u_pointer.h"
 #include "util/u_string.h"
 #include "util/u_cpu_detect.h"
 #include "util/u_debug.h"
@@ -57,6 +58,7 @@
 #include "lp_bld_init.h"
 #include "lp_bld_debug.h"
 #include "lp_bld_intr.h"
+#include "lp_bld_misc.h"
 
 
 /**
@@ -2028,6 +2030,45 @@ update_cached_block(struct gallivm_state *gallivm,
    LLVMSetInstructionCallConv(inst, LLVMFastCallConv);
 }
 
+/**
+ * Hash the block addresses into cache lines.  The cache is direct mapped,
+ * the hash function could be better but it needs to be simple.
+ */
+static LLVMValueRef
+cache_hash_index(struct lp_build_context *bld32,
+                 const struct util_format_description *format_desc,
+                 LLVMValueRef base_ptr,
+                 LLVMValueRef offset)
+{
+   struct gallivm_state *gallivm = bld32->gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef i32t = LLVMInt32TypeInContext(gallivm->context);
+   struct lp_type type = bld32->type;
+   unsigned low_bit, log2size;
+   LLVMValueRef ptr_addrtrunc, hash_index, hash_mask, tmp;
+
+   low_bit = util_logbase2(format_desc->block.bits / 8);
+   log2size = util_logbase2(LP_BUILD_FORMAT_CACHE_SIZE);
+   ptr_addrtrunc = LLVMBuildPtrToInt(builder, base_ptr, i32t, "");
+   ptr_addrtrunc = lp_build_broadcast_scalar(bld32, ptr_addrtrunc);
+   /* For the hash function, first mask off the unused lowest bits. Then just
+      do some xor with address bits - only use lower 32bits */
+   ptr_addrtrunc = LLVMBuildAdd(builder, offset, ptr_addrtrunc, "");
+   ptr_addrtrunc = LLVMBuildLShr(builder, ptr_addrtrunc,
+                                 lp_build_const_int_vec(gallivm, type, low_bit), "");
+   /* This only really makes sense for size 64,128,256 */
+   hash_index = ptr_addrtrunc;
+   ptr_addrtrunc = LLVMBuildLShr(builder, ptr_addrtrunc,
+                                 lp_build_const_int_vec(gallivm, type, 2*log2size), "");
+   hash_index = LLVMBuildXor(builder, ptr_addrtrunc, hash_index, "");
+   tmp = LLVMBuildLShr(builder, hash_index,
+                       lp_build_const_int_vec(gallivm, type, log2size), "");
+   hash_index = LLVMBuildXor(builder, hash_index, tmp, "");
+
+   hash_mask = lp_build_const_int_vec(gallivm, type, LP_BUILD_FORMAT_CACHE_SIZE - 1);
+   return LLVMBuildAnd(builder, hash_index, hash_mask, "");
+}
+
 /*
  * cached lookup
  */
@@ -2043,11 +2084,10 @@ compressed_fetch_cached(struct gallivm_state *gallivm,
 
 {
    LLVMBuilderRef builder = gallivm->builder;
-   unsigned count, low_bit, log2size;
-   LLVMValueRef color, offset_stored, addr, ptr_addrtrunc, tmp;
-   LLVMValueRef ij_index, hash_index, hash_mask, block_index;
+   unsigned count;
+   LLVMValueRef color, offset_stored, addr, tmp;
+   LLVMValueRef ij_index, hash_index, block_index;
    LLVMTypeRef i8t = LLVMInt8TypeInContext(gallivm->context);
-   LLVMTypeRef i32t = LLVMInt32TypeInContext(gallivm->context);
    LLVMTypeRef i64t = LLVMInt64TypeInContext(gallivm->context);
    struct lp_type type;
    struct lp_build_context bld32;
@@ -2067,27 +2107,8 @@ compressed_fetch_cached(struct gallivm_state *gallivm,
     *    assemble colors
     */
 
-   low_bit = util_logbase2(format_desc->block.bits / 8);
-   log2size = util_logbase2(LP_BUILD_FORMAT_CACHE_SIZE);
    addr = LLVMBuildPtrToInt(builder, base_ptr, i64t, "");
-   ptr_addrtrunc = LLVMBuildPtrToInt(builder, base_ptr, i32t, "");
-   ptr_addrtrunc = lp_build_broadcast_scalar(&bld32, ptr_addrtrunc);
-   /* For the hash function, first mask off the unused lowest bits. Then just
-      do some xor with address bits - only use lower 32bits */
-   ptr_addrtrunc = LLVMBuildAdd(builder, offset, ptr_addrtrunc, "");
-   ptr_addrtrunc = LLVMBuildLShr(builder, ptr_addrtrunc,
-                                 lp_build_const_int_vec(gallivm, type, low_bit), "");
-   /* This only really makes sense for size 64,128,256 */
-   hash_index = ptr_addrtrunc;
-   ptr_addrtrunc = LLVMBuildLShr(builder, ptr_addrtrunc,
-                                 lp_build_const_int_vec(gallivm, type, 2*log2size), "");
-   hash_index = LLVMBuildXor(builder, ptr_addrtrunc, hash_index, "");
-   tmp = LLVMBuildLShr(builder, hash_index,
-                       lp_build_const_int_vec(gallivm, type, log2size), "");
-   hash_index = LLVMBuildXor(builder, hash_index, tmp, "");
-
-   hash_mask = lp_build_const_int_vec(gallivm, type, LP_BUILD_FORMAT_CACHE_SIZE - 1);
-   hash_index = LLVMBuildAnd(builder, hash_index, hash_mask, "");
+   hash_index = cache_hash_index(&bld32, format_desc, base_ptr, offset);
    ij_index = LLVMBuildShl(builder, i, lp_build_const_int_vec(gallivm, type, 2), "");
    ij_index = LLVMBuildAdd(builder, ij_index, j, "");
    block_index = LLVMBuildShl(builder, hash_index,
@@ -2159,6 +2180,203 @@ compressed_fetch_cached(struct gallivm_state *gallivm,
 }
 
 
+/*
+ * Formats decoded in C
+ *
+ * These use the same cache as S3TC, but blocks are decoded by the util_format
+ * unpack function on a miss.  Blocks bigger than 4x4 (ASTC) are split into
+ * 4x4 tiles, each in a cache line of its own, tagged with the block address
+ * plus the tile number.  All tiles of a block are filled at once, as the
+ * whole block has to be decoded anyway.
+ */
+
+/* Distance between the cache lines of the tiles of one block. */
+#define CACHE_TILE_STRIDE 41
+
+
+static void
+cache_fill_decoded_block(struct lp_build_format_cache *cache,
+                         const uint8_t *src,
+                         uint32_t hash_index,
+                         uint32_t format)
+{
+   const struct util_format_description *desc = util_format_description(format);
+   const struct util_format_unpack_description *unpack =
+      util_format_unpack_description(format);
+   const unsigned bw = desc->block.width, bh = desc->block.height;
+   const unsigned tiles_x = DIV_ROUND_UP(bw, 4), tiles_y = DIV_ROUND_UP(bh, 4);
+   uint32_t texels[12 * 12];
+
+   assert(bw <= 12 && bh <= 12);
+
+   unpack->unpack_rgba_8unorm_rect((uint8_t *)texels, bw * 4, src, 0, bw, bh);
+
+   for (unsigned ty = 0; ty < tiles_y; ty++) {
+      for (unsigned tx = 0; tx < tiles_x; tx++) {
+         const unsigned tile = ty * tiles_x + tx;
+         const unsigned line = (hash_index + tile * CACHE_TILE_STRIDE) &
+                               (LP_BUILD_FORMAT_CACHE_SIZE - 1);
+
+         for (unsigned y = 0; y < MIN2(4, bh - ty * 4); y++) {
+            for (unsigned x = 0; x < MIN2(4, bw - tx * 4); x++) {
+               cache->cache_data[line][x][y] =
+                  texels[(ty * 4 + y) * bw + tx * 4 + x];
+            }
+         }
+         cache->cache_tags[line] = (uintptr_t)src + tile;
+      }
+   }
+}
+
+
+/**
+ * Fetch texels of formats for which lp_build_format_uses_cache() is true
+ * but which have no decoder in generated code.
+ *
+ * @param n  number of pixels processed
+ * @param i  is a <n x i32> vector with the x subpixel coordinate
+ * @param j  is a <n x i32> vector with the y subpixel coordinate
+ * @return  a <4*n x i8> vector with the pixel RGBA values in AoS, sRGB
+ *          values are not decoded
+ */
+LLVMValueRef
+lp_build_fetch_cached_rgba_aos(struct gallivm_state *gallivm,
+                               const struct util_format_description *format_desc,
+                               unsigned n,
+                               LLVMValueRef base_ptr,
+                               LLVMValueRef offset,
+                               LLVMValueRef i,
+                               LLVMValueRef j,
+                               LLVMValueRef cache)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef i8t = LLVMInt8TypeInContext(gallivm->context);
+   LLVMTypeRef pi8t = LLVMPointerType(i8t, 0);
+   LLVMTypeRef i32t = LLVMInt32TypeInContext(gallivm->context);
+   LLVMTypeRef i64t = LLVMInt64TypeInContext(gallivm->context);
+   LLVMValueRef addr, hash_index, line, tag, ij_index, texel_index, color;
+   LLVMValueRef function;
+   struct lp_type type;
+   struct lp_build_context bld32;
+
+   assert(lp_build_format_uses_cache(format_desc));
+   assert(format_desc->layout != UTIL_FORMAT_LAYOUT_S3TC);
+   assert(format_desc->block.width <= 12 && format_desc->block.height <= 12);
+
+   memset(&type, 0, sizeof type);
+   type.width = 32;
+   type.length = n;
+   lp_build_context_init(&bld32, gallivm, type);
+
+   /*
+    * Function to call looks like:
+    *   fill(struct lp_build_format_cache *cache, const uint8_t *src,
+    *        uint32_t hash_index, uint32_t format)
+    */
+   LLVMTypeRef arg_types[4] = { LLVMTypeOf(cache), pi8t, i32t, i32t };
+   LLVMTypeRef function_type =
+      LLVMFunctionType(LLVMVoidTypeInContext(gallivm->context),
+                       arg_types, ARRAY_SIZE(arg_types), 0);
+   if (gallivm->cache)
+      gallivm->cache->dont_cache = true;
+   function = lp_build_const_func_pointer_from_type(gallivm,
+                                                    func_to_pointer((func_pointer) cache_fill_decoded_block),
+                                                    function_type,
+                                                    "cache_fill_decoded_block");
+
+   addr = LLVMBuildPtrToInt(builder, base_ptr, i64t, "");
+   hash_index = cache_hash_index(&bld32, format_desc, base_ptr, offset);
+   line = hash_index;
+   if (n == 1) {
+      tag = LLVMBuildZExt(builder, offset, i64t, "");
+   } else {
+      tag = LLVMBuildZExt(builder, offset, LLVMVectorType(i64t, n), "");
+      addr = lp_build_broadcast(gallivm, LLVMTypeOf(tag), addr);
+   }
+   tag = LLVMBuildAdd(builder, tag, addr, "");
+
+   if (format_desc->block.width > 4 || format_desc->block.height > 4) {
+      unsigned tiles_x = DIV_ROUND_UP(format_desc->block.width, 4);
+      LLVMValueRef two = lp_build_const_int_vec(gallivm, type, 2);
+      LLVMValueRef three = lp_build_const_int_vec(gallivm, type, 3);
+      LLVMValueRef tile;
+
+      tile = LLVMBuildLShr(builder, j, two, "");
+      tile = LLVMBuildMul(builder, tile,
+                          lp_build_const_int_vec(gallivm, type, tiles_x), "");
+      tile = LLVMBuildAdd(builder, tile, LLVMBuildLShr(builder, i, two, ""), "");
+      i = LLVMBuildAnd(builder, i, three, "");
+      j = LLVMBuildAnd(builder, j, three, "");
+
+      line = LLVMBuildMul(builder, tile,
+                          lp_build_const_int_vec(gallivm, type, CACHE_TILE_STRIDE), "");
+      line = LLVMBuildAdd(builder, line, hash_index, "");
+      line = LLVMBuildAnd(builder, line,
+                          lp_build_const_int_vec(gallivm, type, LP_BUILD_FORMAT_CACHE_SIZE - 1), "");
+      tag = LLVMBuildAdd(builder, tag,
+                         LLVMBuildZExt(builder, tile, LLVMTypeOf(tag), ""), "");
+   }
+
+   ij_index = LLVMBuildShl(builder, i, lp_build_const_int_vec(gallivm, type, 2), "");
+   ij_index = LLVMBuildAdd(builder, ij_index, j, "");
+   texel_index = LLVMBuildShl(builder, line,
+                              lp_build_const_int_vec(gallivm, type, 4), "");
+   texel_index = LLVMBuildAdd(builder, ij_index, texel_index, "");
+
+   color = bld32.undef;
+   for (unsigned count = 0; count < n; count++) {
+      LLVMValueRef index = lp_build_const_int32(gallivm, count);
+      LLVMValueRef linex, tagx, hash_indexx, texel_indexx, offsetx;
+      LLVMValueRef tag_stored, cond, colorx;
+      struct lp_build_if_state if_ctx;
+
+      if (n == 1) {
+         linex = line;
+         tagx = tag;
+         hash_indexx = hash_index;
+         texel_indexx = texel_index;
+         offsetx = offset;
+      } else {
+         linex = LLVMBuildExtractElement(builder, line, index, "");
+         tagx = LLVMBuildExtractElement(builder, tag, index, "");
+         hash_indexx = LLVMBuildExtractElement(builder, hash_index, index, "");
+         texel_indexx = LLVMBuildExtractElement(builder, texel_index, index, "");
+         offsetx = LLVMBuildExtractElement(builder, offset, index, "");
+      }
+
+      tag_stored = s3tc_lookup_tag_data(gallivm, cache, linex);
+      cond = LLVMBuildICmp(builder, LLVMIntNE, tag_stored, tagx, "");
+
+      lp_build_if(&if_ctx, gallivm, cond);
+      {
+         LLVMValueRef args[4];
+
+         args[0] = cache;
+         args[1] = LLVMBuildGEP2(builder, i8t, base_ptr, &offsetx, 1, "");
+         args[2] = hash_indexx;
+         args[3] = lp_build_const_int32(gallivm, format_desc->format);
+         LLVMBuildCall2(builder, function_type, function, args, ARRAY_SIZE(args), "");
+#if LP_BUILD_FORMAT_CACHE_DEBUG
+         s3tc_update_cache_access(gallivm, cache, 1,
+                                  LP_BUILD_FORMAT_CACHE_MEMBER_ACCESS_MISS);
+#endif
+      }
+      lp_build_endif(&if_ctx);
+
+      colorx = s3tc_lookup_cached_pixel(gallivm, cache, texel_indexx);
+      if (n == 1)
+         color = colorx;
+      else
+         color = LLVMBuildInsertElement(builder, color, colorx, index, "");
+   }
+#if LP_BUILD_FORMAT_CACHE_DEBUG
+   s3tc_update_cache_access(gallivm, cache, n,
+                            LP_BUILD_FORMAT_CACHE_MEMBER_ACCESS_TOTAL);
+#endif
+   return LLVMBuildBitCast(builder, color, LLVMVectorType(i8t, n * 4), "");
+}
+
+
 static LLVMValueRef
 s3tc_dxt5_to_rgba_aos(struct gallivm_state *gallivm,
                       unsigned n,
@@ -749,7 +749,8 @@ lp_build_fetch_rgba_soa(struct gallivm_state *gallivm,
    if ((format_desc->layout != UTIL_FORMAT_LAYOUT_PLAIN) &&
        (util_format_fits_8unorm(format_desc) ||
         format_desc->layout == UTIL_FORMAT_LAYOUT_RGTC ||
-        format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC) &&
+        format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC ||
+        (cache && lp_build_format_uses_cache(format_desc))) &&
        type.floating && type.width == 32 &&
        (type.length == 1 || (type.length % 4 == 0))) {
       struct lp_type tmp_type;
@@ -768,8 +769,14 @@ lp_build_fetch_rgba_soa(struct gallivm_state *gallivm,
       /*
        * Make sure the conversion in aos really only does convert to rgba8
        * and not anything more (so use linear format, adjust type).
+       * Formats decoded into the cache in C already return the encoded
+       * values, and the linear variant may decode differently (astc).
        */
-      flinear_desc = util_format_description(util_format_linear(format));
+      if (cache && format_desc->layout != UTIL_FORMAT_LAYOUT_S3TC &&
+          lp_build_format_uses_cache(format_desc))
+         flinear_desc = format_desc;
+      else
+         flinear_desc = util_format_description(util_format_linear(format));
       memset(&tmp_type, 0, sizeof tmp_type);
       tmp_type.width = 8;
       tmp_type.length = type.length * 4;
@@ -786,7 +793,8 @@ lp_build_fetch_rgba_soa(struct gallivm_state *gallivm,
        */
       frgba8_desc = util_format_description(is_signed ? PIPE_FORMAT_R8G8B8A8_SNORM : PIPE_FORMAT_R8G8B8A8_UNORM);
       if (format_desc->colorspace == UTIL_FORMAT_COLORSPACE_SRGB) {
-         assert(format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC);
+         assert(format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC ||
+                lp_build_format_uses_cache(format_desc));
          frgba8_desc = util_format_description(PIPE_FORMAT_R8G8B8A8_SRGB);
       }
       lp_build_unpack_rgba_soa(gallivm,
@@ -403,7 +403,8 @@ gallivm_compile_module(struct gallivm_state *gallivm)
    lp_passmgr_run(gallivm->passmgr,
                   gallivm->module,
                   LLVMGetExecutionEngineTargetMachine(gallivm->engine),
-                  gallivm->module_name);
+                  gallivm->module_name,
+                  gallivm->opt_level);
 
    /* Setting the module's DataLayout to an empty string will cause the
     * ExecutionEngine to copy to the DataLayout string from its target machine
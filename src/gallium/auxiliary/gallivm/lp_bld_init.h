@@ -67,6 +67,8 @@ struct gallivm_state
    LLVMBuilderRef builder;
    struct lp_cached_code *cache;
    unsigned compiled;
+   /* set before gallivm_compile_module, defaults to the full pipeline */
+   enum lp_passmgr_opt_level opt_level;
    LLVMValueRef coro_malloc_hook;
    LLVMValueRef coro_free_hook;
    LLVMValueRef debug_printf_hook;
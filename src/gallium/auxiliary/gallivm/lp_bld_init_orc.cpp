@@ -7,8 +7,10 @@
 #include "util/u_cpu_detect.h"
 #include "util/u_debug.h"
 #include "util/os_time.h"
+#include <atomic>
 #include <string>
 #include <vector>
+#include <memory>
 #include <mutex>
 #include <cstdlib>
 #include "lp_bld.h"
@@ -137,7 +139,15 @@ inline const char* get_module_name(LLVMModuleRef mod) {
 
 once_flag init_lpjit_once_flag = ONCE_FLAG_INIT;
 
-/* A JIT singleton built upon LLJIT */
+/*
+ * A JIT singleton built upon LLJIT.
+ *
+ * Modules are compiled on their first lookup, on the looking up thread.
+ * Modules of different gallivm states (each with its own LLVMContext) may
+ * be compiled concurrently, which llvmpipe does from its compile queue for
+ * precompiles and optimized recompiles while the draw path compiles other
+ * variants.
+ */
 class LPJit
 {
 public:
@@ -149,6 +159,7 @@ public:
    gallivm_state *find_gallivm_state(LLVMModuleRef mod) {
 #if DEBUG
       using llvm::Module;
+      std::lock_guard<std::mutex> lock(module_mutex);
       auto I = gallivm_modules.find(llvm::unwrap(mod)->getModuleIdentifier());
       if (I == gallivm_modules.end()) {
          debug_printf("No gallivm state found for module: %s", get_module_name(mod));
@@ -182,6 +193,7 @@ public:
    static void register_gallivm_state(gallivm_state *gallivm) {
 #if DEBUG
       LPJit* jit = get_instance();
+      std::lock_guard<std::mutex> lock(jit->module_mutex);
       jit->gallivm_modules[gallivm->module_name] = gallivm;
 #endif
    }
@@ -189,6 +201,7 @@ public:
    static void deregister_gallivm_state(gallivm_state *gallivm) {
 #if DEBUG
       LPJit* jit = get_instance();
+      std::lock_guard<std::mutex> lock(jit->module_mutex);
       (void)jit->gallivm_modules.erase(gallivm->module_name);
 #endif
    }
@@ -242,9 +255,10 @@ public:
       using llvm::orc::ExecutorAddr;
       JITDylib* JD = ::unwrap(jd);
       LPJit* jit = get_instance();
-      jit->lookup_mutex.lock();
+      /* Materializes the module on first lookup.  Compilation is
+       * thread-safe, so lookups in different dylibs run concurrently.
+       */
       auto func = ExitOnErr(jit->lljit->lookup(*JD, func_name));
-      jit->lookup_mutex.unlock();
 #if LLVM_VERSION_MAJOR >= 15
       return func.toPtr<void *>();
 #else
@@ -259,12 +273,61 @@ public:
       ExitOnErr(es.removeJITDylib(* ::unwrap(jd)));
    }
 
-   static void set_object_cache(llvm::ObjectCache *objcache) {
-      auto &ircl = LPJit::get_instance()->lljit->getIRCompileLayer();
-      auto &irc = ircl.getCompiler();
-      auto &sc = dynamic_cast<llvm::orc::SimpleCompiler &>(irc);
-      sc.setObjectCache(objcache);
+   /*
+    * Object caches are per module; the compiler picks the one matching
+    * the module it is compiling, so modules can be compiled concurrently.
+    */
+   static void set_object_cache(const char *module_name,
+                                llvm::ObjectCache *objcache) {
+      LPJit* jit = get_instance();
+      std::lock_guard<std::mutex> lock(jit->module_mutex);
+      if (objcache)
+         jit->objcaches[module_name] = objcache;
+      else
+         jit->objcaches.erase(module_name);
+   }
+
+   static llvm::ObjectCache *find_object_cache(llvm::StringRef module_name) {
+      LPJit* jit = get_instance();
+      std::lock_guard<std::mutex> lock(jit->module_mutex);
+      auto I = jit->objcaches.find(module_name);
+      return I == jit->objcaches.end() ? nullptr : I->second;
+   }
+
+   /*
+    * Same for the optimization level, which is only known to the
+    * gallivm_state and not to the layers the module goes through.
+    * Only non-default levels are recorded.
+    */
+   static void set_opt_level(const char *module_name,
+                             enum lp_passmgr_opt_level opt_level) {
+      LPJit* jit = get_instance();
+      std::lock_guard<std::mutex> lock(jit->module_mutex);
+      if (opt_level != LP_PASSMGR_OPT_DEFAULT)
+         jit->opt_levels[module_name] = opt_level;
+      else
+         jit->opt_levels.erase(module_name);
    }
+
+   static enum lp_passmgr_opt_level find_opt_level(llvm::StringRef module_name) {
+      LPJit* jit = get_instance();
+      std::lock_guard<std::mutex> lock(jit->module_mutex);
+      auto I = jit->opt_levels.find(module_name);
+      return I == jit->opt_levels.end() ? LP_PASSMGR_OPT_DEFAULT : I->second;
+   }
+
+   /*
+    * TargetMachines aren't thread-safe (subtargets are created lazily), so
+    * every thread running optimization passes or code generation gets its
+    * own.
+    */
+   static llvm::TargetMachine *get_thread_tm() {
+      static thread_local std::unique_ptr<llvm::TargetMachine> thread_tm;
+      if (!thread_tm)
+         thread_tm = ExitOnErr(get_instance()->jtmb->createTargetMachine());
+      return thread_tm.get();
+   }
+
    LLVMTargetMachineRef tm;
 
 private:
@@ -286,10 +349,14 @@ private:
 
    std::unique_ptr<llvm::orc::LLJIT> lljit;
    std::unique_ptr<llvm::TargetMachine> tm_unique;
-   /* avoid name conflict */
-   unsigned jit_dylib_count;
+   std::unique_ptr<llvm::orc::JITTargetMachineBuilder> jtmb;
+   /* avoid name conflict, gallivm states may be created on any thread */
+   std::atomic<unsigned> jit_dylib_count;
 
-   std::mutex lookup_mutex;
+   /* protects the per-module maps below */
+   std::mutex module_mutex;
+   llvm::StringMap<llvm::ObjectCache *> objcaches;
+   llvm::StringMap<enum lp_passmgr_opt_level> opt_levels;
 
 #if DEBUG
    /* map from module name to gallivm_state */
@@ -304,14 +371,48 @@ void lpjit_exit()
    delete LPJit::jit;
 }
 
+/*
+ * IR compiler for the LLJIT compile layer.  Unlike the default
+ * SimpleCompiler it holds no per-module state, so it can be invoked from
+ * several threads at once.
+ */
+class LPIRCompiler : public llvm::orc::IRCompileLayer::IRCompiler {
+public:
+   LPIRCompiler(llvm::orc::JITTargetMachineBuilder &JTMB)
+      : IRCompiler(llvm::orc::irManglingOptionsFromTargetOptions(
+                      JTMB.getOptions())) {}
+
+   llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+   operator()(llvm::Module &M) override {
+      llvm::TargetMachine *TM = LPJit::get_thread_tm();
+      auto opt_level = TM->getOptLevel();
+
+      /* The thread's TargetMachine is private, so tweaking it is safe. */
+      if (LPJit::find_opt_level(M.getModuleIdentifier()) == LP_PASSMGR_OPT_FAST)
+#if LLVM_VERSION_MAJOR >= 18
+         TM->setOptLevel(llvm::CodeGenOptLevel::Less);
+#else
+         TM->setOptLevel(llvm::CodeGenOpt::Less);
+#endif
+
+      llvm::orc::SimpleCompiler C(*TM,
+                                  LPJit::find_object_cache(M.getModuleIdentifier()));
+      auto obj = C(M);
+      TM->setOptLevel(opt_level);
+      return obj;
+   }
+};
+
 LLVMErrorRef module_transform(void *Ctx, LLVMModuleRef mod) {
    struct lp_passmgr *mgr;
 
    lp_passmgr_create(mod, &mgr);
 
+   const char *module_name = get_module_name(mod);
    lp_passmgr_run(mgr, mod,
-                  LPJit::get_instance()->tm,
-                  get_module_name(mod));
+                  wrap(LPJit::get_thread_tm()),
+                  module_name,
+                  LPJit::find_opt_level(module_name));
 
    lp_passmgr_dispose(mgr);
    return LLVMErrorSuccess;
@@ -332,6 +433,7 @@ LPJit::LPJit() :jit_dylib_count(0) {
    JITTargetMachineBuilder JTMB = create_jtdb();
    tm_unique = ExitOnErr(JTMB.createTargetMachine());
    tm = wrap(tm_unique.get());
+   jtmb = std::make_unique<JITTargetMachineBuilder>(JTMB);
 
    /* Create an LLJIT instance with an ObjectLinkingLayer (JITLINK)
     * or RuntimeDyld as the base layer.
@@ -340,6 +442,11 @@ LPJit::LPJit() :jit_dylib_count(0) {
    lljit = ExitOnErr(
       LLJITBuilder()
          .setJITTargetMachineBuilder(std::move(JTMB))
+         .setCompileFunctionCreator(
+            [&](JITTargetMachineBuilder JTMB)
+               -> llvm::Expected<std::unique_ptr<IRCompileLayer::IRCompiler>> {
+               return std::make_unique<LPIRCompiler>(JTMB);
+            })
 #ifdef USE_JITLINK
          .setObjectLinkingLayerCreator(
             [&](ExecutionSession &ES, const llvm::Triple &TT) {
@@ -601,6 +708,10 @@ gallivm_free_ir(struct gallivm_state *gallivm)
 {
    if (gallivm->module)
       LLVMDisposeModule(gallivm->module);
+   if (gallivm->cache && gallivm->cache->jit_obj_cache && gallivm->module_name)
+      LPJit::set_object_cache(gallivm->module_name, NULL);
+   if (gallivm->opt_level != LP_PASSMGR_OPT_DEFAULT && gallivm->module_name)
+      LPJit::set_opt_level(gallivm->module_name, LP_PASSMGR_OPT_DEFAULT);
    FREE(gallivm->module_name);
 
    if (gallivm->target) {
@@ -624,7 +735,6 @@ gallivm_free_ir(struct gallivm_state *gallivm)
    gallivm->_ts_context=NULL;
    gallivm->cache=NULL;
    LPJit::deregister_gallivm_state(gallivm);
-   LPJit::set_object_cache(NULL);
 }
 
 void
@@ -646,6 +756,9 @@ gallivm_compile_module(struct gallivm_state *gallivm)
 
    lp_build_coro_add_malloc_hooks(gallivm);
 
+   if (gallivm->opt_level != LP_PASSMGR_OPT_DEFAULT)
+      LPJit::set_opt_level(gallivm->module_name, gallivm->opt_level);
+
    LPJit::add_ir_module_to_jd(gallivm->_ts_context, gallivm->module,
       gallivm->_per_module_jd);
    /* ownership of module is now transferred into orc jit,
@@ -660,7 +773,7 @@ gallivm_compile_module(struct gallivm_state *gallivm)
          gallivm->cache->jit_obj_cache = (void *)objcache;
       }
       auto *objcache = (LPObjectCacheORC *)gallivm->cache->jit_obj_cache;
-      LPJit::set_object_cache(objcache);
+      LPJit::set_object_cache(gallivm->module_name, objcache);
    }
    /* defer compilation till first lookup by gallivm_jit_function */
 }
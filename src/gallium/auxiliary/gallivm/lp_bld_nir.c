@@ -1133,7 +1133,14 @@ visit_alu(struct lp_build_nir_context *bld_base,
                            result[0], temp_chan);
       }
    } else if (is_aos(bld_base)) {
-      result[0] = do_alu_action(bld_base, instr, src_bit_size, src);
+      if (lp_nir_is_float_precision_conversion(instr->op)) {
+         /* AOS values are unorm8 whatever their NIR bit size. */
+         result[0] = src[0];
+      } else {
+         for (unsigned i = 0; i < nir_op_infos[instr->op].num_inputs; i++)
+            src_bit_size[i] = 32;
+         result[0] = do_alu_action(bld_base, instr, src_bit_size, src);
+      }
    } else {
       /* Loop for R,G,B,A channels */
       for (unsigned c = 0; c < num_components; c++) {
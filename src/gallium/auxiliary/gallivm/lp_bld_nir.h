@@ -335,6 +335,28 @@ void
 lp_build_opt_nir(struct nir_shader *nir);
 
 
+/*
+ * Is this a float-to-float precision conversion, as inserted when mediump
+ * values get lowered to 16 bits?  The AoS/linear path works on unorm8
+ * values which carry less precision than either side, so these are no-ops
+ * there.
+ */
+static inline bool
+lp_nir_is_float_precision_conversion(nir_op op)
+{
+   switch (op) {
+   case nir_op_f2f16:
+   case nir_op_f2f16_rtne:
+   case nir_op_f2f16_rtz:
+   case nir_op_f2fmp:
+   case nir_op_f2f32:
+      return true;
+   default:
+      return false;
+   }
+}
+
+
 static inline LLVMValueRef
 lp_nir_array_build_gather_values(LLVMBuilderRef builder,
                                  LLVMValueRef * values,
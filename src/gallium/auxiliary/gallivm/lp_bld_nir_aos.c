@@ -334,7 +334,8 @@ emit_load_const(struct lp_build_nir_context *bld_base,
    if (nc == 4)
       do_swizzle = true;
 
-   /* The constant is something like {float, float, float, float}.
+   /* The constant is something like {float, float, float, float}, in
+    * 16 bits if it was mediump.
     * We need to convert the float values from [0,1] to ubyte in [0,255].
     * We previously checked for values outside [0,1] in
     * llvmpipe_nir_fn_is_linear_compat().
@@ -345,9 +346,11 @@ emit_load_const(struct lp_build_nir_context *bld_base,
    assert(bld_base->base.type.length <= ARRAY_SIZE(elems));
    for (unsigned i = 0; i < bld_base->base.type.length; i++) {
       const unsigned j = do_swizzle ? bld->swizzles[i % nc] : i % nc;
-      assert(instr->value[j].f32 >= 0.0f);
-      assert(instr->value[j].f32 <= 1.0f);
-      const unsigned u8val = float_to_ubyte(instr->value[j].f32);
+      const float val = nir_const_value_as_float(instr->value[j],
+                                                 instr->def.bit_size);
+      assert(val >= 0.0f);
+      assert(val <= 1.0f);
+      const unsigned u8val = float_to_ubyte(val);
       elems[i] = LLVMConstInt(bld_base->uint_bld.int_elem_type, u8val, 0);
    }
    outval[0] = LLVMConstVector(elems, bld_base->base.type.length);
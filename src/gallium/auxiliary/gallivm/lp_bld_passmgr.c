@@ -59,6 +59,7 @@
 #if USE_NEW_PASS == 0
 struct lp_passmgr {
    LLVMPassManagerRef passmgr;
+   LLVMPassManagerRef fastpassmgr;
 #if HAVE_CORO == 1
    LLVMPassManagerRef cgpassmgr;
 #endif
@@ -82,6 +83,13 @@ lp_passmgr_create(LLVMModuleRef module, struct lp_passmgr **mgr_p)
       return false;
    }
 
+   mgr->fastpassmgr = LLVMCreateFunctionPassManagerForModule(module);
+   if (!mgr->fastpassmgr) {
+      LLVMDisposePassManager(mgr->passmgr);
+      free(mgr);
+      return false;
+   }
+
 #if HAVE_CORO == 1
    mgr->cgpassmgr = LLVMCreatePassManager();
 #endif
@@ -131,15 +139,25 @@ lp_passmgr_create(LLVMModuleRef module, struct lp_passmgr **mgr_p)
 #endif
       LLVMAddInstructionCombiningPass(mgr->passmgr);
       LLVMAddGVNPass(mgr->passmgr);
+
+      /*
+       * Fast pipeline: just enough to get rid of the allocas and the
+       * most obvious redundancies before handing the code to the backend.
+       */
+      LLVMAddPromoteMemoryToRegisterPass(mgr->fastpassmgr);
+      LLVMAddEarlyCSEPass(mgr->fastpassmgr);
+      LLVMAddCFGSimplificationPass(mgr->fastpassmgr);
    }
    else {
       /* We need at least this pass to prevent the backends to fail in
        * unexpected ways.
        */
       LLVMAddPromoteMemoryToRegisterPass(mgr->passmgr);
+      LLVMAddPromoteMemoryToRegisterPass(mgr->fastpassmgr);
    }
 #if HAVE_CORO == 1
    LLVMAddCoroCleanupPass(mgr->passmgr);
+   LLVMAddCoroCleanupPass(mgr->fastpassmgr);
 #endif
 #endif
    *mgr_p = mgr;
@@ -150,7 +168,8 @@ void
 lp_passmgr_run(struct lp_passmgr *mgr,
                LLVMModuleRef module,
                LLVMTargetMachineRef tm,
-               const char *module_name)
+               const char *module_name,
+               enum lp_passmgr_opt_level opt_level)
 {
    int64_t time_begin;
 
@@ -170,14 +189,16 @@ lp_passmgr_run(struct lp_passmgr *mgr,
    LLVMPassBuilderOptionsRef opts = LLVMCreatePassBuilderOptions();
    LLVMRunPasses(module, passes, tm, opts);
 
-   if (!(gallivm_perf & GALLIVM_PERF_NO_OPT))
+   if (gallivm_perf & GALLIVM_PERF_NO_OPT)
+      strcpy(passes, "mem2reg");
+   else if (opt_level == LP_PASSMGR_OPT_FAST)
+      strcpy(passes, "mem2reg,early-cse,simplifycfg");
+   else
 #if LLVM_VERSION_MAJOR >= 18
       strcpy(passes, "sroa,early-cse,simplifycfg,reassociate,mem2reg,instsimplify,instcombine<no-verify-fixpoint>");
 #else
       strcpy(passes, "sroa,early-cse,simplifycfg,reassociate,mem2reg,instsimplify,instcombine");
 #endif
-   else
-      strcpy(passes, "mem2reg");
 
    LLVMRunPasses(module, passes, tm, opts);
    LLVMDisposePassBuilderOptions(opts);
@@ -186,7 +207,9 @@ lp_passmgr_run(struct lp_passmgr *mgr,
    LLVMRunPassManager(mgr->cgpassmgr, module);
 #endif
    /* Run optimization passes */
-   LLVMInitializeFunctionPassManager(mgr->passmgr);
+   LLVMPassManagerRef passmgr =
+      opt_level == LP_PASSMGR_OPT_FAST ? mgr->fastpassmgr : mgr->passmgr;
+   LLVMInitializeFunctionPassManager(passmgr);
    LLVMValueRef func;
    func = LLVMGetFirstFunction(module);
    while (func) {
@@ -201,29 +224,40 @@ lp_passmgr_run(struct lp_passmgr *mgr,
       LLVMAddTargetDependentFunctionAttr(func, "no-frame-pointer-elim-non-leaf", "true");
 #endif
 
-      LLVMRunFunctionPassManager(mgr->passmgr, func);
+      LLVMRunFunctionPassManager(passmgr, func);
       func = LLVMGetNextFunction(func);
    }
-   LLVMFinalizeFunctionPassManager(mgr->passmgr);
+   LLVMFinalizeFunctionPassManager(passmgr);
 #endif
    if (gallivm_debug & GALLIVM_DEBUG_PERF) {
       int64_t time_end = os_time_get();
       int time_msec = (int)((time_end - time_begin) / 1000);
       assert(module_name);
-      debug_printf("optimizing module %s took %d msec\n",
-                   module_name, time_msec);
+      debug_printf("optimizing module %s%s took %d msec\n",
+                   module_name,
+                   opt_level == LP_PASSMGR_OPT_FAST ? " (fast)" : "",
+                   time_msec);
    }
 }
 
 void
 lp_passmgr_dispose(struct lp_passmgr *mgr)
 {
+   /* gallivm_destroy() calls this again after gallivm_free_ir(). */
+   if (!mgr)
+      return;
+
 #if USE_NEW_PASS == 0
    if (mgr->passmgr) {
       LLVMDisposePassManager(mgr->passmgr);
       mgr->passmgr = NULL;
    }
 
+   if (mgr->fastpassmgr) {
+      LLVMDisposePassManager(mgr->fastpassmgr);
+      mgr->fastpassmgr = NULL;
+   }
+
 #if HAVE_CORO == 1
    if (mgr->cgpassmgr) {
       LLVMDisposePassManager(mgr->cgpassmgr);
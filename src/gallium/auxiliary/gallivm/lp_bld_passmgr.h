@@ -37,6 +37,19 @@ extern "C" {
 
 struct lp_passmgr;
 
+/**
+ * Optimization pipeline to run on a module.
+ *
+ * LP_PASSMGR_OPT_FAST runs only the passes needed for correct and
+ * reasonable code, trading steady state throughput for shorter compile
+ * stalls.  Drivers can use it for a first compile and recompile the
+ * shaders that turn out to be hot with LP_PASSMGR_OPT_DEFAULT.
+ */
+enum lp_passmgr_opt_level {
+   LP_PASSMGR_OPT_DEFAULT = 0,
+   LP_PASSMGR_OPT_FAST,
+};
+
 /*
  * mgr can be returned as NULL for modern pass mgr handling
  * so use a bool to denote success/fail.
@@ -45,7 +58,8 @@ bool lp_passmgr_create(LLVMModuleRef module, struct lp_passmgr **mgr);
 void lp_passmgr_run(struct lp_passmgr *mgr,
                     LLVMModuleRef module,
                     LLVMTargetMachineRef tm,
-                    const char *module_name);
+                    const char *module_name,
+                    enum lp_passmgr_opt_level opt_level);
 void lp_passmgr_dispose(struct lp_passmgr *mgr);
 
 #ifdef __cplusplus
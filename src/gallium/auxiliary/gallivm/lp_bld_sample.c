@@ -2121,6 +2121,17 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
 
    if (block_length == 1) {
       subcoord = bld->zero;
+   } else if (!util_is_power_of_two_nonzero(block_length)) {
+      /*
+       * Only ASTC has blocks which aren't a power of two. LLVM turns the
+       * division by a constant into a multiplication.
+       */
+      LLVMValueRef block_width = lp_build_const_int_vec(bld->gallivm, bld->type,
+                                                        block_length);
+      LLVMValueRef block_coord = LLVMBuildUDiv(builder, coord, block_width, "");
+      subcoord = LLVMBuildSub(builder, coord,
+                              LLVMBuildMul(builder, block_coord, block_width, ""), "");
+      coord = block_coord;
    } else {
       /*
        * Pixel blocks have power of two dimensions. LLVM should convert the
@@ -2958,8 +2958,9 @@ lp_build_clamp_border_color(struct lp_build_sample_context *bld,
       }
    } else {
       /* cannot figure this out from format description */
-      if (format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC) {
-         /* s3tc formats are always unorm */
+      if (format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC ||
+          format_desc->layout == UTIL_FORMAT_LAYOUT_ASTC) {
+         /* s3tc and (ldr) astc formats are always unorm */
          min_clamp = vec4_bld.zero;
          max_clamp = vec4_bld.one;
       } else if (format_desc->layout == UTIL_FORMAT_LAYOUT_RGTC ||
@@ -2971,6 +2972,14 @@ lp_build_clamp_border_color(struct lp_build_sample_context *bld,
          case PIPE_FORMAT_LATC1_UNORM:
          case PIPE_FORMAT_LATC2_UNORM:
          case PIPE_FORMAT_ETC1_RGB8:
+         case PIPE_FORMAT_ETC2_RGB8:
+         case PIPE_FORMAT_ETC2_SRGB8:
+         case PIPE_FORMAT_ETC2_RGB8A1:
+         case PIPE_FORMAT_ETC2_SRGB8A1:
+         case PIPE_FORMAT_ETC2_RGBA8:
+         case PIPE_FORMAT_ETC2_SRGBA8:
+         case PIPE_FORMAT_ETC2_R11_UNORM:
+         case PIPE_FORMAT_ETC2_RG11_UNORM:
          case PIPE_FORMAT_BPTC_RGBA_UNORM:
          case PIPE_FORMAT_BPTC_SRGBA:
             min_clamp = vec4_bld.zero;
@@ -2980,6 +2989,8 @@ lp_build_clamp_border_color(struct lp_build_sample_context *bld,
          case PIPE_FORMAT_RGTC2_SNORM:
          case PIPE_FORMAT_LATC1_SNORM:
          case PIPE_FORMAT_LATC2_SNORM:
+         case PIPE_FORMAT_ETC2_R11_SNORM:
+         case PIPE_FORMAT_ETC2_RG11_SNORM:
             min_clamp = lp_build_const_vec(gallivm, vec4_type, -1.0F);
             max_clamp = vec4_bld.one;
             break;
@@ -3729,7 +3740,8 @@ lp_build_sample_soa_code(struct gallivm_state *gallivm,
 
    /* Note that mip_offsets is an array[level] of offsets to texture images */
 
-   if (dynamic_state->cache_ptr && thread_data_ptr) {
+   if (dynamic_state->cache_ptr && thread_data_ptr &&
+       lp_build_format_uses_cache(bld.format_desc)) {
       bld.cache = dynamic_state->cache_ptr(gallivm, thread_data_type,
                                            thread_data_ptr, texture_index);
    }
@@ -4199,7 +4211,7 @@ lp_build_sample_gen_func(struct gallivm_state *gallivm,
    if (dynamic_state->cache_ptr) {
       const struct util_format_description *format_desc;
       format_desc = util_format_description(static_texture_state->format);
-      if (format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC) {
+      if (lp_build_format_uses_cache(format_desc)) {
          need_cache = true;
       }
    }
@@ -4324,7 +4336,7 @@ lp_build_sample_soa_func(struct gallivm_state *gallivm,
    if (dynamic_state->cache_ptr) {
       const struct util_format_description *format_desc;
       format_desc = util_format_description(static_texture_state->format);
-      if (format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC) {
+      if (lp_build_format_uses_cache(format_desc)) {
          need_cache = true;
       }
    }
@@ -1321,9 +1321,23 @@ hud_parse_env_var(struct hud_context *hud, struct pipe_screen *screen,
       else if (strcmp(name, "API-thread-num-batches") == 0) {
          hud_thread_counter_install(pane, name, HUD_COUNTER_BATCHES);
       }
+      else if (strcmp(name, "API-thread-merged-draws") == 0) {
+         hud_thread_counter_install(pane, name, HUD_COUNTER_MERGED_DRAWS);
+      }
       else if (strcmp(name, "main-thread-busy") == 0) {
          hud_thread_busy_install(pane, name, true);
       }
+      else if (strcmp(name, "st-validate-time") == 0) {
+         hud_validate_graph_install(pane, name, NULL, false);
+         pane->type = PIPE_DRIVER_QUERY_TYPE_MICROSECONDS;
+      }
+      else if (strncmp(name, "st-validate-time-", 17) == 0) {
+         hud_validate_graph_install(pane, name, name + 17, false);
+         pane->type = PIPE_DRIVER_QUERY_TYPE_MICROSECONDS;
+      }
+      else if (strncmp(name, "st-validate-calls-", 18) == 0) {
+         hud_validate_graph_install(pane, name, name + 18, true);
+      }
 #ifdef HAVE_GALLIUM_EXTRA_HUD
       else if (sscanf(name, "nic-rx-%s", arg_name) == 1) {
          hud_nic_graph_install(pane, arg_name, NIC_DIRECTION_RX);
@@ -1640,6 +1654,10 @@ print_help(struct pipe_screen *screen)
    for (i = 0; i < num_cpus; i++)
       printf("    cpu%i\n", i);
 
+   puts("    st-validate-time (GL state validation time per frame)");
+   puts("    st-validate-time-[function], e.g. st-validate-time-st_update_array");
+   puts("    st-validate-calls-[function]");
+
    if (has_occlusion_query(screen))
       puts("    samples-passed");
    if (has_streamout(screen))
@@ -2106,3 +2124,18 @@ hud_add_queue_for_monitoring(struct hud_context *hud,
    assert(!hud->monitored_queue);
    hud->monitored_queue = queue_info;
 }
+
+/**
+ * Return the structure where the GL frontend should record the time spent
+ * in each state validation function, or NULL if no graph shows it or \p cso
+ * isn't the context the HUD records from.  The graphs are only updated by
+ * the record context, so no other context of a share group may write it.
+ */
+struct st_validate_monitoring *
+hud_get_validate_monitoring(struct hud_context *hud, struct cso_context *cso)
+{
+   if (!hud->monitor_validate || hud->record_pipe != cso->pipe)
+      return NULL;
+
+   return &hud->validate;
+}
@@ -34,6 +34,7 @@ struct pipe_context;
 struct pipe_resource;
 struct util_queue_monitoring;
 struct st_context;
+struct st_validate_monitoring;
 
 typedef void (*hud_st_invalidate_state_func)(struct st_context *st,
                                              unsigned flags);
@@ -57,4 +58,7 @@ void
 hud_add_queue_for_monitoring(struct hud_context *hud,
                              struct util_queue_monitoring *queue_info);
 
+struct st_validate_monitoring *
+hud_get_validate_monitoring(struct hud_context *hud, struct cso_context *cso);
+
 #endif
@@ -424,6 +424,10 @@ static unsigned get_counter(struct hud_graph *gr, enum hud_counter counter)
       value = mon->num_batches;
       mon->num_batches = 0;
       return value;
+   case HUD_COUNTER_MERGED_DRAWS:
+      value = mon->num_merged_draws;
+      mon->num_merged_draws = 0;
+      return value;
    default:
       assert(0);
       return 0;
@@ -474,3 +478,108 @@ void hud_thread_counter_install(struct hud_pane *pane, const char *name,
    hud_pane_add_graph(pane, gr);
    hud_pane_set_max_value(pane, 100);
 }
+
+struct validate_info {
+   char atom_name[64];
+   int atom;          /* -1 = all atoms, -2 = not looked up yet */
+   bool calls;
+   uint64_t last_value;
+   unsigned num_frames;
+   int64_t last_time;
+};
+
+static uint64_t
+get_validate_value(struct hud_graph *gr)
+{
+   struct validate_info *info = gr->query_data;
+   struct st_validate_monitoring *mon = &gr->pane->hud->validate;
+   const uint64_t *counters = info->calls ? mon->num_calls : mon->time_ns;
+   uint64_t value = 0;
+
+   /* The names are only there once a context started using the HUD. */
+   if (info->atom == -2) {
+      for (unsigned i = 0; i < mon->num_atoms; i++) {
+         if (!strcmp(mon->atom_names[i], info->atom_name)) {
+            info->atom = i;
+            break;
+         }
+      }
+   }
+
+   if (info->atom >= 0)
+      return counters[info->atom];
+
+   if (info->atom == -1) {
+      for (unsigned i = 0; i < mon->num_atoms; i++)
+         value += counters[i];
+   }
+   return value;
+}
+
+static void
+query_validate(struct hud_graph *gr, struct pipe_context *pipe)
+{
+   struct validate_info *info = gr->query_data;
+   int64_t now = os_time_get_nano();
+
+   info->num_frames++;
+
+   if (info->last_time) {
+      if (info->last_time + gr->pane->period*1000 <= now) {
+         uint64_t value = get_validate_value(gr);
+         double per_frame = (double)(value - info->last_value) /
+                            info->num_frames;
+
+         /* Time is shown in microseconds. */
+         hud_graph_add_value(gr, info->calls ? per_frame : per_frame / 1000);
+         info->last_value = value;
+         info->num_frames = 0;
+         info->last_time = now;
+      }
+   } else {
+      /* initialize */
+      info->last_value = get_validate_value(gr);
+      info->num_frames = 0;
+      info->last_time = now;
+   }
+}
+
+/**
+ * Graph of the time spent in or the number of calls of one state validation
+ * function per frame, or the time spent in all of them if \p atom_name is
+ * NULL.
+ */
+void hud_validate_graph_install(struct hud_pane *pane, const char *name,
+                                const char *atom_name, bool calls)
+{
+   struct hud_graph *gr = CALLOC_STRUCT(hud_graph);
+   struct validate_info *info;
+
+   if (!gr)
+      return;
+
+   strcpy(gr->name, name);
+
+   gr->query_data = info = CALLOC_STRUCT(validate_info);
+   if (!gr->query_data) {
+      FREE(gr);
+      return;
+   }
+
+   if (atom_name) {
+      snprintf(info->atom_name, sizeof(info->atom_name), "%s", atom_name);
+      info->atom = -2;
+   } else {
+      info->atom = -1;
+   }
+   info->calls = calls;
+   gr->query_new_value = query_validate;
+
+   /* Don't use free() as our callback as that messes up Gallium's
+    * memory debugger.  Use simple free_query_data() wrapper.
+    */
+   gr->free_query_data = free_query_data;
+
+   pane->hud->monitor_validate = true;
+   hud_pane_add_graph(pane, gr);
+}
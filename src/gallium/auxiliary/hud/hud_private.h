@@ -34,12 +34,14 @@
 #include "hud/font.h"
 #include "hud/hud_context.h"
 #include "cso_cache/cso_context.h"
+#include "frontend/api.h"
 
 enum hud_counter {
    HUD_COUNTER_OFFLOADED,
    HUD_COUNTER_DIRECT,
    HUD_COUNTER_SYNCS,
    HUD_COUNTER_BATCHES,
+   HUD_COUNTER_MERGED_DRAWS,
 };
 
 struct hud_context {
@@ -62,6 +64,10 @@ struct hud_context {
 
    struct util_queue_monitoring *monitored_queue;
 
+   /* Filled in by the GL frontend of the record context if a graph needs it. */
+   struct st_validate_monitoring validate;
+   bool monitor_validate;
+
    /* states */
    struct pipe_blend_state no_blend, alpha_blend;
    struct pipe_depth_stencil_alpha_state dsa;
@@ -172,6 +178,8 @@ void hud_cpu_graph_install(struct hud_pane *pane, unsigned cpu_index);
 void hud_thread_busy_install(struct hud_pane *pane, const char *name, bool main);
 void hud_thread_counter_install(struct hud_pane *pane, const char *name,
                                 enum hud_counter counter);
+void hud_validate_graph_install(struct hud_pane *pane, const char *name,
+                                const char *atom_name, bool calls);
 void hud_pipe_query_install(struct hud_batch_query_context **pbq,
                             struct hud_pane *pane,
                             const char *name,
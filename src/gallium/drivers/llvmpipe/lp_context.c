@@ -61,6 +61,10 @@ llvmpipe_destroy(struct pipe_context *pipe)
    mtx_unlock(&lp_screen->ctx_mutex);
    lp_print_counters();
 
+   /* Shader precompiles still in flight reference this context */
+   if (util_queue_is_initialized(&lp_screen->compile_queue))
+      util_queue_finish(&lp_screen->compile_queue);
+
    if (llvmpipe->csctx) {
       lp_csctx_destroy(llvmpipe->csctx);
    }
@@ -103,6 +107,8 @@ llvmpipe_destroy(struct pipe_context *pipe)
       pipe_vertex_buffer_unreference(&llvmpipe->vertex_buffer[i]);
    }
 
+   lp_fence_reference(&llvmpipe->copy_fence, NULL);
+
    lp_delete_setup_variants(llvmpipe);
 
    llvmpipe_sampler_matrix_destroy(llvmpipe);
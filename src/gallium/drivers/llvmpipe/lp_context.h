@@ -51,6 +51,7 @@ struct draw_stage;
 struct draw_vertex_shader;
 struct lp_fragment_shader;
 struct lp_compute_shader;
+struct lp_fence;
 struct lp_blend_state;
 struct lp_setup_context;
 struct lp_setup_variant;
@@ -119,6 +120,11 @@ struct llvmpipe_context {
 
    uint64_t dirty; /**< Mask of LP_NEW_x flags */
    unsigned cs_dirty; /**< Mask of LP_CSNEW_x flags */
+
+   /** Scene with the last binned copy into a buffer, see
+    * llvmpipe_wait_shader_buffer_writes()
+    */
+   struct lp_fence *copy_fence;
    /** Mapped vertex buffers */
    uint8_t *mapped_vbuffer[PIPE_MAX_ATTRIBS];
 
@@ -165,6 +171,9 @@ struct llvmpipe_context {
    unsigned nr_fs_variants;
    unsigned nr_fs_instrs;
 
+   /** Currently bound fragment shader variant */
+   struct lp_fragment_shader_variant *fs_variant;
+
    bool permit_linear_rasterizer;
    bool single_vp;
 
@@ -65,6 +65,8 @@
 #define PERF_NO_ALPHATEST   0x80  	/* disable alpha testing */
 #define PERF_NO_RAST_LINEAR 0x100  	/* disable linear rast */
 #define PERF_NO_SHADE       0x200  	/* disable fragment shaders */
+#define PERF_NO_LAZY_CLEAR  0x400  	/* write color clears immediately */
+#define PERF_TIERED_COMPILE 0x800  	/* fast fs compile, optimize hot variants */
 
 
 extern int LP_PERF;
@@ -35,10 +35,13 @@
 #include "pipe/p_context.h"
 #include "util/u_draw.h"
 #include "util/u_prim.h"
+#include "util/perf/cpu_trace.h"
 
 #include "lp_context.h"
+#include "lp_flush.h"
 #include "lp_state.h"
 #include "lp_query.h"
+#include "lp_texture.h"
 
 #include "draw/draw_context.h"
 
@@ -65,6 +68,8 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info,
    const void *mapped_indices = NULL;
    unsigned i;
 
+   MESA_TRACE_FUNC();
+
    if (!llvmpipe_check_render_cond(lp))
       return;
 
@@ -76,6 +81,15 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info,
    if (lp->dirty)
       llvmpipe_update_derived(lp);
 
+   if (lp->fs_variant)
+      llvmpipe_fs_variant_tier_up(lp, lp->fs_variant);
+
+   /* The draw module reads buffers right away, not in scene order */
+   llvmpipe_wait_shader_buffer_writes(lp, PIPE_SHADER_VERTEX);
+   llvmpipe_wait_shader_buffer_writes(lp, PIPE_SHADER_TESS_CTRL);
+   llvmpipe_wait_shader_buffer_writes(lp, PIPE_SHADER_TESS_EVAL);
+   llvmpipe_wait_shader_buffer_writes(lp, PIPE_SHADER_GEOMETRY);
+
    /*
     * Map vertex buffers
     */
@@ -87,6 +101,7 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info,
          if (!lp->vertex_buffer[i].buffer.resource) {
             continue;
          }
+         llvmpipe_wait_buffer_write(lp, lp->vertex_buffer[i].buffer.resource);
          buf = llvmpipe_resource_data(lp->vertex_buffer[i].buffer.resource);
          size = lp->vertex_buffer[i].buffer.resource->width0;
       }
@@ -98,6 +113,7 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info,
       unsigned available_space = ~0;
       mapped_indices = info->has_user_indices ? info->index.user : NULL;
       if (!mapped_indices) {
+         llvmpipe_wait_buffer_write(lp, info->index.resource);
          mapped_indices = llvmpipe_resource_data(info->index.resource);
          available_space = info->index.resource->width0;
       }
@@ -41,6 +41,7 @@
 #include "lp_fence.h"
 #include "lp_screen.h"
 #include "lp_rast.h"
+#include "lp_texture.h"
 
 
 /**
@@ -147,3 +148,66 @@ llvmpipe_flush_resource(struct pipe_context *pipe,
 
    return true;
 }
+
+
+/**
+ * Wait for a copy into the buffer the rasterizer still has to do, see
+ * lp_setup_copy_to_buffer().
+ */
+void
+llvmpipe_wait_buffer_write(struct llvmpipe_context *lp,
+                           struct pipe_resource *resource)
+{
+   struct llvmpipe_resource *lpr = llvmpipe_resource(resource);
+
+   if (!lpr->write_fence)
+      return;
+
+   if (!lp_fence_signalled(lpr->write_fence)) {
+      if (lp_fence_issued(lpr->write_fence))
+         lp_fence_wait(lpr->write_fence);
+      else
+         llvmpipe_finish(&lp->pipe, "buffer write");
+   }
+   lp_fence_reference(&lpr->write_fence, NULL);
+}
+
+
+/**
+ * All stages but the fragment shader read their buffers right away rather
+ * than in scene order, so wait for binned copies into any buffer bound to
+ * \p shader.  Binding a buffer doesn't catch this, as it may have been bound
+ * before the copy.
+ */
+void
+llvmpipe_wait_shader_buffer_writes(struct llvmpipe_context *lp,
+                                   enum pipe_shader_type shader)
+{
+   unsigned i;
+
+   if (!lp->copy_fence)
+      return;
+
+   /* Scenes finish in order, so all the copies are done */
+   if (lp_fence_signalled(lp->copy_fence)) {
+      lp_fence_reference(&lp->copy_fence, NULL);
+      return;
+   }
+
+   for (i = 0; i < ARRAY_SIZE(lp->constants[shader]); i++) {
+      if (lp->constants[shader][i].buffer)
+         llvmpipe_wait_buffer_write(lp, lp->constants[shader][i].buffer);
+   }
+   for (i = 0; i < ARRAY_SIZE(lp->ssbos[shader]); i++) {
+      if (lp->ssbos[shader][i].buffer)
+         llvmpipe_wait_buffer_write(lp, lp->ssbos[shader][i].buffer);
+   }
+   for (i = 0; i < lp->num_sampler_views[shader]; i++) {
+      if (lp->sampler_views[shader][i])
+         llvmpipe_wait_buffer_write(lp, lp->sampler_views[shader][i]->texture);
+   }
+   for (i = 0; i < lp->num_images[shader]; i++) {
+      if (lp->images[shader][i].resource)
+         llvmpipe_wait_buffer_write(lp, lp->images[shader][i].resource);
+   }
+}
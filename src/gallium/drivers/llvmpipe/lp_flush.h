@@ -29,7 +29,9 @@
 #define LP_FLUSH_H
 
 #include "util/compiler.h"
+#include "pipe/p_defines.h"
 
+struct llvmpipe_context;
 struct pipe_context;
 struct pipe_fence_handle;
 struct pipe_resource;
@@ -52,4 +54,12 @@ llvmpipe_flush_resource(struct pipe_context *pipe,
                         bool do_not_block,
                         const char *reason);
 
+void
+llvmpipe_wait_buffer_write(struct llvmpipe_context *lp,
+                           struct pipe_resource *resource);
+
+void
+llvmpipe_wait_shader_buffer_writes(struct llvmpipe_context *lp,
+                                   enum pipe_shader_type shader);
+
 #endif
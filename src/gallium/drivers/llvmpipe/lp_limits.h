@@ -81,6 +81,13 @@
  */
 #define LP_MAX_SHADER_INSTRUCTIONS (2048 * LP_MAX_SHADER_VARIANTS)
 
+/**
+ * Number of draws after which a fragment shader variant compiled with the
+ * fast pipeline gets recompiled with full optimizations
+ * (LP_PERF=tiered_compile).
+ */
+#define LP_FS_TIER_UP_DRAWS 64
+
 /**
  * Max number of setup variants that will be kept around.
  *
@@ -115,12 +115,16 @@ lp_print_counters(void)
 
 
       debug_printf("llvmpipe: nr_color_tile_clear:          %9u\n", lp_count.nr_color_tile_clear);
+      debug_printf("llvmpipe: nr_lazy_clear_recorded:       %9u\n", lp_count.nr_lazy_clear_recorded);
+      debug_printf("llvmpipe:   nr_resolved_in_rast_64x64:  %9u\n", lp_count.nr_lazy_clear_resolved_rast);
+      debug_printf("llvmpipe:   nr_resolved_on_cpu_64x64:   %9u\n", lp_count.nr_lazy_clear_resolved_cpu);
       debug_printf("llvmpipe: nr_color_tile_load:           %9u\n", lp_count.nr_color_tile_load);
       debug_printf("llvmpipe: nr_color_tile_store:          %9u\n", lp_count.nr_color_tile_store);
 
       debug_printf("llvmpipe: nr_llvm_compiles:             %u\n", lp_count.nr_llvm_compiles);
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
       debug_printf("llvmpipe: average LLVM compile time:    %.2f sec\n", lp_count.llvm_compile_time / 1000000.0 / lp_count.nr_llvm_compiles);
+      debug_printf("llvmpipe: nr_llvm_tier_ups:             %u\n", lp_count.nr_llvm_tier_ups);
 
    }
 }
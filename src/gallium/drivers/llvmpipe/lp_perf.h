@@ -64,8 +64,12 @@ struct lp_counters
    unsigned nr_non_empty_4;
    unsigned nr_llvm_compiles;
    int64_t llvm_compile_time;  /**< total, in microseconds */
+   unsigned nr_llvm_tier_ups;
 
    unsigned nr_color_tile_clear;
+   unsigned nr_lazy_clear_recorded;
+   unsigned nr_lazy_clear_resolved_rast;
+   unsigned nr_lazy_clear_resolved_cpu;
    unsigned nr_color_tile_load;
    unsigned nr_color_tile_store;
 };
@@ -35,6 +35,7 @@
 #include "util/u_thread.h"
 #include "util/u_memset.h"
 #include "util/os_time.h"
+#include "util/perf/cpu_trace.h"
 
 #include "lp_scene_queue.h"
 #include "lp_context.h"
@@ -89,6 +90,36 @@ lp_rast_end(struct lp_rasterizer *rast)
 }
 
 
+/**
+ * Fill the rasterizer's current tile of one color buffer with a packed
+ * clear value, for all bound layers and samples.
+ */
+static void
+lp_rast_fill_color_tile(struct lp_rasterizer_task *task,
+                        unsigned cbuf,
+                        union util_color *uc)
+{
+   const struct lp_scene *scene = task->scene;
+   const enum pipe_format format = scene->fb.cbufs[cbuf]->format;
+
+   for (unsigned s = 0; s < scene->cbufs[cbuf].nr_samples; s++) {
+      void *map = (char *) scene->cbufs[cbuf].map
+         + scene->cbufs[cbuf].sample_stride * s;
+      util_fill_box(map,
+                    format,
+                    scene->cbufs[cbuf].stride,
+                    scene->cbufs[cbuf].layer_stride,
+                    task->x,
+                    task->y,
+                    0,
+                    task->width,
+                    task->height,
+                    scene->fb_max_layer + 1,
+                    uc);
+   }
+}
+
+
 /**
  * Beginning rasterization of a tile.
  * \param x  window X position of the tile, in pixels
@@ -119,6 +150,16 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
          task->color_tiles[i] = scene->cbufs[i].map +
                                 scene->cbufs[i].stride * task->y +
                                 scene->cbufs[i].format_bytes * task->x;
+
+         /* First touch of a tile whose clear was deferred */
+         const struct lp_scene_surface *ssurf = &scene->cbufs[i];
+         if (ssurf->lazy_clear_tiles &&
+             BITSET_TEST(ssurf->lazy_clear_tiles,
+                         y * ssurf->lazy_clear_tiles_x + x)) {
+            union util_color uc = ssurf->lazy_clear_color;
+            lp_rast_fill_color_tile(task, i, &uc);
+            LP_COUNT(nr_lazy_clear_resolved_rast);
+         }
       }
    }
    if (scene->fb.zsbuf) {
@@ -156,21 +197,7 @@ lp_rast_clear_color(struct lp_rasterizer_task *task,
           "%s clear value (target format %d) raw 0x%x,0x%x,0x%x,0x%x\n",
           __func__, format, uc.ui[0], uc.ui[1], uc.ui[2], uc.ui[3]);
 
-   for (unsigned s = 0; s < scene->cbufs[cbuf].nr_samples; s++) {
-      void *map = (char *) scene->cbufs[cbuf].map
-         + scene->cbufs[cbuf].sample_stride * s;
-      util_fill_box(map,
-                    format,
-                    scene->cbufs[cbuf].stride,
-                    scene->cbufs[cbuf].layer_stride,
-                    task->x,
-                    task->y,
-                    0,
-                    task->width,
-                    task->height,
-                    scene->fb_max_layer + 1,
-                    &uc);
-   }
+   lp_rast_fill_color_tile(task, cbuf, &uc);
 
    /* this will increase for each rb which probably doesn't mean much */
    LP_COUNT(nr_color_tile_clear);
@@ -688,6 +715,59 @@ lp_rast_set_state(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Copy the part of a color buffer region covered by this tile into a
+ * buffer, converting it to the buffer's format.
+ * This is a bin command called during bin processing.
+ */
+static void
+lp_rast_copy_to_buffer(struct lp_rasterizer_task *task,
+                       const union lp_rast_cmd_arg arg)
+{
+   const struct lp_scene *scene = task->scene;
+   const struct lp_rast_copy_to_buffer *copy = arg.copy_to_buffer;
+   const struct lp_scene_surface *ssurf = &scene->cbufs[copy->cbuf];
+   const struct u_rect tile = {
+      task->x, task->x + task->width - 1,
+      task->y, task->y + task->height - 1
+   };
+   struct u_rect rect = copy->box;
+
+   if (!u_rect_test_intersection(&tile, &rect))
+      return;
+
+   u_rect_find_intersection(&tile, &rect);
+
+   const unsigned width = rect.x1 - rect.x0 + 1;
+   const unsigned height = rect.y1 - rect.y0 + 1;
+   const uint8_t *src = ssurf->map +
+                        rect.y0 * ssurf->stride +
+                        rect.x0 * ssurf->format_bytes;
+   uint8_t *dst = copy->dst +
+                  (rect.y0 - copy->box.y0) * copy->dst_stride +
+                  (rect.x0 - copy->box.x0) *
+                  util_format_get_blocksize(copy->dst_format);
+
+   LP_DBG(DEBUG_RAST, "%s %d,%d %ux%u\n", __func__,
+          rect.x0, rect.y0, width, height);
+
+   if (copy->dst_stride > 0) {
+      util_format_translate(copy->dst_format, dst, copy->dst_stride, 0, 0,
+                            copy->src_format, src, ssurf->stride, 0, 0,
+                            width, height);
+   } else {
+      /* bottom-up rows, one at a time */
+      for (unsigned y = 0; y < height; y++) {
+         util_format_translate(copy->dst_format, dst, 0, 0, 0,
+                               copy->src_format, src, 0, 0, 0,
+                               width, 1);
+         src += ssurf->stride;
+         dst += copy->dst_stride;
+      }
+   }
+}
+
+
 /**
  * Called when we're done writing to a color tile.
  */
@@ -756,6 +836,7 @@ rast_flags[] = {
    TRI,                         /* lp_rast_triangle_ms_3_4 */
    TRI,                         /* lp_rast_triangle_ms_3_16 */
    TRI,                         /* lp_rast_triangle_ms_4_16 */
+   TRI,                         /* copy_to_buffer */
    RECT,                        /* rectangle */
    BLIT,                        /* blit */
 };
@@ -804,6 +885,7 @@ dispatch_blit[] = {
    NULL,                        /* lp_rast_triangle_ms_3_4 */
    NULL,                        /* lp_rast_triangle_ms_3_16 */
    NULL,                        /* lp_rast_triangle_ms_4_16 */
+   NULL,                        /* copy_to_buffer */
    NULL,                        /* rectangle */
    lp_rast_blit_tile_to_dest,
 };
@@ -857,6 +939,7 @@ dispatch_tri[] = {
    lp_rast_triangle_ms_3_4,
    lp_rast_triangle_ms_3_16,
    lp_rast_triangle_ms_4_16,
+   lp_rast_copy_to_buffer,
    lp_rast_rectangle,
    lp_rast_blit_tile,
 };
@@ -907,6 +990,7 @@ dispatch_tri_debug[] =
    lp_rast_triangle_ms_3_4,
    lp_rast_triangle_ms_3_16,
    lp_rast_triangle_ms_4_16,
+   lp_rast_copy_to_buffer,
    lp_rast_rectangle,
    lp_rast_shade_tile,
 };
@@ -948,6 +1032,41 @@ blit_rasterize_bin(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Same as tri_rasterize_bin, but emits a trace slice per run of commands
+ * using the same fragment shader variant, so hot shaders show up in
+ * traces.
+ */
+static void
+trace_tri_rasterize_bin(struct lp_rasterizer_task *task,
+                        const struct cmd_bin *bin)
+{
+   const struct lp_fragment_shader_variant *current = NULL;
+
+   for (const struct cmd_block *block = bin->head; block; block = block->next) {
+      for (unsigned k = 0; k < block->count; k++) {
+         if (block->cmd[k] == LP_RAST_OP_SET_STATE &&
+             block->arg[k].set_state->variant != current) {
+            const struct lp_fragment_shader_variant *variant =
+               block->arg[k].set_state->variant;
+            char name[32];
+
+            if (current)
+               MESA_TRACE_END();
+            snprintf(name, sizeof name, "fs%u_variant%u",
+                     variant->shader->no, variant->no);
+            MESA_TRACE_BEGIN(name);
+            current = variant;
+         }
+         dispatch_tri[block->cmd[k]](task, block->arg[k]);
+      }
+   }
+
+   if (current)
+      MESA_TRACE_END();
+}
+
+
 static void
 tri_rasterize_bin(struct lp_rasterizer_task *task,
                   const struct cmd_bin *bin,
@@ -955,6 +1074,11 @@ tri_rasterize_bin(struct lp_rasterizer_task *task,
 {
    STATIC_ASSERT(ARRAY_SIZE(dispatch_tri) == LP_RAST_OP_MAX);
 
+   if (unlikely(util_perfetto_is_tracing_enabled())) {
+      trace_tri_rasterize_bin(task, bin);
+      return;
+   }
+
    for (const struct cmd_block *block = bin->head; block; block = block->next) {
       for (unsigned k = 0; k < block->count; k++) {
          dispatch_tri[block->cmd[k]](task, block->arg[k]);
@@ -989,15 +1113,19 @@ rasterize_bin(struct lp_rasterizer_task *task,
 {
    struct lp_bin_info info = lp_characterize_bin(bin);
 
+   MESA_TRACE_SCOPE("lp_rast_tile");
+
    lp_rast_tile_begin(task, bin, x, y);
 
    if (LP_DEBUG & DEBUG_NO_FASTPATH) {
       debug_rasterize_bin(task, bin);
    } else if (info.type & LP_RAST_FLAGS_BLIT) {
+      MESA_TRACE_SCOPE("lp_rast_tile_blit");
       blit_rasterize_bin(task, bin);
    } else if (task->scene->permit_linear_rasterizer &&
             !(LP_PERF & PERF_NO_RAST_LINEAR) &&
             (info.type & LP_RAST_FLAGS_RECT)) {
+      MESA_TRACE_SCOPE("lp_rast_tile_linear");
       lp_linear_rasterize_bin(task, bin);
    } else {
       tri_rasterize_bin(task, bin, x, y);
@@ -1042,18 +1170,18 @@ static void
 rasterize_scene(struct lp_rasterizer_task *task,
                 struct lp_scene *scene)
 {
+   MESA_TRACE_FUNC();
+
    task->scene = scene;
 
    /* Clear the cache tags. This should not always be necessary but
     * simpler for now.
     */
-#if LP_USE_TEXTURE_CACHE
    memset(task->thread_data.cache->cache_tags, 0,
           sizeof(task->thread_data.cache->cache_tags));
 #if LP_BUILD_FORMAT_CACHE_DEBUG
    task->thread_data.cache->cache_access_total = 0;
    task->thread_data.cache->cache_access_miss = 0;
-#endif
 #endif
 
    if (!task->rast->no_rast) {
@@ -1177,7 +1305,10 @@ thread_function(void *init_data)
       /* wait for work */
       if (debug)
          debug_printf("thread %d waiting for work\n", task->thread_index);
-      util_semaphore_wait(&task->work_ready);
+      {
+         MESA_TRACE_SCOPE("lp_rast_idle");
+         util_semaphore_wait(&task->work_ready);
+      }
 
       if (rast->exit_flag)
          break;
@@ -1202,7 +1333,11 @@ thread_function(void *init_data)
       rasterize_scene(task, rast->curr_scene);
 
       /* wait for all threads to finish with this scene */
-      util_barrier_wait(&rast->barrier);
+      {
+         /* time spent here shows the load imbalance between threads */
+         MESA_TRACE_SCOPE("lp_rast_wait_threads");
+         util_barrier_wait(&rast->barrier);
+      }
 
       /* XXX: shouldn't be necessary:
        */
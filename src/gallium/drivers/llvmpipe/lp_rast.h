@@ -190,6 +190,20 @@ struct lp_rast_clear_rb {
 };
 
 
+/**
+ * Copy of a region of a color buffer into a buffer, e.g. glReadPixels into
+ * a PBO.  Each tile converts the part of the region it covers.
+ */
+struct lp_rast_copy_to_buffer {
+   struct u_rect box;            /**< inclusive, in framebuffer pixels */
+   unsigned cbuf;
+   enum pipe_format src_format;
+   enum pipe_format dst_format;
+   uint8_t *dst;                 /**< where pixel (box.x0, box.y0) goes */
+   int dst_stride;
+};
+
+
 /*
  * Return the address (as float[][4]) of the FS input values which
  * are immediately after the 'inputs' object.
@@ -259,6 +273,7 @@ union lp_rast_cmd_arg {
    } clear_zstencil;
    struct lp_fence *fence;
    struct llvmpipe_query *query_obj;
+   const struct lp_rast_copy_to_buffer *copy_to_buffer;
 };
 
 
@@ -347,6 +362,15 @@ lp_rast_arg_query(struct llvmpipe_query *pq)
 }
 
 
+static inline union lp_rast_cmd_arg
+lp_rast_arg_copy_to_buffer(const struct lp_rast_copy_to_buffer *copy)
+{
+   union lp_rast_cmd_arg arg;
+   arg.copy_to_buffer = copy;
+   return arg;
+}
+
+
 static inline union lp_rast_cmd_arg
 lp_rast_arg_null(void)
 {
@@ -402,9 +426,10 @@ enum lp_rast_op {
   LP_RAST_OP_MS_TRIANGLE_3_4 =   0x25,
   LP_RAST_OP_MS_TRIANGLE_3_16 =  0x26,
   LP_RAST_OP_MS_TRIANGLE_4_16 =  0x27,
-  LP_RAST_OP_RECTANGLE =         0x28,  /* Keep at end */
-  LP_RAST_OP_BLIT =              0x29,  /* Keep at end */
-  LP_RAST_OP_MAX =               0x2a,
+  LP_RAST_OP_COPY_TO_BUFFER =    0x28,
+  LP_RAST_OP_RECTANGLE =         0x29,  /* Keep at end */
+  LP_RAST_OP_BLIT =              0x2a,  /* Keep at end */
+  LP_RAST_OP_MAX =               0x2b,
   LP_RAST_OP_MASK =              0xff
 };
 
@@ -68,6 +68,7 @@ static const char *cmd_names[] =
    "lp_rast_triangle_ms_3_4",
    "lp_rast_triangle_ms_3_16",
    "lp_rast_triangle_ms_4_16",
+   "copy_to_buffer",
    "rectangle",
    "blit_tile",
 };
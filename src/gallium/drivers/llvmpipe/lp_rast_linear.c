@@ -224,6 +224,7 @@ dispatch_linear[] = {
    NULL,                        /* lp_rast_triangle_ms_3_4 */
    NULL,                        /* lp_rast_triangle_ms_3_16 */
    NULL,                        /* lp_rast_triangle_ms_4_16 */
+   NULL,                        /* copy_to_buffer */
 
    lp_rast_linear_rect,         /* rect */
    lp_rast_linear_tile,         /* blit */
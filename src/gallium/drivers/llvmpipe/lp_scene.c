@@ -31,6 +31,7 @@
 #include "util/reallocarray.h"
 #include "util/u_inlines.h"
 #include "util/format/u_format.h"
+#include "util/os_time.h"
 #include "lp_scene.h"
 #include "lp_fence.h"
 #include "lp_debug.h"
@@ -610,6 +611,8 @@ lp_scene_begin_binning(struct lp_scene *scene,
 {
    assert(lp_scene_is_empty(scene));
 
+   scene->binning_start = os_time_get_nano();
+
    util_copy_framebuffer_state(&scene->fb, fb);
 
    scene->tiles_x = align(fb->width, TILE_SIZE) / TILE_SIZE;
@@ -35,6 +35,7 @@
 #ifndef LP_SCENE_H
 #define LP_SCENE_H
 
+#include "util/bitset.h"
 #include "util/u_thread.h"
 #include "lp_rast.h"
 #include "lp_debug.h"
@@ -127,6 +128,14 @@ struct lp_scene_surface {
    unsigned format_bytes;
    unsigned sample_stride;
    unsigned nr_samples;
+
+   /* Snapshot of the resource's pending lazy clear, taken when binning
+    * starts.  Tiles set here are cleared by the rasterizer before their
+    * commands run.  NULL if nothing is pending.
+    */
+   const BITSET_WORD *lazy_clear_tiles;
+   unsigned lazy_clear_tiles_x;
+   union util_color lazy_clear_color;
 };
 
 
@@ -189,6 +198,9 @@ struct lp_scene {
    bool alloc_failed;
    bool permit_linear_rasterizer;
 
+   /** When binning started, in nanoseconds, for tracing */
+   int64_t binning_start;
+
    /**
     * Number of active tiles in each dimension.
     * This basically the framebuffer size divided by tile size
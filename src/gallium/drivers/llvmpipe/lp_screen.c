@@ -43,6 +43,7 @@
 #include "util/os_misc.h"
 #include "util/os_time.h"
 #include "util/u_helpers.h"
+#include "util/perf/cpu_trace.h"
 #include "util/anon_file.h"
 #include "lp_texture.h"
 #include "lp_fence.h"
@@ -55,6 +56,8 @@
 #include "lp_rast.h"
 #include "lp_cs_tpool.h"
 #include "lp_flush.h"
+#include "lp_state_fs.h"
+#include "lp_state_cs.h"
 
 #include "frontend/sw_winsys.h"
 
@@ -101,6 +104,8 @@ static const struct debug_named_value lp_perf_flags[] = {
    { "no_alphatest",   PERF_NO_ALPHATEST, NULL },
    { "no_rast_linear", PERF_NO_RAST_LINEAR, NULL },
    { "no_shade",       PERF_NO_SHADE, NULL },
+   { "no_lazy_clear",  PERF_NO_LAZY_CLEAR, NULL },
+   { "tiered_compile", PERF_TIERED_COMPILE, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -850,14 +855,14 @@ llvmpipe_is_format_supported(struct pipe_screen *_screen,
          return false;
    }
 
-   if (format_desc->layout == UTIL_FORMAT_LAYOUT_ASTC ||
-       format_desc->layout == UTIL_FORMAT_LAYOUT_ATC) {
+   if (format_desc->layout == UTIL_FORMAT_LAYOUT_ATC) {
       /* Software decoding is not hooked up. */
       return false;
    }
 
-   if (format_desc->layout == UTIL_FORMAT_LAYOUT_ETC &&
-       format != PIPE_FORMAT_ETC1_RGB8)
+   /* Only 2D ASTC blocks can be decoded. */
+   if (format_desc->layout == UTIL_FORMAT_LAYOUT_ASTC &&
+       format_desc->block.depth > 1)
       return false;
 
    /* planar not supported natively */
@@ -917,6 +922,9 @@ llvmpipe_destroy_screen(struct pipe_screen *_screen)
    if (screen->cs_tpool)
       lp_cs_tpool_destroy(screen->cs_tpool);
 
+   if (util_queue_is_initialized(&screen->compile_queue))
+      util_queue_destroy(&screen->compile_queue);
+
    if (screen->rast)
       lp_rast_destroy(screen->rast);
 
@@ -1025,6 +1033,73 @@ lp_get_disk_shader_cache(struct pipe_screen *_screen)
    return screen->disk_shader_cache;
 }
 
+/*
+ * The queue starts with one thread and adds more while jobs are waiting, up
+ * to max_threads.  Failing to create it just disables background compiles.
+ * Called with the late_mutex held.
+ */
+static bool
+lp_compile_queue_init(struct llvmpipe_screen *screen, unsigned max_threads)
+{
+   if (util_queue_is_initialized(&screen->compile_queue))
+      return true;
+
+   return util_queue_init(&screen->compile_queue, "lpcompile", 64,
+                          max_threads,
+                          UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                          UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY, NULL);
+}
+
+
+static void
+llvmpipe_set_max_shader_compiler_threads(struct pipe_screen *_screen,
+                                         unsigned max_threads)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
+
+   /* Zero threads means shaders get compiled at draw time, as before. */
+   if (!max_threads) {
+      screen->precompile_shaders = false;
+      return;
+   }
+
+   mtx_lock(&screen->late_mutex);
+   bool existed = util_queue_is_initialized(&screen->compile_queue);
+   if (!lp_compile_queue_init(screen, max_threads)) {
+      mtx_unlock(&screen->late_mutex);
+      return;
+   }
+   mtx_unlock(&screen->late_mutex);
+
+   if (existed)
+      util_queue_adjust_num_threads(&screen->compile_queue, max_threads,
+                                    false);
+   screen->precompile_shaders = true;
+}
+
+
+static bool
+llvmpipe_is_parallel_shader_compilation_finished(struct pipe_screen *_screen,
+                                                 void *shader,
+                                                 enum pipe_shader_type type)
+{
+   switch (type) {
+   case PIPE_SHADER_FRAGMENT: {
+      struct lp_fragment_shader *fs = shader;
+      return !fs->precompile.queued ||
+             util_queue_fence_is_signalled(&fs->precompile.fence);
+   }
+   case PIPE_SHADER_COMPUTE: {
+      struct lp_compute_shader *cs = shader;
+      return !cs->precompile.queued ||
+             util_queue_fence_is_signalled(&cs->precompile.fence);
+   }
+   default:
+      return true;
+   }
+}
+
+
 static int
 llvmpipe_screen_get_fd(struct pipe_screen *_screen)
 {
@@ -1107,6 +1182,15 @@ llvmpipe_screen_late_init(struct llvmpipe_screen *screen)
 
    lp_build_init(); /* get lp_native_vector_width initialised */
 
+   /*
+    * Precompiles guess the variant key from the state bound at creation
+    * and cost a full LLVM compile per shader, so the queue is only created
+    * once the application asks for compiler threads, or here for tiered
+    * compiles.
+    */
+   if (LP_PERF & PERF_TIERED_COMPILE)
+      lp_compile_queue_init(screen, MAX2(util_get_cpu_caps()->nr_cpus, 1));
+
    lp_disk_cache_create(screen);
    screen->late_init_done = true;
 out:
@@ -1126,6 +1210,8 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
 
    glsl_type_singleton_init_or_ref();
 
+   util_cpu_trace_init();
+
    LP_DEBUG = debug_get_flags_option("LP_DEBUG", lp_debug_flags, 0 );
 
    LP_PERF = debug_get_flags_option("LP_PERF", lp_perf_flags, 0 );
@@ -1164,6 +1250,10 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.finalize_nir = llvmpipe_finalize_nir;
 
    screen->base.get_disk_shader_cache = lp_get_disk_shader_cache;
+   screen->base.set_max_shader_compiler_threads =
+      llvmpipe_set_max_shader_compiler_threads;
+   screen->base.is_parallel_shader_compilation_finished =
+      llvmpipe_is_parallel_shader_compilation_finished;
    llvmpipe_init_screen_resource_funcs(&screen->base);
 
    screen->allow_cl = !!getenv("LP_CL");
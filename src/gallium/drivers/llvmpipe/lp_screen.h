@@ -38,6 +38,7 @@
 #include "pipe/p_defines.h"
 #include "util/u_thread.h"
 #include "util/list.h"
+#include "util/u_queue.h"
 #include "util/vma.h"
 #include "gallivm/lp_bld.h"
 #include "gallivm/lp_bld_misc.h"
@@ -63,6 +64,15 @@ struct llvmpipe_screen
    struct lp_cs_tpool *cs_tpool;
    mtx_t cs_mutex;
 
+   /* Shader compiles off the draw path: precompiles of newly created
+    * shaders and tiered recompiles (LP_PERF=tiered_compile).
+    */
+   struct util_queue compile_queue;
+   /* Set by glMaxShaderCompilerThreadsKHR, through
+    * set_max_shader_compiler_threads.
+    */
+   bool precompile_shaders;
+
    bool allow_cl;
 
    mtx_t late_mutex;
@@ -43,6 +43,7 @@
 #include "util/u_viewport.h"
 #include "draw/draw_pipe.h"
 #include "util/os_time.h"
+#include "util/perf/cpu_trace.h"
 #include "lp_context.h"
 #include "lp_memory.h"
 #include "lp_scene.h"
@@ -196,6 +197,180 @@ lp_setup_reset(struct lp_setup_context *setup)
 }
 
 
+/**
+ * Does the scene's color buffer 'cbuf' cover exactly the surface described
+ * by the resource's pending lazy clear, so that clearing scene tiles
+ * resolves the clear tile by tile?
+ */
+static bool
+lp_setup_lazy_clear_matches(const struct lp_scene *scene, unsigned cbuf)
+{
+   const struct pipe_surface *surf = scene->fb.cbufs[cbuf];
+   const struct llvmpipe_resource *lpr =
+      llvmpipe_resource_const(surf->texture);
+   const struct llvmpipe_lazy_clear *lc = &lpr->lazy_clear;
+
+   return lc->level == surf->u.tex.level &&
+          lc->first_layer == surf->u.tex.first_layer &&
+          lc->last_layer - lc->first_layer == scene->fb_max_layer &&
+          lc->format == surf->format &&
+          scene->fb.width == u_minify(lpr->base.width0, lc->level) &&
+          scene->fb.height == u_minify(lpr->base.height0, lc->level);
+}
+
+
+/**
+ * Write out a pending lazy clear from the setup thread.  Scenes already
+ * queued may still be rasterizing tiles of the resource, so wait for them.
+ */
+static void
+lp_setup_apply_lazy_clear(struct lp_setup_context *setup,
+                          struct llvmpipe_resource *lpr)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(setup->pipe->screen);
+   struct lp_fence *fence = NULL;
+
+   mtx_lock(&screen->rast_mutex);
+   lp_rast_fence(screen->rast, &fence);
+   mtx_unlock(&screen->rast_mutex);
+
+   if (fence) {
+      lp_fence_wait(fence);
+      lp_fence_reference(&fence, NULL);
+   }
+
+   llvmpipe_resource_apply_lazy_clear(lpr);
+}
+
+
+/**
+ * Can a clear of color buffer 'cbuf' be recorded in the resource instead of
+ * being binned into every tile?
+ */
+static bool
+lp_setup_can_lazy_clear(struct lp_setup_context *setup, unsigned cbuf)
+{
+   struct llvmpipe_context *lp = llvmpipe_context(setup->pipe);
+   const struct lp_scene *scene = setup->scene;
+   const struct pipe_surface *surf = scene->fb.cbufs[cbuf];
+
+   if (!surf ||
+       !llvmpipe_resource_is_texture(surf->texture) ||
+       !llvmpipe_resource_can_lazy_clear(surf->texture))
+      return false;
+
+   /* The clear is only binned for the layers all attachments have. */
+   if (surf->u.tex.last_layer - surf->u.tex.first_layer != scene->fb_max_layer)
+      return false;
+
+   if (scene->fb.width != u_minify(surf->texture->width0, surf->u.tex.level) ||
+       scene->fb.height != u_minify(surf->texture->height0, surf->u.tex.level))
+      return false;
+
+   for (unsigned i = 0; i < scene->fb.nr_cbufs; i++) {
+      if (i != cbuf && scene->fb.cbufs[i] &&
+          scene->fb.cbufs[i]->texture == surf->texture)
+         return false;
+   }
+
+   /* Bound views are only resolved when they get bound, so a resource that
+    * is already bound for sampling must be cleared right away.
+    */
+   for (unsigned sh = 0; sh < PIPE_SHADER_MESH_TYPES; sh++) {
+      for (unsigned i = 0; i < lp->num_sampler_views[sh]; i++) {
+         if (lp->sampler_views[sh][i] &&
+             lp->sampler_views[sh][i]->texture == surf->texture)
+            return false;
+      }
+      for (unsigned i = 0; i < lp->num_images[sh]; i++) {
+         if (lp->images[sh][i].resource == surf->texture)
+            return false;
+      }
+   }
+
+   return true;
+}
+
+
+/**
+ * Hand the pending lazy clears of the bound color buffers to the scene,
+ * which clears each tile it touches before running the tile's commands.
+ */
+static bool
+lp_setup_begin_lazy_clears(struct lp_setup_context *setup)
+{
+   struct lp_scene *scene = setup->scene;
+
+   for (unsigned cbuf = 0; cbuf < PIPE_MAX_COLOR_BUFS; cbuf++) {
+      struct lp_scene_surface *ssurf = &scene->cbufs[cbuf];
+      ssurf->lazy_clear_tiles = NULL;
+
+      if (cbuf >= scene->fb.nr_cbufs || !scene->fb.cbufs[cbuf] ||
+          !llvmpipe_resource_is_texture(scene->fb.cbufs[cbuf]->texture))
+         continue;
+
+      struct llvmpipe_resource *lpr =
+         llvmpipe_resource(scene->fb.cbufs[cbuf]->texture);
+      const struct llvmpipe_lazy_clear *lc = &lpr->lazy_clear;
+
+      if (!llvmpipe_resource_has_lazy_clear(lpr))
+         continue;
+
+      if (!lp_setup_lazy_clear_matches(scene, cbuf)) {
+         lp_setup_apply_lazy_clear(setup, lpr);
+         continue;
+      }
+
+      const size_t size =
+         BITSET_WORDS(lc->tiles_x * lc->tiles_y) * sizeof(BITSET_WORD);
+      BITSET_WORD *tiles = lp_scene_alloc(scene, size);
+      if (!tiles)
+         return false;
+
+      memcpy(tiles, lc->pending_tiles, size);
+      ssurf->lazy_clear_tiles = tiles;
+      ssurf->lazy_clear_tiles_x = lc->tiles_x;
+      ssurf->lazy_clear_color = lc->color;
+   }
+
+   return true;
+}
+
+
+/**
+ * Tiles the scene has commands for get resolved by the rasterizer, so they
+ * are no longer pending in the resource.
+ */
+static void
+lp_setup_end_lazy_clears(struct lp_setup_context *setup)
+{
+   struct lp_scene *scene = setup->scene;
+
+   for (unsigned cbuf = 0; cbuf < scene->fb.nr_cbufs; cbuf++) {
+      if (!scene->cbufs[cbuf].lazy_clear_tiles)
+         continue;
+
+      struct llvmpipe_resource *lpr =
+         llvmpipe_resource(scene->fb.cbufs[cbuf]->texture);
+      struct llvmpipe_lazy_clear *lc = &lpr->lazy_clear;
+
+      if (!llvmpipe_resource_has_lazy_clear(lpr))
+         continue;
+
+      for (unsigned y = 0; y < scene->tiles_y; y++) {
+         for (unsigned x = 0; x < scene->tiles_x; x++) {
+            const unsigned i = y * lc->tiles_x + x;
+            if (BITSET_TEST(lc->pending_tiles, i) &&
+                lp_scene_get_bin(scene, x, y)->head) {
+               BITSET_CLEAR(lc->pending_tiles, i);
+               lc->num_pending--;
+            }
+         }
+      }
+   }
+}
+
+
 /** Rasterize all scene's bins */
 static void
 lp_setup_rasterize_scene(struct lp_setup_context *setup)
@@ -203,10 +378,16 @@ lp_setup_rasterize_scene(struct lp_setup_context *setup)
    struct lp_scene *scene = setup->scene;
    struct llvmpipe_screen *screen = llvmpipe_screen(scene->pipe->screen);
 
+   MESA_TRACE_FUNC();
+   MESA_TRACE_SET_COUNTER("llvmpipe binning (us)",
+                          (os_time_get_nano() - scene->binning_start) / 1000.0);
+
    scene->num_active_queries = setup->active_binned_queries;
    memcpy(scene->active_queries, setup->active_queries,
           scene->num_active_queries * sizeof(scene->active_queries[0]));
 
+   lp_setup_end_lazy_clears(setup);
+
    lp_scene_end_binning(scene);
 
    mtx_lock(&screen->rast_mutex);
@@ -252,6 +433,19 @@ begin_binning(struct lp_setup_context *setup)
       for (unsigned cbuf = 0; cbuf < setup->fb.nr_cbufs; cbuf++) {
          assert(PIPE_CLEAR_COLOR0 == 1 << 2);
          if (setup->clear.flags & (1 << (2 + cbuf))) {
+            if (lp_setup_can_lazy_clear(setup, cbuf)) {
+               struct llvmpipe_resource *lpr =
+                  llvmpipe_resource(setup->fb.cbufs[cbuf]->texture);
+
+               if (llvmpipe_resource_has_lazy_clear(lpr) &&
+                   !lp_setup_lazy_clear_matches(scene, cbuf))
+                  lp_setup_apply_lazy_clear(setup, lpr);
+
+               if (llvmpipe_resource_set_lazy_clear(lpr, setup->fb.cbufs[cbuf],
+                                                    &setup->clear.color_val[cbuf]))
+                  continue;
+            }
+
             union lp_rast_cmd_arg clearrb_arg;
             struct lp_rast_clear_rb *cc_scene =
                (struct lp_rast_clear_rb *)
@@ -274,6 +468,9 @@ begin_binning(struct lp_setup_context *setup)
       }
    }
 
+   if (!lp_setup_begin_lazy_clears(setup))
+      return false;
+
    if (setup->fb.zsbuf) {
       if (setup->clear.flags & PIPE_CLEAR_DEPTHSTENCIL) {
          if (!lp_scene_bin_everywhere(scene,
@@ -298,9 +495,9 @@ begin_binning(struct lp_setup_context *setup)
 
 
 /* This basically bins and then flushes any outstanding full-screen
- * clears.
- *
- * TODO: fast path for fullscreen clears and no triangles.
+ * clears.  Color clears which can be deferred are only recorded in the
+ * resource (see llvmpipe_lazy_clear), so a scene of nothing but such
+ * clears doesn't touch any tile.
  */
 static bool
 execute_clears(struct lp_setup_context *setup)
@@ -962,6 +1159,10 @@ lp_setup_is_resource_referenced(const struct lp_setup_context *setup,
    for (unsigned i = 0; i < setup->num_active_scenes; i++) {
       struct lp_scene *scene = setup->scenes[i];
 
+      /* Done, but not reused yet */
+      if (scene->fence && lp_fence_signalled(scene->fence))
+         continue;
+
       mtx_lock(&scene->mutex);
       unsigned ref = lp_scene_is_resource_referenced(scene, texture);
       mtx_unlock(&scene->mutex);
@@ -973,6 +1174,45 @@ lp_setup_is_resource_referenced(const struct lp_setup_context *setup,
 }
 
 
+/*
+ * Whether the fragment shader state reads a buffer written by a copy binned
+ * earlier in the current scene, see lp_setup_copy_to_buffer().  Bins are
+ * rasterized independently, so a draw may read the buffer before the copy
+ * wrote the part it needs.
+ */
+static bool
+fs_reads_pending_copy(const struct lp_setup_context *setup)
+{
+   const struct lp_fence *fence = setup->scene->fence;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(setup->constants); i++) {
+      struct pipe_resource *res = setup->constants[i].current.buffer;
+      if (res && llvmpipe_resource(res)->write_fence == fence)
+         return true;
+   }
+
+   for (unsigned i = 0; i < ARRAY_SIZE(setup->ssbos); i++) {
+      struct pipe_resource *res = setup->ssbos[i].current.buffer;
+      if (res && llvmpipe_resource(res)->write_fence == fence)
+         return true;
+   }
+
+   for (unsigned i = 0; i < ARRAY_SIZE(setup->fs.current_tex); i++) {
+      struct pipe_resource *res = setup->fs.current_tex[i];
+      if (res && llvmpipe_resource(res)->write_fence == fence)
+         return true;
+   }
+
+   for (unsigned i = 0; i < ARRAY_SIZE(setup->images); i++) {
+      struct pipe_resource *res = setup->images[i].current.resource;
+      if (res && llvmpipe_resource(res)->write_fence == fence)
+         return true;
+   }
+
+   return false;
+}
+
+
 /**
  * Called by vbuf code when we're about to draw something.
  *
@@ -1087,6 +1327,9 @@ try_update_scene_state(struct lp_setup_context *setup)
           * the new, current state.  So allocate a new lp_rast_state object
           * and append it to the bin's setup data buffer.
           */
+         if (fs_reads_pending_copy(setup))
+            return false;
+
          struct lp_rast_state *stored =
             (struct lp_rast_state *) lp_scene_alloc(scene, sizeof *stored);
          if (!stored) {
@@ -1515,6 +1758,111 @@ fail:
 }
 
 
+static bool
+bin_copy_to_buffer(struct lp_setup_context *setup,
+                   const struct lp_rast_copy_to_buffer *copy,
+                   struct pipe_resource *dst)
+{
+   struct lp_scene *scene = setup->scene;
+   struct lp_rast_copy_to_buffer *copy_scene =
+      lp_scene_alloc(scene, sizeof *copy_scene);
+
+   if (!copy_scene ||
+       !lp_scene_add_resource_reference(scene, dst, false, true))
+      return false;
+
+   *copy_scene = *copy;
+
+   for (int y = copy->box.y0 >> TILE_ORDER;
+        y <= copy->box.y1 >> TILE_ORDER; y++) {
+      for (int x = copy->box.x0 >> TILE_ORDER;
+           x <= copy->box.x1 >> TILE_ORDER; x++) {
+         if (!lp_scene_bin_command(scene, x, y,
+                                   LP_RAST_OP_COPY_TO_BUFFER,
+                                   lp_rast_arg_copy_to_buffer(copy_scene)))
+            return false;
+      }
+   }
+
+   return true;
+}
+
+
+/**
+ * Put a copy of a region of a bound color buffer into the bins it covers,
+ * so that it happens after the rendering already binned without waiting
+ * for the scene.  The destination buffer gets written by the rasterizer
+ * threads, mapping it flushes the scene as for any other resource the
+ * scene writes.
+ *
+ * \return false if the source isn't a bound color buffer or the copy
+ *         can't be binned; nothing was done then
+ */
+bool
+lp_setup_copy_to_buffer(struct lp_setup_context *setup,
+                        struct pipe_resource *dst,
+                        enum pipe_format dst_format,
+                        unsigned dst_offset, int dst_stride,
+                        struct pipe_resource *src,
+                        enum pipe_format src_format,
+                        unsigned src_level,
+                        const struct pipe_box *src_box)
+{
+   struct lp_rast_copy_to_buffer copy;
+   unsigned cbuf;
+
+   for (cbuf = 0; cbuf < setup->fb.nr_cbufs; cbuf++) {
+      const struct pipe_surface *surf = setup->fb.cbufs[cbuf];
+
+      if (surf && surf->texture == src &&
+          surf->u.tex.level == src_level &&
+          surf->u.tex.first_layer == src_box->z &&
+          util_format_get_blocksize(surf->format) ==
+          util_format_get_blocksize(src_format))
+         break;
+   }
+
+   if (cbuf == setup->fb.nr_cbufs ||
+       src_box->x + src_box->width > setup->fb.width ||
+       src_box->y + src_box->height > setup->fb.height)
+      return false;
+
+   /* Earlier commands of the scene may read or write the buffer in tiles
+    * which get rasterized after the copy.  Scenes are rasterized one after
+    * the other, so earlier scenes don't matter.  Later draws reading the
+    * buffer start a new scene, see fs_reads_pending_copy().
+    */
+   if (setup->scene && lp_scene_is_resource_referenced(setup->scene, dst))
+      return false;
+
+   if (!set_scene_state(setup, SETUP_ACTIVE, "copy_to_buffer"))
+      return false;
+
+   copy.box.x0 = src_box->x;
+   copy.box.x1 = src_box->x + src_box->width - 1;
+   copy.box.y0 = src_box->y;
+   copy.box.y1 = src_box->y + src_box->height - 1;
+   copy.cbuf = cbuf;
+   copy.src_format = src_format;
+   copy.dst_format = dst_format;
+   copy.dst = (uint8_t *)llvmpipe_resource_data(dst) + dst_offset;
+   copy.dst_stride = dst_stride;
+
+   if (!bin_copy_to_buffer(setup, &copy, dst)) {
+      /* Tiles that did get the command just write the same pixels twice */
+      if (!lp_setup_flush_and_restart(setup) ||
+          !bin_copy_to_buffer(setup, &copy, dst))
+         return false;
+   }
+
+   /* Vertex and index buffers are read without looking at the scene */
+   lp_fence_reference(&llvmpipe_resource(dst)->write_fence,
+                      setup->scene->fence);
+
+   return true;
+}
+
+
 bool
 lp_setup_flush_and_restart(struct lp_setup_context *setup)
 {
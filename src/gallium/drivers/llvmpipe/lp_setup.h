@@ -154,6 +154,16 @@ void
 lp_setup_end_query(struct lp_setup_context *setup,
                    struct llvmpipe_query *pq);
 
+bool
+lp_setup_copy_to_buffer(struct lp_setup_context *setup,
+                        struct pipe_resource *dst,
+                        enum pipe_format dst_format,
+                        unsigned dst_offset, int dst_stride,
+                        struct pipe_resource *src,
+                        enum pipe_format src_format,
+                        unsigned src_level,
+                        const struct pipe_box *src_box);
+
 static inline unsigned
 lp_clamp_viewport_idx(int idx)
 {
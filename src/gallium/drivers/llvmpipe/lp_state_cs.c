@@ -40,6 +40,7 @@
 #include "lp_context.h"
 #include "lp_setup_context.h"
 #include "lp_debug.h"
+#include "lp_flush.h"
 #include "lp_state.h"
 #include "lp_perf.h"
 #include "lp_screen.h"
@@ -447,7 +448,6 @@ generate_compute(struct llvmpipe_context *lp,
    lp_build_name(thread_data_ptr, "thread_data");
    lp_build_name(io_ptr, "vertex_io");
 
-   lp_build_nir_prepasses(nir);
    struct hash_table *fns = _mesa_pointer_hash_table_create(NULL);
 
    sampler = lp_llvm_sampler_soa_create(lp_cs_variant_key_samplers(key),
@@ -919,6 +919,11 @@ generate_compute(struct llvmpipe_context *lp,
 }
 
 
+static void
+llvmpipe_cs_precompile(struct llvmpipe_context *lp,
+                       struct lp_compute_shader *shader);
+
+
 static void *
 llvmpipe_create_compute_state(struct pipe_context *pipe,
                               const struct pipe_compute_state *templ)
@@ -952,6 +957,9 @@ llvmpipe_create_compute_state(struct pipe_context *pipe,
 
    llvmpipe_register_shader(pipe, &shader->base);
 
+   /* Variants are compiled from the NIR after the prepasses, see the FS */
+   lp_build_nir_prepasses(nir);
+
    list_inithead(&shader->variants.list);
 
    int nr_samplers = BITSET_LAST_BIT(nir->info.samplers_used);
@@ -959,6 +967,8 @@ llvmpipe_create_compute_state(struct pipe_context *pipe,
    int nr_images = BITSET_LAST_BIT(nir->info.images_used);
    shader->variant_key_size = lp_cs_variant_key_size(MAX2(nr_samplers, nr_sampler_views), nr_images);
 
+   llvmpipe_cs_precompile(llvmpipe_context(pipe), shader);
+
    return shader;
 }
 
@@ -991,6 +1001,18 @@ llvmpipe_get_compute_state_info(struct pipe_context *pipe, void *cs,
 }
 
 
+static void
+llvmpipe_destroy_cs_shader_variant(struct lp_compute_shader_variant *variant)
+{
+   gallivm_destroy(variant->gallivm);
+   lp_context_destroy(&variant->context);
+
+   if (variant->function_name)
+      FREE(variant->function_name);
+   FREE(variant);
+}
+
+
 /**
  * Remove shader variant from two lists: the shader's variant list
  * and the context's variant list.
@@ -1008,8 +1030,6 @@ llvmpipe_remove_cs_shader_variant(struct llvmpipe_context *lp,
                    lp->nr_cs_variants, variant->nr_instrs, lp->nr_cs_instrs);
    }
 
-   gallivm_destroy(variant->gallivm);
-
    /* remove from shader's list */
    list_del(&variant->list_item_local.list);
    variant->shader->variants_cached--;
@@ -1019,9 +1039,7 @@ llvmpipe_remove_cs_shader_variant(struct llvmpipe_context *lp,
    lp->nr_cs_variants--;
    lp->nr_cs_instrs -= variant->nr_instrs;
 
-   if(variant->function_name)
-      FREE(variant->function_name);
-   FREE(variant);
+   llvmpipe_destroy_cs_shader_variant(variant);
 }
 
 
@@ -1039,6 +1057,13 @@ llvmpipe_delete_compute_state(struct pipe_context *pipe,
       pipe_resource_reference(&shader->global_buffers[i], NULL);
    FREE(shader->global_buffers);
 
+   if (shader->precompile.queued) {
+      util_queue_fence_wait(&shader->precompile.fence);
+      util_queue_fence_destroy(&shader->precompile.fence);
+      if (shader->precompile.variant)
+         llvmpipe_destroy_cs_shader_variant(shader->precompile.variant);
+   }
+
    /* Delete all the variants */
    LIST_FOR_EACH_ENTRY_SAFE(li, next, &shader->variants.list, list) {
       llvmpipe_remove_cs_shader_variant(llvmpipe, li->base);
@@ -1217,6 +1242,7 @@ lp_cs_get_ir_cache_key(struct lp_compute_shader_variant *variant,
 
 static struct lp_compute_shader_variant *
 generate_variant(struct llvmpipe_context *lp,
+                 lp_context_ref *context,
                  struct lp_compute_shader *shader,
                  enum pipe_shader_type sh_type,
                  const struct lp_compute_shader_variant_key *key)
@@ -1249,7 +1275,7 @@ generate_variant(struct llvmpipe_context *lp,
    if (!cached.data_size)
       needs_caching = true;
 
-   variant->gallivm = gallivm_create(module_name, &lp->context, &cached);
+   variant->gallivm = gallivm_create(module_name, context, &cached);
    if (!variant->gallivm) {
       FREE(variant);
       return NULL;
@@ -1299,6 +1325,86 @@ generate_variant(struct llvmpipe_context *lp,
 }
 
 
+static void
+lp_cs_precompile_job(void *data, void *gdata, int thread_index)
+{
+   struct lp_compute_shader *shader = data;
+   lp_context_ref context;
+
+   lp_context_create(&context);
+   if (context.ref) {
+      struct lp_compute_shader_variant *variant =
+         generate_variant(shader->precompile.lp, &context, shader,
+                          PIPE_SHADER_COMPUTE, shader->precompile.key);
+      if (variant) {
+         variant->context = context;
+         shader->precompile.variant = variant;
+      } else {
+         lp_context_destroy(&context);
+      }
+   }
+
+   FREE(shader->precompile.key);
+   shader->precompile.key = NULL;
+}
+
+
+/**
+ * Queue the compile of the variant for the currently bound samplers and
+ * images.  Compute variant keys only depend on those, so for most
+ * shaders this is the only variant ever needed.  The key misses when
+ * the shader is dispatched with different sampler or image state.
+ */
+static void
+llvmpipe_cs_precompile(struct llvmpipe_context *lp,
+                       struct lp_compute_shader *shader)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+
+   if (!screen->precompile_shaders)
+      return;
+
+   char store[LP_CS_MAX_VARIANT_KEY_SIZE];
+   const struct lp_compute_shader_variant_key *key =
+      make_variant_key(lp, shader, PIPE_SHADER_COMPUTE, store);
+
+   shader->precompile.key = MALLOC(shader->variant_key_size);
+   if (!shader->precompile.key)
+      return;
+   memcpy(shader->precompile.key, key, shader->variant_key_size);
+
+   shader->precompile.lp = lp;
+   shader->precompile.queued = true;
+   util_queue_fence_init(&shader->precompile.fence);
+   util_queue_add_job(&screen->compile_queue, shader,
+                      &shader->precompile.fence, lp_cs_precompile_job,
+                      NULL, 0);
+}
+
+
+/**
+ * Wait for the precompiled variant and put it into the variant lists.
+ */
+static void
+llvmpipe_cs_add_precompiled_variant(struct llvmpipe_context *lp,
+                                    struct lp_compute_shader *shader)
+{
+   util_queue_fence_wait(&shader->precompile.fence);
+
+   struct lp_compute_shader_variant *variant = shader->precompile.variant;
+   if (!variant)
+      return;
+   shader->precompile.variant = NULL;
+
+   list_add(&variant->list_item_local.list, &shader->variants.list);
+   list_add(&variant->list_item_global.list, &lp->cs_variants_list.list);
+   lp->nr_cs_variants++;
+   lp->nr_cs_instrs += variant->nr_instrs;
+   shader->variants_cached++;
+   LP_COUNT_ADD(nr_llvm_compiles, 2);
+}
+
+
 static void
 lp_cs_ctx_set_cs_variant(struct lp_cs_context *csctx,
                          struct lp_compute_shader_variant *variant)
@@ -1312,6 +1418,9 @@ llvmpipe_update_cs_variant(struct llvmpipe_context *lp,
                            enum pipe_shader_type sh_type,
                            struct lp_compute_shader *shader)
 {
+   if (shader->precompile.queued)
+      llvmpipe_cs_add_precompiled_variant(lp, shader);
+
    char store[LP_CS_MAX_VARIANT_KEY_SIZE];
    struct lp_compute_shader_variant_key *key =
       make_variant_key(lp, shader, sh_type, store);
@@ -1384,7 +1493,7 @@ llvmpipe_update_cs_variant(struct llvmpipe_context *lp,
        */
       int64_t t0, t1, dt;
       t0 = os_time_get();
-      variant = generate_variant(lp, shader, sh_type, key);
+      variant = generate_variant(lp, &lp->context, shader, sh_type, key);
       t1 = os_time_get();
       dt = t1 - t0;
       LP_COUNT_ADD(llvm_compile_time, dt);
@@ -1737,6 +1846,15 @@ llvmpipe_launch_grid(struct pipe_context *pipe,
 
    memset(&job_info, 0, sizeof(job_info));
 
+   llvmpipe_wait_shader_buffer_writes(llvmpipe, PIPE_SHADER_COMPUTE);
+   if (llvmpipe->copy_fence) {
+      for (unsigned i = 0; i < llvmpipe->cs->max_global_buffers; i++) {
+         if (llvmpipe->cs->global_buffers[i])
+            llvmpipe_wait_buffer_write(llvmpipe,
+                                       llvmpipe->cs->global_buffers[i]);
+      }
+   }
+
    llvmpipe_cs_update_derived(llvmpipe, info->input);
 
    fill_grid_size(pipe, 0, info, job_info.grid_size);
@@ -1891,6 +2009,8 @@ llvmpipe_create_ts_state(struct pipe_context *pipe,
    int nr_sampler_views = BITSET_LAST_BIT(nir->info.textures_used);
    int nr_images = BITSET_LAST_BIT(nir->info.images_used);
    shader->variant_key_size = lp_cs_variant_key_size(MAX2(nr_samplers, nr_sampler_views), nr_images);
+
+   lp_build_nir_prepasses(nir);
    return shader;
 }
 
@@ -1968,6 +2088,8 @@ llvmpipe_create_ms_state(struct pipe_context *pipe,
    int nr_sampler_views = BITSET_LAST_BIT(nir->info.textures_used);
    int nr_images = BITSET_LAST_BIT(nir->info.images_used);
    shader->variant_key_size = lp_cs_variant_key_size(MAX2(nr_samplers, nr_sampler_views), nr_images);
+
+   lp_build_nir_prepasses(nir);
    return shader;
 }
 
@@ -2088,6 +2210,10 @@ llvmpipe_draw_mesh_tasks(struct pipe_context *pipe,
    if (lp->dirty)
       llvmpipe_update_derived(lp);
 
+   /* Task and mesh shaders run before their output is binned */
+   llvmpipe_wait_shader_buffer_writes(lp, PIPE_SHADER_TASK);
+   llvmpipe_wait_shader_buffer_writes(lp, PIPE_SHADER_MESH);
+
    unsigned draw_count = info->draw_count;
    if (info->indirect && info->indirect_draw_count) {
       struct pipe_transfer *dc_transfer;
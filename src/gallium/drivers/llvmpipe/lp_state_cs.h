@@ -79,6 +79,9 @@ struct lp_compute_shader_variant
 {
    struct gallivm_state *gallivm;
 
+   /* Set when compiled on the compile queue, see lp_fragment_shader_variant */
+   lp_context_ref context;
+
    LLVMTypeRef jit_cs_context_type;
    LLVMTypeRef jit_cs_context_ptr_type;
    LLVMTypeRef jit_cs_thread_data_type;
@@ -125,6 +128,17 @@ struct lp_compute_shader {
 
    int max_global_buffers;
    struct pipe_resource **global_buffers;
+
+   /* Variant for the state bound at creation time, compiled on the
+    * screen's compile queue and added to the variant lists on first use.
+    */
+   struct {
+      bool queued;
+      struct util_queue_fence fence;
+      struct llvmpipe_context *lp;
+      struct lp_compute_shader_variant_key *key;
+      struct lp_compute_shader_variant *variant;
+   } precompile;
 };
 
 struct lp_cs_exec {
@@ -109,6 +109,10 @@
 #include "compiler/nir/nir_serialize.h"
 #include "util/mesa-sha1.h"
 
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Linker.h>
+
 
 /** Fragment shader number (for debugging) */
 static unsigned fs_no = 0;
@@ -1064,8 +1068,9 @@ generate_fs_loop(struct gallivm_state *gallivm,
    params.image = image;
    params.aniso_filter_table = lp_jit_resources_aniso_filter_table(gallivm, resources_type, resources_ptr);
 
-   /* Build the actual shader */
-   lp_build_nir_soa(gallivm, nir, &params, outputs);
+   /* Build the actual shader, the prepasses ran when it was created */
+   lp_build_nir_soa_func(gallivm, nir, nir_shader_get_entrypoint(nir),
+                         &params, outputs);
 
    /* Alpha test */
    if (key->alpha.enabled) {
@@ -3721,10 +3726,13 @@ lp_fs_get_ir_cache_key(struct lp_fragment_shader_variant *variant,
 
 /**
  * Generate a new fragment shader variant from the shader code and
- * other state indicated by the key.
+ * other state indicated by the key.  The code is built in the given
+ * LLVM context, which is either the llvmpipe context's one or one
+ * private to a compile queue job.
  */
 static struct lp_fragment_shader_variant *
 generate_variant(struct llvmpipe_context *lp,
+                 lp_context_ref *context,
                  struct lp_fragment_shader *shader,
                  const struct lp_fragment_shader_variant_key *key)
 {
@@ -3753,10 +3761,26 @@ generate_variant(struct llvmpipe_context *lp,
          needs_caching = true;
    }
 
+   /*
+    * Only optimized code goes to the disk cache, so on a hit there is
+    * nothing to tier up.  Otherwise the fast compile isn't cached, the
+    * tier up job takes care of that.
+    */
+   const bool tiered = needs_caching &&
+      (LP_PERF & PERF_TIERED_COMPILE) &&
+      util_queue_is_initialized(&screen->compile_queue) &&
+      !(gallivm_get_perf_flags() & GALLIVM_PERF_NO_OPT);
+   if (tiered) {
+      needs_caching = false;
+      memcpy(variant->tier.cache_key, ir_sha1_cache_key,
+             sizeof variant->tier.cache_key);
+   }
+
    char module_name[64];
    snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
             shader->no, shader->variants_created);
-   variant->gallivm = gallivm_create(module_name, &lp->context, &cached);
+   variant->gallivm = gallivm_create(module_name, context,
+                                     tiered ? NULL : &cached);
    if (!variant->gallivm) {
       FREE(variant);
       return NULL;
@@ -3918,6 +3942,13 @@ generate_variant(struct llvmpipe_context *lp,
     * Compile everything
     */
 
+   if (tiered) {
+      /* Keep the unoptimized IR around for llvmpipe_fs_variant_tier_up() */
+      variant->tier.ir = LLVMWriteBitcodeToMemoryBuffer(variant->gallivm->module);
+      if (variant->tier.ir)
+         variant->gallivm->opt_level = LP_PASSMGR_OPT_FAST;
+   }
+
 #if GALLIVM_USE_ORCJIT
 /* module has been moved into ORCJIT after gallivm_compile_module */
    variant->nr_instrs += lp_build_count_ir_module(variant->gallivm->module);
@@ -3970,6 +4001,11 @@ generate_variant(struct llvmpipe_context *lp,
 }
 
 
+static void
+llvmpipe_fs_precompile(struct llvmpipe_context *lp,
+                       struct lp_fragment_shader *shader);
+
+
 static void *
 llvmpipe_create_fs_state(struct pipe_context *pipe,
                          const struct pipe_shader_state *templ)
@@ -4069,6 +4105,14 @@ llvmpipe_create_fs_state(struct pipe_context *pipe,
 
    llvmpipe_fs_analyse_nir(shader);
 
+   /*
+    * Run the gallivm NIR prepasses once here, so that variants compiled
+    * on the compile queue only ever read the NIR.
+    */
+   lp_build_nir_prepasses(nir);
+
+   llvmpipe_fs_precompile(llvmpipe, shader);
+
    return shader;
 }
 
@@ -4088,6 +4132,7 @@ llvmpipe_bind_fs_state(struct pipe_context *pipe, void *fs)
 
    /* invalidate the setup link, NEW_FS will make it update */
    lp_setup_set_fs_variant(llvmpipe->setup, NULL);
+   llvmpipe->fs_variant = NULL;
    llvmpipe->dirty |= LP_NEW_FS;
 }
 
@@ -4117,6 +4162,9 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
    list_del(&variant->list_item_global.list);
    lp->nr_fs_variants--;
    lp->nr_fs_instrs -= variant->nr_instrs;
+
+   if (lp->fs_variant == variant)
+      lp->fs_variant = NULL;
 }
 
 
@@ -4124,7 +4172,19 @@ void
 llvmpipe_destroy_shader_variant(struct llvmpipe_context *lp,
                                 struct lp_fragment_shader_variant *variant)
 {
+   if (variant->tier.queued)
+      util_queue_fence_wait(&variant->tier.fence);
+   if (variant->tier.gallivm) {
+      gallivm_destroy(variant->tier.gallivm);
+      lp_context_destroy(&variant->tier.context);
+   }
+   if (variant->tier.ir)
+      LLVMDisposeMemoryBuffer(variant->tier.ir);
+   if (variant->tier.queued)
+      util_queue_fence_destroy(&variant->tier.fence);
+
    gallivm_destroy(variant->gallivm);
+   lp_context_destroy(&variant->context);
    lp_fs_reference(lp, &variant->shader, NULL);
    if (variant->function_name[RAST_EDGE_TEST])
       FREE(variant->function_name[RAST_EDGE_TEST]);
@@ -4143,6 +4203,9 @@ llvmpipe_destroy_fs(struct llvmpipe_context *llvmpipe,
    /* Delete draw module's data */
    draw_delete_fragment_shader(llvmpipe->draw, shader->draw_data);
 
+   if (shader->precompile.queued)
+      util_queue_fence_destroy(&shader->precompile.fence);
+
    ralloc_free(shader->base.ir.nir);
    assert(shader->variants_cached == 0);
    FREE(shader);
@@ -4156,6 +4219,12 @@ llvmpipe_delete_fs_state(struct pipe_context *pipe, void *fs)
    struct lp_fragment_shader *shader = fs;
    struct lp_fs_variant_list_item *li, *next;
 
+   /* The precompiled variant holds a reference to the shader */
+   if (shader->precompile.queued) {
+      util_queue_fence_wait(&shader->precompile.fence);
+      lp_fs_variant_reference(llvmpipe, &shader->precompile.variant, NULL);
+   }
+
    /* Delete all the variants */
    LIST_FOR_EACH_ENTRY_SAFE(li, next, &shader->variants.list, list) {
       struct lp_fragment_shader_variant *variant;
@@ -4314,6 +4383,7 @@ llvmpipe_set_shader_images(struct pipe_context *pipe,
          bool read_only = !(image->access & PIPE_IMAGE_ACCESS_WRITE);
          llvmpipe_flush_resource(pipe, image->resource, 0, read_only, false,
                                  false, "image");
+         llvmpipe_resource_resolve_clear(pipe, image->resource, false);
       }
    }
 
@@ -4636,6 +4706,96 @@ make_variant_key(struct llvmpipe_context *lp,
 }
 
 
+static void
+lp_fs_precompile_job(void *data, void *gdata, int thread_index)
+{
+   struct lp_fragment_shader *shader = data;
+   lp_context_ref context;
+
+   lp_context_create(&context);
+   if (context.ref) {
+      struct lp_fragment_shader_variant *variant =
+         generate_variant(shader->precompile.lp, &context, shader,
+                          shader->precompile.key);
+      if (variant) {
+         variant->context = context;
+         shader->precompile.variant = variant;
+      } else {
+         lp_context_destroy(&context);
+      }
+   }
+
+   FREE(shader->precompile.key);
+   shader->precompile.key = NULL;
+}
+
+
+/**
+ * Queue the compile of the variant matching the currently bound state,
+ * which is the one most likely to be used, at least by applications that
+ * create their shaders with their render state already set up.
+ *
+ * The key misses whenever the blend, depth/stencil or rasterizer state,
+ * the framebuffer formats or the sampler and image state bound at the
+ * first draw differ from the ones bound here, and the precompile is then
+ * a wasted compile.  That's why precompiles only happen once the
+ * application asked for compiler threads.
+ */
+static void
+llvmpipe_fs_precompile(struct llvmpipe_context *lp,
+                       struct lp_fragment_shader *shader)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+
+   if (!screen->precompile_shaders || !lp->rasterizer ||
+       !lp->depth_stencil || !lp->blend)
+      return;
+
+   /* Nothing bound to render to, the key would be useless */
+   if (!lp->framebuffer.nr_cbufs && !lp->framebuffer.zsbuf)
+      return;
+
+   char store[LP_FS_MAX_VARIANT_KEY_SIZE];
+   const struct lp_fragment_shader_variant_key *key =
+      make_variant_key(lp, shader, store);
+
+   shader->precompile.key = MALLOC(shader->variant_key_size);
+   if (!shader->precompile.key)
+      return;
+   memcpy(shader->precompile.key, key, shader->variant_key_size);
+
+   shader->precompile.lp = lp;
+   shader->precompile.queued = true;
+   util_queue_fence_init(&shader->precompile.fence);
+   util_queue_add_job(&screen->compile_queue, shader,
+                      &shader->precompile.fence, lp_fs_precompile_job,
+                      NULL, 0);
+}
+
+
+/**
+ * Wait for the precompiled variant and put it into the variant lists.
+ */
+static void
+llvmpipe_fs_add_precompiled_variant(struct llvmpipe_context *lp,
+                                    struct lp_fragment_shader *shader)
+{
+   util_queue_fence_wait(&shader->precompile.fence);
+
+   struct lp_fragment_shader_variant *variant = shader->precompile.variant;
+   if (!variant)
+      return;
+   shader->precompile.variant = NULL;
+
+   list_add(&variant->list_item_local.list, &shader->variants.list);
+   list_add(&variant->list_item_global.list, &lp->fs_variants_list.list);
+   lp->nr_fs_variants++;
+   lp->nr_fs_instrs += variant->nr_instrs;
+   shader->variants_cached++;
+   LP_COUNT_ADD(nr_llvm_compiles, 2);
+}
+
+
 /**
  * Update fragment shader state.  This is called just prior to drawing
  * something when some fragment-related state has changed.
@@ -4645,6 +4805,9 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
 {
    struct lp_fragment_shader *shader = lp->fs;
 
+   if (shader->precompile.queued)
+      llvmpipe_fs_add_precompiled_variant(lp, shader);
+
    char store[LP_FS_MAX_VARIANT_KEY_SIZE];
    const struct lp_fragment_shader_variant_key *key =
       make_variant_key(lp, shader, store);
@@ -4719,7 +4882,7 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
        * Generate the new variant.
        */
       int64_t t0 = os_time_get();
-      variant = generate_variant(lp, shader, key);
+      variant = generate_variant(lp, &lp->context, shader, key);
       int64_t t1 = os_time_get();
       int64_t dt = t1 - t0;
       LP_COUNT_ADD(llvm_compile_time, dt);
@@ -4737,6 +4900,168 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
 
    /* Bind this variant */
    lp_setup_set_fs_variant(lp->setup, variant);
+   lp->fs_variant = variant;
+}
+
+
+/**
+ * Link IR previously serialized with LLVMWriteBitcodeToMemoryBuffer() into
+ * the gallivm's module, so that it can be compiled again, e.g. with a
+ * different optimization level.  The bitcode buffer is not consumed.
+ *
+ * Must be called before gallivm_compile_module().
+ */
+static bool
+link_bitcode(struct gallivm_state *gallivm, LLVMMemoryBufferRef bitcode)
+{
+   LLVMModuleRef module;
+
+   if (LLVMParseBitcodeInContext2(gallivm->context, bitcode, &module))
+      return false;
+
+   /* LLVMLinkModules2 destroys the source module */
+   if (LLVMLinkModules2(gallivm->module, module))
+      return false;
+
+   /*
+    * The hooks are declared lazily, pick up the ones the serialized IR
+    * references so they get mapped rather than redeclared.
+    */
+   if (!gallivm->debug_printf_hook)
+      gallivm->debug_printf_hook =
+         LLVMGetNamedFunction(gallivm->module, "debug_printf");
+   if (!gallivm->get_time_hook)
+      gallivm->get_time_hook =
+         LLVMGetNamedFunction(gallivm->module, "get_time_hook");
+
+   return true;
+}
+
+
+/**
+ * Recompile a variant's fast IR with the full optimization pipeline.
+ * Runs on the screen's compile queue, in its own LLVM context.
+ */
+static void
+lp_fs_tier_up_job(void *data, void *gdata, int thread_index)
+{
+   struct lp_fragment_shader_variant *variant = data;
+   struct lp_cached_code cached = { 0 };
+   LLVMValueRef func[2] = { NULL, NULL };
+   LLVMValueRef linear_func = NULL;
+   char module_name[64];
+
+   snprintf(module_name, sizeof(module_name), "fs%u_variant%u_opt",
+            variant->shader->no, variant->no);
+
+   lp_context_create(&variant->tier.context);
+   if (!variant->tier.context.ref)
+      return;
+
+   struct gallivm_state *gallivm =
+      gallivm_create(module_name, &variant->tier.context, &cached);
+   if (!gallivm) {
+      lp_context_destroy(&variant->tier.context);
+      return;
+   }
+
+   if (!link_bitcode(gallivm, variant->tier.ir)) {
+      gallivm_free_ir(gallivm);
+      gallivm_destroy(gallivm);
+      lp_context_destroy(&variant->tier.context);
+      return;
+   }
+
+   /* module has been moved into ORCJIT after gallivm_compile_module */
+   for (unsigned i = 0; i < 2; i++) {
+      if (variant->function_name[i])
+         func[i] = LLVMGetNamedFunction(gallivm->module,
+                                        variant->function_name[i]);
+   }
+   if (variant->linear_function_name)
+      linear_func = LLVMGetNamedFunction(gallivm->module,
+                                         variant->linear_function_name);
+
+   gallivm_compile_module(gallivm);
+
+   for (unsigned i = 0; i < 2; i++) {
+      if (func[i])
+         variant->tier.jit_function[i] = (lp_jit_frag_func)
+            gallivm_jit_function(gallivm, func[i], variant->function_name[i]);
+   }
+   if (linear_func)
+      variant->tier.jit_linear_llvm = (lp_jit_linear_llvm_func)
+         gallivm_jit_function(gallivm, linear_func,
+                              variant->linear_function_name);
+
+   lp_disk_cache_insert_shader(variant->tier.screen, &cached,
+                               variant->tier.cache_key);
+
+   gallivm_free_ir(gallivm);
+   variant->tier.gallivm = gallivm;
+}
+
+
+/**
+ * Called for every draw with the bound variant.  Queues the optimized
+ * recompile once the variant turns out to be hot, and swaps the
+ * optimized code in when it's ready.
+ *
+ * The fast code stays alive until the variant is destroyed, as scenes
+ * in flight may still be executing it.
+ */
+void
+llvmpipe_fs_variant_tier_up(struct llvmpipe_context *lp,
+                            struct lp_fragment_shader_variant *variant)
+{
+   if (!variant->tier.ir)
+      return;
+
+   if (!variant->tier.queued) {
+      if (++variant->tier.draws < LP_FS_TIER_UP_DRAWS)
+         return;
+
+      struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+      variant->tier.screen = screen;
+      variant->tier.queued = true;
+      util_queue_fence_init(&variant->tier.fence);
+      util_queue_add_job(&screen->compile_queue, variant,
+                         &variant->tier.fence, lp_fs_tier_up_job,
+                         NULL, 0);
+      return;
+   }
+
+   if (!util_queue_fence_is_signalled(&variant->tier.fence))
+      return;
+
+   if (variant->tier.gallivm) {
+      lp_jit_frag_func edge = variant->jit_function[RAST_EDGE_TEST];
+
+      if (variant->tier.jit_function[RAST_EDGE_TEST])
+         p_atomic_set(&variant->jit_function[RAST_EDGE_TEST],
+                      variant->tier.jit_function[RAST_EDGE_TEST]);
+
+      if (variant->tier.jit_function[RAST_WHOLE])
+         p_atomic_set(&variant->jit_function[RAST_WHOLE],
+                      variant->tier.jit_function[RAST_WHOLE]);
+      else if (variant->jit_function[RAST_WHOLE] == edge)
+         p_atomic_set(&variant->jit_function[RAST_WHOLE],
+                      variant->jit_function[RAST_EDGE_TEST]);
+
+      if (variant->tier.jit_linear_llvm)
+         p_atomic_set(&variant->jit_linear_llvm,
+                      variant->tier.jit_linear_llvm);
+
+      LP_COUNT(nr_llvm_tier_ups);
+
+      if (LP_DEBUG & DEBUG_FS) {
+         debug_printf("llvmpipe: tiered up fs #%u var %u after %u draws\n",
+                      variant->shader->no, variant->no, variant->tier.draws);
+      }
+   }
+
+   LLVMDisposeMemoryBuffer(variant->tier.ir);
+   variant->tier.ir = NULL;
 }
 
 
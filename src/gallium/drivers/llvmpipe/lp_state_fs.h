@@ -38,6 +38,7 @@
 #include "gallivm/lp_bld_tgsi.h" /* for lp_tgsi_info */
 #include "lp_bld_interp.h" /* for struct lp_shader_input */
 #include "util/u_inlines.h"
+#include "util/u_queue.h"
 #include "lp_jit.h"
 
 struct lp_fragment_shader;
@@ -155,6 +156,11 @@ struct lp_fragment_shader_variant
 
    struct gallivm_state *gallivm;
 
+   /* Set when compiled on the compile queue rather than in the context's
+    * LLVM context, destroyed along with the variant.
+    */
+   lp_context_ref context;
+
    LLVMTypeRef jit_context_type;
    LLVMTypeRef jit_context_ptr_type;
    LLVMTypeRef jit_thread_data_type;
@@ -187,6 +193,26 @@ struct lp_fragment_shader_variant
    /* Total number of LLVM instructions generated */
    unsigned nr_instrs;
 
+   /*
+    * Tiered compilation: the variant is first compiled with the fast
+    * pipeline, and recompiled in the background with full optimizations
+    * once it has been used for LP_FS_TIER_UP_DRAWS draws.
+    */
+   struct {
+      LLVMMemoryBufferRef ir;    /* unoptimized IR, NULL if not tiered */
+      unsigned char cache_key[20];
+      unsigned draws;
+      bool queued;
+      struct util_queue_fence fence;
+      struct llvmpipe_screen *screen;
+
+      /* Written by the compile job, valid once the fence is signalled */
+      lp_context_ref context;
+      struct gallivm_state *gallivm;
+      lp_jit_frag_func jit_function[2];
+      lp_jit_linear_llvm_func jit_linear_llvm;
+   } tier;
+
    struct lp_fs_variant_list_item list_item_global, list_item_local;
    struct lp_fragment_shader *shader;
 
@@ -221,6 +247,19 @@ struct lp_fragment_shader
 
    /** Fragment shader input interpolation info */
    struct lp_shader_input inputs[PIPE_MAX_SHADER_INPUTS];
+
+   /*
+    * Variant for the state bound at creation time, compiled on the
+    * screen's compile queue.  llvmpipe_update_fs() waits for it and adds
+    * it to the variant lists on first use.
+    */
+   struct {
+      bool queued;
+      struct util_queue_fence fence;
+      struct llvmpipe_context *lp;
+      struct lp_fragment_shader_variant_key *key;
+      struct lp_fragment_shader_variant *variant;
+   } precompile;
 };
 
 
@@ -251,6 +290,10 @@ void
 llvmpipe_destroy_fs(struct llvmpipe_context *llvmpipe,
                     struct lp_fragment_shader *shader);
 
+void
+llvmpipe_fs_variant_tier_up(struct llvmpipe_context *lp,
+                            struct lp_fragment_shader_variant *variant);
+
 static inline void
 lp_fs_reference(struct llvmpipe_context *llvmpipe,
                 struct lp_fragment_shader **ptr,
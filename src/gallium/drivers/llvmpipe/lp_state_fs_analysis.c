@@ -28,6 +28,7 @@
 
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "gallivm/lp_bld_nir.h"
 #include "lp_debug.h"
 #include "lp_state.h"
 #include "nir.h"
@@ -45,7 +46,9 @@ is_fs_input(const nir_src *src)
 
    if (parent->type == nir_instr_type_alu) {
       const nir_alu_instr *alu = nir_instr_as_alu(parent);
-      if (alu->op == nir_op_vec2 ||
+      if (lp_nir_is_float_precision_conversion(alu->op)) {
+         return is_fs_input(&alu->src[0].src);
+      } else if (alu->op == nir_op_vec2 ||
           alu->op == nir_op_vec3 ||
           alu->op == nir_op_vec4) {
          /* Check if any of the components come from an FS input */
@@ -184,16 +187,17 @@ get_texcoord_provenance(const nir_tex_src *texcoord,
 
 
 /*
- * Check if all the values of a nir_load_const_instr are 32-bit
+ * Check if all the values of a nir_load_const_instr are 16-bit or 32-bit
  * floats in the range [0,1].  If so, return true, else return false.
  */
 static bool
 check_load_const_in_zero_one(const nir_load_const_instr *load)
 {
-   if (load->def.bit_size != 32)
+   if (load->def.bit_size != 32 && load->def.bit_size != 16)
       return false;
    for (unsigned c = 0; c < load->def.num_components; c++) {
-      float val = load->value[c].f32;
+      float val = nir_const_value_as_float(load->value[c],
+                                           load->def.bit_size);
       if (val < 0.0 || val > 1.0 || isnan(val)) {
          return false;
       }
@@ -329,7 +333,7 @@ llvmpipe_nir_fn_is_linear_compat(const struct nir_shader *shader,
                unsigned num_src = nir_op_infos[alu->op].num_inputs;;
                for (unsigned s = 0; s < num_src; s++) {
                   /* If the MUL uses immediate values, the values must
-                   * be 32-bit floats in the range [0,1].
+                   * be floats in the range [0,1].
                    */
                   if (nir_src_is_const(alu->src[s].src)) {
                      nir_load_const_instr *load =
@@ -345,6 +349,9 @@ llvmpipe_nir_fn_is_linear_compat(const struct nir_shader *shader,
                break;
             }
             default:
+               // mediump lowering, no-ops at 8-bit precision
+               if (lp_nir_is_float_precision_conversion(alu->op))
+                  break;
                // disallowed instruction
                return false;
             }
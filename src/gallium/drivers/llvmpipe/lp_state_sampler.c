@@ -40,6 +40,7 @@
 #include "lp_debug.h"
 #include "frontend/sw_winsys.h"
 #include "lp_flush.h"
+#include "lp_texture.h"
 
 
 static void *
@@ -161,8 +162,10 @@ llvmpipe_set_sampler_views(struct pipe_context *pipe,
                       "context\n", i);
       }
 
-      if (view)
+      if (view) {
          llvmpipe_flush_resource(pipe, view->texture, 0, true, false, false, "sampler_view");
+         llvmpipe_resource_resolve_clear(pipe, view->texture, false);
+      }
 
       if (take_ownership) {
          pipe_sampler_view_reference(&llvmpipe->sampler_views[shader][start + i],
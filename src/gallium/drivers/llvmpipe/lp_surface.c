@@ -25,12 +25,17 @@
  *
  **************************************************************************/
 
+#include <stdlib.h>
+
 #include "util/u_rect.h"
 #include "util/u_surface.h"
 #include "util/u_memset.h"
+#include "util/format/u_format.h"
 #include "lp_context.h"
+#include "lp_fence.h"
 #include "lp_flush.h"
 #include "lp_limits.h"
+#include "lp_setup.h"
 #include "lp_surface.h"
 #include "lp_texture.h"
 #include "lp_query.h"
@@ -116,6 +121,103 @@ lp_resource_copy(struct pipe_context *pipe,
 }
 
 
+/**
+ * Can util_format_translate() convert from src_format to dst_format?
+ */
+static bool
+lp_can_translate_format(enum pipe_format dst_format,
+                        enum pipe_format src_format)
+{
+   const struct util_format_description *dst_desc =
+      util_format_description(dst_format);
+   const struct util_format_description *src_desc =
+      util_format_description(src_format);
+   const struct util_format_pack_description *pack =
+      util_format_pack_description(dst_format);
+   const struct util_format_unpack_description *unpack =
+      util_format_unpack_description(src_format);
+
+   if (!dst_desc || !src_desc ||
+       dst_desc->block.width != 1 || dst_desc->block.height != 1 ||
+       src_desc->block.width != 1 || src_desc->block.height != 1)
+      return false;
+
+   if (util_is_format_compatible(src_desc, dst_desc))
+      return true;
+
+   if (!pack || !unpack ||
+       dst_desc->colorspace == UTIL_FORMAT_COLORSPACE_ZS ||
+       src_desc->colorspace == UTIL_FORMAT_COLORSPACE_ZS)
+      return false;
+
+   if (util_format_fits_8unorm(src_desc) || util_format_fits_8unorm(dst_desc))
+      return (unpack->unpack_rgba_8unorm || unpack->unpack_rgba_8unorm_rect) &&
+             pack->pack_rgba_8unorm;
+
+   if (!unpack->unpack_rgba && !unpack->unpack_rgba_rect)
+      return false;
+
+   if (util_format_is_pure_sint(src_format) ||
+       util_format_is_pure_sint(dst_format))
+      return util_format_is_pure_sint(src_format) ==
+             util_format_is_pure_sint(dst_format) && pack->pack_rgba_sint;
+
+   if (util_format_is_pure_uint(src_format) ||
+       util_format_is_pure_uint(dst_format))
+      return pack->pack_rgba_uint;
+
+   return pack->pack_rgba_float;
+}
+
+
+/**
+ * Only copies out of a bound color buffer are supported, and these are
+ * binned into the scene rather than done right away, see
+ * lp_setup_copy_to_buffer().
+ */
+static bool
+lp_copy_texture_to_buffer(struct pipe_context *pipe,
+                          struct pipe_resource *dst,
+                          enum pipe_format dst_format,
+                          unsigned dst_offset, int dst_stride,
+                          struct pipe_resource *src,
+                          enum pipe_format src_format,
+                          unsigned src_level,
+                          const struct pipe_box *src_box)
+{
+   struct llvmpipe_context *lp = llvmpipe_context(pipe);
+
+   if (dst->target != PIPE_BUFFER ||
+       !llvmpipe_resource_is_texture(src) ||
+       src->nr_samples > 1 ||
+       src_box->depth != 1 ||
+       src_box->width <= 0 || src_box->height <= 0 ||
+       src_box->x < 0 || src_box->y < 0 ||
+       !lp_can_translate_format(dst_format, src_format))
+      return false;
+
+   /* All rows have to be inside the buffer */
+   const int64_t row_size = (int64_t)src_box->width *
+                            util_format_get_blocksize(dst_format);
+   const int64_t last_row = dst_offset +
+                            (int64_t)(src_box->height - 1) * dst_stride;
+
+   if (MIN2(dst_offset, last_row) < 0 ||
+       MAX2(dst_offset, last_row) + row_size > dst->width0 ||
+       abs(dst_stride) < row_size)
+      return false;
+
+   if (!lp_setup_copy_to_buffer(lp->setup, dst, dst_format,
+                                dst_offset, dst_stride,
+                                src, src_format, src_level, src_box))
+      return false;
+
+   /* Shaders which don't run in the scene have to wait for it */
+   lp_fence_reference(&lp->copy_fence, llvmpipe_resource(dst)->write_fence);
+   return true;
+}
+
+
 static void
 lp_blit(struct pipe_context *pipe,
         const struct pipe_blit_info *blit_info)
@@ -522,6 +624,7 @@ llvmpipe_init_surface_functions(struct llvmpipe_context *lp)
    lp->pipe.clear_texture = llvmpipe_clear_texture;
    lp->pipe.clear_buffer = llvmpipe_clear_buffer;
    lp->pipe.resource_copy_region = lp_resource_copy;
+   lp->pipe.copy_texture_to_buffer = lp_copy_texture_to_buffer;
    lp->pipe.blit = lp_blit;
    lp->pipe.flush_resource = lp_flush_resource;
    lp->pipe.get_sample_position = llvmpipe_get_sample_position;
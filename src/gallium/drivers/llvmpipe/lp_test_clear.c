@@ -0,0 +1,379 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Unit tests for full-surface color clears, which are recorded in the
+ * resource and only written to the tiles the next scenes touch.  Whatever
+ * else accesses the resource must still see the whole surface cleared.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "compiler/glsl_types.h"
+#include "util/format/u_format.h"
+#include "util/u_draw.h"
+#include "util/u_inlines.h"
+#include "util/u_sampler.h"
+#include "util/u_simple_shaders.h"
+#include "sw/null/null_sw_winsys.h"
+#include "lp_public.h"
+
+#include "lp_test.h"
+
+
+#define WIDTH 128
+#define HEIGHT 128
+
+/* Pixels drawn by the partial draw, all in the first tile */
+#define DRAWN 16
+
+#define FORMAT PIPE_FORMAT_R8G8B8A8_UNORM
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "test\n");
+
+   fflush(fp);
+}
+
+
+static struct pipe_resource *
+create_texture(struct pipe_screen *screen)
+{
+   struct pipe_resource templ = {0};
+
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = FORMAT;
+   templ.width0 = WIDTH;
+   templ.height0 = HEIGHT;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = PIPE_BIND_RENDER_TARGET | PIPE_BIND_SAMPLER_VIEW;
+
+   return screen->resource_create(screen, &templ);
+}
+
+
+static void
+set_framebuffer(struct pipe_context *pipe, struct pipe_surface *surf)
+{
+   struct pipe_framebuffer_state fb = {0};
+
+   if (surf) {
+      fb.width = WIDTH;
+      fb.height = HEIGHT;
+      fb.nr_cbufs = 1;
+      fb.cbufs[0] = surf;
+   }
+
+   pipe->set_framebuffer_state(pipe, &fb);
+}
+
+
+/**
+ * Draw the rectangle from (-1, -1) to (x1, y1) in clip space with 'fs',
+ * which gets 'generic' of each corner as GENERIC[0].
+ */
+static void
+draw_rect(struct pipe_context *pipe, void *fs, float x1, float y1,
+          const float generic[4][4])
+{
+   const float corners[4][2] = {
+      { -1.0f, -1.0f }, { x1, -1.0f }, { -1.0f, y1 }, { x1, y1 },
+   };
+   const enum tgsi_semantic semantic_names[] = {
+      TGSI_SEMANTIC_POSITION, TGSI_SEMANTIC_GENERIC,
+   };
+   const unsigned semantic_indexes[] = { 0, 0 };
+   float vertices[4][2][4];
+   struct pipe_vertex_element velems[2] = {0};
+   struct pipe_vertex_buffer vbuf = {0};
+   struct pipe_rasterizer_state rast = {0};
+   struct pipe_blend_state blend = {0};
+   struct pipe_depth_stencil_alpha_state dsa = {0};
+   struct pipe_viewport_state viewport = {
+      .scale = { WIDTH / 2.0f, HEIGHT / 2.0f, 1.0f },
+      .translate = { WIDTH / 2.0f, HEIGHT / 2.0f, 0.0f },
+   };
+   void *vs, *velems_state, *rast_state, *blend_state, *dsa_state;
+
+   for (unsigned i = 0; i < 4; i++) {
+      vertices[i][0][0] = corners[i][0];
+      vertices[i][0][1] = corners[i][1];
+      vertices[i][0][2] = 0.0f;
+      vertices[i][0][3] = 1.0f;
+      memcpy(vertices[i][1], generic[i], sizeof(generic[i]));
+   }
+
+   for (unsigned i = 0; i < 2; i++) {
+      velems[i].src_offset = i * sizeof(vertices[0][0]);
+      velems[i].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+      velems[i].src_stride = sizeof(vertices[0]);
+   }
+   velems_state = pipe->create_vertex_elements_state(pipe, 2, velems);
+   vbuf.is_user_buffer = true;
+   vbuf.buffer.user = vertices;
+
+   rast.half_pixel_center = 1;
+   rast.depth_clip_near = 1;
+   rast.depth_clip_far = 1;
+   rast_state = pipe->create_rasterizer_state(pipe, &rast);
+   blend.rt[0].colormask = PIPE_MASK_RGBA;
+   blend_state = pipe->create_blend_state(pipe, &blend);
+   dsa_state = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+   vs = util_make_vertex_passthrough_shader(pipe, 2, semantic_names,
+                                            semantic_indexes, false);
+
+   pipe->bind_vertex_elements_state(pipe, velems_state);
+   pipe->set_vertex_buffers(pipe, 1, &vbuf);
+   pipe->bind_rasterizer_state(pipe, rast_state);
+   pipe->bind_blend_state(pipe, blend_state);
+   pipe->bind_depth_stencil_alpha_state(pipe, dsa_state);
+   pipe->set_viewport_states(pipe, 0, 1, &viewport);
+   pipe->bind_vs_state(pipe, vs);
+   pipe->bind_fs_state(pipe, fs);
+
+   util_draw_arrays(pipe, MESA_PRIM_TRIANGLE_STRIP, 0, 4);
+
+   pipe->bind_fs_state(pipe, NULL);
+   pipe->bind_vs_state(pipe, NULL);
+   pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+   pipe->bind_blend_state(pipe, NULL);
+   pipe->bind_rasterizer_state(pipe, NULL);
+   pipe->set_vertex_buffers(pipe, 0, NULL);
+   pipe->bind_vertex_elements_state(pipe, NULL);
+   pipe->delete_vs_state(pipe, vs);
+   pipe->delete_depth_stencil_alpha_state(pipe, dsa_state);
+   pipe->delete_blend_state(pipe, blend_state);
+   pipe->delete_rasterizer_state(pipe, rast_state);
+   pipe->delete_vertex_elements_state(pipe, velems_state);
+}
+
+
+/**
+ * Compare the whole texture against 'inside' in the DRAWN x DRAWN corner
+ * and 'outside' everywhere else.
+ */
+static bool
+check_texture(struct pipe_context *pipe, struct pipe_resource *tex,
+              const char *test, const union pipe_color_union *inside,
+              const union pipe_color_union *outside)
+{
+   struct pipe_transfer *transfer;
+   uint32_t expected[2] = {0};
+   const uint8_t *map;
+   bool success = true;
+
+   util_format_pack_rgba(FORMAT, &expected[0], inside->f, 1);
+   util_format_pack_rgba(FORMAT, &expected[1], outside->f, 1);
+
+   map = pipe_texture_map(pipe, tex, 0, 0, PIPE_MAP_READ,
+                          0, 0, WIDTH, HEIGHT, &transfer);
+
+   for (unsigned y = 0; y < HEIGHT && success; y++) {
+      const uint32_t *row = (const uint32_t *)(map + y * transfer->stride);
+
+      for (unsigned x = 0; x < WIDTH; x++) {
+         const uint32_t value = expected[x >= DRAWN || y >= DRAWN];
+
+         if (row[x] != value) {
+            fprintf(stderr, "%s: pixel (%u, %u) is 0x%08x, expected 0x%08x\n",
+                    test, x, y, row[x], value);
+            success = false;
+            break;
+         }
+      }
+   }
+
+   pipe_texture_unmap(pipe, transfer);
+
+   return success;
+}
+
+
+/**
+ * The draw's tile gets cleared by the rasterizer, the map has to write out
+ * the others.
+ */
+static bool
+test_partial_draw(struct pipe_context *pipe)
+{
+   static const union pipe_color_union clear = {
+      .f = { 0.0f, 0.0f, 1.0f, 1.0f },
+   };
+   static const union pipe_color_union color = {
+      .f = { 1.0f, 0.0f, 0.0f, 1.0f },
+   };
+   const float generic[4][4] = {
+      { 1.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f },
+      { 1.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f },
+   };
+   struct pipe_resource *tex = create_texture(pipe->screen);
+   struct pipe_surface surf_templ = {0}, *surf;
+   void *fs;
+   bool success;
+
+   surf_templ.format = FORMAT;
+   surf = pipe->create_surface(pipe, tex, &surf_templ);
+   set_framebuffer(pipe, surf);
+
+   fs = util_make_fragment_passthrough_shader(pipe, TGSI_SEMANTIC_GENERIC,
+                                              TGSI_INTERPOLATE_CONSTANT,
+                                              false);
+
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0, NULL, &clear, 0.0, 0);
+   draw_rect(pipe, fs, -1.0f + 2.0f * DRAWN / WIDTH,
+             -1.0f + 2.0f * DRAWN / HEIGHT, generic);
+
+   success = check_texture(pipe, tex, "partial draw", &color, &clear);
+
+   set_framebuffer(pipe, NULL);
+   pipe->delete_fs_state(pipe, fs);
+   pipe_surface_reference(&surf, NULL);
+   pipe_resource_reference(&tex, NULL);
+
+   return success;
+}
+
+
+/**
+ * Sampling happens outside of the scenes clearing tiles, so binding the
+ * view has to write out the whole clear.
+ */
+static bool
+test_sample(struct pipe_context *pipe)
+{
+   static const union pipe_color_union clear = {
+      .f = { 0.0f, 1.0f, 0.0f, 1.0f },
+   };
+   static const union pipe_color_union dst_clear = {
+      .f = { 0.0f, 0.0f, 0.0f, 0.0f },
+   };
+   const float texcoords[4][4] = {
+      { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f },
+      { 0.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 0.0f, 1.0f },
+   };
+   struct pipe_resource *src = create_texture(pipe->screen);
+   struct pipe_resource *dst = create_texture(pipe->screen);
+   struct pipe_surface surf_templ = {0}, *src_surf, *dst_surf;
+   struct pipe_sampler_view view_templ, *view;
+   struct pipe_sampler_state sampler = {0};
+   void *fs, *sampler_state;
+   bool success;
+
+   surf_templ.format = FORMAT;
+   src_surf = pipe->create_surface(pipe, src, &surf_templ);
+   dst_surf = pipe->create_surface(pipe, dst, &surf_templ);
+
+   set_framebuffer(pipe, src_surf);
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0, NULL, &clear, 0.0, 0);
+
+   set_framebuffer(pipe, dst_surf);
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0, NULL, &dst_clear, 0.0, 0);
+
+   u_sampler_view_default_template(&view_templ, src, FORMAT);
+   view = pipe->create_sampler_view(pipe, src, &view_templ);
+   pipe->set_sampler_views(pipe, PIPE_SHADER_FRAGMENT, 0, 1, 0, false,
+                           &view);
+
+   sampler.wrap_s = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler.wrap_t = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler.wrap_r = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler.min_img_filter = PIPE_TEX_FILTER_NEAREST;
+   sampler.mag_img_filter = PIPE_TEX_FILTER_NEAREST;
+   sampler.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+   sampler_state = pipe->create_sampler_state(pipe, &sampler);
+   pipe->bind_sampler_states(pipe, PIPE_SHADER_FRAGMENT, 0, 1,
+                             &sampler_state);
+
+   fs = util_make_fragment_tex_shader(pipe, TGSI_TEXTURE_2D,
+                                      TGSI_RETURN_TYPE_FLOAT,
+                                      TGSI_RETURN_TYPE_FLOAT, false, false);
+
+   draw_rect(pipe, fs, 1.0f, 1.0f, texcoords);
+
+   success = check_texture(pipe, dst, "sample", &clear, &clear);
+
+   set_framebuffer(pipe, NULL);
+   pipe->set_sampler_views(pipe, PIPE_SHADER_FRAGMENT, 0, 0, 1, false,
+                           NULL);
+   pipe->bind_sampler_states(pipe, PIPE_SHADER_FRAGMENT, 0, 0, NULL);
+   pipe->delete_sampler_state(pipe, sampler_state);
+   pipe->delete_fs_state(pipe, fs);
+   pipe_sampler_view_reference(&view, NULL);
+   pipe_surface_reference(&dst_surf, NULL);
+   pipe_surface_reference(&src_surf, NULL);
+   pipe_resource_reference(&dst, NULL);
+   pipe_resource_reference(&src, NULL);
+
+   return success;
+}
+
+
+bool
+test_all(unsigned verbose, FILE *fp)
+{
+   static const struct {
+      const char *name;
+      bool (*func)(struct pipe_context *pipe);
+   } tests[] = {
+      { "partial draw", test_partial_draw },
+      { "sample", test_sample },
+   };
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   bool success = true;
+
+   glsl_type_singleton_init_or_ref();
+
+   screen = llvmpipe_create_screen(null_sw_create());
+   pipe = screen->context_create(screen, NULL, 0);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(tests); i++) {
+      bool result = tests[i].func(pipe);
+
+      if (verbose)
+         printf("%s: %s\n", tests[i].name, result ? "ok" : "FAIL");
+
+      if (fp)
+         fprintf(fp, "%s\t%s\n", result ? "pass" : "fail", tests[i].name);
+
+      success &= result;
+   }
+
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+
+   glsl_type_singleton_decref();
+
+   return success;
+}
+
+
+bool
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+bool
+test_single(unsigned verbose, FILE *fp)
+{
+   printf("no test_single()");
+   return true;
+}
@@ -0,0 +1,345 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Unit tests for copies from a color buffer into a buffer, as used for
+ * glReadPixels into a PBO.
+ *
+ * These are binned into the scene rather than done right away, so whatever
+ * reads the buffer outside of the scene has to wait for them, and draws in
+ * the same scene must not run before them.  GL needs no barrier between the
+ * two, and the buffer may already be bound when the copy is made.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "util/u_draw.h"
+#include "util/u_inlines.h"
+#include "util/u_simple_shaders.h"
+#include "compiler/nir/nir_builder.h"
+#include "tgsi/tgsi_from_mesa.h"
+#include "sw/null/null_sw_winsys.h"
+#include "lp_public.h"
+
+#include "lp_test.h"
+
+
+#define WIDTH 128
+#define HEIGHT 128
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "format\n");
+
+   fflush(fp);
+}
+
+
+/**
+ * ssbo[1][0] = ssbo[0][offset]
+ */
+static nir_shader *
+create_copy_shader(struct pipe_screen *screen, gl_shader_stage stage,
+                   unsigned offset)
+{
+   const nir_shader_compiler_options *options =
+      screen->get_compiler_options(screen, PIPE_SHADER_IR_NIR,
+                                   pipe_shader_type_from_mesa(stage));
+   nir_builder b = nir_builder_init_simple_shader(stage, options, "read pbo");
+
+   if (stage == MESA_SHADER_COMPUTE) {
+      b.shader->info.workgroup_size[0] = 1;
+      b.shader->info.workgroup_size[1] = 1;
+      b.shader->info.workgroup_size[2] = 1;
+   }
+   b.shader->info.num_ssbos = 2;
+
+   nir_def *value = nir_load_ssbo(&b, 1, 32, nir_imm_int(&b, 0),
+                                  nir_imm_int(&b, offset), .align_mul = 4);
+   nir_store_ssbo(&b, value, nir_imm_int(&b, 1), nir_imm_int(&b, 0),
+                  .align_mul = 4);
+
+   screen->finalize_nir(screen, b.shader);
+
+   return b.shader;
+}
+
+
+static void *
+create_cs(struct pipe_context *pipe, unsigned offset)
+{
+   struct pipe_compute_state state = {0};
+
+   state.ir_type = PIPE_SHADER_IR_NIR;
+   state.prog = create_copy_shader(pipe->screen, MESA_SHADER_COMPUTE, offset);
+
+   return pipe->create_compute_state(pipe, &state);
+}
+
+
+static void *
+create_fs(struct pipe_context *pipe, unsigned offset)
+{
+   struct pipe_shader_state state = {0};
+
+   state.type = PIPE_SHADER_IR_NIR;
+   state.ir.nir = create_copy_shader(pipe->screen, MESA_SHADER_FRAGMENT,
+                                     offset);
+
+   return pipe->create_fs_state(pipe, &state);
+}
+
+
+static bool
+check_result(struct pipe_context *pipe, struct pipe_resource *result,
+             enum pipe_format format, const union pipe_color_union *color,
+             const char *stage)
+{
+   uint32_t expected = 0, value;
+
+   util_format_pack_rgba(format, &expected, color->f, 1);
+   pipe_buffer_read(pipe, result, 0, 4, &value);
+   if (memcmp(&value, &expected, util_format_get_blocksize(format))) {
+      fprintf(stderr, "%s: %s shader read 0x%08x, expected 0x%08x\n",
+              util_format_name(format), stage, value, expected);
+      return false;
+   }
+
+   return true;
+}
+
+
+/**
+ * Runs the fragment shader in the first tile only, which the rasterizer may
+ * get to before the copy is done in the last one.
+ */
+static void
+draw_corner(struct pipe_context *pipe)
+{
+   static const float vertices[4][4] = {
+      { -1.0f,  -1.0f,  0.0f, 1.0f },
+      { -0.75f, -1.0f,  0.0f, 1.0f },
+      { -1.0f,  -0.75f, 0.0f, 1.0f },
+      { -0.75f, -0.75f, 0.0f, 1.0f },
+   };
+   const enum tgsi_semantic semantic_names[] = { TGSI_SEMANTIC_POSITION };
+   const unsigned semantic_indexes[] = { 0 };
+   struct pipe_vertex_element velem = {0};
+   struct pipe_vertex_buffer vbuf = {0};
+   struct pipe_rasterizer_state rast = {0};
+   struct pipe_blend_state blend = {0};
+   struct pipe_depth_stencil_alpha_state dsa = {0};
+   struct pipe_viewport_state viewport = {
+      .scale = { WIDTH / 2.0f, HEIGHT / 2.0f, 1.0f },
+      .translate = { WIDTH / 2.0f, HEIGHT / 2.0f, 0.0f },
+   };
+   void *vs, *velems, *rast_state, *blend_state, *dsa_state;
+
+   velem.src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   velem.src_stride = sizeof(vertices[0]);
+   velems = pipe->create_vertex_elements_state(pipe, 1, &velem);
+   vbuf.is_user_buffer = true;
+   vbuf.buffer.user = vertices;
+
+   rast.half_pixel_center = 1;
+   rast.depth_clip_near = 1;
+   rast.depth_clip_far = 1;
+   rast_state = pipe->create_rasterizer_state(pipe, &rast);
+   blend_state = pipe->create_blend_state(pipe, &blend);
+   dsa_state = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+   vs = util_make_vertex_passthrough_shader(pipe, 1, semantic_names,
+                                            semantic_indexes, false);
+
+   pipe->bind_vertex_elements_state(pipe, velems);
+   pipe->set_vertex_buffers(pipe, 1, &vbuf);
+   pipe->bind_rasterizer_state(pipe, rast_state);
+   pipe->bind_blend_state(pipe, blend_state);
+   pipe->bind_depth_stencil_alpha_state(pipe, dsa_state);
+   pipe->set_viewport_states(pipe, 0, 1, &viewport);
+   pipe->bind_vs_state(pipe, vs);
+
+   util_draw_arrays(pipe, MESA_PRIM_TRIANGLE_STRIP, 0, 4);
+
+   pipe->bind_vs_state(pipe, NULL);
+   pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+   pipe->bind_blend_state(pipe, NULL);
+   pipe->bind_rasterizer_state(pipe, NULL);
+   pipe->set_vertex_buffers(pipe, 0, NULL);
+   pipe->bind_vertex_elements_state(pipe, NULL);
+   pipe->delete_vs_state(pipe, vs);
+   pipe->delete_depth_stencil_alpha_state(pipe, dsa_state);
+   pipe->delete_blend_state(pipe, blend_state);
+   pipe->delete_rasterizer_state(pipe, rast_state);
+   pipe->delete_vertex_elements_state(pipe, velems);
+}
+
+
+static bool
+test_format(unsigned verbose, FILE *fp, struct pipe_context *pipe,
+            enum pipe_format format)
+{
+   struct pipe_screen *screen = pipe->screen;
+   const unsigned bpp = util_format_get_blocksize(format);
+   const unsigned last = ((HEIGHT - 1) * WIDTH + WIDTH - 1) * bpp;
+   struct pipe_resource templ = {0};
+   struct pipe_resource *tex, *pbo, *result;
+   struct pipe_surface surf_templ = {0}, *surf;
+   struct pipe_framebuffer_state fb = {0};
+   struct pipe_shader_buffer ssbos[2] = {0};
+   struct pipe_grid_info info = {0};
+   union pipe_color_union color = {
+      .f = { 1.0f, 0.5f, 0.25f, 0.0f },
+   };
+   union pipe_color_union color2 = {
+      .f = { 0.0f, 0.25f, 0.5f, 1.0f },
+   };
+   bool success = true;
+   void *cs, *fs;
+
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = format;
+   templ.width0 = WIDTH;
+   templ.height0 = HEIGHT;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = PIPE_BIND_RENDER_TARGET | PIPE_BIND_SAMPLER_VIEW;
+   tex = screen->resource_create(screen, &templ);
+
+   pbo = pipe_buffer_create(screen, PIPE_BIND_SHADER_BUFFER,
+                            PIPE_USAGE_STREAM, WIDTH * HEIGHT * bpp);
+   result = pipe_buffer_create(screen, PIPE_BIND_SHADER_BUFFER,
+                               PIPE_USAGE_STAGING, 4);
+
+   /* Bound before the copy, so binding it doesn't sync with the scene */
+   cs = create_cs(pipe, last);
+   pipe->bind_compute_state(pipe, cs);
+   ssbos[0].buffer = pbo;
+   ssbos[0].buffer_size = pbo->width0;
+   ssbos[1].buffer = result;
+   ssbos[1].buffer_size = result->width0;
+   pipe->set_shader_buffers(pipe, PIPE_SHADER_COMPUTE, 0, 2, ssbos, 0x2);
+
+   surf_templ.format = format;
+   surf = pipe->create_surface(pipe, tex, &surf_templ);
+   fb.width = WIDTH;
+   fb.height = HEIGHT;
+   fb.nr_cbufs = 1;
+   fb.cbufs[0] = surf;
+   pipe->set_framebuffer_state(pipe, &fb);
+
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0, NULL, &color, 0.0, 0);
+
+   struct pipe_box box;
+   u_box_2d_zslice(0, 0, 0, WIDTH, HEIGHT, &box);
+   if (!pipe->copy_texture_to_buffer(pipe, pbo, format, 0, WIDTH * bpp,
+                                     tex, format, 0, &box)) {
+      fprintf(stderr, "%s: copy not binned\n", util_format_name(format));
+      success = false;
+   }
+
+   info.block[0] = info.block[1] = info.block[2] = 1;
+   info.grid[0] = info.grid[1] = info.grid[2] = 1;
+   info.work_dim = 1;
+   pipe->launch_grid(pipe, &info);
+
+   success &= check_result(pipe, result, format, &color, "compute");
+
+   /* Also bound before the copy, but the scene only gets to see the
+    * buffers with the draw after it.
+    */
+   pipe->flush(pipe, NULL, 0);
+   fs = create_fs(pipe, last);
+   pipe->bind_fs_state(pipe, fs);
+   pipe->set_shader_buffers(pipe, PIPE_SHADER_FRAGMENT, 0, 2, ssbos, 0x2);
+
+   pipe->clear(pipe, PIPE_CLEAR_COLOR0, NULL, &color2, 0.0, 0);
+   if (!pipe->copy_texture_to_buffer(pipe, pbo, format, 0, WIDTH * bpp,
+                                     tex, format, 0, &box)) {
+      fprintf(stderr, "%s: copy not binned\n", util_format_name(format));
+      success = false;
+   }
+
+   draw_corner(pipe);
+
+   success &= check_result(pipe, result, format, &color2, "fragment");
+
+   if (verbose)
+      printf("%s: %s\n", util_format_name(format), success ? "ok" : "FAIL");
+
+   if (fp)
+      fprintf(fp, "%s\t%s\n", success ? "pass" : "fail",
+              util_format_name(format));
+
+   memset(&fb, 0, sizeof(fb));
+   pipe->set_framebuffer_state(pipe, &fb);
+   pipe->set_shader_buffers(pipe, PIPE_SHADER_FRAGMENT, 0, 2, NULL, 0);
+   pipe->set_shader_buffers(pipe, PIPE_SHADER_COMPUTE, 0, 2, NULL, 0);
+   pipe->bind_fs_state(pipe, NULL);
+   pipe->delete_fs_state(pipe, fs);
+   pipe->bind_compute_state(pipe, NULL);
+   pipe->delete_compute_state(pipe, cs);
+   pipe_surface_reference(&surf, NULL);
+   pipe_resource_reference(&result, NULL);
+   pipe_resource_reference(&pbo, NULL);
+   pipe_resource_reference(&tex, NULL);
+
+   return success;
+}
+
+
+bool
+test_all(unsigned verbose, FILE *fp)
+{
+   static const enum pipe_format formats[] = {
+      PIPE_FORMAT_R8G8B8A8_UNORM,
+      PIPE_FORMAT_B8G8R8A8_UNORM,
+      PIPE_FORMAT_R32_FLOAT,
+   };
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   bool success = true;
+
+   glsl_type_singleton_init_or_ref();
+
+   screen = llvmpipe_create_screen(null_sw_create());
+   pipe = screen->context_create(screen, NULL, 0);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(formats); i++)
+      success &= test_format(verbose, fp, pipe, formats[i]);
+
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+
+   glsl_type_singleton_decref();
+
+   return success;
+}
+
+
+bool
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+bool
+test_single(unsigned verbose, FILE *fp)
+{
+   printf("no test_single()");
+   return true;
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Unit tests for mediump-lowered shaders on the 8-bit linear path.
+ *
+ * A shader that scales a constant color is built once with 32-bit floats
+ * and once the way nir_lower_mediump leaves it, with f2fmp/f2f32 around
+ * 16-bit math.  Both must be accepted by the linear analysis, and the AoS
+ * code generated for them must give the same unorm8 results.
+ *
+ * lp_test_blend only generates the blend stage, which the mediump handling
+ * doesn't change, and never runs a shader through the NIR backends.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "util/u_pointer.h"
+#include "gallivm/lp_bld.h"
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_nir.h"
+#include "gallivm/lp_bld_type.h"
+#include "compiler/nir/nir_builder.h"
+#include "lp_state_fs.h"
+
+#include "lp_test.h"
+
+
+typedef void (*linear_test_func_t)(const uint8_t *consts, uint8_t *out);
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "mediump\t"
+           "factor\n");
+
+   fflush(fp);
+}
+
+
+/**
+ * color = ubo[0] * factor, optionally lowered to 16 bits like mediump.
+ */
+static nir_shader *
+build_scale_shader(bool mediump, float factor)
+{
+   static const nir_shader_compiler_options options = { 0 };
+   nir_builder b = nir_builder_init_simple_shader(MESA_SHADER_FRAGMENT,
+                                                  &options, "scale");
+
+   nir_variable *out = nir_variable_create(b.shader, nir_var_shader_out,
+                                           glsl_vec4_type(), "color");
+   out->data.location = FRAG_RESULT_DATA0;
+   out->data.driver_location = 0;
+   b.shader->info.outputs_written = BITFIELD64_BIT(FRAG_RESULT_DATA0);
+   b.shader->num_outputs = 1;
+
+   nir_def *color = nir_load_ubo(&b, 4, 32, nir_imm_int(&b, 0),
+                                 nir_imm_int(&b, 0), .align_mul = 16,
+                                 .range = ~0);
+   if (mediump) {
+      color = nir_f2fmp(&b, color);
+      color = nir_fmul_imm(&b, color, factor);
+      color = nir_f2f32(&b, color);
+   } else {
+      color = nir_fmul_imm(&b, color, factor);
+   }
+   nir_store_var(&b, out, color, 0xf);
+
+   return b.shader;
+}
+
+
+static enum lp_fs_kind
+analyse(nir_shader *nir)
+{
+   struct lp_fragment_shader *shader = CALLOC_STRUCT(lp_fragment_shader);
+   enum lp_fs_kind kind;
+
+   shader->base.ir.nir = nir;
+   llvmpipe_fs_analyse_nir(shader);
+   kind = shader->kind;
+   FREE(shader);
+
+   return kind;
+}
+
+
+static LLVMValueRef
+add_linear_test(struct gallivm_state *gallivm, nir_shader *nir)
+{
+   static const unsigned char rgba_swizzles[4] = {0, 1, 2, 3};
+   LLVMContextRef context = gallivm->context;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_type type = lp_type_unorm(8, 128);
+   LLVMTypeRef vec_type = lp_build_vec_type(gallivm, type);
+   LLVMTypeRef ptr_type = LLVMPointerType(LLVMInt8TypeInContext(context), 0);
+   LLVMTypeRef args[2] = { ptr_type, ptr_type };
+   LLVMValueRef func =
+      LLVMAddFunction(gallivm->module, "test_linear",
+                      LLVMFunctionType(LLVMVoidTypeInContext(context),
+                                       args, 2, 0));
+   LLVMValueRef inputs[PIPE_MAX_SHADER_INPUTS];
+   LLVMValueRef outputs[PIPE_MAX_SHADER_OUTPUTS];
+
+   LLVMSetFunctionCallConv(func, LLVMCCallConv);
+   LLVMPositionBuilderAtEnd(builder,
+                            LLVMAppendBasicBlockInContext(context, func,
+                                                          "entry"));
+
+   for (unsigned i = 0; i < PIPE_MAX_SHADER_INPUTS; i++)
+      inputs[i] = LLVMGetUndef(vec_type);
+   for (unsigned i = 0; i < PIPE_MAX_SHADER_OUTPUTS; i++)
+      outputs[i] = NULL;
+
+   lp_build_nir_aos(gallivm, nir, type, rgba_swizzles,
+                    LLVMGetParam(func, 0), inputs, outputs, NULL);
+
+   LLVMValueRef color = LLVMBuildLoad2(builder, vec_type, outputs[0], "");
+   LLVMValueRef out_ptr =
+      LLVMBuildBitCast(builder, LLVMGetParam(func, 1),
+                       LLVMPointerType(vec_type, 0), "");
+   LLVMBuildStore(builder, color, out_ptr);
+   LLVMBuildRetVoid(builder);
+
+   gallivm_verify_function(gallivm, func);
+
+   return func;
+}
+
+
+/**
+ * Runs the AoS code for \p nir on 4 pixels of the color in \p consts.
+ */
+UTIL_ALIGN_STACK
+static void
+run_linear(nir_shader *nir, const uint8_t consts[4], uint8_t out[16])
+{
+   lp_context_ref context;
+   struct gallivm_state *gallivm;
+   LLVMValueRef test;
+   linear_test_func_t test_func;
+
+   lp_context_create(&context);
+   gallivm = gallivm_create("test_module", &context, NULL);
+
+   nir_shader *clone = nir_shader_clone(NULL, nir);
+   test = add_linear_test(gallivm, clone);
+   ralloc_free(clone);
+
+   gallivm_compile_module(gallivm);
+   test_func = (linear_test_func_t)
+      gallivm_jit_function(gallivm, test, "test_linear");
+   gallivm_free_ir(gallivm);
+
+   test_func(consts, out);
+
+   gallivm_destroy(gallivm);
+   lp_context_destroy(&context);
+}
+
+
+static bool
+test_linear(unsigned verbose, FILE *fp, float factor)
+{
+   static const uint8_t consts[4] = { 0x00, 0x40, 0xc3, 0xff };
+   nir_shader *highp = build_scale_shader(false, factor);
+   nir_shader *mediump = build_scale_shader(true, factor);
+   bool in_range = factor >= 0.0f && factor <= 1.0f;
+   bool success = true;
+
+   /* Constants outside of [0,1] don't fit unorm8 whatever the precision. */
+   enum lp_fs_kind expected = in_range ? LP_FS_KIND_LLVM_LINEAR :
+                                         LP_FS_KIND_GENERAL;
+   if (analyse(highp) != expected || analyse(mediump) != expected) {
+      fprintf(stderr, "factor %f: unexpected linear analysis\n", factor);
+      success = false;
+   }
+
+   if (in_range) {
+      uint8_t highp_out[16], mediump_out[16];
+
+      run_linear(highp, consts, highp_out);
+      run_linear(mediump, consts, mediump_out);
+
+      for (unsigned i = 0; i < 16; i++) {
+         int expected_val = (int)(consts[i % 4] * factor + 0.5f);
+
+         if (mediump_out[i] != highp_out[i] ||
+             abs(mediump_out[i] - expected_val) > 1) {
+            fprintf(stderr, "factor %f: mediump %u, highp %u, expected %d "
+                    "at %u\n", factor, mediump_out[i], highp_out[i],
+                    expected_val, i);
+            success = false;
+            break;
+         }
+      }
+   }
+
+   if (verbose)
+      printf("factor %f: %s\n", factor, success ? "ok" : "FAIL");
+
+   if (fp)
+      fprintf(fp, "%s\t1\t%f\n", success ? "pass" : "fail", factor);
+
+   ralloc_free(highp);
+   ralloc_free(mediump);
+
+   return success;
+}
+
+
+bool
+test_all(unsigned verbose, FILE *fp)
+{
+   static const float factors[] = { 0.0f, 0.25f, 0.5f, 1.0f, 2.0f };
+   bool success = true;
+
+   glsl_type_singleton_init_or_ref();
+
+   for (unsigned i = 0; i < ARRAY_SIZE(factors); i++)
+      success &= test_linear(verbose, fp, factors[i]);
+
+   glsl_type_singleton_decref();
+
+   return success;
+}
+
+
+bool
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+bool
+test_single(unsigned verbose, FILE *fp)
+{
+   printf("no test_single()");
+   return true;
+}
@@ -33,10 +33,6 @@
 
 struct lp_build_sampler_soa;
 struct lp_sampler_static_state;
-/**
- * Whether texture cache is used for s3tc textures.
- */
-#define LP_USE_TEXTURE_CACHE 0
 
 struct lp_build_sampler_soa *
 lp_llvm_sampler_soa_create(const struct lp_sampler_static_state *static_state,
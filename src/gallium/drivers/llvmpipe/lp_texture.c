@@ -42,6 +42,7 @@
 #include "util/format/u_format.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
+#include "util/u_surface.h"
 #include "util/u_transfer.h"
 
 #if DETECT_OS_POSIX
@@ -49,7 +50,10 @@
 #endif
 
 #include "lp_context.h"
+#include "lp_debug.h"
+#include "lp_fence.h"
 #include "lp_flush.h"
+#include "lp_perf.h"
 #include "lp_screen.h"
 #include "lp_texture.h"
 #include "lp_setup.h"
@@ -583,6 +587,8 @@ llvmpipe_resource_destroy(struct pipe_screen *pscreen,
       }
    }
 
+   lp_fence_reference(&lpr->write_fence, NULL);
+
 #if defined(HAVE_LIBDRM) && defined(HAVE_LINUX_UDMABUF_H)
    if (lpr->dmabuf_alloc)
       pscreen->free_memory_fd(pscreen, (struct pipe_memory_allocation*)lpr->dmabuf_alloc);
@@ -598,6 +604,7 @@ llvmpipe_resource_destroy(struct pipe_screen *pscreen,
    }
 
    free(lpr->residency);
+   free(lpr->lazy_clear.pending_tiles);
 
 #if MESA_DEBUG
    simple_mtx_lock(&resource_list_mutex);
@@ -688,6 +695,175 @@ llvmpipe_resource_unmap(struct pipe_resource *resource,
 }
 
 
+/**
+ * Can color clears of this resource be deferred with a llvmpipe_lazy_clear?
+ * Anything whose memory may be seen outside of the driver's own mapping
+ * paths (display targets, shared or imported memory) has to be cleared
+ * eagerly.
+ */
+bool
+llvmpipe_resource_can_lazy_clear(const struct pipe_resource *resource)
+{
+   const struct llvmpipe_resource *lpr = llvmpipe_resource_const(resource);
+
+   if (LP_PERF & PERF_NO_LAZY_CLEAR)
+      return false;
+
+   switch (resource->target) {
+   case PIPE_TEXTURE_2D:
+   case PIPE_TEXTURE_2D_ARRAY:
+   case PIPE_TEXTURE_RECT:
+      break;
+   default:
+      return false;
+   }
+
+   if (resource->nr_samples > 1 ||
+       (resource->flags & PIPE_RESOURCE_FLAG_SPARSE) ||
+       (resource->bind & (PIPE_BIND_DISPLAY_TARGET |
+                          PIPE_BIND_SCANOUT |
+                          PIPE_BIND_SHARED)))
+      return false;
+
+   return !lpr->dt && !lpr->user_ptr && !lpr->backable &&
+          !lpr->imported_memory && !lpr->dmabuf;
+}
+
+
+/**
+ * Record a clear of the whole surface 'surf' without touching memory.
+ * A previously pending clear of the same level/layers is superseded,
+ * otherwise it is written out first (callers which may race with
+ * rasterization should have done so themselves).
+ *
+ * \return false if the clear couldn't be recorded, nothing is pending then
+ */
+bool
+llvmpipe_resource_set_lazy_clear(struct llvmpipe_resource *lpr,
+                                 const struct pipe_surface *surf,
+                                 const union util_color *color)
+{
+   struct llvmpipe_lazy_clear *lc = &lpr->lazy_clear;
+   const unsigned level = surf->u.tex.level;
+
+   if (llvmpipe_resource_has_lazy_clear(lpr) &&
+       (lc->level != level ||
+        lc->first_layer != surf->u.tex.first_layer ||
+        lc->last_layer != surf->u.tex.last_layer))
+      llvmpipe_resource_apply_lazy_clear(lpr);
+
+   const unsigned tiles_x =
+      DIV_ROUND_UP(u_minify(lpr->base.width0, level), TILE_SIZE);
+   const unsigned tiles_y =
+      DIV_ROUND_UP(u_minify(lpr->base.height0, level), TILE_SIZE);
+   const unsigned num_tiles = tiles_x * tiles_y;
+
+   if (lc->num_alloced_tiles < num_tiles) {
+      free(lc->pending_tiles);
+      lc->pending_tiles = malloc(BITSET_WORDS(num_tiles) * sizeof(BITSET_WORD));
+      lc->num_alloced_tiles = lc->pending_tiles ? num_tiles : 0;
+      if (!lc->pending_tiles) {
+         lc->num_pending = 0;
+         return false;
+      }
+   }
+
+   lc->tiles_x = tiles_x;
+   lc->tiles_y = tiles_y;
+   memset(lc->pending_tiles, 0, BITSET_WORDS(num_tiles) * sizeof(BITSET_WORD));
+   BITSET_SET_RANGE(lc->pending_tiles, 0, num_tiles - 1);
+   lc->num_pending = num_tiles;
+   lc->level = level;
+   lc->first_layer = surf->u.tex.first_layer;
+   lc->last_layer = surf->u.tex.last_layer;
+   lc->format = surf->format;
+   lc->color = *color;
+
+   LP_COUNT(nr_lazy_clear_recorded);
+   LP_DBG(DEBUG_SETUP, "%s tex %u level %u layers %u..%u, %u tiles\n",
+          __func__, lpr->id, level, lc->first_layer, lc->last_layer,
+          num_tiles);
+   return true;
+}
+
+
+/**
+ * Write the clear value into all tiles still pending.  The caller must make
+ * sure no scene in flight touches those tiles, which holds as long as the
+ * resource's pending bits are only updated by the setup code.
+ */
+void
+llvmpipe_resource_apply_lazy_clear(struct llvmpipe_resource *lpr)
+{
+   struct llvmpipe_lazy_clear *lc = &lpr->lazy_clear;
+
+   if (!llvmpipe_resource_has_lazy_clear(lpr))
+      return;
+
+   const unsigned level = lc->level;
+   const unsigned width = u_minify(lpr->base.width0, level);
+   const unsigned height = u_minify(lpr->base.height0, level);
+   uint8_t *map = llvmpipe_get_texture_image_address(lpr, lc->first_layer,
+                                                     level);
+   unsigned i;
+
+   BITSET_FOREACH_SET(i, lc->pending_tiles, lc->tiles_x * lc->tiles_y) {
+      const unsigned x = (i % lc->tiles_x) * TILE_SIZE;
+      const unsigned y = (i / lc->tiles_x) * TILE_SIZE;
+
+      util_fill_box(map, lc->format,
+                    lpr->row_stride[level], lpr->img_stride[level],
+                    x, y, 0,
+                    MIN2(TILE_SIZE, width - x),
+                    MIN2(TILE_SIZE, height - y),
+                    lc->last_layer - lc->first_layer + 1,
+                    &lc->color);
+   }
+
+   LP_COUNT_ADD(nr_lazy_clear_resolved_cpu, lc->num_pending);
+   lc->num_pending = 0;
+}
+
+
+/**
+ * Forget a pending clear, e.g. because the whole resource is about to be
+ * overwritten.
+ */
+void
+llvmpipe_resource_discard_lazy_clear(struct llvmpipe_resource *lpr)
+{
+   lpr->lazy_clear.num_pending = 0;
+}
+
+
+/**
+ * Make the memory of a resource match its logical contents before it gets
+ * accessed other than as a render target of the scene being binned.
+ *
+ * \return false if a scene uses the resource and do_not_block is set,
+ *         the clear is still pending then
+ */
+bool
+llvmpipe_resource_resolve_clear(struct pipe_context *pipe,
+                                struct pipe_resource *resource,
+                                bool do_not_block)
+{
+   struct llvmpipe_resource *lpr = llvmpipe_resource(resource);
+
+   if (!llvmpipe_resource_is_texture(resource) ||
+       !llvmpipe_resource_has_lazy_clear(lpr))
+      return true;
+
+   /* Let a scene still binning against the resource claim its tiles. */
+   if (!llvmpipe_flush_resource(pipe, resource, 0, false, true, do_not_block,
+                                "lazy clear"))
+      return false;
+
+   llvmpipe_resource_apply_lazy_clear(lpr);
+   return true;
+}
+
+
 void *
 llvmpipe_resource_data(struct pipe_resource *resource)
 {
@@ -940,6 +1116,21 @@ llvmpipe_transfer_map_ms(struct pipe_context *pipe,
       }
    }
 
+   if (llvmpipe_resource_is_texture(resource) &&
+       llvmpipe_resource_has_lazy_clear(lpr)) {
+      bool do_not_block =
+         !!(usage & (PIPE_MAP_DONTBLOCK | PIPE_MAP_UNSYNCHRONIZED));
+
+      if (usage & PIPE_MAP_DISCARD_WHOLE_RESOURCE) {
+         llvmpipe_resource_discard_lazy_clear(lpr);
+      } else if (!llvmpipe_resource_resolve_clear(pipe, resource,
+                                                  do_not_block)) {
+         /* Unsynchronized maps get the memory as is while scenes use it. */
+         if (!(usage & PIPE_MAP_UNSYNCHRONIZED))
+            return NULL;
+      }
+   }
+
    /* Check if we're mapping a current constant buffer */
    if ((usage & PIPE_MAP_WRITE) &&
        (resource->bind & PIPE_BIND_CONSTANT_BUFFER)) {
@@ -1168,12 +1359,14 @@ llvmpipe_is_resource_referenced(struct pipe_context *pipe,
                                 unsigned level)
 {
    struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   /* Any buffer may be the destination of a binned copy */
    if (!(presource->bind & (PIPE_BIND_DEPTH_STENCIL |
                             PIPE_BIND_RENDER_TARGET |
                             PIPE_BIND_SAMPLER_VIEW |
                             PIPE_BIND_CONSTANT_BUFFER |
                             PIPE_BIND_SHADER_BUFFER |
-                            PIPE_BIND_SHADER_IMAGE)))
+                            PIPE_BIND_SHADER_IMAGE)) &&
+       !llvmpipe_resource(presource)->write_fence)
       return LP_UNREFERENCED;
 
    return lp_setup_is_resource_referenced(llvmpipe->setup, presource);
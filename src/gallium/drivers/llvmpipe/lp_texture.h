@@ -31,6 +31,7 @@
 
 #include "pipe/p_state.h"
 #include "util/u_debug.h"
+#include "util/u_pack_color.h"
 #include "lp_limits.h"
 #include "util/bitset.h"
 #if MESA_DEBUG
@@ -56,10 +57,32 @@ struct pipe_context;
 struct pipe_screen;
 struct pipe_memory_object;
 struct llvmpipe_context;
+struct lp_fence;
 struct llvmpipe_screen;
 
 struct sw_displaytarget;
 
+/**
+ * Deferred full-surface color clear.
+ *
+ * Instead of writing the clear value into every tile, the clear is recorded
+ * here and each tile whose bit is set in pending_tiles logically contains
+ * 'color'.  A tile is resolved by the rasterizer the first time a scene
+ * touches it, and llvmpipe_resource_resolve_clear() writes out whatever is
+ * left before any other kind of access (mapping, sampling, images).
+ */
+struct llvmpipe_lazy_clear
+{
+   BITSET_WORD *pending_tiles;  /**< one bit per TILE_SIZE^2 tile */
+   unsigned num_alloced_tiles;
+   unsigned tiles_x, tiles_y;
+   unsigned num_pending;
+   unsigned level;
+   unsigned first_layer, last_layer;
+   enum pipe_format format;     /**< surface format 'color' is packed in */
+   union util_color color;
+};
+
 /**
  * llvmpipe subclass of pipe_resource.  A texture, drawing surface,
  * vertex buffer, const buffer, etc.
@@ -117,6 +140,12 @@ struct llvmpipe_resource
    bool backable;
    struct pipe_memory_object *imported_memory;
    bool dmabuf;
+
+   /** Color clear not yet written to memory, see llvmpipe_lazy_clear */
+   struct llvmpipe_lazy_clear lazy_clear;
+
+   /** Scene with a binned copy into this buffer, see lp_setup_copy_to_buffer */
+   struct lp_fence *write_fence;
 #if MESA_DEBUG
    struct list_head list;
 #endif
@@ -307,6 +336,31 @@ llvmpipe_transfer_map_ms(struct pipe_context *pipe,
                          const struct pipe_box *box,
                          struct pipe_transfer **transfer);
 
+static inline bool
+llvmpipe_resource_has_lazy_clear(const struct llvmpipe_resource *lpr)
+{
+   return lpr->lazy_clear.num_pending != 0;
+}
+
+bool
+llvmpipe_resource_can_lazy_clear(const struct pipe_resource *resource);
+
+bool
+llvmpipe_resource_set_lazy_clear(struct llvmpipe_resource *lpr,
+                                 const struct pipe_surface *surf,
+                                 const union util_color *color);
+
+void
+llvmpipe_resource_apply_lazy_clear(struct llvmpipe_resource *lpr);
+
+void
+llvmpipe_resource_discard_lazy_clear(struct llvmpipe_resource *lpr);
+
+bool
+llvmpipe_resource_resolve_clear(struct pipe_context *pipe,
+                                struct pipe_resource *resource,
+                                bool do_not_block);
+
 uint32_t
 llvmpipe_get_texel_offset(struct pipe_resource *resource,
                           uint32_t level, uint32_t x,
@@ -199,6 +199,11 @@ dri_create_context(struct dri_screen *screen,
       ctx->hud = hud_create(ctx->st->cso_context,
                             share_ctx ? share_ctx->hud : NULL,
                             ctx->st, st_context_invalidate_state);
+      if (ctx->hud) {
+         struct st_validate_monitoring *mon =
+            hud_get_validate_monitoring(ctx->hud, ctx->st->cso_context);
+         st_context_set_validate_monitoring(ctx->st, mon);
+      }
    }
 
    /* order of precedence (least to most):
@@ -262,6 +267,7 @@ dri_destroy_context(struct dri_context *ctx)
    _mesa_glthread_finish(ctx->st->ctx);
 
    if (ctx->hud) {
+      st_context_set_validate_monitoring(ctx->st, NULL);
       hud_destroy(ctx->hud, ctx->st->cso_context);
    }
 
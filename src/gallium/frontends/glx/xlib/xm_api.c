@@ -1016,6 +1016,11 @@ XMesaContext XMesaCreateContext( XMesaVisual v, XMesaContext share_list,
 
    c->hud = hud_create(c->st->cso_context, NULL, c->st,
                        st_context_invalidate_state);
+   if (c->hud) {
+      struct st_validate_monitoring *mon =
+         hud_get_validate_monitoring(c->hud, c->st->cso_context);
+      st_context_set_validate_monitoring(c->st, mon);
+   }
 
    return c;
 
@@ -1031,6 +1036,7 @@ PUBLIC
 void XMesaDestroyContext( XMesaContext c )
 {
    if (c->hud) {
+      st_context_set_validate_monitoring(c->st, NULL);
       hud_destroy(c->hud, NULL);
    }
 
@@ -255,6 +255,11 @@ stw_create_context_attribs(HDC hdc, INT iLayerPlane, struct stw_context *shareCt
    if (ctx->st->cso_context) {
       ctx->hud = hud_create(ctx->st->cso_context, NULL, ctx->st,
                             st_context_invalidate_state);
+      if (ctx->hud) {
+         struct st_validate_monitoring *mon =
+            hud_get_validate_monitoring(ctx->hud, ctx->st->cso_context);
+         st_context_set_validate_monitoring(ctx->st, mon);
+      }
    }
 
    return ctx;
@@ -300,6 +305,7 @@ void
 stw_destroy_context(struct stw_context *ctx)
 {
    if (ctx->hud) {
+      st_context_set_validate_monitoring(ctx->st, NULL);
       hud_destroy(ctx->hud, NULL);
    }
 
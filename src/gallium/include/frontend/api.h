@@ -27,6 +27,8 @@
 #ifndef _API_H_
 #define _API_H_
 
+#include <stdint.h>
+
 #include "util/format/u_formats.h"
 
 struct st_context;
@@ -99,6 +101,21 @@ enum st_attachment_type {
 #define ST_INVALIDATE_VERTEX_BUFFERS      (1 << 3)
 #define ST_INVALIDATE_FB_STATE            (1 << 4)
 
+#define ST_VALIDATE_MAX_ATOMS             64
+
+/**
+ * CPU time and number of calls of every state validation function, for the
+ * HUD.  The HUD owns the structure, the GL frontend only adds to the
+ * counters and fills in the names.
+ */
+struct st_validate_monitoring
+{
+   unsigned num_atoms;
+   const char *atom_names[ST_VALIDATE_MAX_ATOMS];
+   uint64_t time_ns[ST_VALIDATE_MAX_ATOMS];
+   uint64_t num_calls[ST_VALIDATE_MAX_ATOMS];
+};
+
 /**
  * Value to pipe_frontend_streen::get_param function.
  */
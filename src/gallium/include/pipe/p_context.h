@@ -690,6 +690,25 @@ struct pipe_context {
                                 unsigned src_level,
                                 const struct pipe_box *src_box);
 
+   /**
+    * Copy a block of pixels from a texture into a buffer, converting them
+    * from src_format to dst_format, e.g. for glReadPixels into a PBO.
+    * Rows are dst_stride bytes apart starting at dst_offset, a negative
+    * stride stores them bottom-up.  Only src_box->depth == 1 is allowed.
+    *
+    * Optional.
+    *
+    * \return false if the driver can't do this copy, nothing is done then
+    */
+   bool (*copy_texture_to_buffer)(struct pipe_context *pipe,
+                                  struct pipe_resource *dst,
+                                  enum pipe_format dst_format,
+                                  unsigned dst_offset, int dst_stride,
+                                  struct pipe_resource *src,
+                                  enum pipe_format src_format,
+                                  unsigned src_level,
+                                  const struct pipe_box *src_box);
+
    /* Optimal hardware path for blitting pixels.
     * Scaling, format conversion, up- and downsampling (resolve) are allowed.
     */
@@ -1123,6 +1123,14 @@ _mesa_free_context_data(struct gl_context *ctx, bool destroy_debug_output)
       _mesa_make_current(ctx, NULL, NULL);
    }
 
+   /* Queued compiles use the context, and shaders deleted below wait for
+    * them.
+    */
+   if (util_queue_is_initialized(&ctx->ShaderCompileQueue)) {
+      util_queue_finish(&ctx->ShaderCompileQueue);
+      util_queue_destroy(&ctx->ShaderCompileQueue);
+   }
+
    /* unreference WinSysDraw/Read buffers */
    _mesa_reference_framebuffer(&ctx->WinSysDrawBuffer, NULL);
    _mesa_reference_framebuffer(&ctx->WinSysReadBuffer, NULL);
@@ -5560,6 +5560,16 @@ save_Materialfv(GLenum face, GLenum pname, const GLfloat * param)
       }
    }
 
+   /* Materials that are per-vertex in the pending vertex list don't need
+    * to end it.
+    */
+   for (i = 0; i < MAT_ATTRIB_MAX; i++) {
+      if ((bitmask & (1 << i)) &&
+          vbo_save_fold_attr(ctx, VBO_ATTRIB_FIRST_MATERIAL + i, args,
+                             GL_FLOAT, (const uint32_t *)param))
+         bitmask &= ~(1 << i);
+   }
+
    /* If this call has no effect, return early */
    if (bitmask == 0)
       return;
@@ -5837,7 +5847,6 @@ save_Attr32bit(struct gl_context *ctx, unsigned attr, unsigned size,
                GLenum type, uint32_t x, uint32_t y, uint32_t z, uint32_t w)
 {
    Node *n;
-   SAVE_FLUSH_VERTICES(ctx);
    unsigned base_op;
    unsigned index = attr;
 
@@ -5857,13 +5866,21 @@ save_Attr32bit(struct gl_context *ctx, unsigned attr, unsigned size,
       attr -= VERT_ATTRIB_GENERIC0;
    }
 
-   n = alloc_instruction(ctx, base_op + size - 1, 1 + size);
-   if (n) {
-      n[1].ui = attr;
-      n[2].ui = x;
-      if (size >= 2) n[3].ui = y;
-      if (size >= 3) n[4].ui = z;
-      if (size >= 4) n[5].ui = w;
+   /* If the attribute is per-vertex in the pending vertex list, the value
+    * goes into the following vertices and the list doesn't have to end.
+    */
+   if (!vbo_save_fold_attr(ctx, index, size, type,
+                           (const uint32_t[]){x, y, z, w})) {
+      SAVE_FLUSH_VERTICES(ctx);
+
+      n = alloc_instruction(ctx, base_op + size - 1, 1 + size);
+      if (n) {
+         n[1].ui = attr;
+         n[2].ui = x;
+         if (size >= 2) n[3].ui = y;
+         if (size >= 3) n[4].ui = z;
+         if (size >= 4) n[5].ui = w;
+      }
    }
 
    ctx->ListState.ActiveAttribSize[index] = size;
@@ -30,6 +30,11 @@
 #include "format_pack.h"
 #include "format_unpack.h"
 
+#if defined(USE_SSE41)
+#include "main/sse_swizzle_convert.h"
+#include "util/u_cpu_detect.h"
+#endif
+
 const mesa_array_format RGBA32_FLOAT =
    MESA_ARRAY_FORMAT(MESA_ARRAY_FORMAT_BASE_FORMAT_RGBA_VARIANTS,
                      4, 1, 1, 1, 4, 0, 1, 2, 3);
@@ -247,6 +252,36 @@ convert_ubyte_rgba_to_bgra(size_t width, size_t height,
 }
 
 
+/**
+ * A swizzle-and-convert operation with everything that only depends on the
+ * formats and the swizzle worked out up front.  _mesa_format_convert makes
+ * one for every step of the conversion and runs it for every row.
+ */
+struct swizzle_convert_plan {
+   enum mesa_array_format_datatype dst_type, src_type;
+   int num_dst_channels, num_src_channels;
+   uint8_t swizzle[4];
+   bool normalized;
+   bool is_memcpy;
+#if defined(USE_SSE41)
+   bool use_sse41;
+   struct sse_swizzle_convert_plan sse41;
+#endif
+};
+
+static void
+swizzle_convert_plan_init(struct swizzle_convert_plan *plan,
+                          enum mesa_array_format_datatype dst_type,
+                          int num_dst_channels,
+                          enum mesa_array_format_datatype src_type,
+                          int num_src_channels,
+                          const uint8_t swizzle[4], bool normalized);
+
+static void
+swizzle_convert_plan_run(const struct swizzle_convert_plan *plan,
+                         void *dst, const void *src, int count);
+
+
 /**
  * This can be used to convert between most color formats.
  *
@@ -293,6 +328,7 @@ _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
    uint32_t (*tmp_uint)[4];
    int bits;
    size_t row;
+   struct swizzle_convert_plan plan;
 
    if (_mesa_format_is_mesa_array_format(src_format)) {
       src_format_is_mesa_array_format = true;
@@ -448,10 +484,11 @@ _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
       compute_src2dst_component_mapping(src2rgba, rgba2dst, rebase_swizzle,
                                         src2dst);
 
+      swizzle_convert_plan_init(&plan, dst_type, dst_num_channels,
+                                src_type, src_num_channels,
+                                src2dst, normalized);
       for (row = 0; row < height; ++row) {
-         _mesa_swizzle_and_convert(dst, dst_type, dst_num_channels,
-                                   src, src_type, src_num_channels,
-                                   src2dst, normalized, width);
+         swizzle_convert_plan_run(&plan, dst, src, width);
          src += src_stride;
          dst += dst_stride;
       }
@@ -537,20 +574,23 @@ _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
       if (src_array_format) {
          compute_rebased_rgba_component_mapping(src2rgba, rebase_swizzle,
                                                 rebased_src2rgba);
+         swizzle_convert_plan_init(&plan, common_type, 4,
+                                   src_type, src_num_channels,
+                                   rebased_src2rgba, normalized);
          for (row = 0; row < height; ++row) {
-            _mesa_swizzle_and_convert(tmp_uint + row * width, common_type, 4,
-                                      src, src_type, src_num_channels,
-                                      rebased_src2rgba, normalized, width);
+            swizzle_convert_plan_run(&plan, tmp_uint + row * width, src, width);
             src += src_stride;
          }
       } else {
+         if (rebase_swizzle)
+            swizzle_convert_plan_init(&plan, common_type, 4, common_type, 4,
+                                      rebase_swizzle, false);
          for (row = 0; row < height; ++row) {
             _mesa_unpack_uint_rgba_row(src_format, width,
                                        src, tmp_uint + row * width);
             if (rebase_swizzle)
-               _mesa_swizzle_and_convert(tmp_uint + row * width, common_type, 4,
-                                         tmp_uint + row * width, common_type, 4,
-                                         rebase_swizzle, false, width);
+               swizzle_convert_plan_run(&plan, tmp_uint + row * width,
+                                        tmp_uint + row * width, width);
             src += src_stride;
          }
       }
@@ -560,10 +600,10 @@ _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
        * _mesa_swizzle_and_convert path.
        */
       if (dst_format_is_mesa_array_format) {
+         swizzle_convert_plan_init(&plan, dst_type, dst_num_channels,
+                                   common_type, 4, rgba2dst, normalized);
          for (row = 0; row < height; ++row) {
-            _mesa_swizzle_and_convert(dst, dst_type, dst_num_channels,
-                                      tmp_uint + row * width, common_type, 4,
-                                      rgba2dst, normalized, width);
+            swizzle_convert_plan_run(&plan, dst, tmp_uint + row * width, width);
             dst += dst_stride;
          }
       } else {
@@ -581,33 +621,34 @@ _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
       if (src_format_is_mesa_array_format) {
          compute_rebased_rgba_component_mapping(src2rgba, rebase_swizzle,
                                                 rebased_src2rgba);
+         swizzle_convert_plan_init(&plan, MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                                   src_type, src_num_channels,
+                                   rebased_src2rgba, normalized);
          for (row = 0; row < height; ++row) {
-            _mesa_swizzle_and_convert(tmp_float + row * width,
-                                      MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
-                                      src, src_type, src_num_channels,
-                                      rebased_src2rgba, normalized, width);
+            swizzle_convert_plan_run(&plan, tmp_float + row * width, src, width);
             src += src_stride;
          }
       } else {
+         if (rebase_swizzle)
+            swizzle_convert_plan_init(&plan, MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                                      MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                                      rebase_swizzle, normalized);
          for (row = 0; row < height; ++row) {
             _mesa_unpack_rgba_row(src_format, width,
                                   src, tmp_float + row * width);
             if (rebase_swizzle)
-               _mesa_swizzle_and_convert(tmp_float + row * width,
-                                         MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
-                                         tmp_float + row * width,
-                                         MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
-                                         rebase_swizzle, normalized, width);
+               swizzle_convert_plan_run(&plan, tmp_float + row * width,
+                                        tmp_float + row * width, width);
             src += src_stride;
          }
       }
 
       if (dst_format_is_mesa_array_format) {
+         swizzle_convert_plan_init(&plan, dst_type, dst_num_channels,
+                                   MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                                   rgba2dst, normalized);
          for (row = 0; row < height; ++row) {
-            _mesa_swizzle_and_convert(dst, dst_type, dst_num_channels,
-                                      tmp_float + row * width,
-                                      MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
-                                      rgba2dst, normalized, width);
+            swizzle_convert_plan_run(&plan, dst, tmp_float + row * width, width);
             dst += dst_stride;
          }
       } else {
@@ -625,33 +666,34 @@ _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
       if (src_format_is_mesa_array_format) {
          compute_rebased_rgba_component_mapping(src2rgba, rebase_swizzle,
                                                 rebased_src2rgba);
+         swizzle_convert_plan_init(&plan, MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                                   src_type, src_num_channels,
+                                   rebased_src2rgba, normalized);
          for (row = 0; row < height; ++row) {
-            _mesa_swizzle_and_convert(tmp_ubyte + row * width,
-                                      MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
-                                      src, src_type, src_num_channels,
-                                      rebased_src2rgba, normalized, width);
+            swizzle_convert_plan_run(&plan, tmp_ubyte + row * width, src, width);
             src += src_stride;
          }
       } else {
+         if (rebase_swizzle)
+            swizzle_convert_plan_init(&plan, MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                                      MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                                      rebase_swizzle, normalized);
          for (row = 0; row < height; ++row) {
             _mesa_unpack_ubyte_rgba_row(src_format, width,
                                         src, tmp_ubyte + row * width);
             if (rebase_swizzle)
-               _mesa_swizzle_and_convert(tmp_ubyte + row * width,
-                                         MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
-                                         tmp_ubyte + row * width,
-                                         MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
-                                         rebase_swizzle, normalized, width);
+               swizzle_convert_plan_run(&plan, tmp_ubyte + row * width,
+                                        tmp_ubyte + row * width, width);
             src += src_stride;
          }
       }
 
       if (dst_format_is_mesa_array_format) {
+         swizzle_convert_plan_init(&plan, dst_type, dst_num_channels,
+                                   MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                                   rgba2dst, normalized);
          for (row = 0; row < height; ++row) {
-            _mesa_swizzle_and_convert(dst, dst_type, dst_num_channels,
-                                      tmp_ubyte + row * width,
-                                      MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
-                                      rgba2dst, normalized, width);
+            swizzle_convert_plan_run(&plan, dst, tmp_ubyte + row * width, width);
             dst += dst_stride;
          }
       } else {
@@ -667,25 +709,20 @@ _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
 }
 
 /**
- * Attempts to perform the given swizzle-and-convert operation with memcpy
- *
- * This function determines if the given swizzle-and-convert operation can
- * be done with a simple memcpy and, if so, does the memcpy.  If not, it
- * returns false and we fall back to the standard version below.
+ * Determines if the given swizzle-and-convert operation can be done with a
+ * simple memcpy.  If not, we fall back to the standard version below.
  *
  * The arguments are exactly the same as for _mesa_swizzle_and_convert
  *
- * \return  true if it successfully performed the swizzle-and-convert
- *          operation with memcpy, false otherwise
+ * \return  true if the swizzle-and-convert operation is a memcpy, false
+ *          otherwise
  */
 static bool
-swizzle_convert_try_memcpy(void *dst,
-                           enum mesa_array_format_datatype dst_type,
-                           int num_dst_channels,
-                           const void *src,
-                           enum mesa_array_format_datatype src_type,
-                           int num_src_channels,
-                           const uint8_t swizzle[4], bool normalized, int count)
+swizzle_convert_is_memcpy(enum mesa_array_format_datatype dst_type,
+                          int num_dst_channels,
+                          enum mesa_array_format_datatype src_type,
+                          int num_src_channels,
+                          const uint8_t swizzle[4])
 {
    int i;
 
@@ -698,9 +735,6 @@ swizzle_convert_try_memcpy(void *dst,
       if (swizzle[i] != i && swizzle[i] != MESA_FORMAT_SWIZZLE_NONE)
          return false;
 
-   memcpy(dst, src, count * num_src_channels *
-          _mesa_array_format_datatype_get_size(src_type));
-
    return true;
 }
 
@@ -1365,6 +1399,104 @@ convert_int(void *void_dst, int num_dst_channels,
 }
 
 
+static void
+swizzle_convert_scalar(void *void_dst, enum mesa_array_format_datatype dst_type, int num_dst_channels,
+                       const void *void_src, enum mesa_array_format_datatype src_type, int num_src_channels,
+                       const uint8_t swizzle[4], bool normalized, int count)
+{
+   switch (dst_type) {
+   case MESA_ARRAY_FORMAT_TYPE_FLOAT:
+      convert_float(void_dst, num_dst_channels, void_src, src_type,
+                    num_src_channels, swizzle, normalized, count);
+      break;
+   case MESA_ARRAY_FORMAT_TYPE_HALF:
+      convert_half_float(void_dst, num_dst_channels, void_src, src_type,
+                    num_src_channels, swizzle, normalized, count);
+      break;
+   case MESA_ARRAY_FORMAT_TYPE_UBYTE:
+      convert_ubyte(void_dst, num_dst_channels, void_src, src_type,
+                    num_src_channels, swizzle, normalized, count);
+      break;
+   case MESA_ARRAY_FORMAT_TYPE_BYTE:
+      convert_byte(void_dst, num_dst_channels, void_src, src_type,
+                   num_src_channels, swizzle, normalized, count);
+      break;
+   case MESA_ARRAY_FORMAT_TYPE_USHORT:
+      convert_ushort(void_dst, num_dst_channels, void_src, src_type,
+                     num_src_channels, swizzle, normalized, count);
+      break;
+   case MESA_ARRAY_FORMAT_TYPE_SHORT:
+      convert_short(void_dst, num_dst_channels, void_src, src_type,
+                    num_src_channels, swizzle, normalized, count);
+      break;
+   case MESA_ARRAY_FORMAT_TYPE_UINT:
+      convert_uint(void_dst, num_dst_channels, void_src, src_type,
+                   num_src_channels, swizzle, normalized, count);
+      break;
+   case MESA_ARRAY_FORMAT_TYPE_INT:
+      convert_int(void_dst, num_dst_channels, void_src, src_type,
+                  num_src_channels, swizzle, normalized, count);
+      break;
+   default:
+      assert(!"Invalid channel type");
+   }
+}
+
+static void
+swizzle_convert_plan_init(struct swizzle_convert_plan *plan,
+                          enum mesa_array_format_datatype dst_type,
+                          int num_dst_channels,
+                          enum mesa_array_format_datatype src_type,
+                          int num_src_channels,
+                          const uint8_t swizzle[4], bool normalized)
+{
+   plan->dst_type = dst_type;
+   plan->src_type = src_type;
+   plan->num_dst_channels = num_dst_channels;
+   plan->num_src_channels = num_src_channels;
+   memcpy(plan->swizzle, swizzle, sizeof(plan->swizzle));
+   plan->normalized = normalized;
+   plan->is_memcpy = swizzle_convert_is_memcpy(dst_type, num_dst_channels,
+                                               src_type, num_src_channels,
+                                               swizzle);
+#if defined(USE_SSE41)
+   plan->use_sse41 = !plan->is_memcpy &&
+                     util_get_cpu_caps()->has_sse4_1 &&
+                     _mesa_sse41_plan_swizzle_convert(&plan->sse41,
+                                                      dst_type, num_dst_channels,
+                                                      src_type, num_src_channels,
+                                                      swizzle, normalized);
+#endif
+}
+
+static void
+swizzle_convert_plan_run(const struct swizzle_convert_plan *plan,
+                         void *dst, const void *src, int count)
+{
+   if (plan->is_memcpy) {
+      memcpy(dst, src, count * plan->num_src_channels *
+             _mesa_array_format_datatype_get_size(plan->src_type));
+      return;
+   }
+
+#if defined(USE_SSE41)
+   if (plan->use_sse41) {
+      int done = _mesa_sse41_swizzle_convert(dst, src, &plan->sse41, count);
+
+      /* The scalar code below finishes the row */
+      dst = (uint8_t *)dst + done * plan->sse41.dst_bpp;
+      src = (const uint8_t *)src + done * plan->sse41.src_bpp;
+      count -= done;
+      if (count == 0)
+         return;
+   }
+#endif
+
+   swizzle_convert_scalar(dst, plan->dst_type, plan->num_dst_channels,
+                          src, plan->src_type, plan->num_src_channels,
+                          plan->swizzle, plan->normalized, count);
+}
+
 /**
  * Convert between array-based color formats.
  *
@@ -1418,45 +1550,9 @@ _mesa_swizzle_and_convert(void *void_dst, enum mesa_array_format_datatype dst_ty
                           const void *void_src, enum mesa_array_format_datatype src_type, int num_src_channels,
                           const uint8_t swizzle[4], bool normalized, int count)
 {
-   if (swizzle_convert_try_memcpy(void_dst, dst_type, num_dst_channels,
-                                  void_src, src_type, num_src_channels,
-                                  swizzle, normalized, count))
-      return;
+   struct swizzle_convert_plan plan;
 
-   switch (dst_type) {
-   case MESA_ARRAY_FORMAT_TYPE_FLOAT:
-      convert_float(void_dst, num_dst_channels, void_src, src_type,
-                    num_src_channels, swizzle, normalized, count);
-      break;
-   case MESA_ARRAY_FORMAT_TYPE_HALF:
-      convert_half_float(void_dst, num_dst_channels, void_src, src_type,
-                    num_src_channels, swizzle, normalized, count);
-      break;
-   case MESA_ARRAY_FORMAT_TYPE_UBYTE:
-      convert_ubyte(void_dst, num_dst_channels, void_src, src_type,
-                    num_src_channels, swizzle, normalized, count);
-      break;
-   case MESA_ARRAY_FORMAT_TYPE_BYTE:
-      convert_byte(void_dst, num_dst_channels, void_src, src_type,
-                   num_src_channels, swizzle, normalized, count);
-      break;
-   case MESA_ARRAY_FORMAT_TYPE_USHORT:
-      convert_ushort(void_dst, num_dst_channels, void_src, src_type,
-                     num_src_channels, swizzle, normalized, count);
-      break;
-   case MESA_ARRAY_FORMAT_TYPE_SHORT:
-      convert_short(void_dst, num_dst_channels, void_src, src_type,
-                    num_src_channels, swizzle, normalized, count);
-      break;
-   case MESA_ARRAY_FORMAT_TYPE_UINT:
-      convert_uint(void_dst, num_dst_channels, void_src, src_type,
-                   num_src_channels, swizzle, normalized, count);
-      break;
-   case MESA_ARRAY_FORMAT_TYPE_INT:
-      convert_int(void_dst, num_dst_channels, void_src, src_type,
-                  num_src_channels, swizzle, normalized, count);
-      break;
-   default:
-      assert(!"Invalid channel type");
-   }
+   swizzle_convert_plan_init(&plan, dst_type, num_dst_channels,
+                             src_type, num_src_channels, swizzle, normalized);
+   swizzle_convert_plan_run(&plan, void_dst, void_src, count);
 }
@@ -134,6 +134,8 @@ glthread_unmarshal_batch(void *job, void *gdata, int thread_index)
       ctx->TexturesLocked = true;
    }
 
+   ctx->GLThread.batch_end = &buffer[used];
+
    while (pos < used) {
       const struct marshal_cmd_base *cmd =
          (const struct marshal_cmd_base *)&buffer[pos];
@@ -232,6 +232,9 @@ struct glthread_state
    /** Number of uint64_t elements filled already. */
    unsigned used;
 
+   /** The end of the batch being executed, for looking at the next calls. */
+   const uint64_t *batch_end;
+
    /** Upload buffer. */
    struct gl_buffer_object *upload_buffer;
    uint8_t *upload_ptr;
@@ -32,6 +32,8 @@
 #include "api_exec_decl.h"
 #include "main/glthread_marshal.h"
 #include "main/dispatch.h"
+#include "main/draw_validate.h"
+#include "main/transformfeedback.h"
 #include "main/varray.h"
 
 static inline unsigned
@@ -280,6 +282,100 @@ upload_vertices(struct gl_context *ctx, unsigned user_buffer_mask,
    return true;
 }
 
+/* Draws that follow each other in a batch can't have any state changes
+ * between them.  Runs of such draws with the same mode are executed as one
+ * MultiDraw call, which validates the state and goes through the driver's
+ * draw setup only once.
+ */
+#define MAX_MERGED_DRAWS 256
+
+static bool
+can_merge_draws(struct gl_context *ctx, GLenum mode, GLbitfield valid_prim_mask)
+{
+   /* Invalid draws must each report their error from their own entry point,
+    * which includes an incomplete framebuffer or unsupported shader stages.
+    */
+   if (!_mesa_is_valid_prim_mode(ctx, mode) ||
+       !((1u << mode) & valid_prim_mask))
+      return false;
+
+   /* The MultiDraw functions are called directly, bypassing the dispatch. */
+   if (ctx->Dispatch.Current != ctx->Dispatch.OutsideBeginEnd)
+      return false;
+
+   /* GLES checks the space left for transform feedback per draw. */
+   if (_mesa_is_xfb_active_and_unpaused(ctx))
+      return false;
+
+   /* MultiDraw increments gl_DrawID for each draw. */
+   struct gl_program *vs = ctx->_Shader->CurrentProgram[MESA_SHADER_VERTEX];
+   return !vs || !BITSET_TEST(vs->info.system_values_read,
+                              SYSTEM_VALUE_DRAW_ID);
+}
+
+/**
+ * Return the parameters of \p cmd if it's a non-instanced DrawArrays
+ * without user buffers that can be merged with others.
+ */
+static bool
+get_mergeable_draw_arrays(const uint64_t *cmd, const uint64_t *end,
+                          GLenum *mode, GLint *first, GLsizei *count)
+{
+   if (cmd >= end ||
+       ((const struct marshal_cmd_base *)cmd)->cmd_id !=
+       DISPATCH_CMD_DrawArraysInstanced)
+      return false;
+
+   const struct marshal_cmd_DrawArraysInstanced *draw =
+      (const struct marshal_cmd_DrawArraysInstanced *)cmd;
+
+   /* Leave anything that generates an error of its own to the caller. */
+   if (draw->primcount != 1 || draw->first < 0 || draw->count < 0)
+      return false;
+
+   *mode = draw->mode;
+   *first = draw->first;
+   *count = draw->count;
+   return true;
+}
+
+/**
+ * Execute the DrawArraysInstanced call at \p cmd together with the ones
+ * directly after it that use the same mode.
+ *
+ * \return  the number of slots of the executed calls, or 0 if there was
+ *          nothing to merge and the caller has to execute \p cmd
+ */
+static uint32_t
+merge_draw_arrays(struct gl_context *ctx, const uint64_t *cmd)
+{
+   const uint32_t cmd_slots =
+      align(sizeof(struct marshal_cmd_DrawArraysInstanced), 8) / 8;
+   const uint64_t *end = ctx->GLThread.batch_end;
+   GLint first[MAX_MERGED_DRAWS];
+   GLsizei count[MAX_MERGED_DRAWS];
+   GLenum mode, next_mode;
+   unsigned num_draws = 1;
+
+   if (!get_mergeable_draw_arrays(cmd, end, &mode, &first[0], &count[0]) ||
+       !get_mergeable_draw_arrays(cmd + cmd_slots, end, &next_mode,
+                                  &first[1], &count[1]) ||
+       next_mode != mode || !can_merge_draws(ctx, mode, ctx->ValidPrimMask))
+      return 0;
+
+   do {
+      num_draws++;
+   } while (num_draws < MAX_MERGED_DRAWS &&
+            get_mergeable_draw_arrays(cmd + num_draws * cmd_slots, end,
+                                      &next_mode, &first[num_draws],
+                                      &count[num_draws]) &&
+            next_mode == mode);
+
+   _mesa_MultiDrawArrays(mode, first, count, num_draws);
+   p_atomic_add(&ctx->GLThread.stats.num_merged_draws, num_draws);
+   return num_draws * cmd_slots;
+}
+
 /* DrawArraysInstanced without user buffers. */
 uint32_t
 _mesa_unmarshal_DrawArraysInstanced(struct gl_context *ctx,
@@ -290,6 +386,10 @@ _mesa_unmarshal_DrawArraysInstanced(struct gl_context *ctx,
    const GLsizei count = cmd->count;
    const GLsizei instance_count = cmd->primcount;
 
+   uint32_t merged_slots = merge_draw_arrays(ctx, (const uint64_t *)cmd);
+   if (merged_slots)
+      return merged_slots;
+
    CALL_DrawArraysInstanced(ctx->Dispatch.Current, (mode, first, count, instance_count));
    return align(sizeof(*cmd), 8) / 8;
 }
@@ -620,6 +720,95 @@ _mesa_marshal_MultiDrawArrays(GLenum mode, const GLint *first,
    }
 }
 
+/**
+ * Return the parameters of \p cmd if it's a DrawElements or
+ * DrawElementsPacked that can be merged with others.
+ */
+static bool
+get_mergeable_draw_elements(struct gl_context *ctx, const uint64_t *cmd,
+                            const uint64_t *end, GLenum *mode, GLenum *type,
+                            GLsizei *count, const GLvoid **indices,
+                            uint32_t *num_slots)
+{
+   if (cmd >= end)
+      return false;
+
+   switch (((const struct marshal_cmd_base *)cmd)->cmd_id) {
+   case DISPATCH_CMD_DrawElements: {
+      const struct marshal_cmd_DrawElements *draw =
+         (const struct marshal_cmd_DrawElements *)cmd;
+
+      *mode = draw->mode;
+      *type = _mesa_decode_index_type(draw->type);
+      *count = draw->count;
+      *indices = draw->indices;
+      *num_slots = align(sizeof(*draw), 8) / 8;
+      break;
+   }
+   case DISPATCH_CMD_DrawElementsPacked: {
+      const struct marshal_cmd_DrawElementsPacked *draw =
+         (const struct marshal_cmd_DrawElementsPacked *)cmd;
+
+      *mode = draw->mode;
+      *type = _mesa_decode_index_type(draw->type);
+      *count = draw->count;
+      *indices = (void*)(uintptr_t)draw->indices;
+      *num_slots = align(sizeof(*draw), 8) / 8;
+      break;
+   }
+   default:
+      return false;
+   }
+
+   /* Leave anything that generates an error of its own or that
+    * glDrawElements skips to the caller.
+    */
+   struct gl_buffer_object *index_bo = ctx->Array.VAO->IndexBufferObj;
+
+   return *count >= 0 && _mesa_is_index_type_valid(*type) &&
+          index_bo && (uintptr_t)*indices <= index_bo->Size;
+}
+
+/**
+ * Execute the DrawElements(Packed) call at \p cmd together with the ones
+ * directly after it that use the same mode and index type.
+ *
+ * \return  the number of slots of the executed calls, or 0 if there was
+ *          nothing to merge and the caller has to execute \p cmd
+ */
+static uint32_t
+merge_draw_elements(struct gl_context *ctx, const uint64_t *cmd)
+{
+   const uint64_t *end = ctx->GLThread.batch_end;
+   GLsizei count[MAX_MERGED_DRAWS];
+   const GLvoid *indices[MAX_MERGED_DRAWS];
+   GLenum mode, type, next_mode, next_type;
+   uint32_t num_slots, next_slots;
+   unsigned num_draws = 1;
+
+   if (!get_mergeable_draw_elements(ctx, cmd, end, &mode, &type, &count[0],
+                                    &indices[0], &num_slots) ||
+       !get_mergeable_draw_elements(ctx, cmd + num_slots, end, &next_mode,
+                                    &next_type, &count[1], &indices[1],
+                                    &next_slots) ||
+       next_mode != mode || next_type != type ||
+       !can_merge_draws(ctx, mode, ctx->ValidPrimMaskIndexed))
+      return 0;
+
+   do {
+      num_draws++;
+      num_slots += next_slots;
+   } while (num_draws < MAX_MERGED_DRAWS &&
+            get_mergeable_draw_elements(ctx, cmd + num_slots, end, &next_mode,
+                                        &next_type, &count[num_draws],
+                                        &indices[num_draws], &next_slots) &&
+            next_mode == mode && next_type == type);
+
+   _mesa_MultiDrawElements(mode, count, type, indices, num_draws);
+   p_atomic_add(&ctx->GLThread.stats.num_merged_draws, num_draws);
+   return num_slots;
+}
+
 uint32_t
 _mesa_unmarshal_DrawElements(struct gl_context *ctx,
                              const struct marshal_cmd_DrawElements *restrict cmd)
@@ -629,6 +818,10 @@ _mesa_unmarshal_DrawElements(struct gl_context *ctx,
    const GLenum type = _mesa_decode_index_type(cmd->type);
    const GLvoid *indices = cmd->indices;
 
+   uint32_t merged_slots = merge_draw_elements(ctx, (const uint64_t *)cmd);
+   if (merged_slots)
+      return merged_slots;
+
    CALL_DrawElements(ctx->Dispatch.Current, (mode, count, type, indices));
    return align(sizeof(*cmd), 8) / 8;
 }
@@ -642,6 +835,10 @@ _mesa_unmarshal_DrawElementsPacked(struct gl_context *ctx,
    const GLenum type = _mesa_decode_index_type(cmd->type);
    const GLvoid *indices = (void*)(uintptr_t)cmd->indices;
 
+   uint32_t merged_slots = merge_draw_elements(ctx, (const uint64_t *)cmd);
+   if (merged_slots)
+      return merged_slots;
+
    CALL_DrawElements(ctx->Dispatch.Current, (mode, count, type, indices));
    return align(sizeof(*cmd), 8) / 8;
 }
@@ -139,6 +139,13 @@ _mesa_MaxShaderCompilerThreadsKHR(GLuint count)
 
    ctx->Hint.MaxShaderCompilerThreads = count;
 
+   /* 0 makes glCompileShader synchronous again, see queue_compile_shader(). */
+   struct util_queue *queue = &ctx->ShaderCompileQueue;
+   if (count && util_queue_is_initialized(queue)) {
+      util_queue_adjust_num_threads(queue, MIN2(count, queue->max_threads),
+                                    false);
+   }
+
    struct pipe_screen *screen = ctx->screen;
    if (screen->set_max_shader_compiler_threads)
       screen->set_max_shader_compiler_threads(screen, count);
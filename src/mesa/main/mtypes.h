@@ -55,6 +55,7 @@
 #include "util/u_idalloc.h"
 #include "util/simple_mtx.h"
 #include "util/u_dynarray.h"
+#include "util/u_queue.h"
 #include "vbo/vbo.h"
 
 #include "pipe/p_state.h"
@@ -1459,6 +1460,7 @@ struct gl_buffer_object
    unsigned MinMaxCacheHitIndices;
    unsigned MinMaxCacheMissIndices;
    struct hash_table *MinMaxCache;
+   struct vbo_minmax_blocks *MinMaxBlocks; /**< per-block min/max */
    simple_mtx_t MinMaxCacheMutex;
    bool MinMaxCacheDirty:1;
 
@@ -3616,6 +3618,12 @@ struct gl_context
 
    bool shader_builtin_ref;
 
+   /**
+    * Worker threads running the GLSL compiler for glCompileShader, sized by
+    * GL_KHR_parallel_shader_compile.  Created on first use.
+    */
+   struct util_queue ShaderCompileQueue;
+
    struct pipe_draw_start_count_bias *tmp_draws;
    unsigned num_tmp_draws;
 };
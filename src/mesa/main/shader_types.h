@@ -39,6 +39,7 @@
 #include "compiler/shader_info.h"
 #include "compiler/glsl/list.h"
 #include "compiler/glsl/ir_uniform.h"
+#include "util/u_queue.h"
 
 #include "pipe/p_state.h"
 
@@ -155,6 +156,13 @@ struct gl_shader
 
    enum gl_compile_status CompileStatus;
 
+   /**
+    * Signalled when a compile that glCompileShader queued to
+    * gl_context::ShaderCompileQueue has finished.  See
+    * _mesa_wait_shader_compile().
+    */
+   struct util_queue_fence compile_fence;
+
    /** SHA1 of the pre-processed source used by the disk cache. */
    uint8_t disk_cache_sha1[SHA1_DIGEST_LENGTH];
    /** BLAKE3 of the original source before replacement, set by glShaderSource. */
@@ -165,6 +173,7 @@ struct gl_shader
    blake3_hash compiled_source_blake3;
 
    const GLchar *Source;  /**< Source code string */
+   bool HasInclude;       /**< Source may have an #include directive */
    const GLchar *FallbackSource;  /**< Fallback string used by on-disk cache*/
 
    GLchar *InfoLog;
@@ -38,6 +38,7 @@
 
 #include "util/glheader.h"
 #include "main/context.h"
+#include "main/debug_output.h"
 #include "draw_validate.h"
 #include "main/enums.h"
 #include "main/glspirv.h"
@@ -65,6 +66,7 @@
 #include "util/list.h"
 #include "util/log.h"
 #include "util/perf/cpu_trace.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_process.h"
 #include "util/u_string.h"
 #include "api_exec_decl.h"
@@ -1046,14 +1048,21 @@ get_shaderiv(struct gl_context *ctx, GLuint name, GLenum pname, GLint *params)
    switch (pname) {
    case GL_SHADER_TYPE:
       *params = shader->Type;
-      break;
+      return;
    case GL_DELETE_STATUS:
       *params = shader->DeletePending;
-      break;
+      return;
    case GL_COMPLETION_STATUS_ARB:
-      /* _mesa_glsl_compile_shader is not offloaded to other threads. */
-      *params = GL_TRUE;
+      *params = util_queue_fence_is_signalled(&shader->compile_fence);
       return;
+   default:
+      break;
+   }
+
+   /* Everything else depends on a compile that may still be running. */
+   _mesa_wait_shader_compile(shader);
+
+   switch (pname) {
    case GL_COMPILE_STATUS:
       *params = shader->CompileStatus ? GL_TRUE : GL_FALSE;
       break;
@@ -1123,6 +1132,7 @@ get_shader_info_log(struct gl_context *ctx, GLuint shader, GLsizei bufSize,
       return;
    }
 
+   _mesa_wait_shader_compile(sh);
    _mesa_copy_string(infoLog, bufSize, length, sh->InfoLog);
 }
 
@@ -1159,6 +1169,9 @@ set_shader_source(struct gl_shader *sh, const GLchar *source,
 {
    assert(sh);
 
+   /* A queued compile may still be reading the old source. */
+   _mesa_wait_shader_compile(sh);
+
    /* The GL_ARB_gl_spirv spec adds the following to the end of the description
     * of ShaderSource:
     *
@@ -1183,6 +1196,11 @@ set_shader_source(struct gl_shader *sh, const GLchar *source,
    }
 
    memcpy(sh->source_blake3, original_blake3, BLAKE3_OUT_LEN);
+
+   /* Only a hint for queue_compile_shader(), the preprocessor is what finds
+    * the actual directives.  "# include" is one too, so look for the word.
+    */
+   sh->HasInclude = source && strstr(source, "include");
 }
 
 static void
@@ -1194,6 +1212,60 @@ ensure_builtin_types(struct gl_context *ctx)
    }
 }
 
+static void
+compile_shader_job(void *job, void *gdata, int thread_index)
+{
+   _mesa_glsl_compile_shader((struct gl_context *) gdata,
+                             (struct gl_shader *) job, false, false, false);
+}
+
+/**
+ * Queue the GLSL compile of \p sh to a worker thread, so that glCompileShader
+ * returns right away and GL_COMPLETION_STATUS_KHR tells when it's done.
+ * Returns false if the shader has to be compiled synchronously.
+ */
+static bool
+queue_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
+{
+   /* Only offload when the driver compiles in parallel too, which is what
+    * KHR_parallel_shader_compile is exposed for, and the app didn't turn it
+    * off with glMaxShaderCompilerThreadsKHR(0).
+    */
+   if (!ctx->screen->set_max_shader_compiler_threads ||
+       ctx->Hint.MaxShaderCompilerThreads == 0)
+      return false;
+
+   /* MESA_GLSL output is expected in call order, and synchronous debug
+    * output has to come from the calling thread.
+    */
+   if (ctx->_Shader->Flags ||
+       _mesa_get_debug_state_int(ctx, GL_DEBUG_OUTPUT_SYNCHRONOUS))
+      return false;
+
+   /* The preprocessor resolves shader includes through shared state that
+    * glNamedStringARB & co. can change under it.
+    */
+   if (sh->HasInclude)
+      return false;
+
+   struct util_queue *queue = &ctx->ShaderCompileQueue;
+   if (!util_queue_is_initialized(queue)) {
+      unsigned max_threads = util_get_cpu_caps()->nr_cpus;
+
+      if (!util_queue_init(queue, "glsl", 64, max_threads,
+                           UTIL_QUEUE_INIT_RESIZE_IF_FULL, ctx))
+         return false;
+
+      util_queue_adjust_num_threads(queue,
+                                    MIN2(ctx->Hint.MaxShaderCompilerThreads,
+                                         max_threads), false);
+   }
+
+   util_queue_add_job(queue, sh, &sh->compile_fence, compile_shader_job,
+                      NULL, 0);
+   return true;
+}
+
 /**
  * Compile a shader.
  */
@@ -1203,6 +1275,8 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
    if (!sh)
       return;
 
+   _mesa_wait_shader_compile(sh);
+
    /* The GL_ARB_gl_spirv spec says:
     *
     *    "Add a new error for the CompileShader command:
@@ -1229,6 +1303,12 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
 
       ensure_builtin_types(ctx);
 
+      /* Nothing below does anything for a queued compile, since it's only
+       * queued without MESA_GLSL flags.
+       */
+      if (queue_compile_shader(ctx, sh))
+         return;
+
       /* this call will set the shader->CompileStatus field to indicate if
        * compilation was successful.
        */
@@ -1333,6 +1413,9 @@ link_program(struct gl_context *ctx, struct gl_shader_program *shProg,
 
    ensure_builtin_types(ctx);
 
+   for (unsigned i = 0; i < shProg->NumShaders; i++)
+      _mesa_wait_shader_compile(shProg->Shaders[i]);
+
    FLUSH_VERTICES(ctx, 0, 0);
    st_link_shader(ctx, shProg);
 
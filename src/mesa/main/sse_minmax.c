@@ -27,69 +27,150 @@
 
 #include "main/sse_minmax.h"
 #include "util/macros.h"
-#include <smmintrin.h>
 #include <stdint.h>
 
-void
-_mesa_uint_array_min_max(const unsigned *ui_indices, unsigned *min_index,
-                         unsigned *max_index, const unsigned count)
-{
-   unsigned max_ui = 0;
-   unsigned min_ui = ~0U;
-   unsigned i = 0;
-   unsigned aligned_count = count;
-
-   /* handle the first few values without SSE until the pointer is aligned */
-   while (((uintptr_t)ui_indices & 15) && aligned_count) {
-      if (*ui_indices > max_ui)
-         max_ui = *ui_indices;
-      if (*ui_indices < min_ui)
-         min_ui = *ui_indices;
-
-      aligned_count--;
-      ui_indices++;
-   }
+/* This file is built once with SSE4.1 and once with AVX2, the vector type
+ * and the function names follow the instruction set.
+ */
+#ifdef __AVX2__
+#include <immintrin.h>
 
-   /* TODO: The actual threshold for SSE begin useful may be higher than 8.
-    * Some careful microbenchmarks and measurement are required to
-    * find the actual tipping point.
-    */
-   if (aligned_count >= 8) {
-      alignas(16) unsigned max_arr[4];
-      alignas(16) unsigned min_arr[4];
-      unsigned vec_count;
-      __m128i max_ui4 = _mm_setzero_si128();
-      __m128i min_ui4 = _mm_set1_epi32(~0U);
-      __m128i ui_indices4;
-      __m128i *ui_indices_ptr;
+#define VEC_BYTES 32
+typedef __m256i vec;
+#define vec_load(p)        _mm256_loadu_si256((const __m256i *)(p))
+#define vec_store(p, v)    _mm256_storeu_si256((__m256i *)(p), v)
+#define vec_zero()         _mm256_setzero_si256()
+#define vec_or(a, b)       _mm256_or_si256(a, b)
+#define vec_andnot(a, b)   _mm256_andnot_si256(a, b)
+#define vec_set1_8(x)      _mm256_set1_epi8((char)(x))
+#define vec_set1_16(x)     _mm256_set1_epi16((short)(x))
+#define vec_set1_32(x)     _mm256_set1_epi32((int)(x))
+#define vec_cmpeq_8(a, b)  _mm256_cmpeq_epi8(a, b)
+#define vec_cmpeq_16(a, b) _mm256_cmpeq_epi16(a, b)
+#define vec_cmpeq_32(a, b) _mm256_cmpeq_epi32(a, b)
+#define vec_min_8(a, b)    _mm256_min_epu8(a, b)
+#define vec_min_16(a, b)   _mm256_min_epu16(a, b)
+#define vec_min_32(a, b)   _mm256_min_epu32(a, b)
+#define vec_max_8(a, b)    _mm256_max_epu8(a, b)
+#define vec_max_16(a, b)   _mm256_max_epu16(a, b)
+#define vec_max_32(a, b)   _mm256_max_epu32(a, b)
+#define MINMAX_FUNC(name)  name##_avx2
+#else
+#include <smmintrin.h>
 
-      vec_count = aligned_count & ~0x3;
-      ui_indices_ptr = (__m128i *)ui_indices;
-      for (i = 0; i < vec_count / 4; i++) {
-         ui_indices4 = _mm_load_si128(&ui_indices_ptr[i]);
-         max_ui4 = _mm_max_epu32(ui_indices4, max_ui4);
-         min_ui4 = _mm_min_epu32(ui_indices4, min_ui4);
-      }
+#define VEC_BYTES 16
+typedef __m128i vec;
+#define vec_load(p)        _mm_loadu_si128((const __m128i *)(p))
+#define vec_store(p, v)    _mm_storeu_si128((__m128i *)(p), v)
+#define vec_zero()         _mm_setzero_si128()
+#define vec_or(a, b)       _mm_or_si128(a, b)
+#define vec_andnot(a, b)   _mm_andnot_si128(a, b)
+#define vec_set1_8(x)      _mm_set1_epi8((char)(x))
+#define vec_set1_16(x)     _mm_set1_epi16((short)(x))
+#define vec_set1_32(x)     _mm_set1_epi32((int)(x))
+#define vec_cmpeq_8(a, b)  _mm_cmpeq_epi8(a, b)
+#define vec_cmpeq_16(a, b) _mm_cmpeq_epi16(a, b)
+#define vec_cmpeq_32(a, b) _mm_cmpeq_epi32(a, b)
+#define vec_min_8(a, b)    _mm_min_epu8(a, b)
+#define vec_min_16(a, b)   _mm_min_epu16(a, b)
+#define vec_min_32(a, b)   _mm_min_epu32(a, b)
+#define vec_max_8(a, b)    _mm_max_epu8(a, b)
+#define vec_max_16(a, b)   _mm_max_epu16(a, b)
+#define vec_max_32(a, b)   _mm_max_epu32(a, b)
+#define MINMAX_FUNC(name)  name##_sse41
+#endif
 
-      _mm_store_si128((__m128i *)max_arr, max_ui4);
-      _mm_store_si128((__m128i *)min_arr, min_ui4);
+/* Restart indices are or'ed to all ones for the min and masked to zero for
+ * the max, so they never win.  If nothing but restart indices was seen the
+ * vector result is (all ones, 0), which no real index can produce.
+ */
+#define INDEX_MIN_MAX(bits)                                                  \
+static void                                                                  \
+index_min_max_##bits(const uint##bits##_t *indices, unsigned count,          \
+                     bool restart, unsigned restart_index,                   \
+                     unsigned *min_index, unsigned *max_index)               \
+{                                                                            \
+   const unsigned lanes = VEC_BYTES / sizeof(uint##bits##_t);                \
+   const vec restart_vec = vec_set1_##bits(restart_index);                   \
+   vec min_vec = vec_set1_##bits(~0);                                        \
+   vec max_vec = vec_zero();                                                 \
+   unsigned min = ~0U, max = 0;                                              \
+   unsigned i = 0;                                                           \
+                                                                             \
+   if (restart) {                                                            \
+      for (; i + lanes <= count; i += lanes) {                               \
+         vec v = vec_load(indices + i);                                      \
+         vec mask = vec_cmpeq_##bits(v, restart_vec);                        \
+         min_vec = vec_min_##bits(min_vec, vec_or(v, mask));                 \
+         max_vec = vec_max_##bits(max_vec, vec_andnot(mask, v));             \
+      }                                                                      \
+   } else {                                                                  \
+      for (; i + lanes <= count; i += lanes) {                               \
+         vec v = vec_load(indices + i);                                      \
+         min_vec = vec_min_##bits(min_vec, v);                               \
+         max_vec = vec_max_##bits(max_vec, v);                               \
+      }                                                                      \
+   }                                                                         \
+                                                                             \
+   if (i) {                                                                  \
+      uint##bits##_t min_arr[VEC_BYTES / sizeof(uint##bits##_t)];            \
+      uint##bits##_t max_arr[VEC_BYTES / sizeof(uint##bits##_t)];            \
+      uint##bits##_t vmin = UINT##bits##_MAX, vmax = 0;                      \
+                                                                             \
+      vec_store(min_arr, min_vec);                                           \
+      vec_store(max_arr, max_vec);                                           \
+      for (unsigned j = 0; j < lanes; j++) {                                 \
+         vmin = MIN2(vmin, min_arr[j]);                                      \
+         vmax = MAX2(vmax, max_arr[j]);                                      \
+      }                                                                      \
+                                                                             \
+      if (vmin != UINT##bits##_MAX || vmax != 0) {                           \
+         min = vmin;                                                         \
+         max = vmax;                                                         \
+      }                                                                      \
+   }                                                                         \
+                                                                             \
+   for (; i < count; i++) {                                                  \
+      if (restart && indices[i] == restart_index)                            \
+         continue;                                                           \
+      min = MIN2(min, indices[i]);                                           \
+      max = MAX2(max, indices[i]);                                           \
+   }                                                                         \
+                                                                             \
+   *min_index = min;                                                         \
+   *max_index = max;                                                         \
+}
 
-      for (i = 0; i < 4; i++) {
-         if (max_arr[i] > max_ui)
-            max_ui = max_arr[i];
-         if (min_arr[i] < min_ui)
-            min_ui = min_arr[i];
-      }
-      i = vec_count;
-   }
+INDEX_MIN_MAX(8)
+INDEX_MIN_MAX(16)
+INDEX_MIN_MAX(32)
 
-   for (; i < aligned_count; i++) {
-      if (ui_indices[i] > max_ui)
-         max_ui = ui_indices[i];
-      if (ui_indices[i] < min_ui)
-         min_ui = ui_indices[i];
+/**
+ * Same as the scalar loops in vbo_get_minmax_index_mapped(): restart
+ * indices are skipped, and ~0 / 0 is returned if there is no other index.
+ */
+void
+MINMAX_FUNC(_mesa_index_array_min_max)(const void *indices,
+                                       unsigned index_size, unsigned count,
+                                       bool restart, unsigned restart_index,
+                                       unsigned *min_index,
+                                       unsigned *max_index)
+{
+   switch (index_size) {
+   case 4:
+      index_min_max_32(indices, count, restart, restart_index,
+                       min_index, max_index);
+      break;
+   case 2:
+      /* A restart index that doesn't fit never matches */
+      index_min_max_16(indices, count, restart && restart_index <= UINT16_MAX,
+                       restart_index, min_index, max_index);
+      break;
+   case 1:
+      index_min_max_8(indices, count, restart && restart_index <= UINT8_MAX,
+                      restart_index, min_index, max_index);
+      break;
+   default:
+      unreachable("not reached");
    }
-
-   *min_index = min_ui;
-   *max_index = max_ui;
 }
@@ -28,8 +28,26 @@
 #ifndef SSE_MINMAX_H
 #define SSE_MINMAX_H
 
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void
-_mesa_uint_array_min_max(const unsigned *ui_indices, unsigned *min_index,
-                         unsigned *max_index, const unsigned count);
+_mesa_index_array_min_max_sse41(const void *indices, unsigned index_size,
+                                unsigned count, bool restart,
+                                unsigned restart_index,
+                                unsigned *min_index, unsigned *max_index);
+
+void
+_mesa_index_array_min_max_avx2(const void *indices, unsigned index_size,
+                               unsigned count, bool restart,
+                               unsigned restart_index,
+                               unsigned *min_index, unsigned *max_index);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* SSE_MINMAX_H */
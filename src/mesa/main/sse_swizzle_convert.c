@@ -0,0 +1,264 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * SSE4.1 versions of the most common _mesa_swizzle_and_convert operations.
+ *
+ * Each operation is first planned into a kernel and a pshufb table that
+ * moves every channel to its destination position, so the per-pixel work
+ * is a load, a shuffle, the conversion if any and a store.  Only a prefix
+ * of the row is converted here; the caller finishes the last few pixels
+ * with the scalar code, so no load or store ever leaves the row.
+ */
+
+#include "main/sse_swizzle_convert.h"
+#include "util/macros.h"
+#include <smmintrin.h>
+#include <string.h>
+
+static uint32_t
+swizzle_one(enum mesa_array_format_datatype type, bool normalized)
+{
+   switch (type) {
+   case MESA_ARRAY_FORMAT_TYPE_FLOAT:
+      return 0x3f800000;
+   case MESA_ARRAY_FORMAT_TYPE_HALF:
+      return 0x3c00;
+   case MESA_ARRAY_FORMAT_TYPE_UBYTE:
+      return normalized ? UINT8_MAX : 1;
+   case MESA_ARRAY_FORMAT_TYPE_BYTE:
+      return normalized ? INT8_MAX : 1;
+   case MESA_ARRAY_FORMAT_TYPE_USHORT:
+      return normalized ? UINT16_MAX : 1;
+   case MESA_ARRAY_FORMAT_TYPE_SHORT:
+      return normalized ? INT16_MAX : 1;
+   case MESA_ARRAY_FORMAT_TYPE_UINT:
+      return normalized ? UINT32_MAX : 1;
+   case MESA_ARRAY_FORMAT_TYPE_INT:
+      return normalized ? INT32_MAX : 1;
+   default:
+      unreachable("Invalid channel type");
+   }
+}
+
+/**
+ * Fills in the shuffle table for \p pixels pixels made of \p size byte
+ * channels.  Channels that are MESA_FORMAT_SWIZZLE_ONE get \p one from the
+ * fill table, MESA_FORMAT_SWIZZLE_ZERO and NONE channels end up as 0.
+ */
+static void
+plan_shuffle(struct sse_swizzle_convert_plan *plan, int pixels, int size,
+             int num_src_channels, int num_dst_channels,
+             const uint8_t swizzle[4], uint32_t one)
+{
+   memset(plan->shuffle, 0x80, sizeof(plan->shuffle));
+   memset(plan->fill, 0, sizeof(plan->fill));
+
+   for (int p = 0; p < pixels; p++) {
+      for (int i = 0; i < num_dst_channels; i++) {
+         for (int b = 0; b < size; b++) {
+            int d = (p * num_dst_channels + i) * size + b;
+
+            if (swizzle[i] <= MESA_FORMAT_SWIZZLE_W)
+               plan->shuffle[d] = (p * num_src_channels + swizzle[i]) * size + b;
+            else if (swizzle[i] == MESA_FORMAT_SWIZZLE_ONE)
+               plan->fill[d] = one >> (8 * b);
+         }
+      }
+   }
+}
+
+/**
+ * Sets up \p plan for the given swizzle-and-convert operation.  The
+ * arguments are the same as for _mesa_swizzle_and_convert.
+ *
+ * \return  true if there is a kernel for the operation
+ */
+bool
+_mesa_sse41_plan_swizzle_convert(struct sse_swizzle_convert_plan *plan,
+                                 enum mesa_array_format_datatype dst_type,
+                                 int num_dst_channels,
+                                 enum mesa_array_format_datatype src_type,
+                                 int num_src_channels,
+                                 const uint8_t swizzle[4], bool normalized)
+{
+   memset(plan, 0, sizeof(*plan));
+
+   /* The scalar code reads garbage for these, don't bother */
+   for (int i = 0; i < num_dst_channels; i++) {
+      if (swizzle[i] <= MESA_FORMAT_SWIZZLE_W &&
+          swizzle[i] >= num_src_channels)
+         return false;
+   }
+
+   if (src_type == dst_type) {
+      int size = _mesa_array_format_datatype_get_size(src_type);
+
+      plan->op = SSE_SWIZZLE_CONVERT_SHUFFLE;
+      plan->src_bpp = num_src_channels * size;
+      plan->dst_bpp = num_dst_channels * size;
+      plan->pixels = 16 / MAX2(plan->src_bpp, plan->dst_bpp);
+      plan_shuffle(plan, plan->pixels, size, num_src_channels,
+                   num_dst_channels, swizzle, swizzle_one(dst_type, normalized));
+
+      /* The bytes past the last whole pixel belong to the next one.  Write
+       * back what was loaded so that in-place conversions keep working.
+       */
+      if (plan->src_bpp == plan->dst_bpp) {
+         for (int i = plan->pixels * plan->dst_bpp; i < 16; i++)
+            plan->shuffle[i] = i;
+      }
+      return true;
+   }
+
+   if (dst_type == MESA_ARRAY_FORMAT_TYPE_FLOAT && num_dst_channels == 4 &&
+       (src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE ||
+        src_type == MESA_ARRAY_FORMAT_TYPE_USHORT)) {
+      int size = _mesa_array_format_datatype_get_size(src_type);
+      const uint32_t one = 0x3f800000;
+
+      plan->op = size == 1 ? SSE_SWIZZLE_CONVERT_UBYTE_TO_FLOAT :
+                             SSE_SWIZZLE_CONVERT_USHORT_TO_FLOAT;
+      plan->src_bpp = num_src_channels * size;
+      plan->dst_bpp = 16;
+      plan->pixels = 4 / size;
+      plan->scale = !normalized ? 1.0f :
+                    size == 1 ? 1.0f / (float)UINT8_MAX :
+                                1.0f / (float)UINT16_MAX;
+      plan_shuffle(plan, plan->pixels, size, num_src_channels, 4, swizzle, 0);
+
+      /* Ones are or'ed in after the conversion, one pixel at a time */
+      for (int i = 0; i < 4; i++) {
+         if (swizzle[i] == MESA_FORMAT_SWIZZLE_ONE)
+            memcpy(&plan->fill[i * 4], &one, sizeof(one));
+      }
+      return true;
+   }
+
+   if (src_type == MESA_ARRAY_FORMAT_TYPE_FLOAT && num_src_channels == 4 &&
+       normalized &&
+       (dst_type == MESA_ARRAY_FORMAT_TYPE_UBYTE ||
+        dst_type == MESA_ARRAY_FORMAT_TYPE_USHORT)) {
+      int size = _mesa_array_format_datatype_get_size(dst_type);
+
+      plan->op = size == 1 ? SSE_SWIZZLE_CONVERT_FLOAT_TO_UNORM8 :
+                             SSE_SWIZZLE_CONVERT_FLOAT_TO_UNORM16;
+      plan->src_bpp = 16;
+      plan->dst_bpp = num_dst_channels * size;
+      plan->pixels = 4 / size;
+      plan->scale = size == 1 ? UINT8_MAX : UINT16_MAX;
+      plan_shuffle(plan, plan->pixels, size, 4, num_dst_channels, swizzle,
+                   swizzle_one(dst_type, normalized));
+      return true;
+   }
+
+   return false;
+}
+
+/**
+ * Same as _mesa_float_to_unorm.  max() goes first so that NaN becomes 0.
+ */
+static inline __m128i
+float_to_unorm(__m128 f, __m128 scale)
+{
+   f = _mm_min_ps(_mm_max_ps(f, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+   return _mm_cvtps_epi32(_mm_mul_ps(f, scale));
+}
+
+/**
+ * Runs \p plan on the first pixels of the row.
+ *
+ * \return  the number of pixels converted, the rest are left to the caller
+ */
+int
+_mesa_sse41_swizzle_convert(void *void_dst, const void *void_src,
+                            const struct sse_swizzle_convert_plan *plan,
+                            int count)
+{
+   uint8_t *dst = void_dst;
+   const uint8_t *src = void_src;
+   const __m128i shuffle = _mm_loadu_si128((const __m128i *)plan->shuffle);
+   const __m128i fill = _mm_loadu_si128((const __m128i *)plan->fill);
+   const __m128 scale = _mm_set1_ps(plan->scale);
+   const int src_bpp = plan->src_bpp;
+   const int dst_bpp = plan->dst_bpp;
+   int x = 0, last;
+
+   /* 16 bytes are loaded and stored at a time, stop before that reaches
+    * past the end of the row.
+    */
+   last = count - DIV_ROUND_UP(16, MIN2(src_bpp, dst_bpp));
+
+   switch (plan->op) {
+   case SSE_SWIZZLE_CONVERT_SHUFFLE:
+      for (; x <= last; x += plan->pixels) {
+         __m128i v = _mm_loadu_si128((const __m128i *)(src + x * src_bpp));
+         v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), fill);
+         _mm_storeu_si128((__m128i *)(dst + x * dst_bpp), v);
+      }
+      break;
+
+   case SSE_SWIZZLE_CONVERT_UBYTE_TO_FLOAT:
+      for (; x <= last; x += 4) {
+         __m128i v = _mm_loadu_si128((const __m128i *)(src + x * src_bpp));
+         float *d = (float *)(dst + x * 16);
+
+         v = _mm_shuffle_epi8(v, shuffle);
+         for (int p = 0; p < 4; p++) {
+            __m128 f = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(v));
+            f = _mm_or_ps(_mm_mul_ps(f, scale), _mm_castsi128_ps(fill));
+            _mm_storeu_ps(d + p * 4, f);
+            v = _mm_srli_si128(v, 4);
+         }
+      }
+      break;
+
+   case SSE_SWIZZLE_CONVERT_USHORT_TO_FLOAT:
+      for (; x <= last; x += 2) {
+         __m128i v = _mm_loadu_si128((const __m128i *)(src + x * src_bpp));
+         float *d = (float *)(dst + x * 16);
+
+         v = _mm_shuffle_epi8(v, shuffle);
+         for (int p = 0; p < 2; p++) {
+            __m128 f = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(v));
+            f = _mm_or_ps(_mm_mul_ps(f, scale), _mm_castsi128_ps(fill));
+            _mm_storeu_ps(d + p * 4, f);
+            v = _mm_srli_si128(v, 8);
+         }
+      }
+      break;
+
+   case SSE_SWIZZLE_CONVERT_FLOAT_TO_UNORM8:
+      for (; x <= last; x += 4) {
+         const float *s = (const float *)(src + x * 16);
+         __m128i i0 = float_to_unorm(_mm_loadu_ps(s + 0), scale);
+         __m128i i1 = float_to_unorm(_mm_loadu_ps(s + 4), scale);
+         __m128i i2 = float_to_unorm(_mm_loadu_ps(s + 8), scale);
+         __m128i i3 = float_to_unorm(_mm_loadu_ps(s + 12), scale);
+         __m128i v = _mm_packus_epi16(_mm_packs_epi32(i0, i1),
+                                      _mm_packs_epi32(i2, i3));
+
+         v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), fill);
+         _mm_storeu_si128((__m128i *)(dst + x * dst_bpp), v);
+      }
+      break;
+
+   case SSE_SWIZZLE_CONVERT_FLOAT_TO_UNORM16:
+      for (; x <= last; x += 2) {
+         const float *s = (const float *)(src + x * 16);
+         __m128i i0 = float_to_unorm(_mm_loadu_ps(s + 0), scale);
+         __m128i i1 = float_to_unorm(_mm_loadu_ps(s + 4), scale);
+         __m128i v = _mm_packus_epi32(i0, i1);
+
+         v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), fill);
+         _mm_storeu_si128((__m128i *)(dst + x * dst_bpp), v);
+      }
+      break;
+
+   default:
+      break;
+   }
+
+   return x;
+}
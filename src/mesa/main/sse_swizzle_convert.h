@@ -0,0 +1,53 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SSE_SWIZZLE_CONVERT_H
+#define SSE_SWIZZLE_CONVERT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "main/formats.h"
+
+enum sse_swizzle_convert_op {
+   SSE_SWIZZLE_CONVERT_NONE = 0,
+   /* Same type on both sides, only bytes move */
+   SSE_SWIZZLE_CONVERT_SHUFFLE,
+   SSE_SWIZZLE_CONVERT_UBYTE_TO_FLOAT,
+   SSE_SWIZZLE_CONVERT_USHORT_TO_FLOAT,
+   SSE_SWIZZLE_CONVERT_FLOAT_TO_UNORM8,
+   SSE_SWIZZLE_CONVERT_FLOAT_TO_UNORM16,
+};
+
+/**
+ * A swizzle-and-convert operation compiled down to one of the kernels in
+ * sse_swizzle_convert.c.
+ *
+ * The plan only depends on the formats and the swizzle, so callers
+ * converting a whole image make it once and run it for every row.
+ */
+struct sse_swizzle_convert_plan {
+   enum sse_swizzle_convert_op op;
+   uint8_t src_bpp;   /**< source bytes per pixel */
+   uint8_t dst_bpp;   /**< destination bytes per pixel */
+   uint8_t pixels;    /**< pixels handled per iteration */
+   float scale;       /**< unorm to float scale factor */
+   uint8_t shuffle[16];
+   uint8_t fill[16];  /**< or'ed in for MESA_FORMAT_SWIZZLE_ONE */
+};
+
+bool
+_mesa_sse41_plan_swizzle_convert(struct sse_swizzle_convert_plan *plan,
+                                 enum mesa_array_format_datatype dst_type,
+                                 int num_dst_channels,
+                                 enum mesa_array_format_datatype src_type,
+                                 int num_src_channels,
+                                 const uint8_t swizzle[4], bool normalized);
+
+int
+_mesa_sse41_swizzle_convert(void *dst, const void *src,
+                            const struct sse_swizzle_convert_plan *plan,
+                            int count);
+
+#endif /* SSE_SWIZZLE_CONVERT_H */
@@ -207,6 +207,7 @@
 #include <util/fast_urem_by_const.h>
 #include <util/format/format_utils.h>
 #include <util/format/u_format.h>
+#include <util/format/u_format_astc.h>
 #include <util/format/u_format_bptc.h>
 #include <util/format/u_format_etc.h>
 #include <util/format/u_format_fxt1.h>
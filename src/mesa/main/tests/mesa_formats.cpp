@@ -35,6 +35,7 @@
 #include "main/glformats.h"
 #include "main/format_unpack.h"
 #include "main/format_pack.h"
+#include "main/format_utils.h"
 
 // Test fixture for Format tests.
 class MesaFormatsTest : public ::testing::Test {
@@ -283,3 +284,65 @@ TEST_F(MesaFormatsTest, PackUbyteRGBARounding)
       EXPECT_EQ(result, (i * 31 + 127) / 255);
    }
 }
+
+/* Rows are long enough for the SIMD paths and leave a tail for the scalar
+ * code.
+ */
+TEST_F(MesaFormatsTest, SwizzleAndConvertUbyteFloat)
+{
+   const uint8_t bgr1[4] = {2, 1, 0, MESA_FORMAT_SWIZZLE_ONE};
+   const uint8_t bgra[4] = {2, 1, 0, 3};
+   uint8_t val[37 * 4], result[37 * 4];
+   float tmp[37 * 4];
+
+   for (int i = 0; i < 37 * 4; i++)
+      val[i] = i * 7;
+
+   _mesa_swizzle_and_convert(tmp, MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                             val, MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                             bgr1, true, 37);
+   for (int i = 0; i < 37; i++) {
+      EXPECT_EQ(tmp[i * 4 + 0], _mesa_unorm_to_float(val[i * 4 + 2], 8));
+      EXPECT_EQ(tmp[i * 4 + 1], _mesa_unorm_to_float(val[i * 4 + 1], 8));
+      EXPECT_EQ(tmp[i * 4 + 2], _mesa_unorm_to_float(val[i * 4 + 0], 8));
+      EXPECT_EQ(tmp[i * 4 + 3], 1.0f);
+   }
+
+   _mesa_swizzle_and_convert(result, MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                             tmp, MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                             bgra, true, 37);
+   for (int i = 0; i < 37; i++) {
+      EXPECT_EQ(result[i * 4 + 0], val[i * 4 + 0]);
+      EXPECT_EQ(result[i * 4 + 1], val[i * 4 + 1]);
+      EXPECT_EQ(result[i * 4 + 2], val[i * 4 + 2]);
+      EXPECT_EQ(result[i * 4 + 3], 0xff);
+   }
+}
+
+TEST_F(MesaFormatsTest, SwizzleAndConvertFloatToUnorm)
+{
+   const uint8_t rgba[4] = {0, 1, 2, 3};
+   const float special[] = {-1.0f, -0.0f, 2.0f, NAN, 0.5f, 1.0f / 255.0f};
+   float val[23 * 4];
+   uint8_t result8[23 * 4];
+   uint16_t result16[23 * 4];
+
+   for (int i = 0; i < 23 * 4; i++)
+      val[i] = i < 6 ? special[i] : i / (23.0f * 4.0f);
+
+   _mesa_swizzle_and_convert(result8, MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                             val, MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                             rgba, true, 23);
+   _mesa_swizzle_and_convert(result16, MESA_ARRAY_FORMAT_TYPE_USHORT, 4,
+                             val, MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                             rgba, true, 23);
+   for (int i = 0; i < 23 * 4; i++) {
+      if (isnan(val[i])) {
+         EXPECT_EQ(result8[i], 0);
+         EXPECT_EQ(result16[i], 0);
+      } else {
+         EXPECT_EQ(result8[i], _mesa_float_to_unorm(val[i], 8));
+         EXPECT_EQ(result16[i], _mesa_float_to_unorm(val[i], 16));
+      }
+   }
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \name minmax_index.cpp
+ *
+ * Check the SIMD index min/max kernels against a scalar reference, and the
+ * per-block min/max cache of index buffers.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "main/mtypes.h"
+#include "main/sse_minmax.h"
+#include "util/u_cpu_detect.h"
+#include "vbo/vbo.h"
+
+typedef void (*minmax_func)(const void *indices, unsigned index_size,
+                            unsigned count, bool restart,
+                            unsigned restart_index,
+                            unsigned *min_index, unsigned *max_index);
+
+static unsigned
+get_index(const void *indices, unsigned index_size, unsigned i)
+{
+   switch (index_size) {
+   case 4: return ((const uint32_t *)indices)[i];
+   case 2: return ((const uint16_t *)indices)[i];
+   default: return ((const uint8_t *)indices)[i];
+   }
+}
+
+static void
+set_index(void *indices, unsigned index_size, unsigned i, unsigned value)
+{
+   switch (index_size) {
+   case 4: ((uint32_t *)indices)[i] = value; break;
+   case 2: ((uint16_t *)indices)[i] = value; break;
+   default: ((uint8_t *)indices)[i] = value; break;
+   }
+}
+
+static void
+reference_min_max(const void *indices, unsigned index_size, unsigned count,
+                  bool restart, unsigned restart_index,
+                  unsigned *min_index, unsigned *max_index)
+{
+   unsigned min = ~0u, max = 0;
+
+   for (unsigned i = 0; i < count; i++) {
+      unsigned index = get_index(indices, index_size, i);
+
+      if (restart && index == restart_index)
+         continue;
+      min = MIN2(min, index);
+      max = MAX2(max, index);
+   }
+   *min_index = min;
+   *max_index = max;
+}
+
+class minmax_index : public ::testing::TestWithParam<unsigned> {
+protected:
+   void SetUp() override;
+   void TearDown() override;
+
+   void fill(unsigned count, unsigned seed, unsigned restart_every);
+   void check(minmax_func func, const char *name);
+
+   unsigned index_size;
+   unsigned restart_index;
+   /* One extra index so that unaligned starts can be tested */
+   uint8_t *storage;
+};
+
+void
+minmax_index::SetUp()
+{
+   index_size = GetParam();
+   restart_index = index_size == 4 ? 0xffffffff :
+                   index_size == 2 ? 0xffff : 0xff;
+   storage = (uint8_t *)calloc(4096 + 1, index_size);
+}
+
+void
+minmax_index::TearDown()
+{
+   free(storage);
+}
+
+void
+minmax_index::fill(unsigned count, unsigned seed, unsigned restart_every)
+{
+   srand(seed);
+   for (unsigned i = 0; i < count; i++) {
+      unsigned value = (unsigned)rand();
+
+      if (index_size < 4)
+         value &= restart_index;
+      if (restart_every && i % restart_every == 0)
+         value = restart_index;
+      set_index(storage, index_size, i, value);
+   }
+}
+
+void
+minmax_index::check(minmax_func func, const char *name)
+{
+   static const unsigned counts[] = {
+      0, 1, 2, 3, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 1000, 4095,
+   };
+
+   for (unsigned restart_every = 0; restart_every < 5; restart_every++) {
+      fill(4096 + 1, restart_every + index_size, restart_every);
+
+      for (unsigned start = 0; start < 2; start++) {
+         const void *indices = storage + start * index_size;
+
+         for (unsigned c = 0; c < ARRAY_SIZE(counts); c++) {
+            for (unsigned restart = 0; restart < 2; restart++) {
+               unsigned min, max, ref_min, ref_max;
+
+               func(indices, index_size, counts[c], restart, restart_index,
+                    &min, &max);
+               reference_min_max(indices, index_size, counts[c], restart,
+                                 restart_index, &ref_min, &ref_max);
+               EXPECT_EQ(ref_min, min)
+                  << name << " count " << counts[c] << " start " << start
+                  << " restart " << restart << " every " << restart_every;
+               EXPECT_EQ(ref_max, max)
+                  << name << " count " << counts[c] << " start " << start
+                  << " restart " << restart << " every " << restart_every;
+            }
+         }
+      }
+   }
+
+   /* Only restart indices: nothing is drawn. */
+   memset(storage, 0xff, 4096 * index_size);
+   for (unsigned c = 0; c < ARRAY_SIZE(counts); c++) {
+      unsigned min, max;
+
+      func(storage, index_size, counts[c], true, restart_index, &min, &max);
+      EXPECT_EQ(~0u, min) << name << " all restart, count " << counts[c];
+      EXPECT_EQ(0u, max) << name << " all restart, count " << counts[c];
+   }
+}
+
+static void
+mapped_min_max(const void *indices, unsigned index_size, unsigned count,
+               bool restart, unsigned restart_index,
+               unsigned *min_index, unsigned *max_index)
+{
+   vbo_get_minmax_index_mapped(count, index_size, restart_index, restart,
+                               indices, min_index, max_index);
+}
+
+TEST_P(minmax_index, mapped)
+{
+   check(mapped_min_max, "vbo_get_minmax_index_mapped");
+}
+
+TEST_P(minmax_index, sse41)
+{
+#if defined(USE_SSE41)
+   if (!util_get_cpu_caps()->has_sse4_1)
+      GTEST_SKIP() << "SSE4.1 not supported";
+   check(_mesa_index_array_min_max_sse41, "sse41");
+#else
+   GTEST_SKIP() << "built without SSE4.1";
+#endif
+}
+
+TEST_P(minmax_index, avx2)
+{
+#if defined(USE_SSE41)
+   if (!util_get_cpu_caps()->has_avx2)
+      GTEST_SKIP() << "AVX2 not supported";
+   check(_mesa_index_array_min_max_avx2, "avx2");
+#else
+   GTEST_SKIP() << "built without AVX2";
+#endif
+}
+
+TEST_P(minmax_index, blocks)
+{
+   struct gl_buffer_object obj;
+   unsigned min, max, ref_min, ref_max;
+
+   memset(&obj, 0, sizeof(obj));
+   simple_mtx_init(&obj.MinMaxCacheMutex, mtx_plain);
+   obj.Size = 4096 * index_size;
+   fill(4096, index_size, 7);
+
+   /* Less than one whole block can't use the cache. */
+   EXPECT_FALSE(vbo_get_minmax_blocks(&obj, storage + 10 * index_size,
+                                      index_size, 10 * index_size, 1000,
+                                      true, restart_index, &min, &max));
+
+   /* Partial blocks at both ends, the whole blocks 1 and 2 are unknown. */
+   ASSERT_TRUE(vbo_get_minmax_blocks(&obj, storage + 1000 * index_size,
+                                     index_size, 1000 * index_size, 2500,
+                                     true, restart_index, &min, &max));
+   reference_min_max(storage + 1000 * index_size, index_size, 2500, true,
+                     restart_index, &ref_min, &ref_max);
+   EXPECT_EQ(ref_min, min);
+   EXPECT_EQ(ref_max, max);
+   EXPECT_EQ(0u, obj.MinMaxCacheHitIndices);
+
+   /* Block 1 is known now, block 0 is scanned and recorded. */
+   ASSERT_TRUE(vbo_get_minmax_blocks(&obj, storage, index_size, 0, 2100,
+                                     true, restart_index, &min, &max));
+   reference_min_max(storage, index_size, 2100, true, restart_index,
+                     &ref_min, &ref_max);
+   EXPECT_EQ(ref_min, min);
+   EXPECT_EQ(ref_max, max);
+   EXPECT_EQ(1024u, obj.MinMaxCacheHitIndices);
+
+   /* All of blocks 0-2 are known. */
+   ASSERT_TRUE(vbo_get_minmax_blocks(&obj, storage, index_size, 0, 3072,
+                                     true, restart_index, &min, &max));
+   reference_min_max(storage, index_size, 3072, true, restart_index,
+                     &ref_min, &ref_max);
+   EXPECT_EQ(ref_min, min);
+   EXPECT_EQ(ref_max, max);
+   EXPECT_EQ(1024u + 3072u, obj.MinMaxCacheHitIndices);
+
+   /* A different restart state drops the summaries. */
+   ASSERT_TRUE(vbo_get_minmax_blocks(&obj, storage, index_size, 0, 3072,
+                                     false, 0, &min, &max));
+   reference_min_max(storage, index_size, 3072, false, 0,
+                     &ref_min, &ref_max);
+   EXPECT_EQ(ref_min, min);
+   EXPECT_EQ(ref_max, max);
+   EXPECT_EQ(1024u + 3072u, obj.MinMaxCacheHitIndices);
+
+   /* So does a write to the buffer. */
+   obj.MinMaxCacheDirty = true;
+   EXPECT_FALSE(vbo_get_minmax_blocks(&obj, storage, index_size, 0, 3072,
+                                      false, 0, &min, &max));
+   EXPECT_EQ(NULL, obj.MinMaxBlocks);
+
+   vbo_delete_minmax_cache(&obj);
+   simple_mtx_destroy(&obj.MinMaxCacheMutex);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+   minmax,
+   minmax_index,
+   ::testing::Values(1, 2, 4)
+);
@@ -26,22 +26,31 @@
 
 #include <inttypes.h>
 #include "texcompress.h"
+#include "formats.h"
+#include "util/format/u_format.h"
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-void
+/**
+ * Decode ASTC 2D LDR texture data.  The decoder lives in
+ * util/format/u_format_astc.cpp.
+ *
+ * \param src_width in pixels
+ * \param src_height in pixels
+ * \param dst_stride in bytes
+ */
+static inline void
 _mesa_unpack_astc_2d_ldr(uint8_t *dst_row,
                          unsigned dst_stride,
                          const uint8_t *src_row,
                          unsigned src_stride,
                          unsigned src_width,
                          unsigned src_height,
-                         mesa_format format);
+                         mesa_format format)
+{
+   assert(_mesa_is_format_astc_2d(format));
 
-#ifdef __cplusplus
+   util_format_unpack_rgba_8unorm_rect(format, dst_row, dst_stride,
+                                       src_row, src_stride,
+                                       src_width, src_height);
 }
-#endif
 
 #endif
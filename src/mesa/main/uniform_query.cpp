@@ -1091,6 +1091,7 @@ _mesa_ensure_and_associate_uniform_storage(struct gl_context *ctx,
     * program constant) has to happen before creating this linkage.
     */
    associate_uniform_storage(ctx, shader_program, prog);
+   _mesa_parameter_values_changed(prog->Parameters);
 }
 
 
@@ -1280,6 +1281,24 @@ _mesa_flush_vertices_for_uniforms(struct gl_context *ctx,
    ctx->NewDriverState |= new_driver_state;
 }
 
+/**
+ * Give the parameter lists of all stages using \p uni a new ValuesSerial
+ * after the uniform's values have been written to them.
+ */
+static void
+mark_parameter_values_changed(struct gl_shader_program *shProg,
+                              const struct gl_uniform_storage *uni)
+{
+   unsigned mask = uni->active_shader_mask;
+
+   while (mask) {
+      struct gl_linked_shader *sh = shProg->_LinkedShaders[u_bit_scan(&mask)];
+
+      if (sh && sh->Program->Parameters)
+         _mesa_parameter_values_changed(sh->Program->Parameters);
+   }
+}
+
 static bool
 copy_uniforms_to_storage(gl_constant_value *storage,
                          struct gl_uniform_storage *uni,
@@ -1518,6 +1537,9 @@ _mesa_uniform(GLint location, GLsizei count, const GLvoid *values,
    if (!ctx_flushed && !(glsl_type_is_sampler(uni->type) && uni->is_bindless))
       return; /* no change in uniform values */
 
+   if (ctx_flushed)
+      mark_parameter_values_changed(shProg, uni);
+
    /* If the uniform is a sampler, do the extra magic necessary to propagate
     * the changes through.
     */
@@ -1954,13 +1976,18 @@ _mesa_uniform_matrix(GLint location, GLsizei count,
                                             basicType, !flushed))
             flushed = true;
       }
+
+      if (flushed)
+         mark_parameter_values_changed(shProg, uni);
    } else {
       storage =  &uni->storage[size_mul * elements * offset];
       if (copy_uniform_matrix_to_storage(ctx, storage, uni, count, values,
                                          size_mul, offset, components, vectors,
                                          transpose, cols, rows, basicType,
-                                         true))
+                                         true)) {
          _mesa_propagate_uniforms_to_driver_storage(uni, offset, count);
+         mark_parameter_values_changed(shProg, uni);
+      }
    }
 }
 
@@ -2109,6 +2136,8 @@ _mesa_uniform_handle(GLint location, GLsizei count, const GLvoid *values,
       _mesa_propagate_uniforms_to_driver_storage(uni, offset, count);
    }
 
+   mark_parameter_values_changed(shProg, uni);
+
    if (glsl_type_is_sampler(uni->type)) {
       /* Mark this bindless sampler as not bound to a texture unit because
        * it refers to a texture handle.
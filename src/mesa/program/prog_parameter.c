@@ -31,6 +31,7 @@
 #include "util/glheader.h"
 #include "main/macros.h"
 #include "main/errors.h"
+#include "util/u_atomic.h"
 #include "util/u_memory.h"
 #include "prog_instruction.h"
 #include "prog_parameter.h"
@@ -143,6 +144,7 @@ _mesa_new_parameter_list(void)
    list->UniformBytes = 0;
    list->FirstStateVarIndex = INT_MAX;
    list->LastStateVarIndex = 0;
+   _mesa_parameter_values_changed(list);
    return list;
 }
 
@@ -251,6 +253,18 @@ _mesa_disallow_parameter_storage_realloc(struct gl_program_parameter_list *param
 }
 
 
+/**
+ * Give the list a new ValuesSerial after its values have been modified.
+ */
+void
+_mesa_parameter_values_changed(struct gl_program_parameter_list *paramList)
+{
+   static uint64_t serial;
+
+   paramList->ValuesSerial = p_atomic_inc_return(&serial);
+}
+
+
 /**
  * Add a new parameter to a parameter list.
  * Note that parameter values are usually 4-element GLfloat vectors.
@@ -299,6 +313,7 @@ _mesa_add_parameter(struct gl_program_parameter_list *paramList,
    paramList->NumParameters = oldNum + 1;
 
    paramList->NumParameterValues = oldValNum + padded_size;
+   _mesa_parameter_values_changed(paramList);
 
    memset(&paramList->Parameters[oldNum], 0,
           sizeof(struct gl_program_parameter));
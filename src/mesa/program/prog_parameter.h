@@ -140,6 +140,17 @@ struct gl_program_parameter_list
                                might invalidate ParameterValues[] */
    bool DisallowRealloc;
 
+   /**
+    * Changes whenever a parameter is added or a uniform value is written to
+    * ParameterValues[], see _mesa_parameter_values_changed().  Serials are
+    * unique across all lists, so drivers can compare them to a value saved
+    * at upload time to skip uploading the same values again.
+    *
+    * State vars and subroutine uniforms are loaded into ParameterValues[] at
+    * draw time and aren't tracked.
+    */
+   uint64_t ValuesSerial;
+
    /* Parameters are optionally sorted as follows. Uniforms and constants
     * are first, then state vars. This should be true in all cases except
     * ir_to_mesa, which adds constants at the end, and ARB_vp with ARL,
@@ -168,6 +179,9 @@ _mesa_reserve_parameter_storage(struct gl_program_parameter_list *paramList,
 extern void
 _mesa_disallow_parameter_storage_realloc(struct gl_program_parameter_list *paramList);
 
+extern void
+_mesa_parameter_values_changed(struct gl_program_parameter_list *paramList);
+
 extern GLint
 _mesa_add_parameter(struct gl_program_parameter_list *paramList,
                     gl_register_file type, const char *name,
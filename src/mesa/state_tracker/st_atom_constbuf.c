@@ -62,6 +62,36 @@ st_unbind_unused_cb0(struct st_context *st, enum pipe_shader_type shader_type)
    }
 }
 
+/**
+ * Whether uploads of the program's parameters can be reused while
+ * ValuesSerial doesn't change.  Parameters which are written at draw time,
+ * i.e. state vars, ATI constants, subroutine indices and the handles of
+ * bindless samplers/images bound to units, aren't covered by ValuesSerial,
+ * so programs with any of these are always uploaded.
+ */
+static bool
+cb0_upload_is_cacheable(const struct gl_program *prog)
+{
+   if (prog->Parameters->StateFlags || prog->ati_fs)
+      return false;
+
+   if (prog->shader_program &&
+       (prog->sh.NumSubroutineUniformRemapTable ||
+        prog->sh.HasBoundBindlessSampler ||
+        prog->sh.HasBoundBindlessImage))
+      return false;
+
+   return true;
+}
+
+static struct cb0_upload_cache_entry *
+cb0_upload_cache_entry(struct st_context *st,
+                       const struct gl_program_parameter_list *params)
+{
+   return &st->cb0_upload_cache[params->ValuesSerial %
+                                NUM_CB0_UPLOAD_CACHE_ENTRIES];
+}
+
 /**
  * Pass the given program parameters to the graphics pipe as a
  * constant buffer.
@@ -125,26 +155,48 @@ st_upload_constants(struct st_context *st, struct gl_program *prog, gl_shader_st
 
          const unsigned alignment = MAX2(
             st->ctx->Const.UniformBufferOffsetAlignment, 64);
-
-         /* fetch_state always stores 4 components (16 bytes) per matrix row,
-          * but matrix rows are sometimes allocated partially, so add 12
-          * to compensate for the fetch_state defect.
-          */
-         u_upload_alloc(pipe->const_uploader, 0, paramBytes + 12,
-            alignment, &cb.buffer_offset, &cb.buffer, (void**)&ptr);
-
          int uniform_bytes = params->UniformBytes;
-         if (uniform_bytes)
-            memcpy(ptr, params->ParameterValues, uniform_bytes);
 
-         /* Upload the constants which come from fixed-function state, such as
-          * transformation matrices, fog factors, etc.
-          */
-         if (params->StateFlags)
-            _mesa_upload_state_parameters(st->ctx, params, ptr);
+         const bool cacheable = cb0_upload_is_cacheable(prog);
+         struct cb0_upload_cache_entry *cached =
+            cb0_upload_cache_entry(st, params);
+
+         if (cacheable && cached->buffer &&
+             cached->serial == params->ValuesSerial) {
+            /* Nothing was written since the last upload, bind it again.
+             * This is what happens when switching between programs without
+             * changing their uniforms.
+             */
+            cb.buffer = cached->buffer;
+            cb.buffer_offset = cached->offset;
+            pipe->set_constant_buffer(pipe, shader_type, 0, false, &cb);
+         } else {
+            /* fetch_state always stores 4 components (16 bytes) per matrix
+             * row, but matrix rows are sometimes allocated partially, so add
+             * 12 to compensate for the fetch_state defect.
+             */
+            u_upload_alloc(pipe->const_uploader, 0, paramBytes + 12,
+               alignment, &cb.buffer_offset, &cb.buffer, (void**)&ptr);
+
+            if (uniform_bytes)
+               memcpy(ptr, params->ParameterValues, uniform_bytes);
+
+            /* Upload the constants which come from fixed-function state, such
+             * as transformation matrices, fog factors, etc.
+             */
+            if (params->StateFlags)
+               _mesa_upload_state_parameters(st->ctx, params, ptr);
+
+            u_upload_unmap(pipe->const_uploader);
+
+            if (cacheable) {
+               pipe_resource_reference(&cached->buffer, cb.buffer);
+               cached->offset = cb.buffer_offset;
+               cached->serial = params->ValuesSerial;
+            }
 
-         u_upload_unmap(pipe->const_uploader);
-         pipe->set_constant_buffer(pipe, shader_type, 0, true, &cb);
+            pipe->set_constant_buffer(pipe, shader_type, 0, true, &cb);
+         }
 
          /* Set inlinable constants. This is more involved because state
           * parameters are uploaded directly above instead of being loaded
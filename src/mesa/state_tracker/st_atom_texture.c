@@ -289,6 +289,10 @@ update_textures(struct st_context *st,
    unsigned num_unbind = old_num_textures > num_textures ?
                             old_num_textures - num_textures : 0;
 
+   /* Nothing was bound and nothing is used, e.g. the stage has no samplers */
+   if (!num_textures && !num_unbind)
+      return;
+
    pipe->set_sampler_views(pipe, shader_stage, 0, num_textures, num_unbind,
                            true, sampler_views);
    st->state.num_sampler_views[shader_stage] = num_textures;
@@ -92,6 +92,54 @@ needs_integer_signed_unsigned_conversion(const struct gl_context *ctx,
    return false;
 }
 
+/**
+ * Let the driver copy the pixels straight into the PBO, converting them on
+ * the way.  Drivers that defer rendering can queue the copy behind it
+ * instead of waiting for it here.
+ */
+static bool
+try_copy_readpixels(struct st_context *st, struct gl_renderbuffer *rb,
+                    bool invert_y,
+                    GLint x, GLint y, GLsizei width, GLsizei height,
+                    GLenum format, GLenum type,
+                    enum pipe_format src_format, enum pipe_format dst_format,
+                    const struct gl_pixelstore_attrib *pack, void *pixels)
+{
+   struct pipe_context *pipe = st->pipe;
+   struct pipe_surface *surface = rb->surface;
+   struct pipe_box box;
+
+   if (!surface || rb->texture->nr_samples > 1 ||
+       !pack->BufferObj->buffer)
+      return false;
+
+   intptr_t offset = (intptr_t)_mesa_image_address2d(pack, pixels,
+                                                     width, height, format,
+                                                     type, 0, 0);
+   int stride = _mesa_image_row_stride(pack, width, format, type);
+
+   if (offset < 0)
+      return false;
+
+   /* The bottom row of the window comes last in memory */
+   if (invert_y) {
+      offset += (intptr_t)(height - 1) * stride;
+      stride = -stride;
+      y = rb->Height - y - height;
+   }
+
+   u_box_2d_zslice(x, y, surface->u.tex.first_layer, width, height, &box);
+
+   if (!pipe->copy_texture_to_buffer(pipe, pack->BufferObj->buffer,
+                                     dst_format, offset, stride,
+                                     rb->texture, src_format,
+                                     surface->u.tex.level, &box))
+      return false;
+
+   pack->BufferObj->MinMaxCacheDirty = true;
+   return true;
+}
+
 static bool
 try_pbo_readpixels(struct st_context *st, struct gl_renderbuffer *rb,
                    bool invert_y,
@@ -438,7 +486,8 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
    if (rb->TexImage && st->force_compute_based_texture_transfer)
       goto fallback;
 
-   if (!st->prefer_blit_based_texture_transfer) {
+   if (!st->prefer_blit_based_texture_transfer &&
+       !(pack->BufferObj && pipe->copy_texture_to_buffer)) {
       goto fallback;
    }
 
@@ -488,6 +537,19 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
       goto fallback;
    }
 
+   if (pack->BufferObj && pipe->copy_texture_to_buffer &&
+       !needs_integer_signed_unsigned_conversion(ctx, format, type)) {
+      if (try_copy_readpixels(st, rb,
+                              _mesa_fb_orientation(ctx->ReadBuffer) == Y_0_TOP,
+                              x, y, width, height, format, type,
+                              src_format, dst_format, pack, pixels))
+         return;
+   }
+
+   if (!st->prefer_blit_based_texture_transfer) {
+      goto fallback;
+   }
+
    if (st->pbo.download_enabled && pack->BufferObj) {
       if (try_pbo_readpixels(st, rb,
                              _mesa_fb_orientation(ctx->ReadBuffer) == Y_0_TOP,
@@ -73,6 +73,7 @@
 #include "pipe/p_defines.h"
 #include "util/log.h"
 #include "util/u_inlines.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_upload_mgr.h"
 #include "pipe/p_shader_tokens.h"
 #include "util/u_tile.h"
@@ -670,6 +671,205 @@ upload_astc_slice_with_flushed_void_extents(uint8_t *dst,
    }
 }
 
+/**
+ * Decompress rows of blocks of a fallback compressed format into
+ * \p dst_format, which is either RGBA8 or one of its variants.
+ */
+static void
+decompress_rows(uint8_t *dst, unsigned dst_stride,
+                const uint8_t *src, unsigned src_stride,
+                unsigned width, unsigned height,
+                mesa_format src_format, enum pipe_format dst_format)
+{
+   if (src_format == MESA_FORMAT_ETC1_RGB8) {
+      _mesa_etc1_unpack_rgba8888(dst, dst_stride, src, src_stride,
+                                 width, height);
+   } else if (_mesa_is_format_etc2(src_format)) {
+      bool bgra = dst_format == PIPE_FORMAT_B8G8R8A8_SRGB;
+
+      _mesa_unpack_etc2_format(dst, dst_stride, src, src_stride,
+                               width, height, src_format, bgra);
+   } else if (_mesa_is_format_astc_2d(src_format)) {
+      _mesa_unpack_astc_2d_ldr(dst, dst_stride, src, src_stride,
+                               width, height, src_format);
+   } else if (_mesa_is_format_s3tc(src_format)) {
+      _mesa_unpack_s3tc(dst, dst_stride, src, src_stride,
+                        width, height, src_format);
+   } else if (_mesa_is_format_rgtc(src_format) ||
+              _mesa_is_format_latc(src_format)) {
+      _mesa_unpack_rgtc(dst, dst_stride, src, src_stride,
+                        width, height, src_format);
+   } else if (_mesa_is_format_bptc(src_format)) {
+      _mesa_unpack_bptc(dst, dst_stride, src, src_stride,
+                        width, height, src_format);
+   } else {
+      unreachable("unexpected format for a compressed format fallback");
+   }
+}
+
+struct transcode_job {
+   struct gl_context *ctx;
+   uint8_t *dst;
+   unsigned dst_stride;
+   const uint8_t *src;
+   unsigned src_stride;
+   unsigned width, height;
+   mesa_format src_format;
+   enum pipe_format dst_format;
+   bool ok;
+   struct util_queue_fence fence;
+};
+
+/**
+ * Set up \p job for the strip of \p rows rows at \p y of \p image.
+ */
+static void
+init_transcode_strip(struct transcode_job *job,
+                     const struct transcode_job *image,
+                     unsigned y, unsigned rows)
+{
+   unsigned src_bw, src_bh;
+   _mesa_get_format_block_size(image->src_format, &src_bw, &src_bh);
+   unsigned dst_bh = util_format_get_blockheight(image->dst_format);
+
+   *job = *image;
+   job->dst += y / dst_bh * image->dst_stride;
+   job->src += y / src_bh * image->src_stride;
+   job->height = MIN2(rows, image->height - y);
+}
+
+static void
+transcode_rows(void *data, void *gdata, int thread_index)
+{
+   struct transcode_job *job = data;
+
+   if (!util_format_is_compressed(job->dst_format)) {
+      decompress_rows(job->dst, job->dst_stride, job->src, job->src_stride,
+                      job->width, job->height,
+                      job->src_format, job->dst_format);
+      job->ok = true;
+      return;
+   }
+
+   /* Transcode into a different compressed format through RGBA8. */
+   unsigned stride = job->width * 4;
+   void *tmp = malloc(stride * job->height);
+   if (!tmp) {
+      job->ok = false;
+      return;
+   }
+
+   decompress_rows(tmp, stride, job->src, job->src_stride,
+                   job->width, job->height,
+                   job->src_format, PIPE_FORMAT_R8G8B8A8_UNORM);
+
+   /* Compress it to the target format. */
+   struct gl_pixelstore_attrib pack = {0};
+   pack.Alignment = 4;
+
+   job->ok = _mesa_texstore(job->ctx, 2, GL_RGBA, job->dst_format,
+                            job->dst_stride, &job->dst,
+                            job->width, job->height, 1, GL_RGBA,
+                            GL_UNSIGNED_BYTE, tmp, &pack);
+   free(tmp);
+}
+
+/* Texels per job, small enough for the RGBA8 temporary to stay in cache. */
+#define TRANSCODE_JOB_TEXELS (64 * 1024)
+
+/**
+ * Decompress or transcode an image of a fallback compressed format.  Large
+ * images are split into strips of block rows that are processed on the
+ * transcode queue.  Returns false if a strip couldn't be transcoded for
+ * lack of memory, even when retried after the others.
+ */
+bool
+st_transcode_image(struct gl_context *ctx,
+                   uint8_t *dst, unsigned dst_stride,
+                   const uint8_t *src, unsigned src_stride,
+                   unsigned width, unsigned height,
+                   mesa_format src_format, enum pipe_format dst_format)
+{
+   struct st_context *st = st_context(ctx);
+   const struct transcode_job image = {
+      .ctx = ctx,
+      .dst = dst,
+      .dst_stride = dst_stride,
+      .src = src,
+      .src_stride = src_stride,
+      .width = width,
+      .height = height,
+      .src_format = src_format,
+      .dst_format = dst_format,
+   };
+   unsigned src_bw, src_bh;
+   _mesa_get_format_block_size(src_format, &src_bw, &src_bh);
+   unsigned dst_bh = util_format_get_blockheight(dst_format);
+
+   /* Strips have to start on a block row in both formats. */
+   unsigned strip_align = src_bh;
+   while (strip_align % dst_bh)
+      strip_align += src_bh;
+
+   unsigned rows = DIV_ROUND_UP(TRANSCODE_JOB_TEXELS, width);
+   rows = DIV_ROUND_UP(rows, strip_align) * strip_align;
+   unsigned num_jobs = DIV_ROUND_UP(height, rows);
+
+   if (num_jobs > 1 && !util_queue_is_initialized(&st->transcode_queue)) {
+      unsigned num_threads = util_get_cpu_caps()->nr_cpus;
+
+      if (num_threads > 1) {
+         util_queue_init(&st->transcode_queue, "st_transcode", 32,
+                         num_threads, UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL);
+      }
+   }
+
+   struct transcode_job *jobs = NULL;
+   if (num_jobs > 1 && util_queue_is_initialized(&st->transcode_queue))
+      jobs = calloc(num_jobs, sizeof(*jobs));
+
+   if (!jobs) {
+      /* One strip at a time, so the temporary stays small. */
+      for (unsigned i = 0; i < num_jobs; i++) {
+         struct transcode_job job;
+
+         init_transcode_strip(&job, &image, i * rows, rows);
+         transcode_rows(&job, NULL, 0);
+         if (!job.ok)
+            return false;
+      }
+      return true;
+   }
+
+   for (unsigned i = 0; i < num_jobs; i++) {
+      struct transcode_job *job = &jobs[i];
+
+      init_transcode_strip(job, &image, i * rows, rows);
+      util_queue_fence_init(&job->fence);
+      util_queue_add_job(&st->transcode_queue, job, &job->fence,
+                         transcode_rows, NULL, 0);
+   }
+
+   for (unsigned i = 0; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+
+   /* Retry the strips that ran out of memory, now that the temporaries of
+    * the others are freed.
+    */
+   bool ok = true;
+   for (unsigned i = 0; i < num_jobs && ok; i++) {
+      if (!jobs[i].ok) {
+         transcode_rows(&jobs[i], NULL, 0);
+         ok = jobs[i].ok;
+      }
+   }
+
+   free(jobs);
+   return ok;
+}
+
 void
 st_UnmapTextureImage(struct gl_context *ctx,
                      struct gl_texture_image *texImage,
@@ -750,97 +950,19 @@ st_UnmapTextureImage(struct gl_context *ctx,
                                                         transfer->box.width,
                                                         transfer->box.height,
                                                         texImage->pt->format);
-         } else if (util_format_is_compressed(texImage->pt->format)) {
-            /* Transcode into a different compressed format. */
-            unsigned size =
-               _mesa_format_image_size(PIPE_FORMAT_R8G8B8A8_UNORM,
-                                       transfer->box.width,
-                                       transfer->box.height, 1);
-            void *tmp = malloc(size);
-
-            /* Decompress to tmp. */
-            if (texImage->TexFormat == MESA_FORMAT_ETC1_RGB8) {
-               _mesa_etc1_unpack_rgba8888(tmp, transfer->box.width * 4,
-                                          itransfer->temp_data,
-                                          itransfer->temp_stride,
-                                          transfer->box.width,
-                                          transfer->box.height);
-            } else if (_mesa_is_format_etc2(texImage->TexFormat)) {
-               bool bgra = texImage->pt->format == PIPE_FORMAT_B8G8R8A8_SRGB;
-
-               _mesa_unpack_etc2_format(tmp, transfer->box.width * 4,
-                                        itransfer->temp_data,
-                                        itransfer->temp_stride,
-                                        transfer->box.width,
-                                        transfer->box.height,
-                                        texImage->TexFormat,
-                                        bgra);
-            } else if (_mesa_is_format_astc_2d(texImage->TexFormat)) {
-               _mesa_unpack_astc_2d_ldr(tmp, transfer->box.width * 4,
-                                        itransfer->temp_data,
-                                        itransfer->temp_stride,
-                                        transfer->box.width,
-                                        transfer->box.height,
-                                        texImage->TexFormat);
-            } else {
-               unreachable("unexpected format for a compressed format fallback");
-            }
-
-            /* Compress it to the target format. */
-            struct gl_pixelstore_attrib pack = {0};
-            pack.Alignment = 4;
-
-            _mesa_texstore(ctx, 2, GL_RGBA, texImage->pt->format,
-                           transfer->stride, &map,
-                           transfer->box.width,
-                           transfer->box.height, 1, GL_RGBA,
-                           GL_UNSIGNED_BYTE, tmp, &pack);
-            free(tmp);
          } else {
-            /* Decompress into an uncompressed format. */
-            if (texImage->TexFormat == MESA_FORMAT_ETC1_RGB8) {
-               _mesa_etc1_unpack_rgba8888(map, transfer->stride,
-                                          itransfer->temp_data,
-                                          itransfer->temp_stride,
-                                          transfer->box.width,
-                                          transfer->box.height);
-            } else if (_mesa_is_format_etc2(texImage->TexFormat)) {
-               bool bgra = texImage->pt->format == PIPE_FORMAT_B8G8R8A8_SRGB;
-
-               _mesa_unpack_etc2_format(map, transfer->stride,
-                                        itransfer->temp_data,
-                                        itransfer->temp_stride,
-                                        transfer->box.width, transfer->box.height,
-                                        texImage->TexFormat,
-                                        bgra);
-            } else if (_mesa_is_format_astc_2d(texImage->TexFormat)) {
-               _mesa_unpack_astc_2d_ldr(map, transfer->stride,
-                                        itransfer->temp_data,
-                                        itransfer->temp_stride,
-                                        transfer->box.width, transfer->box.height,
-                                        texImage->TexFormat);
-            } else if (_mesa_is_format_s3tc(texImage->TexFormat)) {
-               _mesa_unpack_s3tc(map, transfer->stride,
-                                 itransfer->temp_data,
-                                 itransfer->temp_stride,
-                                 transfer->box.width, transfer->box.height,
-                                 texImage->TexFormat);
-            } else if (_mesa_is_format_rgtc(texImage->TexFormat) ||
-                       _mesa_is_format_latc(texImage->TexFormat)) {
-               _mesa_unpack_rgtc(map, transfer->stride,
-                                 itransfer->temp_data,
-                                 itransfer->temp_stride,
-                                 transfer->box.width, transfer->box.height,
-                                 texImage->TexFormat);
-            } else if (_mesa_is_format_bptc(texImage->TexFormat)) {
-               _mesa_unpack_bptc(map, transfer->stride,
-                                 itransfer->temp_data,
-                                 itransfer->temp_stride,
-                                 transfer->box.width, transfer->box.height,
-                                 texImage->TexFormat);
-            } else {
-               unreachable("unexpected format for a compressed format fallback");
-            }
+            /* Decompress, and transcode into a different compressed format
+             * if the driver has one.
+             */
+            if (!st_transcode_image(ctx, map, transfer->stride,
+                                    itransfer->temp_data,
+                                    itransfer->temp_stride,
+                                    transfer->box.width,
+                                    transfer->box.height,
+                                    texImage->TexFormat,
+                                    texImage->pt->format))
+               _mesa_error(ctx, GL_OUT_OF_MEMORY,
+                           "compressed fallback transcode");
          }
 
          st_texture_image_unmap(st, texImage, slice);
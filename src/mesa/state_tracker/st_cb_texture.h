@@ -130,4 +130,10 @@ void st_TexturePageCommitment(struct gl_context *ctx,
                               struct gl_texture_object *tex_obj,
                               int level, int xoffset, int yoffset, int zoffset,
                               int width, int height, int depth, bool commit);
+
+bool st_transcode_image(struct gl_context *ctx,
+                        uint8_t *dst, unsigned dst_stride,
+                        const uint8_t *src, unsigned src_stride,
+                        unsigned width, unsigned height,
+                        mesa_format src_format, enum pipe_format dst_format);
 #endif /* ST_CB_TEXTURE_H */
@@ -66,6 +66,7 @@
 #include "util/u_vbuf.h"
 #include "util/u_memory.h"
 #include "util/hash_table.h"
+#include "util/os_time.h"
 #include "util/thread_sched.h"
 #include "cso_cache/cso_context.h"
 #include "compiler/glsl/glsl_parser_extras.h"
@@ -344,6 +345,9 @@ st_destroy_context_priv(struct st_context *st, bool destroy_pipe)
    if (_mesa_has_compute_shaders(st->ctx) && st->transcode_astc)
       st_destroy_texcompress_compute(st);
 
+   if (util_queue_is_initialized(&st->transcode_queue))
+      util_queue_destroy(&st->transcode_queue);
+
    st_destroy_bound_texture_handles(st);
    st_destroy_bound_image_handles(st);
 
@@ -799,6 +803,48 @@ st_set_background_context(struct gl_context *ctx,
    fscreen->set_background_context(st, queue_info);
 }
 
+/**
+ * Start recording the time spent in each state update function into
+ * \p mon, which is usually owned by the HUD.  NULL stops it.
+ */
+void
+st_context_set_validate_monitoring(struct st_context *st,
+                                   struct st_validate_monitoring *mon)
+{
+   static const char *const names[] = {
+#define ST_STATE(FLAG, st_update) #st_update,
+#include "st_atom_list.h"
+#undef ST_STATE
+   };
+
+   STATIC_ASSERT(ARRAY_SIZE(names) <= ST_VALIDATE_MAX_ATOMS);
+
+   if (mon) {
+      mon->num_atoms = ARRAY_SIZE(names);
+      memcpy(mon->atom_names, names, sizeof(names));
+   }
+   st->validate_monitoring = mon;
+}
+
+/**
+ * st_validate_state() with timing, used when the HUD shows it.
+ */
+void
+st_validate_state_monitored(struct st_context *st, uint64_t dirty)
+{
+   struct st_validate_monitoring *mon = st->validate_monitoring;
+
+   while (dirty) {
+      unsigned i = u_bit_scan64(&dirty);
+      int64_t start = os_time_get_nano();
+
+      st->update_functions[i](st);
+
+      mon->time_ns[i] += os_time_get_nano() - start;
+      mon->num_calls[i]++;
+   }
+}
+
 static void
 st_init_driver_functions(struct pipe_screen *screen,
                          struct dd_function_table *functions,
@@ -969,6 +1015,9 @@ st_destroy_context(struct st_context *st)
    pipe_sampler_view_reference(&st->pixel_xfer.pixelmap_sampler_view, NULL);
    pipe_resource_reference(&st->pixel_xfer.pixelmap_texture, NULL);
 
+   for (unsigned i = 0; i < NUM_CB0_UPLOAD_CACHE_ENTRIES; i++)
+      pipe_resource_reference(&st->cb0_upload_cache[i].buffer, NULL);
+
    _vbo_DestroyContext(ctx);
 
    st_destroy_program_variants(st);
@@ -100,6 +100,17 @@ struct drawpix_cache_entry
 };
 
 
+#define NUM_CB0_UPLOAD_CACHE_ENTRIES 16
+
+/** An upload of gl_program_parameter_list values into constant buffer 0 */
+struct cb0_upload_cache_entry
+{
+   uint64_t serial;           /**< ValuesSerial of the uploaded list */
+   struct pipe_resource *buffer;
+   unsigned offset;
+};
+
+
 /*
  * Node for a linked list of dead sampler views.
  */
@@ -132,6 +143,9 @@ struct st_context
    /* The list of state update functions. */
    st_update_func_t update_functions[ST_NUM_ATOMS];
 
+   /* Per-atom timing for the HUD, NULL when not monitored. */
+   struct st_validate_monitoring *validate_monitoring;
+
    struct pipe_frontend_screen *frontend_screen; /* e.g. dri_screen */
    void *frontend_context; /* e.g. dri_context */
 
@@ -302,6 +316,14 @@ struct st_context
       unsigned age;
    } drawpix_cache;
 
+   /**
+    * Recent uploads of program parameters into constant buffer 0, indexed
+    * by ValuesSerial modulo NUM_CB0_UPLOAD_CACHE_ENTRIES.  Serials are
+    * unique, so a matching entry holds exactly the current values.  This is
+    * per context because programs are shared between contexts.
+    */
+   struct cb0_upload_cache_entry cb0_upload_cache[NUM_CB0_UPLOAD_CACHE_ENTRIES];
+
    /** for glReadPixels */
    struct {
       struct pipe_resource *src;
@@ -352,6 +374,12 @@ struct st_context
       struct hash_table *astc_partition_tables;
    } texcompress_compute;
 
+   /**
+    * Worker threads decompressing and transcoding the compressed formats
+    * the driver doesn't support on upload.  Created on first use.
+    */
+   struct util_queue transcode_queue;
+
    /** for drawing with st_util_vertex */
    struct cso_velems_state util_velems;
 
@@ -491,6 +519,13 @@ void st_invalidate_state(struct gl_context *ctx);
 void st_set_background_context(struct gl_context *ctx,
                                struct util_queue_monitoring *queue_info);
 
+void
+st_context_set_validate_monitoring(struct st_context *st,
+                                   struct st_validate_monitoring *mon);
+
+void
+st_validate_state_monitored(struct st_context *st, uint64_t dirty);
+
 void
 st_api_query_versions(struct pipe_frontend_screen *fscreen,
                       struct st_config_options *options,
@@ -118,6 +118,11 @@ st_validate_state(struct st_context *st, uint64_t pipeline_state_mask)
    if (dirty) {
       ctx->NewDriverState &= ~dirty;
 
+      if (unlikely(st->validate_monitoring)) {
+         st_validate_state_monitored(st, dirty);
+         return;
+      }
+
       /* Execute functions that set states that have been changed since
        * the last draw.
        *
@@ -0,0 +1,242 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Checks that st_upload_constants() binds the previous upload of a
+ * program's parameters again when switching back to it without changing
+ * its uniforms, and uploads again once they change.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main/mtypes.h"
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "program/prog_parameter.h"
+#include "state_tracker/st_atom_constbuf.h"
+#include "state_tracker/st_context.h"
+#include "util/u_inlines.h"
+#include "util/u_upload_mgr.h"
+
+struct test_buffer {
+   struct pipe_resource base;
+   uint8_t *data;
+};
+
+static struct pipe_constant_buffer bound_cb[PIPE_SHADER_TYPES];
+static unsigned num_resources;
+
+static int
+get_param(struct pipe_screen *screen, enum pipe_cap param)
+{
+   return param == PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT;
+}
+
+static struct pipe_resource *
+resource_create(struct pipe_screen *screen,
+                const struct pipe_resource *templ)
+{
+   struct test_buffer *buf = calloc(1, sizeof(*buf));
+
+   buf->base = *templ;
+   buf->base.screen = screen;
+   pipe_reference_init(&buf->base.reference, 1);
+   buf->data = calloc(1, templ->width0);
+   num_resources++;
+   return &buf->base;
+}
+
+static void
+resource_destroy(struct pipe_screen *screen, struct pipe_resource *res)
+{
+   struct test_buffer *buf = (struct test_buffer *)res;
+
+   free(buf->data);
+   free(buf);
+   num_resources--;
+}
+
+static void *
+buffer_map(struct pipe_context *pipe, struct pipe_resource *res,
+           unsigned level, unsigned usage, const struct pipe_box *box,
+           struct pipe_transfer **transfer)
+{
+   struct pipe_transfer *xfer = calloc(1, sizeof(*xfer));
+
+   pipe_resource_reference(&xfer->resource, res);
+   xfer->box = *box;
+   *transfer = xfer;
+   return ((struct test_buffer *)res)->data + box->x;
+}
+
+static void
+buffer_unmap(struct pipe_context *pipe, struct pipe_transfer *transfer)
+{
+   pipe_resource_reference(&transfer->resource, NULL);
+   free(transfer);
+}
+
+static void
+set_constant_buffer(struct pipe_context *pipe, enum pipe_shader_type shader,
+                    uint index, bool take_ownership,
+                    const struct pipe_constant_buffer *cb)
+{
+   pipe_resource_reference(&bound_cb[shader].buffer, NULL);
+   if (!cb) {
+      memset(&bound_cb[shader], 0, sizeof(bound_cb[shader]));
+      return;
+   }
+
+   bound_cb[shader] = *cb;
+   bound_cb[shader].buffer = NULL;
+   if (take_ownership)
+      bound_cb[shader].buffer = cb->buffer;
+   else
+      pipe_resource_reference(&bound_cb[shader].buffer, cb->buffer);
+}
+
+static struct gl_program *
+create_program(float value)
+{
+   struct gl_program *prog = calloc(1, sizeof(*prog));
+   gl_constant_value values[4];
+
+   for (unsigned i = 0; i < 4; i++)
+      values[i].f = value;
+
+   prog->info.stage = MESA_SHADER_FRAGMENT;
+   prog->Parameters = _mesa_new_parameter_list();
+   _mesa_add_parameter(prog->Parameters, PROGRAM_UNIFORM, "u", 4,
+                       GL_FLOAT_VEC4, values, NULL, true);
+   return prog;
+}
+
+static void
+destroy_program(struct gl_program *prog)
+{
+   _mesa_free_parameter_list(prog->Parameters);
+   free(prog);
+}
+
+static bool
+check_bound(const char *what, float value,
+            const struct pipe_constant_buffer *expected)
+{
+   const struct pipe_constant_buffer *cb = &bound_cb[PIPE_SHADER_FRAGMENT];
+   const float *data;
+
+   if (!cb->buffer) {
+      fprintf(stderr, "%s: no constant buffer bound\n", what);
+      return false;
+   }
+
+   if (expected && (cb->buffer != expected->buffer ||
+                    cb->buffer_offset != expected->buffer_offset)) {
+      fprintf(stderr, "%s: expected the previous upload to be bound\n", what);
+      return false;
+   }
+
+   data = (const float *)(((struct test_buffer *)cb->buffer)->data +
+                          cb->buffer_offset);
+   for (unsigned i = 0; i < 4; i++) {
+      if (data[i] != value) {
+         fprintf(stderr, "%s: got %f, expected %f\n", what, data[i], value);
+         return false;
+      }
+   }
+
+   return true;
+}
+
+int
+main(int argc, char **argv)
+{
+   struct pipe_screen screen = {
+      .get_param = get_param,
+      .resource_create = resource_create,
+      .resource_destroy = resource_destroy,
+   };
+   struct pipe_context pctx = {
+      .screen = &screen,
+      .buffer_map = buffer_map,
+      .buffer_unmap = buffer_unmap,
+      .set_constant_buffer = set_constant_buffer,
+   };
+   struct gl_pipeline_object pipeline = { 0 };
+   struct gl_context *ctx = calloc(1, sizeof(*ctx));
+   struct st_context *st = calloc(1, sizeof(*st));
+   struct pipe_constant_buffer first_a, first_b;
+   bool success = true;
+
+   pctx.const_uploader = u_upload_create_default(&pctx);
+   ctx->_Shader = &pipeline;
+   ctx->Const.UniformBufferOffsetAlignment = 16;
+   st->ctx = ctx;
+   st->pipe = &pctx;
+   st->prefer_real_buffer_in_constbuf0 = true;
+
+   struct gl_program *a = create_program(1.0f);
+   struct gl_program *b = create_program(2.0f);
+
+   st_upload_constants(st, a, MESA_SHADER_FRAGMENT);
+   success &= check_bound("first draw with A", 1.0f, NULL);
+   first_a = bound_cb[PIPE_SHADER_FRAGMENT];
+
+   st_upload_constants(st, b, MESA_SHADER_FRAGMENT);
+   success &= check_bound("first draw with B", 2.0f, NULL);
+   first_b = bound_cb[PIPE_SHADER_FRAGMENT];
+
+   /* Switching back and forth reuses the uploads. */
+   st_upload_constants(st, a, MESA_SHADER_FRAGMENT);
+   success &= check_bound("second draw with A", 1.0f, &first_a);
+   st_upload_constants(st, b, MESA_SHADER_FRAGMENT);
+   success &= check_bound("second draw with B", 2.0f, &first_b);
+
+   /* A uniform write makes it upload again, without touching B's upload. */
+   a->Parameters->ParameterValues[0].f = 3.0f;
+   a->Parameters->ParameterValues[1].f = 3.0f;
+   a->Parameters->ParameterValues[2].f = 3.0f;
+   a->Parameters->ParameterValues[3].f = 3.0f;
+   _mesa_parameter_values_changed(a->Parameters);
+   st_upload_constants(st, a, MESA_SHADER_FRAGMENT);
+   success &= check_bound("draw with A after a uniform write", 3.0f, NULL);
+   if (bound_cb[PIPE_SHADER_FRAGMENT].buffer == first_a.buffer &&
+       bound_cb[PIPE_SHADER_FRAGMENT].buffer_offset == first_a.buffer_offset) {
+      fprintf(stderr, "A wasn't uploaded again after a uniform write\n");
+      success = false;
+   }
+   st_upload_constants(st, b, MESA_SHADER_FRAGMENT);
+   success &= check_bound("third draw with B", 2.0f, &first_b);
+
+   /* Programs with state vars are always uploaded. */
+   a->Parameters->StateFlags = 1;
+   st_upload_constants(st, a, MESA_SHADER_FRAGMENT);
+   struct pipe_constant_buffer state_a = bound_cb[PIPE_SHADER_FRAGMENT];
+   st_upload_constants(st, a, MESA_SHADER_FRAGMENT);
+   if (bound_cb[PIPE_SHADER_FRAGMENT].buffer_offset == state_a.buffer_offset) {
+      fprintf(stderr, "a program with state vars wasn't uploaded again\n");
+      success = false;
+   }
+   a->Parameters->StateFlags = 0;
+
+   set_constant_buffer(&pctx, PIPE_SHADER_FRAGMENT, 0, false, NULL);
+   for (unsigned i = 0; i < NUM_CB0_UPLOAD_CACHE_ENTRIES; i++)
+      pipe_resource_reference(&st->cb0_upload_cache[i].buffer, NULL);
+   u_upload_destroy(pctx.const_uploader);
+   if (num_resources) {
+      fprintf(stderr, "%u buffers leaked\n", num_resources);
+      success = false;
+   }
+
+   destroy_program(a);
+   destroy_program(b);
+   free(st);
+   free(ctx);
+
+   return success ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Checks that st_transcode_image() produces the same image when it splits
+ * a compressed fallback image into strips on the transcode queue as
+ * decoding it in one go, both when decompressing and when transcoding to
+ * another compressed format.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main/mtypes.h"
+#include "main/texcompress_etc.h"
+#include "main/texstore.h"
+#include "state_tracker/st_cb_texture.h"
+#include "state_tracker/st_context.h"
+#include "util/format/u_format.h"
+#include "util/u_queue.h"
+
+/* Not a multiple of the block size, and enough rows for uneven strips. */
+#define WIDTH 300
+#define HEIGHT 702
+
+static bool
+check_image(const char *what, const uint8_t *got, const uint8_t *expected,
+            unsigned stride, unsigned rows)
+{
+   for (unsigned y = 0; y < rows; y++) {
+      if (memcmp(got + y * stride, expected + y * stride, stride)) {
+         fprintf(stderr, "%s: row %u differs\n", what, y);
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static bool
+test_decompress(struct gl_context *ctx, const uint8_t *src,
+                unsigned src_stride)
+{
+   const unsigned stride = WIDTH * 4;
+   uint8_t *expected = calloc(HEIGHT, stride);
+   uint8_t *got = calloc(HEIGHT, stride);
+   bool success = true;
+
+   _mesa_unpack_etc2_format(expected, stride, src, src_stride,
+                            WIDTH, HEIGHT, MESA_FORMAT_ETC2_RGBA8_EAC, false);
+
+   if (!st_transcode_image(ctx, got, stride, src, src_stride, WIDTH, HEIGHT,
+                           MESA_FORMAT_ETC2_RGBA8_EAC,
+                           PIPE_FORMAT_R8G8B8A8_UNORM)) {
+      fprintf(stderr, "decompress: failed\n");
+      success = false;
+   } else {
+      success = check_image("decompress", got, expected, stride, HEIGHT);
+   }
+
+   free(expected);
+   free(got);
+   return success;
+}
+
+static bool
+test_transcode(struct gl_context *ctx, const uint8_t *src,
+               unsigned src_stride)
+{
+   const enum pipe_format format = PIPE_FORMAT_DXT5_RGBA;
+   const unsigned rgba_stride = WIDTH * 4;
+   const unsigned stride = util_format_get_stride(format, WIDTH);
+   const unsigned rows = util_format_get_nblocksy(format, HEIGHT);
+   uint8_t *rgba = calloc(HEIGHT, rgba_stride);
+   uint8_t *expected = calloc(rows, stride);
+   uint8_t *got = calloc(rows, stride);
+   struct gl_pixelstore_attrib pack = { .Alignment = 4 };
+   bool success = true;
+
+   _mesa_unpack_etc2_format(rgba, rgba_stride, src, src_stride,
+                            WIDTH, HEIGHT, MESA_FORMAT_ETC2_RGBA8_EAC, false);
+   _mesa_texstore(ctx, 2, GL_RGBA, (mesa_format)format, stride, &expected,
+                  WIDTH, HEIGHT, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba, &pack);
+
+   if (!st_transcode_image(ctx, got, stride, src, src_stride, WIDTH, HEIGHT,
+                           MESA_FORMAT_ETC2_RGBA8_EAC, format)) {
+      fprintf(stderr, "transcode: failed\n");
+      success = false;
+   } else {
+      success = check_image("transcode", got, expected, stride, rows);
+   }
+
+   free(rgba);
+   free(expected);
+   free(got);
+   return success;
+}
+
+int
+main(int argc, char **argv)
+{
+   struct gl_context *ctx = calloc(1, sizeof(*ctx));
+   struct st_context *st = calloc(1, sizeof(*st));
+   const unsigned src_stride = DIV_ROUND_UP(WIDTH, 4) * 16;
+   const unsigned src_size = DIV_ROUND_UP(HEIGHT, 4) * src_stride;
+   uint8_t *src = malloc(src_size);
+   bool success = true;
+
+   ctx->st = st;
+   st->ctx = ctx;
+
+   /* Any block is valid ETC2, so random ones cover all of its modes. */
+   srand(42);
+   for (unsigned i = 0; i < src_size; i++)
+      src[i] = rand();
+
+   /* Use the strips even on a single CPU. */
+   util_queue_init(&st->transcode_queue, "st_transcode", 32, 4,
+                   UTIL_QUEUE_INIT_RESIZE_IF_FULL, NULL);
+
+   success &= test_decompress(ctx, src, src_stride);
+   success &= test_transcode(ctx, src, src_stride);
+
+   util_queue_destroy(&st->transcode_queue);
+   free(src);
+   free(st);
+   free(ctx);
+
+   return success ? 0 : 1;
+}
@@ -176,6 +176,7 @@ struct vbo_save_context {
    GLboolean dangling_attr_ref;
    GLboolean out_of_memory;  /**< True if last VBO allocation failed */
    bool no_current_update;
+   bool attr_folded;  /**< See vbo_save_fold_attr() */
 };
 
 GLboolean
@@ -211,6 +212,10 @@ vbo_exec_FlushVertices(struct gl_context *ctx, GLuint flags);
 void
 vbo_save_SaveFlushVertices(struct gl_context *ctx);
 
+bool
+vbo_save_fold_attr(struct gl_context *ctx, GLuint attr, GLuint size,
+                   GLenum type, const uint32_t *v);
+
 void
 vbo_save_NotifyBegin(struct gl_context *ctx, GLenum mode,
                      bool no_current_update);
@@ -230,6 +235,13 @@ vbo_get_minmax_index_mapped(unsigned count, unsigned index_size,
                             const void *indices,
                             unsigned *min_index, unsigned *max_index);
 
+bool
+vbo_get_minmax_blocks(struct gl_buffer_object *bufferObj,
+                      const void *indices, unsigned index_size,
+                      GLintptr offset, GLuint count,
+                      bool restart, unsigned restart_index,
+                      GLuint *min_index, GLuint *max_index);
+
 void
 vbo_get_minmax_index(struct gl_context *ctx, struct gl_buffer_object *obj,
                      const void *ptr, GLintptr offset, unsigned count,
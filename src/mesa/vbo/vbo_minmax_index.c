@@ -50,6 +50,28 @@ struct minmax_cache_entry {
 };
 
 
+/* Number of indices summarized by one vbo_minmax_blocks entry */
+#define MINMAX_BLOCK_SIZE 1024
+
+/**
+ * Min/max of every MINMAX_BLOCK_SIZE indices of a buffer, filled in as
+ * draws scan them.  Draws of any range that covers whole blocks then only
+ * have to scan the partial blocks at both ends, whether or not the same
+ * range was drawn before.
+ */
+struct vbo_minmax_blocks {
+   unsigned index_size;
+   bool restart;
+   unsigned restart_index;
+   unsigned num_blocks;
+   struct {
+      GLuint min;
+      GLuint max;
+      bool valid;
+   } blocks[];
+};
+
+
 static uint32_t
 vbo_minmax_cache_hash(const struct minmax_cache_key *key)
 {
@@ -98,6 +120,8 @@ vbo_delete_minmax_cache(struct gl_buffer_object *bufferObj)
 {
    _mesa_hash_table_destroy(bufferObj->MinMaxCache, vbo_minmax_cache_delete_entry);
    bufferObj->MinMaxCache = NULL;
+   free(bufferObj->MinMaxBlocks);
+   bufferObj->MinMaxBlocks = NULL;
 }
 
 
@@ -135,6 +159,8 @@ vbo_get_minmax_cached(struct gl_buffer_object *bufferObj,
       }
 
       _mesa_hash_table_clear(bufferObj->MinMaxCache, vbo_minmax_cache_delete_entry);
+      free(bufferObj->MinMaxBlocks);
+      bufferObj->MinMaxBlocks = NULL;
       bufferObj->MinMaxCacheDirty = false;
       goto out_invalidate;
    }
@@ -234,6 +260,19 @@ vbo_get_minmax_index_mapped(unsigned count, unsigned index_size,
                             const void *indices,
                             unsigned *min_index, unsigned *max_index)
 {
+#if defined(USE_SSE41)
+   if (util_get_cpu_caps()->has_avx2) {
+      _mesa_index_array_min_max_avx2(indices, index_size, count, restart,
+                                     restartIndex, min_index, max_index);
+      return;
+   }
+   if (util_get_cpu_caps()->has_sse4_1) {
+      _mesa_index_array_min_max_sse41(indices, index_size, count, restart,
+                                      restartIndex, min_index, max_index);
+      return;
+   }
+#endif
+
    switch (index_size) {
    case 4: {
       const GLuint *ui_indices = (const GLuint *)indices;
@@ -248,16 +287,10 @@ vbo_get_minmax_index_mapped(unsigned count, unsigned index_size,
          }
       }
       else {
-#if defined(USE_SSE41)
-         if (util_get_cpu_caps()->has_sse4_1) {
-            _mesa_uint_array_min_max(ui_indices, &min_ui, &max_ui, count);
+         for (unsigned i = 0; i < count; i++) {
+            if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
+            if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
          }
-         else
-#endif
-            for (unsigned i = 0; i < count; i++) {
-               if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
-               if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
-            }
       }
       *min_index = min_ui;
       *max_index = max_ui;
@@ -313,6 +346,121 @@ vbo_get_minmax_index_mapped(unsigned count, unsigned index_size,
 }
 
 
+/**
+ * Compute min and max of the \p count indices at \p offset, which are
+ * mapped at \p indices, from the block summaries of the buffer.  The
+ * whole blocks that aren't known yet are scanned and recorded.
+ *
+ * \return false if the range doesn't cover a whole block
+ */
+bool
+vbo_get_minmax_blocks(struct gl_buffer_object *bufferObj,
+                      const void *indices, unsigned index_size,
+                      GLintptr offset, GLuint count,
+                      bool restart, unsigned restart_index,
+                      GLuint *min_index, GLuint *max_index)
+{
+   const char *ptr = indices;
+   const unsigned first = offset / index_size;
+   const unsigned end = first + count;
+   const unsigned first_block = DIV_ROUND_UP(first, MINMAX_BLOCK_SIZE);
+   const unsigned end_block = end / MINMAX_BLOCK_SIZE;
+   struct vbo_minmax_blocks *cache;
+   unsigned hit_count = 0;
+   GLuint min, max, tmp_min, tmp_max;
+
+   if (!vbo_use_minmax_cache(bufferObj) || offset % index_size ||
+       offset + (GLsizeiptr)count * index_size > bufferObj->Size ||
+       first_block >= end_block)
+      return false;
+
+   if (!restart)
+      restart_index = 0;
+
+   simple_mtx_lock(&bufferObj->MinMaxCacheMutex);
+
+   /* vbo_get_minmax_cached() handles this once the hash table exists */
+   if (bufferObj->MinMaxCacheDirty) {
+      free(bufferObj->MinMaxBlocks);
+      bufferObj->MinMaxBlocks = NULL;
+      simple_mtx_unlock(&bufferObj->MinMaxCacheMutex);
+      return false;
+   }
+
+   cache = bufferObj->MinMaxBlocks;
+   if (cache && (cache->index_size != index_size ||
+                 cache->restart != restart ||
+                 cache->restart_index != restart_index)) {
+      free(cache);
+      cache = bufferObj->MinMaxBlocks = NULL;
+   }
+
+   if (!cache) {
+      unsigned num_blocks = bufferObj->Size / index_size / MINMAX_BLOCK_SIZE;
+
+      cache = calloc(1, sizeof(*cache) + num_blocks * sizeof(cache->blocks[0]));
+      if (!cache) {
+         simple_mtx_unlock(&bufferObj->MinMaxCacheMutex);
+         return false;
+      }
+      cache->index_size = index_size;
+      cache->restart = restart;
+      cache->restart_index = restart_index;
+      cache->num_blocks = num_blocks;
+      bufferObj->MinMaxBlocks = cache;
+   }
+
+   assert(end_block <= cache->num_blocks);
+
+   /* The partial blocks at both ends */
+   vbo_get_minmax_index_mapped(first_block * MINMAX_BLOCK_SIZE - first,
+                               index_size, restart_index, restart, ptr,
+                               &min, &max);
+   vbo_get_minmax_index_mapped(end - end_block * MINMAX_BLOCK_SIZE,
+                               index_size, restart_index, restart,
+                               ptr + (end_block * MINMAX_BLOCK_SIZE - first) *
+                                     index_size,
+                               &tmp_min, &tmp_max);
+   min = MIN2(min, tmp_min);
+   max = MAX2(max, tmp_max);
+
+   for (unsigned i = first_block; i < end_block; i++) {
+      if (cache->blocks[i].valid) {
+         hit_count += MINMAX_BLOCK_SIZE;
+      } else {
+         vbo_get_minmax_index_mapped(MINMAX_BLOCK_SIZE, index_size,
+                                     restart_index, restart,
+                                     ptr + (i * MINMAX_BLOCK_SIZE - first) *
+                                           index_size,
+                                     &cache->blocks[i].min,
+                                     &cache->blocks[i].max);
+         cache->blocks[i].valid = true;
+      }
+      min = MIN2(min, cache->blocks[i].min);
+      max = MAX2(max, cache->blocks[i].max);
+   }
+
+   /* vbo_get_minmax_cached() already counted the whole range as a miss
+    * if the hash table exists.  Move the blocks we didn't scan over to the
+    * hits, saturating like vbo_get_minmax_cached() does.
+    */
+   if (bufferObj->MinMaxCache)
+      bufferObj->MinMaxCacheMissIndices -=
+         MIN2(hit_count, bufferObj->MinMaxCacheMissIndices);
+   if (bufferObj->MinMaxCacheHitIndices + hit_count >=
+       bufferObj->MinMaxCacheHitIndices)
+      bufferObj->MinMaxCacheHitIndices += hit_count;
+   else
+      bufferObj->MinMaxCacheHitIndices = ~(unsigned)0;
+
+   simple_mtx_unlock(&bufferObj->MinMaxCacheMutex);
+
+   *min_index = min;
+   *max_index = max;
+   return true;
+}
+
+
 /**
  * Compute min and max elements by scanning the index buffer for
  * glDraw[Range]Elements() calls.
@@ -341,9 +489,14 @@ vbo_get_minmax_index(struct gl_context *ctx, struct gl_buffer_object *obj,
                                           obj, MAP_INTERNAL);
    }
 
-   vbo_get_minmax_index_mapped(count, index_size, restart_index,
-                               primitive_restart, indices,
-                               min_index, max_index);
+   if (!obj ||
+       !vbo_get_minmax_blocks(obj, indices, index_size, offset, count,
+                              primitive_restart, restart_index,
+                              min_index, max_index)) {
+      vbo_get_minmax_index_mapped(count, index_size, restart_index,
+                                  primitive_restart, indices,
+                                  min_index, max_index);
+   }
 
    if (obj) {
       vbo_minmax_cache_store(ctx, obj, index_size, offset, count, *min_index,
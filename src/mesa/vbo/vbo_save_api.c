@@ -195,6 +195,7 @@ reset_counters(struct gl_context *ctx)
    save->vertex_store->used = 0;
    save->prim_store->used = 0;
    save->dangling_attr_ref = GL_FALSE;
+   save->attr_folded = false;
 }
 
 /**
@@ -552,8 +553,14 @@ compile_vertex_list(struct gl_context *ctx)
             unsigned attr_offset = save->attrsz[0] * sizeof(GLfloat);
             unsigned vertex_offset = 0;
 
-            if (node->cold->vertex_count)
+            /* A value folded in after the last vertex is only in the
+             * current vertex.
+             */
+            if (save->attr_folded) {
+               buffer = (const char *)save->vertex;
+            } else if (node->cold->vertex_count) {
                vertex_offset = (node->cold->vertex_count - 1) * stride;
+            }
 
             memcpy(node->cold->current_data, buffer + vertex_offset + attr_offset,
                    current_size * sizeof(GLfloat));
@@ -1546,6 +1553,43 @@ _save_CallLists(GLsizei n, GLenum type, const GLvoid * v)
 
 
 
+/**
+ * Called when a glColor, glNormal, glMaterial, etc. outside of glBegin/glEnd
+ * is getting compiled into a display list.  If the attribute is already
+ * part of the vertex format of the pending vertex list, the value is used
+ * for the following vertices instead of ending the list, so the primitives
+ * before and after it can still be merged by compile_vertex_list().
+ *
+ * \return  true if the value was folded into the vertex list
+ */
+bool
+vbo_save_fold_attr(struct gl_context *ctx, GLuint attr, GLuint size,
+                   GLenum type, const uint32_t *v)
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+
+   if (!ctx->Driver.SaveNeedFlush ||
+       ctx->Driver.CurrentSavePrimitive != PRIM_OUTSIDE_BEGIN_END ||
+       save->out_of_memory || save->no_current_update ||
+       !save->vertex_store->used)
+      return false;
+
+   /* Position and its generic alias emit vertices */
+   if (attr == VBO_ATTRIB_POS || attr == VBO_ATTRIB_GENERIC0)
+      return false;
+
+   if (save->attrsz[attr] != size || save->active_sz[attr] != size ||
+       save->attrtype[attr] != type)
+      return false;
+
+   for (unsigned i = 0; i < size; i++)
+      save->attrptr[attr][i].u = v[i];
+
+   save->attr_folded = true;
+   return true;
+}
+
+
 /**
  * Called when a glBegin is getting compiled into a display list.
  * Updating of ctx->Driver.CurrentSavePrimitive is already taken care of.
@@ -627,10 +627,17 @@ util_format_fits_8unorm(const struct util_format_description *format_desc)
       return false;
 
    case UTIL_FORMAT_LAYOUT_ETC:
-      if (format_desc->format == PIPE_FORMAT_ETC1_RGB8)
+      if (format_desc->format == PIPE_FORMAT_ETC1_RGB8 ||
+          format_desc->format == PIPE_FORMAT_ETC2_RGB8 ||
+          format_desc->format == PIPE_FORMAT_ETC2_RGB8A1 ||
+          format_desc->format == PIPE_FORMAT_ETC2_RGBA8)
          return true;
       return false;
 
+   case UTIL_FORMAT_LAYOUT_ASTC:
+      /* The LDR decoder only produces 8 bits per channel. */
+      return format_desc->block.depth == 1;
+
    case UTIL_FORMAT_LAYOUT_PLAIN:
       /*
        * For these we can find a generic rule.
@@ -1215,21 +1222,38 @@ util_format_rgb_to_bgr(enum pipe_format format)
    }
 }
 
+#if (DETECT_ARCH_AARCH64 || DETECT_ARCH_ARM) && !defined(NO_FORMAT_ASM) && !defined(__SOFTFP__)
+#define UTIL_FORMAT_NEON 1
+#else
+#define UTIL_FORMAT_NEON 0
+#endif
+
+#if (DETECT_ARCH_X86 || DETECT_ARCH_X86_64) && defined(USE_SSE41) && !defined(NO_FORMAT_ASM)
+#define UTIL_FORMAT_X86_SIMD 1
+#else
+#define UTIL_FORMAT_X86_SIMD 0
+#endif
+
 static const struct util_format_unpack_description *util_format_unpack_table[PIPE_FORMAT_COUNT];
 
 static void
 util_format_unpack_table_init(void)
 {
    for (enum pipe_format format = PIPE_FORMAT_NONE; format < PIPE_FORMAT_COUNT; format++) {
-#if (DETECT_ARCH_AARCH64 || DETECT_ARCH_ARM) && !defined(NO_FORMAT_ASM) && !defined(__SOFTFP__)
-      const struct util_format_unpack_description *unpack = util_format_unpack_description_neon(format);
-      if (unpack) {
-         util_format_unpack_table[format] = unpack;
-         continue;
-      }
+      const struct util_format_unpack_description *unpack = NULL;
+
+#if UTIL_FORMAT_NEON
+      unpack = util_format_unpack_description_neon(format);
+#elif UTIL_FORMAT_X86_SIMD
+      unpack = util_format_unpack_description_avx2(format);
+      if (!unpack)
+         unpack = util_format_unpack_description_sse41(format);
 #endif
 
-      util_format_unpack_table[format] = util_format_unpack_description_generic(format);
+      if (!unpack)
+         unpack = util_format_unpack_description_generic(format);
+
+      util_format_unpack_table[format] = unpack;
    }
 }
 
@@ -1242,6 +1266,38 @@ util_format_unpack_description(enum pipe_format format)
    return util_format_unpack_table[format];
 }
 
+static const struct util_format_pack_description *util_format_pack_table[PIPE_FORMAT_COUNT];
+
+static void
+util_format_pack_table_init(void)
+{
+   for (enum pipe_format format = PIPE_FORMAT_NONE; format < PIPE_FORMAT_COUNT; format++) {
+      const struct util_format_pack_description *pack = NULL;
+
+#if UTIL_FORMAT_NEON
+      pack = util_format_pack_description_neon(format);
+#elif UTIL_FORMAT_X86_SIMD
+      pack = util_format_pack_description_avx2(format);
+      if (!pack)
+         pack = util_format_pack_description_sse41(format);
+#endif
+
+      if (!pack)
+         pack = util_format_pack_description_generic(format);
+
+      util_format_pack_table[format] = pack;
+   }
+}
+
+const struct util_format_pack_description *
+util_format_pack_description(enum pipe_format format)
+{
+   static once_flag flag = ONCE_FLAG_INIT;
+   call_once(&flag, util_format_pack_table_init);
+
+   return util_format_pack_table[format];
+}
+
 enum pipe_format
 util_format_snorm_to_unorm(enum pipe_format format)
 {
@@ -418,9 +418,14 @@ typedef void (*util_format_fetch_rgba_func_ptr)(void *restrict dst, const uint8_
 const struct util_format_description *
 util_format_description(enum pipe_format format) ATTRIBUTE_CONST;
 
+/* Lookup with CPU detection for choosing optimized paths. */
 const struct util_format_pack_description *
 util_format_pack_description(enum pipe_format format) ATTRIBUTE_CONST;
 
+/* Codegenned table of CPU-agnostic pack code. */
+const struct util_format_pack_description *
+util_format_pack_description_generic(enum pipe_format format) ATTRIBUTE_CONST;
+
 /* Lookup with CPU detection for choosing optimized paths. */
 const struct util_format_unpack_description *
 util_format_unpack_description(enum pipe_format format) ATTRIBUTE_CONST;
@@ -432,6 +437,22 @@ util_format_unpack_description_generic(enum pipe_format format) ATTRIBUTE_CONST;
 const struct util_format_unpack_description *
 util_format_unpack_description_neon(enum pipe_format format) ATTRIBUTE_CONST;
 
+const struct util_format_pack_description *
+util_format_pack_description_neon(enum pipe_format format) ATTRIBUTE_CONST;
+
+/* Codegenned tables of x86 SIMD code, NULL if the CPU or format lacks it. */
+const struct util_format_unpack_description *
+util_format_unpack_description_sse41(enum pipe_format format) ATTRIBUTE_CONST;
+
+const struct util_format_pack_description *
+util_format_pack_description_sse41(enum pipe_format format) ATTRIBUTE_CONST;
+
+const struct util_format_unpack_description *
+util_format_unpack_description_avx2(enum pipe_format format) ATTRIBUTE_CONST;
+
+const struct util_format_pack_description *
+util_format_pack_description_avx2(enum pipe_format format) ATTRIBUTE_CONST;
+
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
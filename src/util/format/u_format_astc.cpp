@@ -23,19 +23,22 @@
  */
 
 /**
- * \file texcompress_astc.c
+ * \file u_format_astc.cpp
  *
- * Decompression code for GL_KHR_texture_compression_astc_ldr, which is just
- * ASTC 2D LDR.
+ * Decompression code for ASTC 2D LDR, as exposed by
+ * GL_KHR_texture_compression_astc_ldr.
  *
  * The ASTC 2D LDR decoder (without the sRGB part) was copied from the OASTC
  * library written by Philip Taylor. I added sRGB support and adjusted it for
  * Mesa. - Marek
  */
 
-#include "texcompress_astc.h"
-#include "macros.h"
+#include "util/format/u_format.h"
+#include "util/format/u_format_astc.h"
+#include "util/format_srgb.h"
 #include "util/half_float.h"
+#include "util/macros.h"
+#include "util/u_math.h"
 #include <stdio.h>
 #include <cstdlib>  // for abort() on windows
 
@@ -1797,32 +1800,27 @@ decode_error::type Block::calculate_colour_endpoints_size()
 }
 
 /**
- * Decode ASTC 2D LDR texture data.
+ * Decode ASTC 2D LDR texture data to RGBA8.  sRGB formats are left encoded.
  *
- * \param src_width in pixels
- * \param src_height in pixels
+ * \param width in pixels
+ * \param height in pixels
  * \param dst_stride in bytes
  */
-extern "C" void
-_mesa_unpack_astc_2d_ldr(uint8_t *dst_row,
-                         unsigned dst_stride,
-                         const uint8_t *src_row,
-                         unsigned src_stride,
-                         unsigned src_width,
-                         unsigned src_height,
-                         mesa_format format)
+static void
+astc_unpack_rgba_8unorm(enum pipe_format format,
+                        uint8_t *dst_row, unsigned dst_stride,
+                        const uint8_t *src_row, unsigned src_stride,
+                        unsigned width, unsigned height)
 {
-   assert(_mesa_is_format_astc_2d(format));
-   bool srgb = _mesa_is_format_srgb(format);
-
-   unsigned blk_w, blk_h;
-   _mesa_get_format_block_size(format, &blk_w, &blk_h);
-
+   const struct util_format_description *desc = util_format_description(format);
+   const unsigned blk_w = desc->block.width, blk_h = desc->block.height;
    const unsigned block_size = 16;
-   unsigned x_blocks = (src_width + blk_w - 1) / blk_w;
-   unsigned y_blocks = (src_height + blk_h - 1) / blk_h;
+   unsigned x_blocks = (width + blk_w - 1) / blk_w;
+   unsigned y_blocks = (height + blk_h - 1) / blk_h;
 
-   Decoder dec(blk_w, blk_h, 1, srgb, true);
+   assert(desc->block.depth == 1);
+
+   Decoder dec(blk_w, blk_h, 1, util_format_is_srgb(format), true);
 
    for (unsigned y = 0; y < y_blocks; ++y) {
       for (unsigned x = 0; x < x_blocks; ++x) {
@@ -1832,8 +1830,8 @@ _mesa_unpack_astc_2d_ldr(uint8_t *dst_row,
          dec.decode(src_row + x * block_size, block_out);
 
          /* This can be smaller with NPOT dimensions. */
-         unsigned dst_blk_w = MIN2(blk_w, src_width  - x*blk_w);
-         unsigned dst_blk_h = MIN2(blk_h, src_height - y*blk_h);
+         unsigned dst_blk_w = MIN2(blk_w, width  - x*blk_w);
+         unsigned dst_blk_h = MIN2(blk_h, height - y*blk_h);
 
          for (unsigned sub_y = 0; sub_y < dst_blk_h; ++sub_y) {
             for (unsigned sub_x = 0; sub_x < dst_blk_w; ++sub_x) {
@@ -1852,3 +1850,120 @@ _mesa_unpack_astc_2d_ldr(uint8_t *dst_row,
       dst_row += dst_stride * blk_h;
    }
 }
+
+static void
+astc_unpack_rgba_float(enum pipe_format format,
+                       void *dst_row, unsigned dst_stride,
+                       const uint8_t *src_row, unsigned src_stride,
+                       unsigned width, unsigned height)
+{
+   const struct util_format_description *desc = util_format_description(format);
+   const bool srgb = util_format_is_srgb(format);
+   uint8_t tmp[12 * 12 * 4];
+
+   /* Decode one row of blocks at a time through a small RGBA8 buffer. */
+   for (unsigned y = 0; y < height; y += desc->block.height) {
+      const unsigned h = MIN2(desc->block.height, height - y);
+
+      for (unsigned x = 0; x < width; x += desc->block.width) {
+         const unsigned w = MIN2(desc->block.width, width - x);
+
+         astc_unpack_rgba_8unorm(format, tmp, w * 4,
+                                 src_row + x / desc->block.width * 16,
+                                 src_stride, w, h);
+
+         for (unsigned j = 0; j < h; ++j) {
+            float *dst = (float *)((uint8_t *)dst_row + (y + j) * dst_stride) +
+                         x * 4;
+
+            for (unsigned i = 0; i < w; ++i) {
+               const uint8_t *texel = &tmp[(j * w + i) * 4];
+
+               for (unsigned c = 0; c < 3; ++c) {
+                  dst[c] = srgb ? util_format_srgb_8unorm_to_linear_float(texel[c])
+                                : ubyte_to_float(texel[c]);
+               }
+               dst[3] = ubyte_to_float(texel[3]);
+               dst += 4;
+            }
+         }
+      }
+      src_row += src_stride;
+   }
+}
+
+static void
+astc_fetch_rgba(enum pipe_format format, float *dst, const uint8_t *src,
+                unsigned i, unsigned j)
+{
+   const struct util_format_description *desc = util_format_description(format);
+   const bool srgb = util_format_is_srgb(format);
+   uint16_t block_out[12 * 12 * 4];
+
+   assert(i < desc->block.width && j < desc->block.height);
+
+   Decoder dec(desc->block.width, desc->block.height, 1, srgb, true);
+   dec.decode(src, block_out);
+
+   const uint16_t *texel = &block_out[(j * desc->block.width + i) * 4];
+   for (unsigned c = 0; c < 3; ++c) {
+      dst[c] = srgb ? util_format_srgb_8unorm_to_linear_float(texel[c])
+                    : ubyte_to_float(texel[c]);
+   }
+   dst[3] = ubyte_to_float(texel[3]);
+}
+
+#define ASTC_FORMAT(name, format)                                                \
+extern "C" void                                                                  \
+util_format_##name##_unpack_rgba_8unorm(uint8_t *restrict dst_row, unsigned dst_stride, \
+                                        const uint8_t *restrict src_row, unsigned src_stride, \
+                                        unsigned width, unsigned height)         \
+{                                                                                \
+   astc_unpack_rgba_8unorm(format, dst_row, dst_stride, src_row, src_stride,     \
+                           width, height);                                       \
+}                                                                                \
+                                                                                 \
+extern "C" void                                                                  \
+util_format_##name##_unpack_rgba_float(void *restrict dst_row, unsigned dst_stride, \
+                                       const uint8_t *restrict src_row, unsigned src_stride, \
+                                       unsigned width, unsigned height)          \
+{                                                                                \
+   astc_unpack_rgba_float(format, dst_row, dst_stride, src_row, src_stride,      \
+                          width, height);                                        \
+}                                                                                \
+                                                                                 \
+extern "C" void                                                                  \
+util_format_##name##_fetch_rgba(void *restrict dst, const uint8_t *restrict src, \
+                                unsigned i, unsigned j)                          \
+{                                                                                \
+   astc_fetch_rgba(format, (float *)dst, src, i, j);                             \
+}
+
+ASTC_FORMAT(astc_4x4, PIPE_FORMAT_ASTC_4x4)
+ASTC_FORMAT(astc_5x4, PIPE_FORMAT_ASTC_5x4)
+ASTC_FORMAT(astc_5x5, PIPE_FORMAT_ASTC_5x5)
+ASTC_FORMAT(astc_6x5, PIPE_FORMAT_ASTC_6x5)
+ASTC_FORMAT(astc_6x6, PIPE_FORMAT_ASTC_6x6)
+ASTC_FORMAT(astc_8x5, PIPE_FORMAT_ASTC_8x5)
+ASTC_FORMAT(astc_8x6, PIPE_FORMAT_ASTC_8x6)
+ASTC_FORMAT(astc_8x8, PIPE_FORMAT_ASTC_8x8)
+ASTC_FORMAT(astc_10x5, PIPE_FORMAT_ASTC_10x5)
+ASTC_FORMAT(astc_10x6, PIPE_FORMAT_ASTC_10x6)
+ASTC_FORMAT(astc_10x8, PIPE_FORMAT_ASTC_10x8)
+ASTC_FORMAT(astc_10x10, PIPE_FORMAT_ASTC_10x10)
+ASTC_FORMAT(astc_12x10, PIPE_FORMAT_ASTC_12x10)
+ASTC_FORMAT(astc_12x12, PIPE_FORMAT_ASTC_12x12)
+ASTC_FORMAT(astc_4x4_srgb, PIPE_FORMAT_ASTC_4x4_SRGB)
+ASTC_FORMAT(astc_5x4_srgb, PIPE_FORMAT_ASTC_5x4_SRGB)
+ASTC_FORMAT(astc_5x5_srgb, PIPE_FORMAT_ASTC_5x5_SRGB)
+ASTC_FORMAT(astc_6x5_srgb, PIPE_FORMAT_ASTC_6x5_SRGB)
+ASTC_FORMAT(astc_6x6_srgb, PIPE_FORMAT_ASTC_6x6_SRGB)
+ASTC_FORMAT(astc_8x5_srgb, PIPE_FORMAT_ASTC_8x5_SRGB)
+ASTC_FORMAT(astc_8x6_srgb, PIPE_FORMAT_ASTC_8x6_SRGB)
+ASTC_FORMAT(astc_8x8_srgb, PIPE_FORMAT_ASTC_8x8_SRGB)
+ASTC_FORMAT(astc_10x5_srgb, PIPE_FORMAT_ASTC_10x5_SRGB)
+ASTC_FORMAT(astc_10x6_srgb, PIPE_FORMAT_ASTC_10x6_SRGB)
+ASTC_FORMAT(astc_10x8_srgb, PIPE_FORMAT_ASTC_10x8_SRGB)
+ASTC_FORMAT(astc_10x10_srgb, PIPE_FORMAT_ASTC_10x10_SRGB)
+ASTC_FORMAT(astc_12x10_srgb, PIPE_FORMAT_ASTC_12x10_SRGB)
+ASTC_FORMAT(astc_12x12_srgb, PIPE_FORMAT_ASTC_12x12_SRGB)
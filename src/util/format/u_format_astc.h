@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef U_FORMAT_ASTC_H_
+#define U_FORMAT_ASTC_H_
+
+#include <stdint.h>
+
+#include "c99_compat.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ASTC_FORMAT_DECL(name)                                                   \
+void                                                                             \
+util_format_##name##_unpack_rgba_8unorm(uint8_t *restrict dst_row, unsigned dst_stride, \
+                                        const uint8_t *restrict src_row, unsigned src_stride, \
+                                        unsigned width, unsigned height);        \
+void                                                                             \
+util_format_##name##_unpack_rgba_float(void *restrict dst_row, unsigned dst_stride, \
+                                       const uint8_t *restrict src_row, unsigned src_stride, \
+                                       unsigned width, unsigned height);         \
+void                                                                             \
+util_format_##name##_fetch_rgba(void *restrict dst, const uint8_t *restrict src, \
+                                unsigned i, unsigned j);
+
+ASTC_FORMAT_DECL(astc_4x4)
+ASTC_FORMAT_DECL(astc_5x4)
+ASTC_FORMAT_DECL(astc_5x5)
+ASTC_FORMAT_DECL(astc_6x5)
+ASTC_FORMAT_DECL(astc_6x6)
+ASTC_FORMAT_DECL(astc_8x5)
+ASTC_FORMAT_DECL(astc_8x6)
+ASTC_FORMAT_DECL(astc_8x8)
+ASTC_FORMAT_DECL(astc_10x5)
+ASTC_FORMAT_DECL(astc_10x6)
+ASTC_FORMAT_DECL(astc_10x8)
+ASTC_FORMAT_DECL(astc_10x10)
+ASTC_FORMAT_DECL(astc_12x10)
+ASTC_FORMAT_DECL(astc_12x12)
+ASTC_FORMAT_DECL(astc_4x4_srgb)
+ASTC_FORMAT_DECL(astc_5x4_srgb)
+ASTC_FORMAT_DECL(astc_5x5_srgb)
+ASTC_FORMAT_DECL(astc_6x5_srgb)
+ASTC_FORMAT_DECL(astc_6x6_srgb)
+ASTC_FORMAT_DECL(astc_8x5_srgb)
+ASTC_FORMAT_DECL(astc_8x6_srgb)
+ASTC_FORMAT_DECL(astc_8x8_srgb)
+ASTC_FORMAT_DECL(astc_10x5_srgb)
+ASTC_FORMAT_DECL(astc_10x6_srgb)
+ASTC_FORMAT_DECL(astc_10x8_srgb)
+ASTC_FORMAT_DECL(astc_10x10_srgb)
+ASTC_FORMAT_DECL(astc_12x10_srgb)
+ASTC_FORMAT_DECL(astc_12x12_srgb)
+
+#undef ASTC_FORMAT_DECL
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_FORMAT_ASTC_H_ */
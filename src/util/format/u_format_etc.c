@@ -1,9 +1,11 @@
 #include "util/compiler.h"
 #include "util/u_debug.h"
 #include "util/u_math.h"
+#include "util/format_srgb.h"
+#include "util/format/u_format.h"
 #include "util/format/u_format_etc.h"
 
-/* define etc1_parse_block and etc. */
+/* define etc1_parse_block, etc2_rgb8_parse_block and etc. */
 #define UINT8_TYPE uint8_t
 #define TAG(x) x
 #include "util/format/texcompress_etc_tmp.h"
@@ -16,14 +18,6 @@ util_format_etc1_rgb8_unpack_rgba_8unorm(uint8_t *restrict dst_row, unsigned dst
    etc1_unpack_rgba8888(dst_row, dst_stride, src_row, src_stride, width, height);
 }
 
-void
-util_format_etc1_rgb8_pack_rgba_8unorm(UNUSED uint8_t *restrict dst_row, UNUSED unsigned dst_stride,
-                                       UNUSED const uint8_t *restrict src_row, UNUSED unsigned src_stride,
-                                       UNUSED unsigned width, UNUSED unsigned height)
-{
-   assert(0);
-}
-
 void
 util_format_etc1_rgb8_unpack_rgba_float(void *restrict dst_row, unsigned dst_stride, const uint8_t *restrict src_row, unsigned src_stride, unsigned width, unsigned height)
 {
@@ -58,14 +52,6 @@ util_format_etc1_rgb8_unpack_rgba_float(void *restrict dst_row, unsigned dst_str
    }
 }
 
-void
-util_format_etc1_rgb8_pack_rgba_float(UNUSED uint8_t *restrict dst_row, UNUSED unsigned dst_stride,
-                                      UNUSED const float *restrict src_row, UNUSED unsigned src_stride,
-                                      UNUSED unsigned width, UNUSED unsigned height)
-{
-   assert(0);
-}
-
 void
 util_format_etc1_rgb8_fetch_rgba(void *restrict in_dst, const uint8_t *restrict src, unsigned i, unsigned j)
 {
@@ -83,3 +69,260 @@ util_format_etc1_rgb8_fetch_rgba(void *restrict in_dst, const uint8_t *restrict
    dst[2] = ubyte_to_float(tmp[2]);
    dst[3] = 1.0f;
 }
+
+/**
+ * Decodes one ETC2 RGB8, RGB8A1 or RGBA8 block into 4x4 RGBA8 texels, in
+ * rows of four.  sRGB formats are left encoded.
+ */
+static void
+etc2_decode_block_rgba8(enum pipe_format format, const uint8_t *src,
+                        uint8_t texels[4][4][4])
+{
+   const bool punchthrough_alpha = format == PIPE_FORMAT_ETC2_RGB8A1 ||
+                                   format == PIPE_FORMAT_ETC2_SRGB8A1;
+   const bool eac_alpha = format == PIPE_FORMAT_ETC2_RGBA8 ||
+                          format == PIPE_FORMAT_ETC2_SRGBA8;
+   struct etc2_block block;
+
+   if (eac_alpha)
+      etc2_rgba8_parse_block(&block, src);
+   else
+      etc2_rgb8_parse_block(&block, src, punchthrough_alpha);
+
+   for (unsigned j = 0; j < 4; j++) {
+      for (unsigned i = 0; i < 4; i++) {
+         uint8_t *dst = texels[j][i];
+
+         if (eac_alpha) {
+            etc2_rgba8_fetch_texel(&block, i, j, dst);
+         } else {
+            dst[3] = 255;
+            etc2_rgb8_fetch_texel(&block, i, j, dst, punchthrough_alpha);
+         }
+      }
+   }
+}
+
+/**
+ * Decodes one ETC2 R11 or RG11 block into 4x4 texels of one or two 16-bit
+ * channels, in rows of four.
+ */
+static void
+etc2_decode_block_rg11(enum pipe_format format, const uint8_t *src,
+                       uint16_t texels[4][4][2])
+{
+   const bool is_signed = format == PIPE_FORMAT_ETC2_R11_SNORM ||
+                          format == PIPE_FORMAT_ETC2_RG11_SNORM;
+   const unsigned comps = format == PIPE_FORMAT_ETC2_RG11_UNORM ||
+                          format == PIPE_FORMAT_ETC2_RG11_SNORM ? 2 : 1;
+   struct etc2_block block;
+
+   for (unsigned c = 0; c < comps; c++) {
+      etc2_r11_parse_block(&block, src + c * 8);
+
+      for (unsigned j = 0; j < 4; j++) {
+         for (unsigned i = 0; i < 4; i++) {
+            uint8_t *dst = (uint8_t *)&texels[j][i][c];
+
+            if (is_signed)
+               etc2_signed_r11_fetch_texel(&block, i, j, dst);
+            else
+               etc2_r11_fetch_texel(&block, i, j, dst);
+         }
+      }
+   }
+}
+
+static bool
+etc2_format_is_rg11(enum pipe_format format)
+{
+   return format == PIPE_FORMAT_ETC2_R11_UNORM ||
+          format == PIPE_FORMAT_ETC2_R11_SNORM ||
+          format == PIPE_FORMAT_ETC2_RG11_UNORM ||
+          format == PIPE_FORMAT_ETC2_RG11_SNORM;
+}
+
+/**
+ * Converts a texel decoded by etc2_decode_block_rg11() to float RGBA.
+ */
+static void
+etc2_rg11_texel_to_float(enum pipe_format format, const uint16_t *texel,
+                         float *dst)
+{
+   const bool is_signed = format == PIPE_FORMAT_ETC2_R11_SNORM ||
+                          format == PIPE_FORMAT_ETC2_RG11_SNORM;
+   const unsigned comps = format == PIPE_FORMAT_ETC2_RG11_UNORM ||
+                          format == PIPE_FORMAT_ETC2_RG11_SNORM ? 2 : 1;
+
+   for (unsigned c = 0; c < 2; c++) {
+      if (c >= comps)
+         dst[c] = 0.0f;
+      else if (is_signed)
+         dst[c] = MAX2((int16_t)texel[c] / 32767.0f, -1.0f);
+      else
+         dst[c] = texel[c] / 65535.0f;
+   }
+   dst[2] = 0.0f;
+   dst[3] = 1.0f;
+}
+
+static void
+etc2_texel_to_float(enum pipe_format format, const uint8_t *texel, float *dst)
+{
+   if (util_format_is_srgb(format)) {
+      dst[0] = util_format_srgb_8unorm_to_linear_float(texel[0]);
+      dst[1] = util_format_srgb_8unorm_to_linear_float(texel[1]);
+      dst[2] = util_format_srgb_8unorm_to_linear_float(texel[2]);
+   } else {
+      dst[0] = ubyte_to_float(texel[0]);
+      dst[1] = ubyte_to_float(texel[1]);
+      dst[2] = ubyte_to_float(texel[2]);
+   }
+   dst[3] = ubyte_to_float(texel[3]);
+}
+
+static void
+etc2_unpack_rgba_8unorm(enum pipe_format format,
+                        uint8_t *restrict dst_row, unsigned dst_stride,
+                        const uint8_t *restrict src_row, unsigned src_stride,
+                        unsigned width, unsigned height)
+{
+   const unsigned bs = util_format_get_blocksize(format);
+
+   for (unsigned y = 0; y < height; y += 4) {
+      const uint8_t *src = src_row;
+
+      for (unsigned x = 0; x < width; x += 4) {
+         const unsigned h = MIN2(4, height - y), w = MIN2(4, width - x);
+
+         if (etc2_format_is_rg11(format)) {
+            const bool is_signed = format == PIPE_FORMAT_ETC2_R11_SNORM ||
+                                   format == PIPE_FORMAT_ETC2_RG11_SNORM;
+            uint16_t texels[4][4][2];
+
+            etc2_decode_block_rg11(format, src, texels);
+            for (unsigned j = 0; j < h; j++) {
+               for (unsigned i = 0; i < w; i++) {
+                  uint8_t *dst = dst_row + (y + j) * dst_stride + (x + i) * 4;
+                  float rgba[4];
+
+                  etc2_rg11_texel_to_float(format, texels[j][i], rgba);
+                  for (unsigned c = 0; c < 4; c++) {
+                     dst[c] = is_signed ? float_to_ubyte(MAX2(rgba[c], 0.0f))
+                                        : float_to_ubyte(rgba[c]);
+                  }
+               }
+            }
+         } else {
+            uint8_t texels[4][4][4];
+
+            etc2_decode_block_rgba8(format, src, texels);
+            for (unsigned j = 0; j < h; j++) {
+               memcpy(dst_row + (y + j) * dst_stride + x * 4, texels[j],
+                      w * 4);
+            }
+         }
+
+         src += bs;
+      }
+
+      src_row += src_stride;
+   }
+}
+
+static void
+etc2_unpack_rgba_float(enum pipe_format format,
+                       void *restrict dst_row, unsigned dst_stride,
+                       const uint8_t *restrict src_row, unsigned src_stride,
+                       unsigned width, unsigned height)
+{
+   const unsigned bs = util_format_get_blocksize(format);
+
+   for (unsigned y = 0; y < height; y += 4) {
+      const uint8_t *src = src_row;
+
+      for (unsigned x = 0; x < width; x += 4) {
+         const unsigned h = MIN2(4, height - y), w = MIN2(4, width - x);
+         uint16_t rg11[4][4][2];
+         uint8_t rgba8[4][4][4];
+
+         if (etc2_format_is_rg11(format))
+            etc2_decode_block_rg11(format, src, rg11);
+         else
+            etc2_decode_block_rgba8(format, src, rgba8);
+
+         for (unsigned j = 0; j < h; j++) {
+            float *dst = (float *)((uint8_t *)dst_row + (y + j) * dst_stride) +
+                         x * 4;
+
+            for (unsigned i = 0; i < w; i++) {
+               if (etc2_format_is_rg11(format))
+                  etc2_rg11_texel_to_float(format, rg11[j][i], dst);
+               else
+                  etc2_texel_to_float(format, rgba8[j][i], dst);
+               dst += 4;
+            }
+         }
+
+         src += bs;
+      }
+
+      src_row += src_stride;
+   }
+}
+
+static void
+etc2_fetch_rgba(enum pipe_format format, float *dst, const uint8_t *src,
+                unsigned i, unsigned j)
+{
+   assert(i < 4 && j < 4); /* check i, j against 4x4 block size */
+
+   if (etc2_format_is_rg11(format)) {
+      uint16_t texels[4][4][2];
+
+      etc2_decode_block_rg11(format, src, texels);
+      etc2_rg11_texel_to_float(format, texels[j][i], dst);
+   } else {
+      uint8_t texels[4][4][4];
+
+      etc2_decode_block_rgba8(format, src, texels);
+      etc2_texel_to_float(format, texels[j][i], dst);
+   }
+}
+
+#define ETC2_FORMAT(name, format)                                                \
+void                                                                             \
+util_format_##name##_unpack_rgba_8unorm(uint8_t *restrict dst_row, unsigned dst_stride, \
+                                        const uint8_t *restrict src_row, unsigned src_stride, \
+                                        unsigned width, unsigned height)         \
+{                                                                                \
+   etc2_unpack_rgba_8unorm(format, dst_row, dst_stride, src_row, src_stride,     \
+                           width, height);                                       \
+}                                                                                \
+                                                                                 \
+void                                                                             \
+util_format_##name##_unpack_rgba_float(void *restrict dst_row, unsigned dst_stride, \
+                                       const uint8_t *restrict src_row, unsigned src_stride, \
+                                       unsigned width, unsigned height)          \
+{                                                                                \
+   etc2_unpack_rgba_float(format, dst_row, dst_stride, src_row, src_stride,      \
+                          width, height);                                        \
+}                                                                                \
+                                                                                 \
+void                                                                             \
+util_format_##name##_fetch_rgba(void *restrict dst, const uint8_t *restrict src, \
+                                unsigned i, unsigned j)                          \
+{                                                                                \
+   etc2_fetch_rgba(format, dst, src, i, j);                                      \
+}
+
+ETC2_FORMAT(etc2_rgb8, PIPE_FORMAT_ETC2_RGB8)
+ETC2_FORMAT(etc2_srgb8, PIPE_FORMAT_ETC2_SRGB8)
+ETC2_FORMAT(etc2_rgb8a1, PIPE_FORMAT_ETC2_RGB8A1)
+ETC2_FORMAT(etc2_srgb8a1, PIPE_FORMAT_ETC2_SRGB8A1)
+ETC2_FORMAT(etc2_rgba8, PIPE_FORMAT_ETC2_RGBA8)
+ETC2_FORMAT(etc2_srgba8, PIPE_FORMAT_ETC2_SRGBA8)
+ETC2_FORMAT(etc2_r11_unorm, PIPE_FORMAT_ETC2_R11_UNORM)
+ETC2_FORMAT(etc2_r11_snorm, PIPE_FORMAT_ETC2_R11_SNORM)
+ETC2_FORMAT(etc2_rg11_unorm, PIPE_FORMAT_ETC2_RG11_UNORM)
+ETC2_FORMAT(etc2_rg11_snorm, PIPE_FORMAT_ETC2_RG11_SNORM)
@@ -766,3 +766,316 @@ def generate(formats):
 
                 generate_format_unpack(format, channel, native_type, suffix)
                 generate_format_pack(format, channel, native_type, suffix)
+
+
+# Depth formats with SIMD unpack kernels: (kernel, shift of the Z24 bits)
+simd_depth_formats = {
+    'PIPE_FORMAT_Z16_UNORM': ('z16', 0),
+    'PIPE_FORMAT_Z24_UNORM_S8_UINT': ('z24', 0),
+    'PIPE_FORMAT_Z24X8_UNORM': ('z24', 0),
+    'PIPE_FORMAT_S8_UINT_Z24_UNORM': ('z24', 8),
+    'PIPE_FORMAT_X8Z24_UNORM': ('z24', 8),
+}
+
+
+def is_simd_unorm(format):
+    '''32-bit RGB formats with only UNORM channels that fit in a float mantissa.'''
+
+    if format.layout != PLAIN or format.colorspace != RGB:
+        return False
+    if format.block_width != 1 or format.block_height != 1 or format.block_size() != 32:
+        return False
+
+    has_unorm = False
+    for channel in format.le_channels:
+        if channel.type == VOID:
+            continue
+        if channel.type != UNSIGNED or not channel.norm or channel.size > 16:
+            return False
+        has_unorm = True
+
+    return has_unorm
+
+
+def is_simd_8unorm(format):
+    return is_simd_unorm(format) and \
+        all(channel.size == 8 for channel in format.le_channels)
+
+
+def is_simd_half4(format):
+    channels = format.le_channels
+    return format.layout == PLAIN and format.colorspace == RGB and \
+        all(c.type == FLOAT and c.size == 16 for c in channels) and \
+        format.le_swizzles == [SWIZZLE_X, SWIZZLE_Y, SWIZZLE_Z, SWIZZLE_W]
+
+
+def generate_simd_unorm(format):
+    '''Generate the SIMD wrappers of a format accepted by is_simd_unorm().'''
+
+    name = format.short_name()
+    channels = format.le_channels
+    swizzles = format.le_swizzles
+    inv_swizzle = inv_swizzles(swizzles)
+
+    unpack_shift = []
+    unpack_mask = []
+    unpack_scale = []
+    unpack_const = []
+    for i in range(4):
+        swizzle = swizzles[i]
+        if swizzle < 4:
+            channel = channels[swizzle]
+            unpack_shift.append('%u' % channel.shift)
+            unpack_mask.append('0x%x' % ((1 << channel.size) - 1))
+            unpack_scale.append('1.0f/0x%x' % ((1 << channel.size) - 1))
+            unpack_const.append('0')
+        else:
+            unpack_shift.append('0')
+            unpack_mask.append('0')
+            unpack_scale.append('0')
+            unpack_const.append('1' if swizzle == SWIZZLE_1 else '0')
+
+    pack_src = []
+    pack_shift = []
+    pack_bits = []
+    for i in range(4):
+        channel = channels[i]
+        if channel.type == VOID or inv_swizzle[i] is None:
+            pack_src.append('-1')
+        else:
+            pack_src.append('%u' % inv_swizzle[i])
+        pack_shift.append('%u' % channel.shift)
+        pack_bits.append('%u' % channel.size)
+
+    print('static const struct util_format_simd_unorm %s_layout = {' % name)
+    print('   .unpack_shift = {%s},' % ', '.join(unpack_shift))
+    print('   .unpack_mask = {%s},' % ', '.join(unpack_mask))
+    print('   .unpack_scale = {%s},' % ', '.join(unpack_scale))
+    print('   .unpack_const = {%s},' % ', '.join(unpack_const))
+    print('   .pack_src = {%s},' % ', '.join(pack_src))
+    print('   .pack_shift = {%s},' % ', '.join(pack_shift))
+    print('   .pack_bits = {%s},' % ', '.join(pack_bits))
+    print('};')
+    print()
+
+    print('static void')
+    print('util_format_%s_unpack_rgba_float_simd(void *restrict dst, const uint8_t *restrict src, unsigned width)' % name)
+    print('{')
+    print('   unsigned x = simd_unpack_unorm_float(dst, src, width, &%s_layout);' % name)
+    print('   util_format_%s_unpack_rgba_float((float *)dst + x * 4, src + x * 4, width - x);' % name)
+    print('}')
+    print()
+
+    print('static void')
+    print('util_format_%s_pack_rgba_float_simd(uint8_t *restrict dst_row, unsigned dst_stride, const float *restrict src_row, unsigned src_stride, unsigned width, unsigned height)' % name)
+    print('{')
+    print('   for (unsigned y = 0; y < height; y++) {')
+    print('      unsigned x = simd_pack_unorm_float(dst_row, src_row, width, &%s_layout);' % name)
+    print('      util_format_%s_pack_rgba_float(dst_row + x * 4, dst_stride, src_row + x * 4, src_stride, width - x, 1);' % name)
+    print('      dst_row += dst_stride;')
+    print('      src_row += src_stride/sizeof(*src_row);')
+    print('   }')
+    print('}')
+    print()
+
+    if not is_simd_8unorm(format):
+        return
+
+    # Byte shuffles for 4 pixels; entries with the top bit set give zero.
+    unpack_table = []
+    unpack_fill = 0
+    pack_table = []
+    for p in range(4):
+        for i in range(4):
+            swizzle = swizzles[i]
+            if swizzle < 4:
+                unpack_table.append(p * 4 + channels[swizzle].shift // 8)
+            else:
+                unpack_table.append(0x80)
+                if swizzle == SWIZZLE_1:
+                    unpack_fill |= 0xff << (i * 8)
+        pack = [0x80] * 4
+        for i in range(4):
+            if pack_src[i] != '-1':
+                pack[channels[i].shift // 8] = p * 4 + inv_swizzle[i]
+        pack_table += pack
+
+    print('static const uint8_t %s_unpack_shuffle[16] = {%s};' %
+          (name, ', '.join(['0x%02x' % x for x in unpack_table])))
+    print('static const uint8_t %s_pack_shuffle[16] = {%s};' %
+          (name, ', '.join(['0x%02x' % x for x in pack_table])))
+    print()
+
+    print('static void')
+    print('util_format_%s_unpack_rgba_8unorm_simd(uint8_t *restrict dst, const uint8_t *restrict src, unsigned width)' % name)
+    print('{')
+    print('   unsigned x = simd_shuffle_8unorm(dst, src, width, %s_unpack_shuffle, 0x%x);' % (name, unpack_fill))
+    print('   util_format_%s_unpack_rgba_8unorm(dst + x * 4, src + x * 4, width - x);' % name)
+    print('}')
+    print()
+
+    print('static void')
+    print('util_format_%s_pack_rgba_8unorm_simd(uint8_t *restrict dst_row, unsigned dst_stride, const uint8_t *restrict src_row, unsigned src_stride, unsigned width, unsigned height)' % name)
+    print('{')
+    print('   for (unsigned y = 0; y < height; y++) {')
+    print('      unsigned x = simd_shuffle_8unorm(dst_row, src_row, width, %s_pack_shuffle, 0);' % name)
+    print('      util_format_%s_pack_rgba_8unorm(dst_row + x * 4, dst_stride, src_row + x * 4, src_stride, width - x, 1);' % name)
+    print('      dst_row += dst_stride;')
+    print('      src_row += src_stride;')
+    print('   }')
+    print('}')
+    print()
+
+
+def generate_simd_half4(format):
+    name = format.short_name()
+
+    print('static void')
+    print('util_format_%s_unpack_rgba_float_simd(void *restrict dst, const uint8_t *restrict src, unsigned width)' % name)
+    print('{')
+    print('   unsigned x = simd_unpack_half4(dst, src, width);')
+    print('   util_format_%s_unpack_rgba_float((float *)dst + x * 4, src + x * 8, width - x);' % name)
+    print('}')
+    print()
+
+    print('static void')
+    print('util_format_%s_pack_rgba_float_simd(uint8_t *restrict dst_row, unsigned dst_stride, const float *restrict src_row, unsigned src_stride, unsigned width, unsigned height)' % name)
+    print('{')
+    print('   for (unsigned y = 0; y < height; y++) {')
+    print('      unsigned x = simd_pack_half4(dst_row, src_row, width);')
+    print('      util_format_%s_pack_rgba_float(dst_row + x * 8, dst_stride, src_row + x * 4, src_stride, width - x, 1);' % name)
+    print('      dst_row += dst_stride;')
+    print('      src_row += src_stride/sizeof(*src_row);')
+    print('   }')
+    print('}')
+    print()
+
+
+def generate_simd_depth(format):
+    name = format.short_name()
+    kernel, shift = simd_depth_formats[format.name]
+    block_bytes = format.block_size() // 8
+    args = 'width, %u' % shift if kernel == 'z24' else 'width'
+
+    for dst_type, suffix in (('float', 'float'), ('uint32_t', '32unorm')):
+        print('static void')
+        print('util_format_%s_unpack_z_%s_simd(%s *restrict dst_row, unsigned dst_stride, const uint8_t *restrict src_row, unsigned src_stride, unsigned width, unsigned height)' %
+              (name, suffix, dst_type))
+        print('{')
+        print('   for (unsigned y = 0; y < height; y++) {')
+        print('      unsigned x = simd_unpack_%s_%s(dst_row, src_row, %s);' % (kernel, suffix, args))
+        print('      util_format_%s_unpack_z_%s(dst_row + x, dst_stride, src_row + x * %u, src_stride, width - x, 1);' %
+              (name, suffix, block_bytes))
+        print('      dst_row += dst_stride/sizeof(*dst_row);')
+        print('      src_row += src_stride;')
+        print('   }')
+        print('}')
+        print()
+
+
+def generate_simd(formats):
+    '''Generate u_format_simd.c, which is built once per x86 instruction set.'''
+
+    print()
+    print('#include "util/u_cpu_detect.h"')
+    print('#include "u_format.h"')
+    print('#include "u_format_pack.h"')
+    print('#include "u_format_simd.h"')
+    print('#include "u_format_zs.h"')
+    print()
+
+    unorm = [f for f in formats if is_simd_unorm(f)]
+    half4 = [f for f in formats if is_simd_half4(f)]
+    depth = [f for f in formats if f.name in simd_depth_formats]
+
+    for format in unorm:
+        generate_simd_unorm(format)
+
+    print('#if UTIL_FORMAT_SIMD_HAS_F16C')
+    print()
+    for format in half4:
+        generate_simd_half4(format)
+    print('#endif')
+    print()
+
+    for format in depth:
+        generate_simd_depth(format)
+
+    def description_entry(format, fields):
+        name = format.short_name()
+        print('   [%s] = {' % format.name)
+        for field, suffix, simd in fields:
+            print('      .%s = &util_format_%s_%s%s,' % (field, name, suffix, '_simd' if simd else ''))
+        print('   },')
+
+    print('static const struct util_format_unpack_description util_format_unpack_descriptions_simd[] = {')
+    for format in unorm:
+        description_entry(format, [('unpack_rgba_8unorm', 'unpack_rgba_8unorm', is_simd_8unorm(format)),
+                                       ('unpack_rgba', 'unpack_rgba_float', True)])
+    print('#if UTIL_FORMAT_SIMD_HAS_F16C')
+    for format in half4:
+        description_entry(format, [('unpack_rgba_8unorm', 'unpack_rgba_8unorm', False),
+                                       ('unpack_rgba', 'unpack_rgba_float', True)])
+    print('#endif')
+    for format in depth:
+        fields = [('unpack_z_32unorm', 'unpack_z_32unorm', True),
+                  ('unpack_z_float', 'unpack_z_float', True)]
+        if format.has_stencil():
+            fields.append(('unpack_s_8uint', 'unpack_s_8uint', False))
+        description_entry(format, fields)
+    print('};')
+    print()
+
+    print('static const struct util_format_pack_description util_format_pack_descriptions_simd[] = {')
+    for format in unorm:
+        description_entry(format, [('pack_rgba_8unorm', 'pack_rgba_8unorm', is_simd_8unorm(format)),
+                                     ('pack_rgba_float', 'pack_rgba_float', True)])
+    print('#if UTIL_FORMAT_SIMD_HAS_F16C')
+    for format in half4:
+        description_entry(format, [('pack_rgba_8unorm', 'pack_rgba_8unorm', False),
+                                     ('pack_rgba_float', 'pack_rgba_float', True)])
+    print('#endif')
+    print('};')
+    print()
+
+    print('static bool')
+    print('util_format_simd_supported(void)')
+    print('{')
+    print('#ifdef __AVX2__')
+    print('   return util_get_cpu_caps()->has_avx2 && util_get_cpu_caps()->has_f16c;')
+    print('#else')
+    print('   return util_get_cpu_caps()->has_sse4_1;')
+    print('#endif')
+    print('}')
+    print()
+
+    print('const struct util_format_unpack_description *')
+    print('UTIL_FORMAT_SIMD_FUNC(util_format_unpack_description)(enum pipe_format format)')
+    print('{')
+    print('   if (!util_format_simd_supported() ||')
+    print('       format >= ARRAY_SIZE(util_format_unpack_descriptions_simd))')
+    print('      return NULL;')
+    print()
+    print('   const struct util_format_unpack_description *unpack =')
+    print('      &util_format_unpack_descriptions_simd[format];')
+    print('   if (!unpack->unpack_rgba && !unpack->unpack_z_float)')
+    print('      return NULL;')
+    print()
+    print('   return unpack;')
+    print('}')
+    print()
+
+    print('const struct util_format_pack_description *')
+    print('UTIL_FORMAT_SIMD_FUNC(util_format_pack_description)(enum pipe_format format)')
+    print('{')
+    print('   if (!util_format_simd_supported() ||')
+    print('       format >= ARRAY_SIZE(util_format_pack_descriptions_simd))')
+    print('      return NULL;')
+    print()
+    print('   const struct util_format_pack_description *pack =')
+    print('      &util_format_pack_descriptions_simd[format];')
+    print('   if (!pack->pack_rgba_float)')
+    print('      return NULL;')
+    print()
+    print('   return pack;')
+    print('}')
@@ -0,0 +1,432 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file
+ * Building blocks for the x86 pack/unpack kernels in the generated
+ * u_format_simd.c.
+ *
+ * u_format_simd.c is compiled once with SSE4.1 and once with AVX2 + F16C
+ * enabled, and the vector width follows the instruction set.  The kernels
+ * here only handle whole vectors of pixels and return how many pixels they
+ * did, the generated wrappers finish the row with the generic code so that
+ * the results are bit-identical to the u_format_table.c functions.
+ */
+
+#ifndef U_FORMAT_SIMD_H
+#define U_FORMAT_SIMD_H
+
+#include <stdint.h>
+#include <immintrin.h>
+
+
+#ifdef __AVX2__
+#define UTIL_FORMAT_SIMD_WIDTH 8
+#define UTIL_FORMAT_SIMD_HAS_F16C 1
+#define UTIL_FORMAT_SIMD_FUNC(name) name##_avx2
+#else
+#define UTIL_FORMAT_SIMD_WIDTH 4
+#define UTIL_FORMAT_SIMD_HAS_F16C 0
+#define UTIL_FORMAT_SIMD_FUNC(name) name##_sse41
+#endif
+
+/**
+ * Layout of a 32-bit format whose channels are all UNORM and narrower than
+ * the float mantissa, e.g. R8G8B8A8 or R10G10B10A2.
+ */
+struct util_format_simd_unorm {
+   /** Per RGBA component: source channel bits, or a constant when mask is 0. */
+   uint32_t unpack_shift[4];
+   uint32_t unpack_mask[4];
+   float unpack_scale[4];
+   float unpack_const[4];
+
+   /** Per stored channel: the RGBA component it comes from, or -1. */
+   int pack_src[4];
+   uint32_t pack_shift[4];
+   uint32_t pack_bits[4];
+};
+
+#ifdef __AVX2__
+
+typedef __m256 simd_float;
+typedef __m256i simd_int;
+
+#define simd_set1_float _mm256_set1_ps
+#define simd_set1_int _mm256_set1_epi32
+#define simd_and _mm256_and_si256
+#define simd_or _mm256_or_si256
+#define simd_add _mm256_add_ps
+#define simd_mul _mm256_mul_ps
+#define simd_min _mm256_min_ps
+#define simd_max _mm256_max_ps
+#define simd_int_to_float _mm256_cvtepi32_ps
+#define simd_float_to_int _mm256_cvtps_epi32
+#define simd_as_int _mm256_castps_si256
+
+static inline simd_int
+simd_load_int(const void *src)
+{
+   return _mm256_loadu_si256((const __m256i *)src);
+}
+
+static inline void
+simd_store_int(void *dst, simd_int v)
+{
+   _mm256_storeu_si256((__m256i *)dst, v);
+}
+
+static inline simd_int
+simd_srl(simd_int v, unsigned count)
+{
+   return _mm256_srl_epi32(v, _mm_cvtsi32_si128(count));
+}
+
+static inline simd_int
+simd_sll(simd_int v, unsigned count)
+{
+   return _mm256_sll_epi32(v, _mm_cvtsi32_si128(count));
+}
+
+static inline simd_int
+simd_shuffle_table(const uint8_t table[16])
+{
+   return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)table));
+}
+
+static inline simd_int
+simd_shuffle(simd_int v, simd_int table)
+{
+   return _mm256_shuffle_epi8(v, table);
+}
+
+static inline void
+simd_transpose(simd_float v[4])
+{
+   __m256 t0 = _mm256_unpacklo_ps(v[0], v[1]);
+   __m256 t1 = _mm256_unpacklo_ps(v[2], v[3]);
+   __m256 t2 = _mm256_unpackhi_ps(v[0], v[1]);
+   __m256 t3 = _mm256_unpackhi_ps(v[2], v[3]);
+
+   v[0] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+   v[1] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+   v[2] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+   v[3] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+/**
+ * Load 8 RGBA pixels as one vector per component.  Each 128-bit lane is
+ * transposed on its own, so pixels 0-3 go to the low lanes and pixels 4-7
+ * to the high lanes.
+ */
+static inline void
+simd_load_rgba(simd_float c[4], const float *src)
+{
+   for (unsigned i = 0; i < 4; i++) {
+      c[i] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + i * 4)),
+                                  _mm_loadu_ps(src + 16 + i * 4), 1);
+   }
+   simd_transpose(c);
+}
+
+static inline void
+simd_store_rgba(float *dst, simd_float c[4])
+{
+   simd_transpose(c);
+   for (unsigned i = 0; i < 4; i++) {
+      _mm_storeu_ps(dst + i * 4, _mm256_castps256_ps128(c[i]));
+      _mm_storeu_ps(dst + 16 + i * 4, _mm256_extractf128_ps(c[i], 1));
+   }
+}
+
+/** Convert 8 Z24 values to float the way z24_unorm_to_z32_float() does. */
+static inline simd_float
+simd_z24_to_float(simd_int z)
+{
+   const __m256d scale = _mm256_set1_pd(1.0 / 0xffffff);
+   __m128 lo = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(z)), scale));
+   __m128 hi = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(z, 1)), scale));
+   return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+static inline simd_int
+simd_load_z16(const uint8_t *src)
+{
+   return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)src));
+}
+
+#else /* SSE4.1 */
+
+typedef __m128 simd_float;
+typedef __m128i simd_int;
+
+#define simd_set1_float _mm_set1_ps
+#define simd_set1_int _mm_set1_epi32
+#define simd_and _mm_and_si128
+#define simd_or _mm_or_si128
+#define simd_add _mm_add_ps
+#define simd_mul _mm_mul_ps
+#define simd_min _mm_min_ps
+#define simd_max _mm_max_ps
+#define simd_int_to_float _mm_cvtepi32_ps
+#define simd_float_to_int _mm_cvtps_epi32
+#define simd_as_int _mm_castps_si128
+
+static inline simd_int
+simd_load_int(const void *src)
+{
+   return _mm_loadu_si128((const __m128i *)src);
+}
+
+static inline void
+simd_store_int(void *dst, simd_int v)
+{
+   _mm_storeu_si128((__m128i *)dst, v);
+}
+
+static inline simd_int
+simd_srl(simd_int v, unsigned count)
+{
+   return _mm_srl_epi32(v, _mm_cvtsi32_si128(count));
+}
+
+static inline simd_int
+simd_sll(simd_int v, unsigned count)
+{
+   return _mm_sll_epi32(v, _mm_cvtsi32_si128(count));
+}
+
+static inline simd_int
+simd_shuffle_table(const uint8_t table[16])
+{
+   return _mm_loadu_si128((const __m128i *)table);
+}
+
+static inline simd_int
+simd_shuffle(simd_int v, simd_int table)
+{
+   return _mm_shuffle_epi8(v, table);
+}
+
+static inline void
+simd_load_rgba(simd_float c[4], const float *src)
+{
+   for (unsigned i = 0; i < 4; i++)
+      c[i] = _mm_loadu_ps(src + i * 4);
+   _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+}
+
+static inline void
+simd_store_rgba(float *dst, simd_float c[4])
+{
+   _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+   for (unsigned i = 0; i < 4; i++)
+      _mm_storeu_ps(dst + i * 4, c[i]);
+}
+
+/** Convert 4 Z24 values to float the way z24_unorm_to_z32_float() does. */
+static inline simd_float
+simd_z24_to_float(simd_int z)
+{
+   const __m128d scale = _mm_set1_pd(1.0 / 0xffffff);
+   __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtepi32_pd(z), scale));
+   __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(z, z)), scale));
+   return _mm_movelh_ps(lo, hi);
+}
+
+static inline simd_int
+simd_load_z16(const uint8_t *src)
+{
+   return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)src));
+}
+
+#endif
+
+/**
+ * Reorder the bytes of 32-bit pixels.  Table entries with the top bit set
+ * produce zero, and fill is or'ed in afterwards for the X channels.
+ */
+static inline unsigned
+simd_shuffle_8unorm(uint8_t *restrict dst, const uint8_t *restrict src,
+                    unsigned width, const uint8_t table[16], uint32_t fill)
+{
+   const simd_int shuffle = simd_shuffle_table(table);
+   const simd_int ones = simd_set1_int(fill);
+   unsigned x;
+
+   for (x = 0; x + UTIL_FORMAT_SIMD_WIDTH <= width; x += UTIL_FORMAT_SIMD_WIDTH) {
+      simd_int v = simd_load_int(src + x * 4);
+      simd_store_int(dst + x * 4, simd_or(simd_shuffle(v, shuffle), ones));
+   }
+
+   return x;
+}
+
+static inline unsigned
+simd_unpack_unorm_float(float *restrict dst, const uint8_t *restrict src,
+                        unsigned width,
+                        const struct util_format_simd_unorm *layout)
+{
+   unsigned x;
+
+   for (x = 0; x + UTIL_FORMAT_SIMD_WIDTH <= width; x += UTIL_FORMAT_SIMD_WIDTH) {
+      simd_int v = simd_load_int(src + x * 4);
+      simd_float c[4];
+
+      for (unsigned i = 0; i < 4; i++) {
+         if (layout->unpack_mask[i]) {
+            simd_int bits = simd_and(simd_srl(v, layout->unpack_shift[i]),
+                                     simd_set1_int(layout->unpack_mask[i]));
+            c[i] = simd_mul(simd_int_to_float(bits),
+                            simd_set1_float(layout->unpack_scale[i]));
+         } else {
+            c[i] = simd_set1_float(layout->unpack_const[i]);
+         }
+      }
+
+      simd_store_rgba(dst + x * 4, c);
+   }
+
+   return x;
+}
+
+static inline unsigned
+simd_pack_unorm_float(uint8_t *restrict dst, const float *restrict src,
+                      unsigned width,
+                      const struct util_format_simd_unorm *layout)
+{
+   const simd_float zero = simd_set1_float(0.0f);
+   const simd_float one = simd_set1_float(1.0f);
+   unsigned x;
+
+   for (x = 0; x + UTIL_FORMAT_SIMD_WIDTH <= width; x += UTIL_FORMAT_SIMD_WIDTH) {
+      simd_float c[4];
+      simd_int value = simd_set1_int(0);
+
+      simd_load_rgba(c, src + x * 4);
+
+      for (unsigned i = 0; i < 4; i++) {
+         if (layout->pack_src[i] < 0)
+            continue;
+
+         /* max() returns its second operand for NaN, which maps NaN to 0
+          * like CLAMP() + util_iround() and float_to_ubyte() do.
+          */
+         simd_float f = simd_min(simd_max(c[layout->pack_src[i]], zero), one);
+         simd_int bits;
+
+         if (layout->pack_bits[i] == 8) {
+            /* Same trick as float_to_ubyte(). */
+            f = simd_add(simd_mul(f, simd_set1_float(255.0f / 256.0f)),
+                         simd_set1_float(32768.0f));
+            bits = simd_and(simd_as_int(f), simd_set1_int(0xff));
+         } else {
+            uint32_t max = (1u << layout->pack_bits[i]) - 1;
+            bits = simd_float_to_int(simd_mul(f, simd_set1_float(max)));
+         }
+
+         value = simd_or(value, simd_sll(bits, layout->pack_shift[i]));
+      }
+
+      simd_store_int(dst + x * 4, value);
+   }
+
+   return x;
+}
+
+/** Unpack Z24 stored in the low (shift 0) or high (shift 8) bits. */
+static inline unsigned
+simd_unpack_z24_float(float *restrict dst, const uint8_t *restrict src,
+                      unsigned width, unsigned shift)
+{
+   const simd_int mask = simd_set1_int(0xffffff);
+   unsigned x;
+
+   for (x = 0; x + UTIL_FORMAT_SIMD_WIDTH <= width; x += UTIL_FORMAT_SIMD_WIDTH) {
+      simd_int z = simd_and(simd_srl(simd_load_int(src + x * 4), shift), mask);
+      simd_store_int(dst + x, simd_as_int(simd_z24_to_float(z)));
+   }
+
+   return x;
+}
+
+static inline unsigned
+simd_unpack_z24_32unorm(uint32_t *restrict dst, const uint8_t *restrict src,
+                        unsigned width, unsigned shift)
+{
+   const simd_int mask = simd_set1_int(0xffffff);
+   unsigned x;
+
+   for (x = 0; x + UTIL_FORMAT_SIMD_WIDTH <= width; x += UTIL_FORMAT_SIMD_WIDTH) {
+      simd_int z = simd_and(simd_srl(simd_load_int(src + x * 4), shift), mask);
+      simd_store_int(dst + x, simd_or(simd_sll(z, 8), simd_srl(z, 16)));
+   }
+
+   return x;
+}
+
+static inline unsigned
+simd_unpack_z16_float(float *restrict dst, const uint8_t *restrict src,
+                      unsigned width)
+{
+   const simd_float scale = simd_set1_float((float)(1.0 / 0xffff));
+   unsigned x;
+
+   for (x = 0; x + UTIL_FORMAT_SIMD_WIDTH <= width; x += UTIL_FORMAT_SIMD_WIDTH) {
+      simd_float z = simd_mul(simd_int_to_float(simd_load_z16(src + x * 2)), scale);
+      simd_store_int(dst + x, simd_as_int(z));
+   }
+
+   return x;
+}
+
+static inline unsigned
+simd_unpack_z16_32unorm(uint32_t *restrict dst, const uint8_t *restrict src,
+                        unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + UTIL_FORMAT_SIMD_WIDTH <= width; x += UTIL_FORMAT_SIMD_WIDTH) {
+      simd_int z = simd_load_z16(src + x * 2);
+      simd_store_int(dst + x, simd_or(simd_sll(z, 16), z));
+   }
+
+   return x;
+}
+
+#if UTIL_FORMAT_SIMD_HAS_F16C
+
+/** R16G16B16A16_FLOAT, two pixels per conversion. */
+static inline unsigned
+simd_unpack_half4(float *restrict dst, const uint8_t *restrict src,
+                  unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 2 <= width; x += 2) {
+      __m128i h = _mm_loadu_si128((const __m128i *)(src + x * 8));
+      _mm256_storeu_ps(dst + x * 4, _mm256_cvtph_ps(h));
+   }
+
+   return x;
+}
+
+static inline unsigned
+simd_pack_half4(uint8_t *restrict dst, const float *restrict src,
+                unsigned width)
+{
+   unsigned x;
+
+   /* Round towards zero like _mesa_float_to_float16_rtz(). */
+   for (x = 0; x + 2 <= width; x += 2) {
+      __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + x * 4), _MM_FROUND_TO_ZERO);
+      _mm_storeu_si128((__m128i *)(dst + x * 8), h);
+   }
+
+   return x;
+}
+
+#endif
+
+#endif /* U_FORMAT_SIMD_H */
@@ -125,9 +125,9 @@ def has_access(format):
     ]
     if format.short_name() in noaccess_formats:
         return False
-    if format.layout in ('astc', 'atc'):
+    if format.layout == 'atc':
         return False
-    if format.layout == 'etc' and format.short_name() != 'etc1_rgb8':
+    if format.layout == 'astc' and format.block_depth > 1:
         return False
     return True
 
@@ -153,6 +153,7 @@ def write_format_aliases(formats):
 def write_format_table(formats):
     write_format_table_header(sys.stdout)
     print('#include "util/format/u_format.h"')
+    print('#include "u_format_astc.h"')
     print('#include "u_format_bptc.h"')
     print('#include "u_format_fxt1.h"')
     print('#include "u_format_s3tc.h"')
@@ -220,7 +221,7 @@ def write_format_table(formats):
 
     def generate_table_getter(type):
         suffix = ""
-        if type == "unpack_":
+        if type in ("pack_", "unpack_"):
             suffix = "_generic"
         print("ATTRIBUTE_RETURNS_NONNULL const struct util_format_%sdescription *" % type)
         print("util_format_%sdescription%s(enum pipe_format format)" % (type, suffix))
@@ -281,7 +282,9 @@ def write_format_table(formats):
             continue
 
         print("   [%s] = {" % (format.name,))
-        if format.colorspace != ZS and not format.is_pure_color():
+        # ETC and ASTC only have decoders.
+        if format.colorspace != ZS and not format.is_pure_color() and \
+           format.layout not in ('etc', 'astc'):
             print("      .pack_rgba_8unorm = &util_format_%s_pack_rgba_8unorm," % sn)
             print("      .pack_rgba_float = &util_format_%s_pack_rgba_float," % sn)
 
@@ -357,6 +360,7 @@ def write_format_table(formats):
 
 def main():
     formats = {}
+    simd = False
 
     sys.stdout2 = open(os.devnull, "w")
     sys.stdout3 = open(os.devnull, "w")
@@ -372,6 +376,9 @@ def main():
             sys.stdout = open(os.devnull, "w")
             sys.stdout2 = sys.stdout
             continue
+        elif arg == '--simd':
+            simd = True
+            continue
 
         to_add = parse(arg)
         duplicates = [x.name for x in to_add if x.name in formats]
@@ -379,7 +386,11 @@ def main():
             raise RuntimeError(f"Duplicate format entries {', '.join(duplicates)}")
         formats.update({ x.name: x for x in to_add })
 
-    write_format_table(formats.values())
+    if simd:
+        write_format_table_header(sys.stdout)
+        u_format_pack.generate_simd(formats.values())
+    else:
+        write_format_table(formats.values())
 
 if __name__ == '__main__':
     main()
@@ -594,6 +594,100 @@ util_format_test_cases[] =
       }
    },
 
+   {
+      PIPE_FORMAT_ETC2_RGB8,
+      {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+      {0x67, 0xc6, 0x69, 0x73, 0x51, 0xff, 0x4a, 0xec},
+      {
+         {
+            {0x56/255.0, 0xb9/255.0, 0x5e/255.0, 0xff/255.0},
+            {0x56/255.0, 0xb9/255.0, 0x5e/255.0, 0xff/255.0},
+            {0x56/255.0, 0xb9/255.0, 0x5e/255.0, 0xff/255.0},
+            {0x56/255.0, 0xb9/255.0, 0x5e/255.0, 0xff/255.0}
+         },
+         {
+            {0x56/255.0, 0xb9/255.0, 0x5e/255.0, 0xff/255.0},
+            {0x39/255.0, 0x9c/255.0, 0x41/255.0, 0xff/255.0},
+            {0x8d/255.0, 0xf0/255.0, 0x95/255.0, 0xff/255.0},
+            {0x70/255.0, 0xd3/255.0, 0x78/255.0, 0xff/255.0}
+         },
+         {
+            {0x1e/255.0, 0x79/255.0, 0x37/255.0, 0xff/255.0},
+            {0x1e/255.0, 0x79/255.0, 0x37/255.0, 0xff/255.0},
+            {0x6c/255.0, 0xc7/255.0, 0x85/255.0, 0xff/255.0},
+            {0x1e/255.0, 0x79/255.0, 0x37/255.0, 0xff/255.0}
+         },
+         {
+            {0x1e/255.0, 0x79/255.0, 0x37/255.0, 0xff/255.0},
+            {0x1e/255.0, 0x79/255.0, 0x37/255.0, 0xff/255.0},
+            {0x96/255.0, 0xf1/255.0, 0xaf/255.0, 0xff/255.0},
+            {0x6c/255.0, 0xc7/255.0, 0x85/255.0, 0xff/255.0}
+         }
+      }
+   },
+   {
+      PIPE_FORMAT_ETC2_RGBA8,
+      {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+      {0x67, 0xc6, 0x69, 0x73, 0x51, 0xff, 0x4a, 0xec, 0x29, 0xcd, 0xba, 0xab, 0xf2, 0xfb, 0xe3, 0x46},
+      {
+         {
+            {0x11/255.0, 0xb6/255.0, 0xa5/255.0, 0x00/255.0},
+            {0x11/255.0, 0xb6/255.0, 0xa5/255.0, 0x13/255.0},
+            {0x79/255.0, 0xff/255.0, 0xff/255.0, 0xdf/255.0},
+            {0x11/255.0, 0xb6/255.0, 0xa5/255.0, 0xaf/255.0}
+         },
+         {
+            {0x00/255.0, 0x7e/255.0, 0x6d/255.0, 0x07/255.0},
+            {0x11/255.0, 0xb6/255.0, 0xa5/255.0, 0xaf/255.0},
+            {0x00/255.0, 0x7e/255.0, 0x6d/255.0, 0xdf/255.0},
+            {0x00/255.0, 0x7e/255.0, 0x6d/255.0, 0x00/255.0}
+         },
+         {
+            {0x4e/255.0, 0xd2/255.0, 0xeb/255.0, 0x07/255.0},
+            {0x14/255.0, 0x98/255.0, 0xb1/255.0, 0x07/255.0},
+            {0x3a/255.0, 0xbe/255.0, 0xd7/255.0, 0xbb/255.0},
+            {0x14/255.0, 0x98/255.0, 0xb1/255.0, 0xaf/255.0}
+         },
+         {
+            {0x28/255.0, 0xac/255.0, 0xc5/255.0, 0xdf/255.0},
+            {0x28/255.0, 0xac/255.0, 0xc5/255.0, 0x13/255.0},
+            {0x3a/255.0, 0xbe/255.0, 0xd7/255.0, 0x8b/255.0},
+            {0x14/255.0, 0x98/255.0, 0xb1/255.0, 0x8b/255.0}
+         }
+      }
+   },
+   {
+      PIPE_FORMAT_ASTC_4x4,
+      {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+      {0x3e, 0x05, 0xf1, 0xec, 0xd9, 0x67, 0x33, 0xb7, 0x99, 0x50, 0xa3, 0xe3, 0x14, 0xd3, 0xd9, 0x34},
+      {
+         {
+            {0xf6/255.0, 0xde/255.0, 0xdb/255.0, 0xff/255.0},
+            {0xd9/255.0, 0xd1/255.0, 0xcc/255.0, 0xff/255.0},
+            {0xb5/255.0, 0xc1/255.0, 0xb9/255.0, 0xff/255.0},
+            {0x98/255.0, 0xb3/255.0, 0xaa/255.0, 0xff/255.0}
+         },
+         {
+            {0xcb/255.0, 0xc1/255.0, 0xc5/255.0, 0xff/255.0},
+            {0xcb/255.0, 0xc3/255.0, 0xc5/255.0, 0xff/255.0},
+            {0xd9/255.0, 0xce/255.0, 0xcc/255.0, 0xff/255.0},
+            {0xd9/255.0, 0xd1/255.0, 0xcc/255.0, 0xff/255.0}
+         },
+         {
+            {0xcb/255.0, 0xbc/255.0, 0xc5/255.0, 0xff/255.0},
+            {0xc7/255.0, 0xc1/255.0, 0xc3/255.0, 0xff/255.0},
+            {0xd3/255.0, 0xcc/255.0, 0xc9/255.0, 0xff/255.0},
+            {0xcf/255.0, 0xd1/255.0, 0xc7/255.0, 0xff/255.0}
+         },
+         {
+            {0xf6/255.0, 0xd0/255.0, 0xdb/255.0, 0xff/255.0},
+            {0xcf/255.0, 0xc7/255.0, 0xc7/255.0, 0xff/255.0},
+            {0x9f/255.0, 0xbc/255.0, 0xae/255.0, 0xff/255.0},
+            {0x78/255.0, 0xb3/255.0, 0x99/255.0, 0xff/255.0}
+         }
+      }
+   },
+
 
    /*
     * Standard 8-bit integer formats
@@ -37,36 +37,160 @@
 #include "u_format_pack.h"
 #include "util/u_cpu_detect.h"
 
-static void
-util_format_b8g8r8a8_unorm_unpack_rgba_8unorm_neon(uint8_t *restrict dst, const uint8_t *restrict src, unsigned width)
+/* Channel index meaning "fill this channel with a constant" below. */
+#define NEON_FILL -1
+
+/**
+ * Reorder the channels of 16 32-bit pixels at a time.  Returns the number of
+ * pixels done, the caller finishes the row with the generic code.
+ */
+static inline unsigned
+neon_swizzle_8unorm(uint8_t *restrict dst, const uint8_t *restrict src, unsigned width,
+                    int r, int g, int b, int a, uint8_t fill)
+{
+   const int swizzle[4] = { r, g, b, a };
+   unsigned x;
+
+   for (x = 0; x + 16 <= width; x += 16) {
+      uint8x16x4_t load = vld4q_u8(src + x * 4);
+      uint8x16x4_t swap;
+      for (unsigned i = 0; i < 4; i++)
+         swap.val[i] = swizzle[i] == NEON_FILL ? vdupq_n_u8(fill) : load.val[swizzle[i]];
+      vst4q_u8(dst + x * 4, swap);
+   }
+
+   return x;
+}
+
+/* Widen 16 bytes to floats the same way ubyte_to_float() does. */
+static inline void
+neon_ubyte_to_float(float32x4_t out[4], uint8x16_t v)
+{
+   const float32x4_t scale = vdupq_n_f32(1.0f / 255.0f);
+   uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+   uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+
+   out[0] = vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), scale);
+   out[1] = vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), scale);
+   out[2] = vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), scale);
+   out[3] = vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), scale);
+}
+
+static inline unsigned
+neon_unpack_8unorm_float(float *restrict dst, const uint8_t *restrict src, unsigned width,
+                         int r, int g, int b, int a)
 {
-   while (width >= 16) {
-      uint8x16x4_t load = vld4q_u8(src);
-      uint8x16x4_t swap = { .val = { load.val[2], load.val[1], load.val[0], load.val[3] } };
-      vst4q_u8(dst, swap);
-      width -= 16;
-      dst += 16 * 4;
-      src += 16 * 4;
+   const int swizzle[4] = { r, g, b, a };
+   unsigned x;
+
+   for (x = 0; x + 16 <= width; x += 16) {
+      uint8x16x4_t load = vld4q_u8(src + x * 4);
+      float32x4_t c[4][4];
+
+      for (unsigned i = 0; i < 4; i++) {
+         if (swizzle[i] == NEON_FILL) {
+            for (unsigned j = 0; j < 4; j++)
+               c[i][j] = vdupq_n_f32(1.0f);
+         } else {
+            neon_ubyte_to_float(c[i], load.val[swizzle[i]]);
+         }
+      }
+
+      for (unsigned j = 0; j < 4; j++) {
+         float32x4x4_t pixels = { .val = { c[0][j], c[1][j], c[2][j], c[3][j] } };
+         vst4q_f32(dst + (x + j * 4) * 4, pixels);
+      }
    }
-   if (width)
-      util_format_b8g8r8a8_unorm_unpack_rgba_8unorm(dst, src, width);
+
+   return x;
 }
 
+#define NEON_8UNORM_FORMAT(fmt, r, g, b, a)                                   \
+static void                                                                   \
+util_format_##fmt##_unpack_rgba_8unorm_neon(uint8_t *restrict dst,            \
+                                            const uint8_t *restrict src,      \
+                                            unsigned width)                   \
+{                                                                             \
+   unsigned x = neon_swizzle_8unorm(dst, src, width, r, g, b, a, 0xff);       \
+   util_format_##fmt##_unpack_rgba_8unorm(dst + x * 4, src + x * 4, width - x); \
+}                                                                             \
+                                                                              \
+static void                                                                   \
+util_format_##fmt##_unpack_rgba_float_neon(void *restrict dst,                \
+                                           const uint8_t *restrict src,       \
+                                           unsigned width)                    \
+{                                                                             \
+   unsigned x = neon_unpack_8unorm_float(dst, src, width, r, g, b, a);        \
+   util_format_##fmt##_unpack_rgba_float((float *)dst + x * 4, src + x * 4,   \
+                                         width - x);                          \
+}                                                                             \
+                                                                              \
+static void                                                                   \
+util_format_##fmt##_pack_rgba_8unorm_neon(uint8_t *restrict dst_row,          \
+                                          unsigned dst_stride,                \
+                                          const uint8_t *restrict src_row,    \
+                                          unsigned src_stride,                \
+                                          unsigned width, unsigned height)    \
+{                                                                             \
+   /* The swizzle is its own inverse for all the formats below. */           \
+   for (unsigned y = 0; y < height; y++) {                                    \
+      unsigned x = neon_swizzle_8unorm(dst_row, src_row, width,               \
+                                       r, g, b, a, 0);                        \
+      util_format_##fmt##_pack_rgba_8unorm(dst_row + x * 4, dst_stride,       \
+                                           src_row + x * 4, src_stride,       \
+                                           width - x, 1);                     \
+      dst_row += dst_stride;                                                  \
+      src_row += src_stride;                                                  \
+   }                                                                          \
+}
+
+NEON_8UNORM_FORMAT(b8g8r8a8_unorm, 2, 1, 0, 3)
+NEON_8UNORM_FORMAT(b8g8r8x8_unorm, 2, 1, 0, NEON_FILL)
+NEON_8UNORM_FORMAT(r8g8b8a8_unorm, 0, 1, 2, 3)
+NEON_8UNORM_FORMAT(r8g8b8x8_unorm, 0, 1, 2, NEON_FILL)
+
+#define NEON_UNPACK_ENTRY(FMT, fmt)                                           \
+   [PIPE_FORMAT_##FMT] = {                                                    \
+      .unpack_rgba_8unorm = &util_format_##fmt##_unpack_rgba_8unorm_neon,     \
+      .unpack_rgba = &util_format_##fmt##_unpack_rgba_float_neon,             \
+   }
+
+#define NEON_PACK_ENTRY(FMT, fmt)                                             \
+   [PIPE_FORMAT_##FMT] = {                                                    \
+      .pack_rgba_8unorm = &util_format_##fmt##_pack_rgba_8unorm_neon,         \
+      .pack_rgba_float = &util_format_##fmt##_pack_rgba_float,                \
+   }
+
 static const struct util_format_unpack_description util_format_unpack_descriptions_neon[] = {
-   [PIPE_FORMAT_B8G8R8A8_UNORM] = {
-      .unpack_rgba_8unorm = &util_format_b8g8r8a8_unorm_unpack_rgba_8unorm_neon,
-      .unpack_rgba = &util_format_b8g8r8a8_unorm_unpack_rgba_float,
-   },
+   NEON_UNPACK_ENTRY(B8G8R8A8_UNORM, b8g8r8a8_unorm),
+   NEON_UNPACK_ENTRY(B8G8R8X8_UNORM, b8g8r8x8_unorm),
+   NEON_UNPACK_ENTRY(R8G8B8A8_UNORM, r8g8b8a8_unorm),
+   NEON_UNPACK_ENTRY(R8G8B8X8_UNORM, r8g8b8x8_unorm),
 };
 
-const struct util_format_unpack_description *
-util_format_unpack_description_neon(enum pipe_format format)
+static const struct util_format_pack_description util_format_pack_descriptions_neon[] = {
+   NEON_PACK_ENTRY(B8G8R8A8_UNORM, b8g8r8a8_unorm),
+   NEON_PACK_ENTRY(B8G8R8X8_UNORM, b8g8r8x8_unorm),
+   NEON_PACK_ENTRY(R8G8B8A8_UNORM, r8g8b8a8_unorm),
+   NEON_PACK_ENTRY(R8G8B8X8_UNORM, r8g8b8x8_unorm),
+};
+
+static bool
+util_format_neon_supported(void)
 {
    /* CPU detect for NEON support.  On arm64, it's implied. */
 #if DETECT_ARCH_ARM
-   if (!util_get_cpu_caps()->has_neon)
-      return NULL;
+   return util_get_cpu_caps()->has_neon;
+#else
+   return true;
 #endif
+}
+
+const struct util_format_unpack_description *
+util_format_unpack_description_neon(enum pipe_format format)
+{
+   if (!util_format_neon_supported())
+      return NULL;
 
    if (format >= ARRAY_SIZE(util_format_unpack_descriptions_neon))
       return NULL;
@@ -77,4 +201,19 @@ util_format_unpack_description_neon(enum pipe_format format)
    return &util_format_unpack_descriptions_neon[format];
 }
 
+const struct util_format_pack_description *
+util_format_pack_description_neon(enum pipe_format format)
+{
+   if (!util_format_neon_supported())
+      return NULL;
+
+   if (format >= ARRAY_SIZE(util_format_pack_descriptions_neon))
+      return NULL;
+
+   if (!util_format_pack_descriptions_neon[format].pack_rgba_8unorm)
+      return NULL;
+
+   return &util_format_pack_descriptions_neon[format];
+}
+
 #endif /* DETECT_ARCH_AARCH64 | DETECT_ARCH_ARM */
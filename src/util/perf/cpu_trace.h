@@ -147,6 +147,18 @@ _mesa_trace_scope_end(UNUSED int *scope)
 
 #endif /* __has_attribute(cleanup) && __has_attribute(unused) */
 
+/* Explicit begin/end pairs, for slices that don't match a C scope. */
+#define MESA_TRACE_BEGIN(name)                                               \
+   do {                                                                      \
+      _MESA_TRACE_BEGIN(name);                                               \
+      _MESA_GPUVIS_TRACE_BEGIN(name);                                        \
+   } while (0)
+#define MESA_TRACE_END()                                                     \
+   do {                                                                      \
+      _MESA_GPUVIS_TRACE_END();                                              \
+      _MESA_TRACE_END();                                                     \
+   } while (0)
+
 #define MESA_TRACE_SCOPE(name) _MESA_TRACE_SCOPE(name)
 #define MESA_TRACE_SCOPE_FLOW(name, id) _MESA_TRACE_SCOPE_FLOW(name, id)
 #define MESA_TRACE_FUNC() _MESA_TRACE_SCOPE(__func__)
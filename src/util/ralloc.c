@@ -959,6 +959,35 @@ gc_sweep_end(gc_ctx *ctx)
    ctx->rubbish = NULL;
 }
 
+void
+gc_adopt(gc_ctx *new_ctx, gc_ctx *old_ctx)
+{
+   assert(!new_ctx->rubbish && !old_ctx->rubbish);
+
+   for (unsigned i = 0; i < NUM_FREELIST_BUCKETS; i++) {
+      unsigned obj_size = gc_bucket_obj_size(i);
+      list_for_each_entry(gc_slab, slab, &old_ctx->slabs[i].slabs, link) {
+         slab->ctx = new_ctx;
+
+         /* gc_mark_live() flips the generation bit, so objects have to agree
+          * with their new context about the current generation.
+          */
+         if (old_ctx->current_gen != new_ctx->current_gen) {
+            for (char *ptr = (char*)(slab + 1); ptr != slab->next_available; ptr += obj_size)
+               ((gc_block_header *)ptr)->flags ^= CURRENT_GENERATION;
+         }
+      }
+
+      list_splicetail(&old_ctx->slabs[i].slabs, &new_ctx->slabs[i].slabs);
+      list_inithead(&old_ctx->slabs[i].slabs);
+      list_splicetail(&old_ctx->slabs[i].free_slabs, &new_ctx->slabs[i].free_slabs);
+      list_inithead(&old_ctx->slabs[i].free_slabs);
+   }
+
+   /* The slabs and the allocations too large for them. */
+   ralloc_adopt(new_ctx, old_ctx);
+}
+
 /***************************************************************************
  * Linear allocator for short-lived allocations.
  ***************************************************************************
@@ -512,6 +512,12 @@ void gc_sweep_start(gc_ctx *ctx);
 void gc_mark_live(gc_ctx *ctx, const void *mem);
 void gc_sweep_end(gc_ctx *ctx);
 
+/**
+ * Move all allocations of \p old_ctx to \p new_ctx, leaving \p old_ctx
+ * empty.  Neither context may be in the middle of a sweep.
+ */
+void gc_adopt(gc_ctx *new_ctx, gc_ctx *old_ctx);
+
 /**
  * Declare C++ new and delete operators which use ralloc.
  *
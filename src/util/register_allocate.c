@@ -71,12 +71,16 @@
  */
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "blob.h"
 #include "ralloc.h"
 #include "util/bitset.h"
+#include "util/u_atomic.h"
+#include "util/u_debug.h"
 #include "util/u_dynarray.h"
+#include "util/u_process.h"
 #include "u_math.h"
 #include "register_allocate.h"
 #include "register_allocate_internal.h"
@@ -487,9 +491,45 @@ ra_get_adjacency_bit_index(unsigned n1, unsigned n2)
    return ra_get_num_adjacency_bits(k1) + k2;
 }
 
+#define RA_ADJACENCY_BLOCK_WORDS \
+   BITSET_WORDS(RA_ADJACENCY_BLOCK_NODES * RA_ADJACENCY_BLOCK_NODES)
+
+static uint64_t
+ra_get_num_adjacency_blocks(unsigned n)
+{
+   uint64_t blocks = DIV_ROUND_UP(n, RA_ADJACENCY_BLOCK_NODES);
+   return (blocks * (blocks + 1)) / 2;
+}
+
+/**
+ * Returns the tile of the blocked matrix holding the (n1, n2) bit, and the
+ * index of the bit within it.  Like the dense matrix, the layout only
+ * depends on the node numbers so it doesn't change when the graph grows.
+ */
+static BITSET_WORD **
+ra_get_adjacency_block(struct ra_graph *g, unsigned n1, unsigned n2,
+                       unsigned *bit)
+{
+   assert(n1 != n2);
+   unsigned k1 = MAX2(n1, n2);
+   unsigned k2 = MIN2(n1, n2);
+   uint64_t b1 = k1 / RA_ADJACENCY_BLOCK_NODES;
+   uint64_t b2 = k2 / RA_ADJACENCY_BLOCK_NODES;
+
+   *bit = (k1 % RA_ADJACENCY_BLOCK_NODES) * RA_ADJACENCY_BLOCK_NODES +
+          (k2 % RA_ADJACENCY_BLOCK_NODES);
+   return &g->adjacency_blocks[(b1 * (b1 + 1)) / 2 + b2];
+}
+
 static bool
 ra_test_adjacency_bit(struct ra_graph *g, unsigned n1, unsigned n2)
 {
+   if (g->adjacency_blocks) {
+      unsigned bit;
+      BITSET_WORD *block = *ra_get_adjacency_block(g, n1, n2, &bit);
+      return block && BITSET_TEST(block, bit);
+   }
+
    uint64_t index = ra_get_adjacency_bit_index(n1, n2);
    return BITSET_TEST(g->adjacency, index);
 }
@@ -497,14 +537,31 @@ ra_test_adjacency_bit(struct ra_graph *g, unsigned n1, unsigned n2)
 static void
 ra_set_adjacency_bit(struct ra_graph *g, unsigned n1, unsigned n2)
 {
-   unsigned index = ra_get_adjacency_bit_index(n1, n2);
+   if (g->adjacency_blocks) {
+      unsigned bit;
+      BITSET_WORD **block = ra_get_adjacency_block(g, n1, n2, &bit);
+      if (!*block)
+         *block = rzalloc_array(g, BITSET_WORD, RA_ADJACENCY_BLOCK_WORDS);
+      BITSET_SET(*block, bit);
+      return;
+   }
+
+   uint64_t index = ra_get_adjacency_bit_index(n1, n2);
    BITSET_SET(g->adjacency, index);
 }
 
 static void
 ra_clear_adjacency_bit(struct ra_graph *g, unsigned n1, unsigned n2)
 {
-   unsigned index = ra_get_adjacency_bit_index(n1, n2);
+   if (g->adjacency_blocks) {
+      unsigned bit;
+      BITSET_WORD *block = *ra_get_adjacency_block(g, n1, n2, &bit);
+      if (block)
+         BITSET_CLEAR(block, bit);
+      return;
+   }
+
+   uint64_t index = ra_get_adjacency_bit_index(n1, n2);
    BITSET_CLEAR(g->adjacency, index);
 }
 
@@ -546,9 +603,33 @@ ra_realloc_interference_graph(struct ra_graph *g, unsigned int alloc)
    assert(g->alloc % BITSET_WORDBITS == 0);
    alloc = align(alloc, BITSET_WORDBITS);
    g->nodes = rerzalloc(g, g->nodes, struct ra_node, g->alloc, alloc);
-   g->adjacency = rerzalloc(g, g->adjacency, BITSET_WORD,
-                            BITSET_WORDS(ra_get_num_adjacency_bits(g->alloc)),
-                            BITSET_WORDS(ra_get_num_adjacency_bits(alloc)));
+
+   if (alloc > RA_SPARSE_ADJACENCY_NODES) {
+      uint64_t old_blocks = g->adjacency_blocks ?
+                            ra_get_num_adjacency_blocks(g->alloc) : 0;
+      g->adjacency_blocks = rerzalloc(g, g->adjacency_blocks, BITSET_WORD *,
+                                      old_blocks,
+                                      ra_get_num_adjacency_blocks(alloc));
+
+      /* Moving from the dense matrix: the adjacency lists hold the same
+       * information, so rebuild the tiles from them.
+       */
+      if (g->adjacency) {
+         for (unsigned n = 0; n < g->alloc; n++) {
+            util_dynarray_foreach(&g->nodes[n].adjacency_list,
+                                  unsigned int, n2p) {
+               if (*n2p < n)
+                  ra_set_adjacency_bit(g, n, *n2p);
+            }
+         }
+         ralloc_free(g->adjacency);
+         g->adjacency = NULL;
+      }
+   } else {
+      g->adjacency = rerzalloc(g, g->adjacency, BITSET_WORD,
+                               BITSET_WORDS(ra_get_num_adjacency_bits(g->alloc)),
+                               BITSET_WORDS(ra_get_num_adjacency_bits(alloc)));
+   }
 
    /* Initialize new nodes. */
    for (unsigned i = g->alloc; i < alloc; i++) {
@@ -653,6 +734,75 @@ ra_reset_node_interference(struct ra_graph *g, unsigned int n)
    util_dynarray_clear(&g->nodes[n].adjacency_list);
 }
 
+void
+ra_graph_serialize(const struct ra_graph *g, struct blob *blob)
+{
+   blob_write_uint32(blob, g->count);
+
+   for (unsigned int n = 0; n < g->count; n++) {
+      const struct ra_node *node = &g->nodes[n];
+
+      blob_write_uint32(blob, node->class);
+      blob_write_uint32(blob, node->forced_reg);
+      blob_write_uint32(blob, fui(node->spill_cost));
+
+      /* Each interference is written once, by its higher numbered node. */
+      unsigned int lower = 0;
+      util_dynarray_foreach(&node->adjacency_list, unsigned int, n2p) {
+         if (*n2p < n)
+            lower++;
+      }
+
+      blob_write_uint32(blob, lower);
+      util_dynarray_foreach(&node->adjacency_list, unsigned int, n2p) {
+         if (*n2p < n)
+            blob_write_uint32(blob, *n2p);
+      }
+   }
+}
+
+struct ra_graph *
+ra_graph_deserialize(struct ra_regs *regs, struct blob_reader *blob)
+{
+   unsigned int count = blob_read_uint32(blob);
+   struct ra_graph *g = ra_alloc_interference_graph(regs, count);
+
+   for (unsigned int n = 0; n < count && !blob->overrun; n++) {
+      unsigned int class = blob_read_uint32(blob);
+      if (class >= regs->class_count) {
+         blob->overrun = true;
+         break;
+      }
+
+      unsigned int forced_reg = blob_read_uint32(blob);
+      if (forced_reg != NO_REG && forced_reg >= regs->count) {
+         blob->overrun = true;
+         break;
+      }
+
+      g->nodes[n].class = class;
+      g->nodes[n].forced_reg = forced_reg;
+      g->nodes[n].spill_cost = uif(blob_read_uint32(blob));
+
+      unsigned int lower = blob_read_uint32(blob);
+      for (unsigned int i = 0; i < lower && !blob->overrun; i++) {
+         unsigned int n2 = blob_read_uint32(blob);
+         if (n2 >= n) {
+            blob->overrun = true;
+            break;
+         }
+         ra_add_node_interference(g, n, n2);
+      }
+   }
+
+   if (blob->overrun) {
+      ralloc_free(g);
+      return NULL;
+   }
+
+   return g;
+}
+
 static void
 update_pq_info(struct ra_graph *g, unsigned int n)
 {
@@ -975,9 +1125,46 @@ ra_select(struct ra_graph *g)
    return true;
 }
 
+DEBUG_GET_ONCE_OPTION(ra_dump_path, "MESA_RA_DUMP_PATH", NULL)
+
+/**
+ * Writes the register set and graph to a new file in MESA_RA_DUMP_PATH, in
+ * the format the ra_bench tool reads.
+ */
+static void
+ra_dump_graph(const struct ra_graph *g, const char *path)
+{
+   static uint32_t dump_count;
+   struct blob blob;
+
+   blob_init(&blob);
+   ra_set_serialize(g->regs, &blob);
+   ra_graph_serialize(g, &blob);
+
+   if (!blob.out_of_memory) {
+      char filename[1024];
+      snprintf(filename, sizeof(filename), "%s/%s-%u.ra", path,
+               util_get_process_name(), p_atomic_inc_return(&dump_count));
+
+      FILE *f = fopen(filename, "wb");
+      if (f) {
+         fwrite(blob.data, 1, blob.size, f);
+         fclose(f);
+      } else {
+         fprintf(stderr, "MESA_RA_DUMP_PATH: can't open %s\n", filename);
+      }
+   }
+
+   blob_finish(&blob);
+}
+
 bool
 ra_allocate(struct ra_graph *g)
 {
+   const char *dump_path = debug_get_option_ra_dump_path();
+   if (unlikely(dump_path))
+      ra_dump_graph(g, dump_path);
+
    ra_simplify(g);
    return ra_select(g);
 }
@@ -120,6 +120,21 @@ void ra_add_node_interference(struct ra_graph *g,
 void ra_reset_node_interference(struct ra_graph *g, unsigned int n);
 /** @} */
 
+/** @{ Interference graph serialization
+ *
+ * Captures the node classes, forced registers, spill costs and
+ * interference of a graph so that it can be replayed against the same
+ * register set (see ra_set_serialize()) outside of the driver, e.g. by
+ * the ra_bench tool.  The select_reg callback is not captured.
+ *
+ * Setting MESA_RA_DUMP_PATH to a directory makes ra_allocate() write every
+ * graph it colors there, together with its register set.
+ */
+void ra_graph_serialize(const struct ra_graph *g, struct blob *blob);
+struct ra_graph *ra_graph_deserialize(struct ra_regs *regs,
+                                      struct blob_reader *blob);
+/** @} */
+
 /** @{ Graph-coloring register allocation */
 bool ra_allocate(struct ra_graph *g);
 
@@ -38,6 +38,14 @@ extern "C" {
 #define class klass
 #endif
 
+/**
+ * Graphs allocated with (or grown to) more than this many nodes track
+ * interference with ra_graph::adjacency_blocks instead of the dense
+ * triangular bit matrix.
+ */
+#define RA_SPARSE_ADJACENCY_NODES 4096
+#define RA_ADJACENCY_BLOCK_NODES 64
+
 struct ra_reg {
    BITSET_WORD *conflicts;
    struct util_dynarray conflict_list;
@@ -130,7 +138,23 @@ struct ra_graph {
     * the variables that need register allocation.
     */
    struct ra_node *nodes;
+
+   /**
+    * Triangular interference bit matrix, used while the graph is small
+    * enough that n^2/2 bits are cheap.  NULL once the graph switches to
+    * adjacency_blocks.
+    */
    BITSET_WORD *adjacency;
+
+   /**
+    * Blocked interference matrix for large graphs.  The triangular matrix is
+    * split into RA_ADJACENCY_BLOCK_NODES x RA_ADJACENCY_BLOCK_NODES tiles
+    * which are only allocated once an interference lands in them.  Live
+    * ranges mostly interfere with nodes numbered close to them, so only the
+    * tiles near the diagonal end up populated.
+    */
+   BITSET_WORD **adjacency_blocks;
+
    unsigned int count; /**< count of nodes. */
 
    unsigned int alloc; /**< count of nodes allocated. */
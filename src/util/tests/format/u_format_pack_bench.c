@@ -0,0 +1,182 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Throughput benchmark for the per-row pack/unpack functions, comparing the
+ * generic code with whatever util_format_{pack,unpack}_description() picks
+ * for this CPU.
+ *
+ * Usage: u_format_pack_bench [-i iterations] [-s size]
+ *
+ * Every function converts a size x size image and the average throughput is
+ * reported in megapixels per second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/format/u_format.h"
+#include "util/os_time.h"
+#include "util/u_math.h"
+
+static const enum pipe_format formats[] = {
+   PIPE_FORMAT_R8G8B8A8_UNORM,
+   PIPE_FORMAT_B8G8R8A8_UNORM,
+   PIPE_FORMAT_B8G8R8X8_UNORM,
+   PIPE_FORMAT_R10G10B10A2_UNORM,
+   PIPE_FORMAT_R16G16B16A16_FLOAT,
+   PIPE_FORMAT_Z16_UNORM,
+   PIPE_FORMAT_Z24_UNORM_S8_UINT,
+   PIPE_FORMAT_S8_UINT_Z24_UNORM,
+};
+
+enum op {
+   OP_UNPACK_8UNORM,
+   OP_UNPACK_FLOAT,
+   OP_PACK_8UNORM,
+   OP_PACK_FLOAT,
+   OP_UNPACK_Z_FLOAT,
+   OP_UNPACK_Z_32UNORM,
+   OP_COUNT,
+};
+
+static const char *op_names[OP_COUNT] = {
+   "unpack_rgba_8unorm",
+   "unpack_rgba",
+   "pack_rgba_8unorm",
+   "pack_rgba_float",
+   "unpack_z_float",
+   "unpack_z_32unorm",
+};
+
+static bool
+has_op(const struct util_format_unpack_description *unpack,
+       const struct util_format_pack_description *pack, enum op op)
+{
+   switch (op) {
+   case OP_UNPACK_8UNORM: return unpack->unpack_rgba_8unorm;
+   case OP_UNPACK_FLOAT: return unpack->unpack_rgba;
+   case OP_PACK_8UNORM: return pack->pack_rgba_8unorm;
+   case OP_PACK_FLOAT: return pack->pack_rgba_float;
+   case OP_UNPACK_Z_FLOAT: return unpack->unpack_z_float;
+   case OP_UNPACK_Z_32UNORM: return unpack->unpack_z_32unorm;
+   default: return false;
+   }
+}
+
+static double
+bench(const struct util_format_unpack_description *unpack,
+      const struct util_format_pack_description *pack, enum op op,
+      uint8_t *packed, unsigned packed_stride, uint8_t *unpacked,
+      unsigned size, unsigned iterations)
+{
+   unsigned unpacked_stride = size * 16;
+
+   int64_t start = os_time_get_nano();
+   for (unsigned n = 0; n < iterations; n++) {
+      switch (op) {
+      case OP_UNPACK_8UNORM:
+         for (unsigned y = 0; y < size; y++) {
+            unpack->unpack_rgba_8unorm(unpacked + y * unpacked_stride,
+                                       packed + y * packed_stride, size);
+         }
+         break;
+      case OP_UNPACK_FLOAT:
+         for (unsigned y = 0; y < size; y++) {
+            unpack->unpack_rgba(unpacked + y * unpacked_stride,
+                                packed + y * packed_stride, size);
+         }
+         break;
+      case OP_PACK_8UNORM:
+         pack->pack_rgba_8unorm(packed, packed_stride, unpacked,
+                                unpacked_stride, size, size);
+         break;
+      case OP_PACK_FLOAT:
+         pack->pack_rgba_float(packed, packed_stride, (float *)unpacked,
+                               unpacked_stride, size, size);
+         break;
+      case OP_UNPACK_Z_FLOAT:
+         unpack->unpack_z_float((float *)unpacked, unpacked_stride,
+                                packed, packed_stride, size, size);
+         break;
+      case OP_UNPACK_Z_32UNORM:
+         unpack->unpack_z_32unorm((uint32_t *)unpacked, unpacked_stride,
+                                  packed, packed_stride, size, size);
+         break;
+      default:
+         break;
+      }
+   }
+   int64_t elapsed = os_time_get_nano() - start;
+
+   return (double)size * size * iterations / (elapsed / 1000.0);
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned iterations = 16;
+   unsigned size = 1024;
+
+   for (int i = 1; i < argc; i++) {
+      int value = i + 1 < argc ? MAX2(atoi(argv[i + 1]), 1) : 0;
+
+      if (!strcmp(argv[i], "-i") && value) {
+         iterations = value;
+      } else if (!strcmp(argv[i], "-s") && value) {
+         size = value;
+      } else {
+         fprintf(stderr, "usage: %s [-i iterations] [-s size]\n", argv[0]);
+         return 1;
+      }
+      i++;
+   }
+
+   /* Up to 8 bytes per packed pixel and 16 per unpacked one.  Values in the
+    * float image are kept in [0, 1] by using random bytes below 0x3f.
+    */
+   unsigned packed_stride = size * 8;
+   uint8_t *packed = malloc((size_t)packed_stride * size);
+   uint8_t *unpacked = malloc((size_t)size * size * 16);
+   srand(0);
+   for (size_t i = 0; i < (size_t)packed_stride * size; i++)
+      packed[i] = rand();
+   for (size_t i = 0; i < (size_t)size * size * 16; i++)
+      unpacked[i] = rand() % 0x3f;
+
+   printf("%ux%u\n", size, size);
+   printf("%-24s %-20s %14s %14s\n", "format", "function", "generic MP/s",
+          "selected MP/s");
+
+   for (unsigned i = 0; i < ARRAY_SIZE(formats); i++) {
+      const struct util_format_unpack_description *unpack =
+         util_format_unpack_description(formats[i]);
+      const struct util_format_pack_description *pack =
+         util_format_pack_description(formats[i]);
+      const struct util_format_unpack_description *ref_unpack =
+         util_format_unpack_description_generic(formats[i]);
+      const struct util_format_pack_description *ref_pack =
+         util_format_pack_description_generic(formats[i]);
+
+      for (enum op op = 0; op < OP_COUNT; op++) {
+         if (!has_op(ref_unpack, ref_pack, op))
+            continue;
+
+         double generic = bench(ref_unpack, ref_pack, op, packed,
+                                packed_stride, unpacked, size, iterations);
+         double selected = bench(unpack, pack, op, packed,
+                                 packed_stride, unpacked, size, iterations);
+
+         printf("%-24s %-20s %14.1f %14.1f\n",
+                util_format_short_name(formats[i]), op_names[op],
+                generic, selected);
+      }
+   }
+
+   free(unpacked);
+   free(packed);
+
+   return 0;
+}
@@ -28,8 +28,11 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <float.h>
+#include <math.h>
 
+#include "util/detect_arch.h"
 #include "util/half_float.h"
 #include "util/u_math.h"
 #include "util/format/u_format.h"
@@ -731,6 +734,150 @@ test_format_norm_flags(const struct util_format_description *format_desc)
    return success;
 }
 
+/*
+ * The CPU-specific pack/unpack functions must give the same bits as the
+ * generic ones.  Rows of every width up to SIMD_TEST_WIDTH go through both,
+ * so the vector loops as well as the scalar tails are covered, and the
+ * output buffers are compared past the end to catch overruns.
+ */
+#define SIMD_TEST_WIDTH 67
+#define SIMD_TEST_HEIGHT 2
+#define SIMD_TEST_STRIDE (SIMD_TEST_WIDTH * 16 + 16)
+
+static void
+fill_random(void *data, size_t size)
+{
+   uint8_t *bytes = data;
+
+   for (size_t i = 0; i < size; i++)
+      bytes[i] = rand();
+}
+
+static void
+fill_random_float(float *data, unsigned count)
+{
+   static const float special[] = {
+      0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 2.0f, NAN, INFINITY, -INFINITY,
+      0.5f / 255.0f, 1.5f / 255.0f, 0.5f / 1023.0f, 1e-40f, 65504.0f, 1e6f,
+   };
+
+   for (unsigned i = 0; i < count; i++) {
+      unsigned r = rand();
+
+      if (r % 4 == 0)
+         data[i] = special[(r / 4) % ARRAY_SIZE(special)];
+      else
+         data[i] = (float)rand() / RAND_MAX * 1.5f - 0.25f;
+   }
+}
+
+static bool
+compare_simd_floats(const float *a, const float *b, unsigned count)
+{
+   for (unsigned i = 0; i < count; i++) {
+      if (memcmp(&a[i], &b[i], sizeof(float)) && !(isnan(a[i]) && isnan(b[i])))
+         return false;
+   }
+
+   return true;
+}
+
+static bool
+test_format_simd(const struct util_format_description *format_desc,
+                 const char *isa,
+                 const struct util_format_unpack_description *unpack,
+                 const struct util_format_pack_description *pack)
+{
+   enum pipe_format format = format_desc->format;
+   const struct util_format_unpack_description *ref_unpack =
+      util_format_unpack_description_generic(format);
+   const struct util_format_pack_description *ref_pack =
+      util_format_pack_description_generic(format);
+   static uint8_t src[SIMD_TEST_HEIGHT * SIMD_TEST_STRIDE];
+   static uint8_t dst[2][SIMD_TEST_HEIGHT * SIMD_TEST_STRIDE];
+   bool success = true;
+
+   if (!unpack && !pack)
+      return true;
+
+   printf("Testing util_format_%s_%s ...\n", format_desc->short_name, isa);
+   fflush(stdout);
+
+#define CHECK_SIMD(name, compare)                                          \
+   if (!(compare)) {                                                      \
+      printf("FAILED: %s %s differs from the generic code for width %u\n", \
+             isa, #name, width);                                          \
+      success = false;                                                    \
+   }
+
+   for (unsigned width = 1; width <= SIMD_TEST_WIDTH; width++) {
+      fill_random(src, sizeof(src));
+      fill_random(dst[0], sizeof(dst[0]));
+      memcpy(dst[1], dst[0], sizeof(dst[0]));
+
+      if (unpack && unpack->unpack_rgba) {
+         unpack->unpack_rgba(dst[0], src, width);
+         ref_unpack->unpack_rgba(dst[1], src, width);
+         CHECK_SIMD(unpack_rgba,
+                    compare_simd_floats((float *)dst[0], (float *)dst[1],
+                                        sizeof(dst[0]) / sizeof(float)));
+      }
+
+      if (unpack && unpack->unpack_rgba_8unorm) {
+         unpack->unpack_rgba_8unorm(dst[0], src, width);
+         ref_unpack->unpack_rgba_8unorm(dst[1], src, width);
+         CHECK_SIMD(unpack_rgba_8unorm, !memcmp(dst[0], dst[1], sizeof(dst[0])));
+      }
+
+      if (unpack && unpack->unpack_z_float) {
+         unpack->unpack_z_float((float *)dst[0], SIMD_TEST_STRIDE,
+                                src, SIMD_TEST_STRIDE, width, SIMD_TEST_HEIGHT);
+         ref_unpack->unpack_z_float((float *)dst[1], SIMD_TEST_STRIDE,
+                                    src, SIMD_TEST_STRIDE, width, SIMD_TEST_HEIGHT);
+         CHECK_SIMD(unpack_z_float,
+                    compare_simd_floats((float *)dst[0], (float *)dst[1],
+                                        sizeof(dst[0]) / sizeof(float)));
+      }
+
+      if (unpack && unpack->unpack_z_32unorm) {
+         unpack->unpack_z_32unorm((uint32_t *)dst[0], SIMD_TEST_STRIDE,
+                                  src, SIMD_TEST_STRIDE, width, SIMD_TEST_HEIGHT);
+         ref_unpack->unpack_z_32unorm((uint32_t *)dst[1], SIMD_TEST_STRIDE,
+                                      src, SIMD_TEST_STRIDE, width, SIMD_TEST_HEIGHT);
+         CHECK_SIMD(unpack_z_32unorm, !memcmp(dst[0], dst[1], sizeof(dst[0])));
+      }
+
+      if (unpack && unpack->unpack_s_8uint) {
+         unpack->unpack_s_8uint(dst[0], SIMD_TEST_STRIDE,
+                                src, SIMD_TEST_STRIDE, width, SIMD_TEST_HEIGHT);
+         ref_unpack->unpack_s_8uint(dst[1], SIMD_TEST_STRIDE,
+                                    src, SIMD_TEST_STRIDE, width, SIMD_TEST_HEIGHT);
+         CHECK_SIMD(unpack_s_8uint, !memcmp(dst[0], dst[1], sizeof(dst[0])));
+      }
+
+      if (pack && pack->pack_rgba_8unorm) {
+         pack->pack_rgba_8unorm(dst[0], SIMD_TEST_STRIDE,
+                                src, SIMD_TEST_STRIDE, width, SIMD_TEST_HEIGHT);
+         ref_pack->pack_rgba_8unorm(dst[1], SIMD_TEST_STRIDE,
+                                    src, SIMD_TEST_STRIDE, width, SIMD_TEST_HEIGHT);
+         CHECK_SIMD(pack_rgba_8unorm, !memcmp(dst[0], dst[1], sizeof(dst[0])));
+      }
+
+      if (pack && pack->pack_rgba_float) {
+         fill_random_float((float *)src, sizeof(src) / sizeof(float));
+         pack->pack_rgba_float(dst[0], SIMD_TEST_STRIDE,
+                               (float *)src, SIMD_TEST_STRIDE, width, SIMD_TEST_HEIGHT);
+         ref_pack->pack_rgba_float(dst[1], SIMD_TEST_STRIDE,
+                                   (float *)src, SIMD_TEST_STRIDE, width, SIMD_TEST_HEIGHT);
+         CHECK_SIMD(pack_rgba_float, !memcmp(dst[0], dst[1], sizeof(dst[0])));
+      }
+   }
+
+#undef CHECK_SIMD
+
+   return success;
+}
+
 typedef bool
 (*test_func_t)(const struct util_format_description *format_desc,
                const struct util_format_test_case *test);
@@ -857,6 +1004,22 @@ test_all(void)
 
       TEST_FORMAT_METADATA(norm_flags);
 
+#if (DETECT_ARCH_X86 || DETECT_ARCH_X86_64) && defined(USE_SSE41) && !defined(NO_FORMAT_ASM)
+      if (!test_format_simd(format_desc, "avx2",
+                            util_format_unpack_description_avx2(format),
+                            util_format_pack_description_avx2(format)))
+         success = false;
+      if (!test_format_simd(format_desc, "sse41",
+                            util_format_unpack_description_sse41(format),
+                            util_format_pack_description_sse41(format)))
+         success = false;
+#elif (DETECT_ARCH_AARCH64 || DETECT_ARCH_ARM) && !defined(NO_FORMAT_ASM) && !defined(__SOFTFP__)
+      if (!test_format_simd(format_desc, "neon",
+                            util_format_unpack_description_neon(format),
+                            util_format_pack_description_neon(format)))
+         success = false;
+#endif
+
 #     undef TEST_ONE_FUNC
 #     undef TEST_ONE_FORMAT
    }
@@ -0,0 +1,197 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Throughput benchmark for the CPU decoders of compressed formats, as used
+ * when uploading textures in formats the driver doesn't support.
+ *
+ * Usage: u_format_transcode_bench [-i iterations] [-s size] [-t threads]
+ *
+ * For every format a size x size image of random blocks is decoded to
+ * RGBA8, and decoded and re-encoded to DXT5, and the average throughput is
+ * reported in megapixels per second.  With more than one thread the image
+ * is split into strips of block rows like st/mesa does on upload.  Random
+ * ASTC blocks are often invalid and decode to the error color, so ASTC
+ * numbers are only comparable with each other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/format/u_format.h"
+#include "util/os_time.h"
+#include "util/u_math.h"
+#include "util/u_queue.h"
+
+static const enum pipe_format formats[] = {
+   PIPE_FORMAT_ETC1_RGB8,
+   PIPE_FORMAT_ETC2_RGB8,
+   PIPE_FORMAT_ETC2_RGBA8,
+   PIPE_FORMAT_BPTC_RGBA_UNORM,
+   PIPE_FORMAT_ASTC_4x4,
+   PIPE_FORMAT_ASTC_6x6,
+   PIPE_FORMAT_ASTC_8x8,
+   PIPE_FORMAT_ASTC_12x12,
+};
+
+struct strip {
+   enum pipe_format format;
+   bool transcode;
+   const uint8_t *src;
+   unsigned src_stride;
+   uint8_t *dst;
+   unsigned dst_stride;
+   uint8_t *tmp;
+   unsigned width, height;
+   struct util_queue_fence fence;
+};
+
+static void
+run_strip(void *data, void *gdata, int thread_index)
+{
+   struct strip *strip = data;
+   const struct util_format_pack_description *dxt5 =
+      util_format_pack_description(PIPE_FORMAT_DXT5_RGBA);
+
+   if (!strip->transcode) {
+      util_format_unpack_rgba_8unorm_rect(strip->format,
+                                          strip->dst, strip->dst_stride,
+                                          strip->src, strip->src_stride,
+                                          strip->width, strip->height);
+      return;
+   }
+
+   util_format_unpack_rgba_8unorm_rect(strip->format,
+                                       strip->tmp, strip->width * 4,
+                                       strip->src, strip->src_stride,
+                                       strip->width, strip->height);
+   dxt5->pack_rgba_8unorm(strip->dst, strip->dst_stride,
+                          strip->tmp, strip->width * 4,
+                          strip->width, strip->height);
+}
+
+static double
+bench(struct util_queue *queue, unsigned num_threads,
+      enum pipe_format format, bool transcode,
+      const uint8_t *src, unsigned size, unsigned iterations)
+{
+   const struct util_format_description *desc = util_format_description(format);
+   unsigned src_stride = DIV_ROUND_UP(size, desc->block.width) *
+                         desc->block.bits / 8;
+   unsigned dst_stride = transcode ? size / 4 * 16 : size * 4;
+
+   /* Strips start on a block row of both formats. */
+   unsigned rows = DIV_ROUND_UP(size, num_threads);
+   unsigned strip_align = desc->block.height;
+   while (transcode && strip_align % 4)
+      strip_align += desc->block.height;
+   rows = DIV_ROUND_UP(rows, strip_align) * strip_align;
+
+   unsigned num_strips = DIV_ROUND_UP(size, rows);
+   struct strip *strips = calloc(num_strips, sizeof(*strips));
+   uint8_t *dst = malloc((size_t)dst_stride * size);
+   uint8_t *tmp = transcode ? malloc((size_t)size * size * 4) : NULL;
+
+   for (unsigned i = 0; i < num_strips; i++) {
+      unsigned y = i * rows;
+
+      strips[i].format = format;
+      strips[i].transcode = transcode;
+      strips[i].src = src + y / desc->block.height * src_stride;
+      strips[i].src_stride = src_stride;
+      strips[i].dst = dst + (transcode ? y / 4 : y) * dst_stride;
+      strips[i].dst_stride = dst_stride;
+      strips[i].tmp = tmp ? tmp + (size_t)y * size * 4 : NULL;
+      strips[i].width = size;
+      strips[i].height = MIN2(rows, size - y);
+   }
+
+   int64_t start = os_time_get_nano();
+   for (unsigned n = 0; n < iterations; n++) {
+      if (num_strips == 1) {
+         run_strip(&strips[0], NULL, 0);
+         continue;
+      }
+
+      for (unsigned i = 0; i < num_strips; i++) {
+         util_queue_fence_init(&strips[i].fence);
+         util_queue_add_job(queue, &strips[i], &strips[i].fence,
+                            run_strip, NULL, 0);
+      }
+      for (unsigned i = 0; i < num_strips; i++) {
+         util_queue_fence_wait(&strips[i].fence);
+         util_queue_fence_destroy(&strips[i].fence);
+      }
+   }
+   int64_t elapsed = os_time_get_nano() - start;
+
+   free(tmp);
+   free(dst);
+   free(strips);
+
+   return (double)size * size * iterations / (elapsed / 1000.0);
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned iterations = 4;
+   unsigned size = 2048;
+   unsigned num_threads = 1;
+
+   for (int i = 1; i < argc; i++) {
+      int value = i + 1 < argc ? MAX2(atoi(argv[i + 1]), 1) : 0;
+
+      if (!strcmp(argv[i], "-i") && value) {
+         iterations = value;
+      } else if (!strcmp(argv[i], "-s") && value) {
+         size = value;
+      } else if (!strcmp(argv[i], "-t") && value) {
+         num_threads = value;
+      } else {
+         fprintf(stderr, "usage: %s [-i iterations] [-s size] "
+                 "[-t threads]\n", argv[0]);
+         return 1;
+      }
+      i++;
+   }
+
+   /* Only whole blocks of every format, up to ASTC 12x12. */
+   size = DIV_ROUND_UP(size, 12) * 12;
+
+   struct util_queue queue;
+   memset(&queue, 0, sizeof(queue));
+   if (num_threads > 1 &&
+       !util_queue_init(&queue, "bench", num_threads, num_threads, 0, NULL)) {
+      fprintf(stderr, "failed to create %u threads\n", num_threads);
+      return 1;
+   }
+
+   /* Enough random data for the format with the most bits per pixel. */
+   size_t src_size = (size_t)size * size;
+   uint8_t *src = malloc(src_size);
+   srand(0);
+   for (size_t i = 0; i < src_size; i++)
+      src[i] = rand();
+
+   printf("%ux%u, %u thread(s)\n", size, size, num_threads);
+   printf("%-24s %14s %14s\n", "format", "decode MP/s", "to DXT5 MP/s");
+
+   for (unsigned i = 0; i < ARRAY_SIZE(formats); i++) {
+      double decode = bench(&queue, num_threads, formats[i], false,
+                            src, size, iterations);
+      double transcode = bench(&queue, num_threads, formats[i], true,
+                               src, size, iterations);
+
+      printf("%-24s %14.1f %14.1f\n", util_format_short_name(formats[i]),
+             decode, transcode);
+   }
+
+   free(src);
+   if (num_threads > 1)
+      util_queue_destroy(&queue);
+
+   return 0;
+}
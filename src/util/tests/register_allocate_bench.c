@@ -0,0 +1,160 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Compile-time benchmark for util/register_allocate.
+ *
+ * Usage: ra_bench [-i iterations] [file...]
+ *
+ * Each file holds a register set written by ra_set_serialize() followed by
+ * a graph written by ra_graph_serialize(), as dumped by drivers when
+ * MESA_RA_DUMP_PATH is set.  Every iteration rebuilds the
+ * interference graph from the file and runs ra_allocate() on it, so both the
+ * cost of building interference and of coloring show up in the timings.
+ *
+ * Without any file, a few synthetic graphs of increasing size are generated
+ * from overlapping live ranges instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/blob.h"
+#include "util/macros.h"
+#include "util/os_file.h"
+#include "util/os_time.h"
+#include "util/ralloc.h"
+#include "util/register_allocate.h"
+#include "util/register_allocate_internal.h"
+
+static void
+report(const char *name, unsigned nodes, unsigned iterations,
+       int64_t total_ns, unsigned success)
+{
+   printf("%-32s %8u nodes %10.3f ms/iter %s\n", name, nodes,
+          total_ns / 1000000.0 / iterations,
+          success == iterations ? "" : "(failed to color)");
+}
+
+static void
+replay(void *blob_data, size_t size, const char *name, unsigned iterations)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   struct blob_reader reader;
+
+   blob_reader_init(&reader, blob_data, size);
+   struct ra_regs *regs = ra_set_deserialize(mem_ctx, &reader);
+   if (reader.overrun) {
+      fprintf(stderr, "%s: corrupt register set\n", name);
+      ralloc_free(mem_ctx);
+      return;
+   }
+   size_t graph_offset = reader.current - (const uint8_t *)blob_data;
+
+   unsigned nodes = 0, success = 0;
+   int64_t total = 0;
+   for (unsigned i = 0; i < iterations; i++) {
+      blob_reader_init(&reader, (uint8_t *)blob_data + graph_offset,
+                       size - graph_offset);
+
+      int64_t start = os_time_get_nano();
+      struct ra_graph *g = ra_graph_deserialize(regs, &reader);
+      if (!g || reader.overrun) {
+         fprintf(stderr, "%s: corrupt graph\n", name);
+         break;
+      }
+      success += ra_allocate(g);
+      total += os_time_get_nano() - start;
+
+      nodes = g->count;
+      ralloc_free(g);
+   }
+
+   if (nodes)
+      report(name, nodes, iterations, total, success);
+   ralloc_free(mem_ctx);
+}
+
+/**
+ * Builds a graph of @count scalar nodes with random live ranges over a
+ * program of @count instructions, roughly what a long straight-line compute
+ * shader looks like to a backend.
+ */
+static void
+synthetic(unsigned count, unsigned iterations)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   struct ra_regs *regs = ra_alloc_reg_set(mem_ctx, 128, false);
+   struct ra_class *class = ra_alloc_contig_reg_class(regs, 1);
+   for (unsigned r = 0; r < 128; r++)
+      ra_class_add_reg(class, r);
+   ra_set_finalize(regs, NULL);
+
+   unsigned *def = ralloc_array(mem_ctx, unsigned, count);
+   unsigned *end = ralloc_array(mem_ctx, unsigned, count);
+   srand(count);
+   for (unsigned n = 0; n < count; n++) {
+      unsigned len = 1 + rand() % 48;
+      def[n] = n;
+      end[n] = MIN2(n + len, count);
+   }
+
+   unsigned success = 0;
+   int64_t total = 0;
+   for (unsigned i = 0; i < iterations; i++) {
+      int64_t start = os_time_get_nano();
+      struct ra_graph *g = ra_alloc_interference_graph(regs, count);
+      for (unsigned n = 0; n < count; n++) {
+         ra_set_node_class(g, n, class);
+         for (unsigned n2 = n + 1; n2 < end[n]; n2++) {
+            if (def[n2] < end[n])
+               ra_add_node_interference(g, n, n2);
+         }
+      }
+      success += ra_allocate(g);
+      total += os_time_get_nano() - start;
+      ralloc_free(g);
+   }
+
+   char name[32];
+   snprintf(name, sizeof(name), "synthetic-%u", count);
+   report(name, count, iterations, total, success);
+   ralloc_free(mem_ctx);
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned iterations = 10;
+   int first_file = 1;
+
+   if (argc > 2 && strcmp(argv[1], "-i") == 0) {
+      iterations = MAX2(atoi(argv[2]), 1);
+      first_file = 3;
+   }
+
+   if (first_file >= argc) {
+      static const unsigned sizes[] = { 512, 2048, 8192, 32768 };
+      for (unsigned i = 0; i < ARRAY_SIZE(sizes); i++)
+         synthetic(sizes[i], iterations);
+      return 0;
+   }
+
+   int ret = 0;
+   for (int i = first_file; i < argc; i++) {
+      size_t size;
+      char *data = os_read_file(argv[i], &size);
+      if (!data) {
+         fprintf(stderr, "%s: can't read file\n", argv[i]);
+         ret = 1;
+         continue;
+      }
+
+      replay(data, size, argv[i], iterations);
+      free(data);
+   }
+
+   return ret;
+}
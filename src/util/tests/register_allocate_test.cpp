@@ -279,3 +279,114 @@ TEST_F(ra_test, serialization_roundtrip)
    blob_finish(&blob);
 }
 
+
+static unsigned
+node_degree(struct ra_graph *g, unsigned n)
+{
+   return util_dynarray_num_elements(&g->nodes[n].adjacency_list, unsigned);
+}
+
+TEST_F(ra_test, sparse_interference)
+{
+   struct ra_regs *regs = ra_alloc_reg_set(mem_ctx, 4, true);
+   struct ra_class *reg = ra_alloc_contig_reg_class(regs, 1);
+   for (int i = 0; i < 4; i++)
+      ra_class_add_reg(reg, i);
+   ra_set_finalize(regs, NULL);
+
+   /* Start dense and grow past the threshold one node at a time. */
+   struct ra_graph *g = ra_alloc_interference_graph(regs, 1);
+   ra_set_node_class(g, 0, reg);
+   ASSERT_EQ(g->adjacency_blocks, nullptr);
+
+   for (unsigned n = 1; n < RA_SPARSE_ADJACENCY_NODES + 100; n++) {
+      ASSERT_EQ(ra_add_node(g, reg), n);
+      ra_add_node_interference(g, n - 1, n);
+   }
+   ra_add_node_interference(g, 0, RA_SPARSE_ADJACENCY_NODES + 99);
+
+   ASSERT_NE(g->adjacency_blocks, nullptr);
+   ASSERT_EQ(g->adjacency, nullptr);
+
+   /* Interference recorded before the switch must still be known, so adding
+    * it again doesn't duplicate the adjacency list entries.
+    */
+   ra_add_node_interference(g, 1, 0);
+   ra_add_node_interference(g, 2, 1);
+   ra_add_node_interference(g, RA_SPARSE_ADJACENCY_NODES + 99, 0);
+   EXPECT_EQ(node_degree(g, 0), 2);
+   EXPECT_EQ(node_degree(g, 1), 2);
+   EXPECT_EQ(node_degree(g, RA_SPARSE_ADJACENCY_NODES + 99), 2);
+
+   ra_reset_node_interference(g, 1);
+   EXPECT_EQ(node_degree(g, 0), 1);
+   EXPECT_EQ(node_degree(g, 1), 0);
+   EXPECT_EQ(node_degree(g, 2), 1);
+   ra_add_node_interference(g, 0, 1);
+   EXPECT_EQ(node_degree(g, 0), 2);
+
+   ASSERT_TRUE(ra_allocate(g));
+   for (unsigned n = 1; n < g->count; n++)
+      EXPECT_NE(ra_get_node_reg(g, n - 1), ra_get_node_reg(g, n));
+   EXPECT_NE(ra_get_node_reg(g, 0), ra_get_node_reg(g, g->count - 1));
+
+   ralloc_free(g);
+}
+
+TEST_F(ra_test, graph_serialization_roundtrip)
+{
+   struct ra_regs *regs = ra_alloc_reg_set(mem_ctx, 8, true);
+   struct ra_class *reg = ra_alloc_contig_reg_class(regs, 1);
+   struct ra_class *reg2 = ra_alloc_contig_reg_class(regs, 2);
+   for (int i = 0; i < 8; i++) {
+      ra_class_add_reg(reg, i);
+      if (i % 2 == 0)
+         ra_class_add_reg(reg2, i);
+   }
+   ra_set_finalize(regs, NULL);
+
+   struct ra_graph *g = ra_alloc_interference_graph(regs, 5);
+   for (unsigned n = 0; n < 5; n++)
+      ra_set_node_class(g, n, n % 2 ? reg2 : reg);
+   ra_set_node_reg(g, 4, 7);
+   ra_set_node_spill_cost(g, 3, 2.5f);
+   ra_add_node_interference(g, 0, 1);
+   ra_add_node_interference(g, 3, 1);
+   ra_add_node_interference(g, 4, 2);
+
+   struct blob blob;
+   blob_init(&blob);
+   ra_graph_serialize(g, &blob);
+
+   struct blob_reader reader;
+   blob_reader_init(&reader, blob.data, blob.size);
+   struct ra_graph *g2 = ra_graph_deserialize(regs, &reader);
+   ASSERT_NE(g2, nullptr);
+   ASSERT_EQ(g2->count, g->count);
+
+   for (unsigned n = 0; n < g->count; n++) {
+      EXPECT_EQ(ra_get_node_class(g2, n), ra_get_node_class(g, n));
+      EXPECT_EQ(g2->nodes[n].forced_reg, g->nodes[n].forced_reg);
+      EXPECT_EQ(g2->nodes[n].spill_cost, g->nodes[n].spill_cost);
+      EXPECT_EQ(g2->nodes[n].q_total, g->nodes[n].q_total);
+      EXPECT_EQ(node_degree(g2, n), node_degree(g, n));
+   }
+
+   /* A truncated blob is rejected. */
+   blob_reader_init(&reader, blob.data, blob.size - 4);
+   EXPECT_EQ(ra_graph_deserialize(regs, &reader), nullptr);
+
+   /* So is a forced register outside of the register set.  The first
+    * node's forced_reg follows the node count and its class.
+    */
+   uint32_t *data = (uint32_t *)malloc(blob.size);
+   memcpy(data, blob.data, blob.size);
+   data[2] = regs->count;
+   blob_reader_init(&reader, data, blob.size);
+   EXPECT_EQ(ra_graph_deserialize(regs, &reader), nullptr);
+   free(data);
+
+   blob_finish(&blob);
+   ralloc_free(g);
+   ralloc_free(g2);
+}
@@ -292,6 +292,7 @@ struct util_queue_monitoring
    unsigned num_direct_items;
    unsigned num_syncs;
    unsigned num_batches;
+   unsigned num_merged_draws;
 };
 
 #ifdef __cplusplus